@@ -1596,6 +1596,98 @@ static void test_reg_unload_key(void)
     DeleteFileA("saved_key.LOG");
 }
 
+static void check_loaded_hive( BOOL has_v2 )
+{
+    char buffer[16];
+    HKEY key, subkey;
+    DWORD value, len;
+    LONG ret;
+
+    ret = RegLoadKeyA( HKEY_LOCAL_MACHINE, "CacheTest", "cache_hive" );
+    ok( !ret, "RegLoadKeyA failed, ret %d\n", ret );
+    if (ret) return;
+
+    ret = RegOpenKeyExA( HKEY_LOCAL_MACHINE, "CacheTest", 0, KEY_READ, &key );
+    ok( !ret, "RegOpenKeyExA failed, ret %d\n", ret );
+    len = sizeof(value);
+    ret = RegQueryValueExA( key, "v1", NULL, NULL, (BYTE *)&value, &len );
+    ok( !ret && value == 1, "got ret %d, value %u\n", ret, value );
+    len = sizeof(value);
+    ret = RegQueryValueExA( key, "v2", NULL, NULL, (BYTE *)&value, &len );
+    if (has_v2) ok( !ret && value == 2, "got ret %d, value %u\n", ret, value );
+    else ok( ret == ERROR_FILE_NOT_FOUND, "got ret %d\n", ret );
+
+    ret = RegOpenKeyExA( key, "sub", 0, KEY_READ, &subkey );
+    ok( !ret, "RegOpenKeyExA failed, ret %d\n", ret );
+    len = sizeof(buffer);
+    ret = RegQueryValueExA( subkey, NULL, NULL, NULL, (BYTE *)buffer, &len );
+    ok( !ret && !strcmp( buffer, "data" ), "got ret %d, %s\n", ret, buffer );
+    len = sizeof(buffer);
+    ret = RegQueryInfoKeyA( subkey, buffer, &len, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL );
+    ok( !ret && !strcmp( buffer, "class" ), "got ret %d, class %s\n", ret, buffer );
+    RegCloseKey( subkey );
+    RegCloseKey( key );
+
+    ret = RegUnLoadKeyA( HKEY_LOCAL_MACHINE, "CacheTest" );
+    ok( !ret, "RegUnLoadKeyA failed, ret %d\n", ret );
+}
+
+static void save_cache_hive( HKEY key )
+{
+    LONG ret;
+
+    DeleteFileA( "cache_hive" );
+    DeleteFileA( "cache_hive.LOG" );
+    set_privileges( SE_BACKUP_NAME, TRUE );
+    ret = RegSaveKeyA( key, "cache_hive", NULL );
+    ok( !ret, "RegSaveKeyA failed, ret %d\n", ret );
+    set_privileges( SE_BACKUP_NAME, FALSE );
+}
+
+/* Loading a saved hive again gives the same contents, and saving it again
+ * replaces them. Wine can keep a binary cache of hive files, which must be
+ * used on the second load and invalidated by the new save. */
+static void test_reg_load_key_cache(void)
+{
+    HKEY key, subkey;
+    DWORD value;
+    LONG ret;
+
+    if (!set_privileges( SE_BACKUP_NAME, TRUE ) || !set_privileges( SE_RESTORE_NAME, TRUE ))
+    {
+        win_skip( "Failed to set SE_BACKUP_NAME and SE_RESTORE_NAME privileges, skipping tests\n" );
+        set_privileges( SE_BACKUP_NAME, FALSE );
+        return;
+    }
+    set_privileges( SE_BACKUP_NAME, FALSE );
+
+    ret = RegCreateKeyA( hkey_main, "cache_src", &key );
+    ok( !ret, "RegCreateKeyA failed, ret %d\n", ret );
+    value = 1;
+    RegSetValueExA( key, "v1", 0, REG_DWORD, (BYTE *)&value, sizeof(value) );
+    ret = RegCreateKeyExA( key, "sub", 0, (char *)"class", 0, KEY_ALL_ACCESS, NULL, &subkey, NULL );
+    ok( !ret, "RegCreateKeyExA failed, ret %d\n", ret );
+    RegSetValueExA( subkey, NULL, 0, REG_SZ, (BYTE *)"data", 5 );
+    RegCloseKey( subkey );
+
+    save_cache_hive( key );
+    check_loaded_hive( FALSE );
+    check_loaded_hive( FALSE );
+
+    value = 2;
+    RegSetValueExA( key, "v2", 0, REG_DWORD, (BYTE *)&value, sizeof(value) );
+    save_cache_hive( key );
+    check_loaded_hive( TRUE );
+    check_loaded_hive( TRUE );
+
+    set_privileges( SE_RESTORE_NAME, FALSE );
+    delete_key( key );
+    RegCloseKey( key );
+    DeleteFileA( "cache_hive" );
+    DeleteFileA( "cache_hive.LOG" );
+    DeleteFileA( "cache_hive.bin" );
+}
+
 /* tests that show that RegConnectRegistry and 
    OpenSCManager accept computer names without the
    \\ prefix (what MSDN says).   */
@@ -2276,6 +2368,75 @@ static void test_reg_delete_tree(void)
         "Expected ERROR_FILE_NOT_FOUND, got %d\n", ret);
 }
 
+struct large_value_info
+{
+    HKEY key;
+    unsigned int id;
+};
+
+static DWORD WINAPI large_value_thread( void *arg )
+{
+    const struct large_value_info *info = arg;
+    WCHAR name[1024];
+    BYTE *data, *buffer;
+    DWORD i, j, size, len, name_len;
+    LONG ret;
+
+    data = HeapAlloc( GetProcessHeap(), 0, 300000 );
+    buffer = HeapAlloc( GetProcessHeap(), 0, 300000 );
+
+    for (i = 0; i < 40; i++)
+    {
+        /* sizes below and above the request buffer size and the pipe buffer size */
+        size = (i * 7919 + info->id * 104729) % 300000 + 1;
+        name_len = (i * 131 + info->id * 17) % (ARRAY_SIZE(name) - 16) + 1;
+        for (j = 0; j < name_len; j++) name[j] = 'a' + (i + j + info->id) % 26;
+        swprintf( name + name_len, 16, L"_%u", info->id );
+        for (j = 0; j < size; j++) data[j] = i + j * 7 + info->id;
+
+        ret = RegSetValueExW( info->key, name, 0, REG_BINARY, data, size );
+        ok( !ret, "%u/%u: RegSetValueExW failed, ret %d\n", info->id, i, ret );
+        len = 300000;
+        ret = RegQueryValueExW( info->key, name, NULL, NULL, buffer, &len );
+        ok( !ret, "%u/%u: RegQueryValueExW failed, ret %d\n", info->id, i, ret );
+        ok( len == size, "%u/%u: got size %u, expected %u\n", info->id, i, len, size );
+        ok( !memcmp( buffer, data, size ), "%u/%u: wrong data\n", info->id, i );
+        ret = RegDeleteValueW( info->key, name );
+        ok( !ret, "%u/%u: RegDeleteValueW failed, ret %d\n", info->id, i, ret );
+    }
+
+    HeapFree( GetProcessHeap(), 0, data );
+    HeapFree( GetProcessHeap(), 0, buffer );
+    return 0;
+}
+
+/* concurrent requests and replies with large variable-size data and long names */
+static void test_large_values(void)
+{
+    struct large_value_info info[4];
+    HANDLE threads[4];
+    HKEY key;
+    LONG ret;
+    int i;
+
+    ret = RegCreateKeyA( hkey_main, "large_values", &key );
+    ok( !ret, "RegCreateKeyA failed, ret %d\n", ret );
+
+    for (i = 0; i < ARRAY_SIZE(threads); i++)
+    {
+        info[i].key = key;
+        info[i].id = i;
+        threads[i] = CreateThread( NULL, 0, large_value_thread, &info[i], 0, NULL );
+        ok( threads[i] != NULL, "CreateThread failed, error %u\n", GetLastError() );
+    }
+    ret = WaitForMultipleObjects( ARRAY_SIZE(threads), threads, TRUE, 60000 );
+    ok( ret == WAIT_OBJECT_0, "WaitForMultipleObjects returned %d\n", ret );
+    for (i = 0; i < ARRAY_SIZE(threads); i++) CloseHandle( threads[i] );
+
+    delete_key( key );
+    RegCloseKey( key );
+}
+
 static void test_rw_order(void)
 {
     HKEY hKey;
@@ -2322,6 +2483,96 @@ static void test_rw_order(void)
     ok(!RegDeleteKeyA(HKEY_CURRENT_USER, keyname), "Failed to delete key\n");
 }
 
+/* keys with many subkeys use a hash table for lookups, check that enumeration,
+ * lookups, creation and deletion keep working as the table grows and shrinks */
+static void test_many_subkeys(void)
+{
+    static const unsigned int count = 600;
+    char name[32], expect[32];
+    HKEY key, subkey;
+    DWORD subkeys, len;
+    unsigned int i, n;
+    LONG ret;
+
+    ret = RegCreateKeyA( hkey_main, "many_subkeys", &key );
+    ok( !ret, "RegCreateKeyA failed, ret %d\n", ret );
+
+    /* insert out of order, alternating the case of the names */
+    for (i = 0; i < count; i++)
+    {
+        n = i * 7 % count;
+        sprintf( name, n % 2 ? "KEY%03u" : "key%03u", n );
+        ret = RegCreateKeyA( key, name, &subkey );
+        ok( !ret, "RegCreateKeyA %s failed, ret %d\n", name, ret );
+        RegCloseKey( subkey );
+    }
+
+    ret = RegQueryInfoKeyA( key, NULL, NULL, NULL, &subkeys, NULL, NULL, NULL, NULL, NULL, NULL, NULL );
+    ok( !ret, "RegQueryInfoKeyA failed, ret %d\n", ret );
+    ok( subkeys == count, "got %u subkeys\n", subkeys );
+
+    for (i = 0; i < count; i++)
+    {
+        len = sizeof(name);
+        ret = RegEnumKeyExA( key, i, name, &len, NULL, NULL, NULL, NULL );
+        ok( !ret, "RegEnumKeyExA %u failed, ret %d\n", i, ret );
+        sprintf( expect, i % 2 ? "KEY%03u" : "key%03u", i );
+        ok( !strcmp( name, expect ), "%u: got %s, expected %s\n", i, name, expect );
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "Key%03u", i );
+        ret = RegOpenKeyA( key, name, &subkey );
+        ok( !ret, "RegOpenKeyA %s failed, ret %d\n", name, ret );
+        RegCloseKey( subkey );
+    }
+    ret = RegOpenKeyA( key, "key600", &subkey );
+    ok( ret == ERROR_FILE_NOT_FOUND, "RegOpenKeyA key600 returned %d\n", ret );
+
+    /* delete every third key and add others in between */
+    for (i = 0; i < count; i += 3)
+    {
+        sprintf( name, "kEy%03u", i );
+        ret = RegDeleteKeyA( key, name );
+        ok( !ret, "RegDeleteKeyA %s failed, ret %d\n", name, ret );
+        sprintf( name, "key%03u_", i + 1 );
+        ret = RegCreateKeyA( key, name, &subkey );
+        ok( !ret, "RegCreateKeyA %s failed, ret %d\n", name, ret );
+        RegCloseKey( subkey );
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "KEY%03u", i );
+        ret = RegOpenKeyA( key, name, &subkey );
+        ok( (ret == ERROR_FILE_NOT_FOUND) == !(i % 3), "RegOpenKeyA %s returned %d\n", name, ret );
+        if (!ret) RegCloseKey( subkey );
+    }
+
+    for (i = n = 0; n < count; n++)
+    {
+        if (!(n % 3)) continue;
+        len = sizeof(name);
+        ret = RegEnumKeyExA( key, i++, name, &len, NULL, NULL, NULL, NULL );
+        ok( !ret, "RegEnumKeyExA %u failed, ret %d\n", i, ret );
+        sprintf( expect, n % 2 ? "KEY%03u" : "key%03u", n );
+        ok( !strcmp( name, expect ), "%u: got %s, expected %s\n", i, name, expect );
+        if (n % 3 != 1) continue;
+        len = sizeof(name);
+        ret = RegEnumKeyExA( key, i++, name, &len, NULL, NULL, NULL, NULL );
+        ok( !ret, "RegEnumKeyExA %u failed, ret %d\n", i, ret );
+        sprintf( expect, "key%03u_", n );
+        ok( !strcmp( name, expect ), "%u: got %s, expected %s\n", i, name, expect );
+    }
+    len = sizeof(name);
+    ret = RegEnumKeyExA( key, i, name, &len, NULL, NULL, NULL, NULL );
+    ok( ret == ERROR_NO_MORE_ITEMS, "RegEnumKeyExA %u returned %d\n", i, ret );
+
+    delete_key( key );
+    RegCloseKey( key );
+}
+
 static void test_symlinks(void)
 {
     static const WCHAR targetW[] = L"\\Software\\Wine\\Test\\target";
@@ -4194,6 +4445,7 @@ START_TEST(registry)
     test_reg_query_value();
     test_reg_query_info();
     test_string_termination();
+    test_many_subkeys();
     test_symlinks();
     test_redirection();
     test_classesroot();
@@ -4202,9 +4454,11 @@ START_TEST(registry)
     test_reg_save_key();
     test_reg_load_key();
     test_reg_unload_key();
+    test_reg_load_key_cache();
     test_reg_copy_tree();
     test_reg_delete_tree();
     test_rw_order();
+    test_large_values();
     test_deleted_key();
     test_delete_value();
     test_delete_key_value();
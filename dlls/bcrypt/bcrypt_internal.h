@@ -30,6 +30,14 @@
 #define MAGIC_DSS1 ('D' | ('S' << 8) | ('S' << 16) | ('1' << 24))
 #define MAGIC_DSS2 ('D' | ('S' << 8) | ('S' << 16) | ('2' << 24))
 
+extern BOOL sha_ni_supported DECLSPEC_HIDDEN;
+extern BOOL avx2_supported DECLSPEC_HIDDEN;
+
+#if defined(__i386__) || defined(__x86_64__)
+#define SHANI_TARGET __attribute__((target("sha,sse4.1")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
 typedef struct
 {
     ULONG64 len;
@@ -40,6 +48,8 @@ typedef struct
 void sha256_init(SHA256_CTX *ctx) DECLSPEC_HIDDEN;
 void sha256_update(SHA256_CTX *ctx, const UCHAR *buffer, ULONG len) DECLSPEC_HIDDEN;
 void sha256_finalize(SHA256_CTX *ctx, UCHAR *buffer) DECLSPEC_HIDDEN;
+void sha256_update_multi(SHA256_CTX **ctx, const UCHAR **buffer, const ULONG *len, ULONG count) DECLSPEC_HIDDEN;
+void sha256_finalize_multi(SHA256_CTX **ctx, UCHAR **buffer, ULONG count) DECLSPEC_HIDDEN;
 
 typedef struct
 {
@@ -51,10 +61,14 @@ typedef struct
 void sha512_init(SHA512_CTX *ctx) DECLSPEC_HIDDEN;
 void sha512_update(SHA512_CTX *ctx, const UCHAR *buffer, ULONG len) DECLSPEC_HIDDEN;
 void sha512_finalize(SHA512_CTX *ctx, UCHAR *buffer) DECLSPEC_HIDDEN;
+void sha512_update_multi(SHA512_CTX **ctx, const UCHAR **buffer, const ULONG *len, ULONG count) DECLSPEC_HIDDEN;
+void sha512_finalize_multi(SHA512_CTX **ctx, UCHAR **buffer, ULONG count) DECLSPEC_HIDDEN;
 
 void sha384_init(SHA512_CTX *ctx) DECLSPEC_HIDDEN;
 #define sha384_update sha512_update
 void sha384_finalize(SHA512_CTX *ctx, UCHAR *buffer) DECLSPEC_HIDDEN;
+#define sha384_update_multi sha512_update_multi
+void sha384_finalize_multi(SHA512_CTX **ctx, UCHAR **buffer, ULONG count) DECLSPEC_HIDDEN;
 
 typedef struct {
     unsigned char chksum[16], X[48], buf[16];
@@ -30,6 +30,10 @@
 
 #include "bcrypt_internal.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
+
 #include "wine/debug.h"
 #include "wine/heap.h"
 
@@ -37,6 +41,9 @@ WINE_DEFAULT_DEBUG_CHANNEL(bcrypt);
 
 static HINSTANCE instance;
 
+BOOL sha_ni_supported;
+BOOL avx2_supported;
+
 static const struct key_funcs *key_funcs;
 
 NTSTATUS WINAPI BCryptAddContextFunction(ULONG table, LPCWSTR context, ULONG iface, LPCWSTR function, ULONG pos)
@@ -213,7 +220,7 @@ NTSTATUS WINAPI BCryptGenRandom(BCRYPT_ALG_HANDLE handle, UCHAR *buffer, ULONG c
 
 NTSTATUS WINAPI BCryptOpenAlgorithmProvider( BCRYPT_ALG_HANDLE *handle, LPCWSTR id, LPCWSTR implementation, DWORD flags )
 {
-    const DWORD supported_flags = BCRYPT_ALG_HANDLE_HMAC_FLAG | BCRYPT_HASH_REUSABLE_FLAG;
+    const DWORD supported_flags = BCRYPT_ALG_HANDLE_HMAC_FLAG | BCRYPT_HASH_REUSABLE_FLAG | BCRYPT_MULTI_FLAG;
     struct algorithm *alg;
     enum alg_id alg_id;
     ULONG i;
@@ -425,6 +432,8 @@ struct hash
     ULONG             secret_len;
     struct hash_impl  outer;
     struct hash_impl  inner;
+    ULONG             element_count;
+    struct hash      *elements;     /* for multi-hash objects */
 };
 
 #define BLOCK_LENGTH_3DES       8
@@ -444,6 +453,22 @@ static NTSTATUS generic_alg_property( enum alg_id id, const WCHAR *prop, UCHAR *
         return STATUS_SUCCESS;
     }
 
+    if (!wcscmp( prop, BCRYPT_MULTI_OBJECT_LENGTH ))
+    {
+        BCRYPT_MULTI_OBJECT_LENGTH_STRUCT *len = (BCRYPT_MULTI_OBJECT_LENGTH_STRUCT *)buf;
+        if (builtin_algorithms[id].class != BCRYPT_HASH_INTERFACE)
+            return STATUS_NOT_SUPPORTED;
+        *ret_size = sizeof(*len);
+        if (size < sizeof(*len))
+            return STATUS_BUFFER_TOO_SMALL;
+        if (buf)
+        {
+            len->cbPerObject  = builtin_algorithms[id].object_length;
+            len->cbPerElement = builtin_algorithms[id].object_length;
+        }
+        return STATUS_SUCCESS;
+    }
+
     if (!wcscmp( prop, BCRYPT_HASH_LENGTH ))
     {
         if (!builtin_algorithms[id].hash_length)
@@ -815,6 +840,49 @@ NTSTATUS WINAPI BCryptCreateHash( BCRYPT_ALG_HANDLE algorithm, BCRYPT_HASH_HANDL
     return STATUS_SUCCESS;
 }
 
+NTSTATUS WINAPI BCryptCreateMultiHash( BCRYPT_ALG_HANDLE algorithm, BCRYPT_HASH_HANDLE *handle, ULONG count,
+                                       UCHAR *object, ULONG object_len, UCHAR *secret, ULONG secret_len, ULONG flags )
+{
+    struct algorithm *alg = algorithm;
+    struct hash *hash;
+    NTSTATUS status;
+    ULONG i;
+
+    TRACE( "%p, %p, %u, %p, %u, %p, %u, %08x\n", algorithm, handle, count, object, object_len,
+           secret, secret_len, flags );
+    if (flags & ~BCRYPT_HASH_REUSABLE_FLAG)
+    {
+        FIXME( "unimplemented flags %08x\n", flags );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
+    if (!alg || alg->hdr.magic != MAGIC_ALG) return STATUS_INVALID_HANDLE;
+    if (!(alg->flags & BCRYPT_MULTI_FLAG) || !handle || !count) return STATUS_INVALID_PARAMETER;
+    if (count > ~0u / sizeof(*hash->elements)) return STATUS_INVALID_PARAMETER;
+    if (object) FIXME( "ignoring object buffer\n" );
+
+    if ((status = hash_create( alg, secret, secret_len, flags, &hash ))) return status;
+    if (!(hash->elements = heap_alloc( count * sizeof(*hash->elements) )))
+    {
+        heap_free( hash->secret );
+        heap_free( hash );
+        return STATUS_NO_MEMORY;
+    }
+
+    /* elements share the secret of the parent object and are reset after each finish operation */
+    for (i = 0; i < count; i++)
+    {
+        hash->elements[i] = *hash;
+        hash->elements[i].hdr.magic = 0;
+        hash->elements[i].flags |= HASH_FLAG_REUSABLE;
+        hash->elements[i].elements = NULL;
+    }
+    hash->element_count = count;
+
+    *handle = hash;
+    return STATUS_SUCCESS;
+}
+
 NTSTATUS WINAPI BCryptDuplicateHash( BCRYPT_HASH_HANDLE handle, BCRYPT_HASH_HANDLE *handle_copy,
                                      UCHAR *object, ULONG objectlen, ULONG flags )
 {
@@ -838,6 +906,23 @@ NTSTATUS WINAPI BCryptDuplicateHash( BCRYPT_HASH_HANDLE handle, BCRYPT_HASH_HAND
     }
     memcpy( hash_copy->secret, hash_orig->secret, hash_orig->secret_len );
 
+    if (hash_orig->elements)
+    {
+        ULONG i;
+
+        if (!(hash_copy->elements = heap_alloc( hash_orig->element_count * sizeof(*hash_copy->elements) )))
+        {
+            heap_free( hash_copy->secret );
+            heap_free( hash_copy );
+            return STATUS_NO_MEMORY;
+        }
+        for (i = 0; i < hash_orig->element_count; i++)
+        {
+            hash_copy->elements[i] = hash_orig->elements[i];
+            hash_copy->elements[i].secret = hash_copy->secret;
+        }
+    }
+
     *handle_copy = hash_copy;
     return STATUS_SUCCESS;
 }
@@ -846,6 +931,7 @@ static void hash_destroy( struct hash *hash )
 {
     if (!hash) return;
     hash->hdr.magic = 0;
+    heap_free( hash->elements );
     heap_free( hash->secret );
     heap_free( hash );
 }
@@ -929,6 +1015,106 @@ NTSTATUS WINAPI BCryptHash( BCRYPT_ALG_HANDLE algorithm, UCHAR *secret, ULONG se
     return status;
 }
 
+#define MAX_MULTI_BATCH 64
+
+/* Process operations of the same type on distinct elements. Plain SHA-2 hashes go
+ * through the multi-buffer implementations, everything else one element at a time. */
+static NTSTATUS process_hash_batch( struct hash *hash, BCRYPT_MULTI_HASH_OPERATION *ops, ULONG count )
+{
+    void *ctx[MAX_MULTI_BATCH];
+    const UCHAR *input[MAX_MULTI_BATCH];
+    UCHAR *output[MAX_MULTI_BATCH];
+    ULONG len[MAX_MULTI_BATCH];
+    NTSTATUS status;
+    ULONG i;
+
+    if (count > 1 && !(hash->flags & HASH_FLAG_HMAC) &&
+        (hash->alg_id == ALG_ID_SHA256 || hash->alg_id == ALG_ID_SHA384 || hash->alg_id == ALG_ID_SHA512))
+    {
+        for (i = 0; i < count; i++)
+        {
+            ctx[i]    = &hash->elements[ops[i].iHash].inner.u;
+            input[i]  = ops[i].pbBuffer;
+            output[i] = ops[i].pbBuffer;
+            len[i]    = ops[i].pbBuffer ? ops[i].cbBuffer : 0;
+        }
+
+        if (ops[0].hashOperation == BCRYPT_HASH_OPERATION_HASH_DATA)
+        {
+            if (hash->alg_id == ALG_ID_SHA256) sha256_update_multi( (SHA256_CTX **)ctx, input, len, count );
+            else sha512_update_multi( (SHA512_CTX **)ctx, input, len, count );
+            return STATUS_SUCCESS;
+        }
+
+        if (hash->alg_id == ALG_ID_SHA256) sha256_finalize_multi( (SHA256_CTX **)ctx, output, count );
+        else if (hash->alg_id == ALG_ID_SHA384) sha384_finalize_multi( (SHA512_CTX **)ctx, output, count );
+        else sha512_finalize_multi( (SHA512_CTX **)ctx, output, count );
+
+        for (i = 0; i < count; i++)
+            if ((status = hash_init( &hash->elements[ops[i].iHash].inner, hash->alg_id ))) return status;
+        return STATUS_SUCCESS;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        struct hash *element = &hash->elements[ops[i].iHash];
+
+        if (ops[i].hashOperation == BCRYPT_HASH_OPERATION_HASH_DATA)
+        {
+            if (!ops[i].pbBuffer) continue;
+            status = hash_update( &element->inner, element->alg_id, ops[i].pbBuffer, ops[i].cbBuffer );
+        }
+        else status = hash_finalize( element, ops[i].pbBuffer, ops[i].cbBuffer );
+        if (status) return status;
+    }
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WINAPI BCryptProcessMultiOperations( BCRYPT_HANDLE handle, BCRYPT_MULTI_OPERATION_TYPE type, void *operations,
+                                              ULONG size, ULONG flags )
+{
+    struct hash *hash = handle;
+    BCRYPT_MULTI_HASH_OPERATION *ops = operations;
+    ULONG i, j, start, count = size / sizeof(*ops);
+    NTSTATUS status;
+
+    TRACE( "%p, %u, %p, %u, %08x\n", handle, type, operations, size, flags );
+
+    if (!hash || hash->hdr.magic != MAGIC_HASH || !hash->elements) return STATUS_INVALID_HANDLE;
+    if (type != BCRYPT_OPERATION_TYPE_HASH || flags || size % sizeof(*ops) || (size && !ops))
+        return STATUS_INVALID_PARAMETER;
+
+    for (i = 0; i < count; i++)
+    {
+        if (ops[i].iHash >= hash->element_count) return STATUS_INVALID_PARAMETER;
+        switch (ops[i].hashOperation)
+        {
+        case BCRYPT_HASH_OPERATION_HASH_DATA:
+            break;
+        case BCRYPT_HASH_OPERATION_FINISH_HASH:
+            if (!ops[i].pbBuffer || ops[i].cbBuffer != builtin_algorithms[hash->alg_id].hash_length)
+                return STATUS_INVALID_PARAMETER;
+            break;
+        default:
+            return STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    /* batch consecutive operations of the same type that touch distinct elements,
+     * the order of operations on any given element is preserved */
+    for (start = 0; start < count; start = i)
+    {
+        for (i = start + 1; i < count && i - start < MAX_MULTI_BATCH; i++)
+        {
+            if (ops[i].hashOperation != ops[start].hashOperation) break;
+            for (j = start; j < i; j++) if (ops[j].iHash == ops[i].iHash) break;
+            if (j < i) break;
+        }
+        if ((status = process_hash_batch( hash, ops + start, i - start ))) return status;
+    }
+    return STATUS_SUCCESS;
+}
+
 static NTSTATUS key_asymmetric_create( struct key **ret_key, struct algorithm *alg, ULONG bitlen,
                                        const UCHAR *pubkey, ULONG pubkey_len )
 {
@@ -1965,6 +2151,28 @@ NTSTATUS WINAPI BCryptDeriveKey(BCRYPT_SECRET_HANDLE handle, LPCWSTR kdf, BCrypt
     return STATUS_INTERNAL_ERROR;
 }
 
+static void detect_cpu_features( void )
+{
+#if defined(__i386__) || defined(__x86_64__)
+    unsigned int xcr0_lo, xcr0_hi;
+    int regs[4], regs7[4];
+
+    __cpuid( regs, 0 );
+    if (regs[0] < 7) return;
+    __cpuid( regs, 1 );
+    __cpuidex( regs7, 7, 0 );
+
+    /* SHA extensions, the implementation also needs SSSE3 and SSE4.1 */
+    sha_ni_supported = (regs7[1] & 0x20000000) && (regs[2] & 0x00080200) == 0x00080200;
+
+    /* AVX and OSXSAVE, and the OS saving the YMM state */
+    if ((regs[2] & 0x18000000) != 0x18000000) return;
+    __asm__ __volatile__( "xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0) );
+    if ((xcr0_lo & 6) != 6) return;
+    avx2_supported = (regs7[1] & 0x20) != 0;
+#endif
+}
+
 BOOL WINAPI DllMain( HINSTANCE hinst, DWORD reason, LPVOID reserved )
 {
     switch (reason)
@@ -1972,6 +2180,7 @@ BOOL WINAPI DllMain( HINSTANCE hinst, DWORD reason, LPVOID reserved )
     case DLL_PROCESS_ATTACH:
         instance = hinst;
         DisableThreadLibraryCalls( hinst );
+        detect_cpu_features();
         __wine_init_unix_lib( hinst, reason, NULL, &key_funcs );
         break;
     case DLL_PROCESS_DETACH:
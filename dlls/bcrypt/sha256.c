@@ -22,6 +22,10 @@
 
 #include "bcrypt_internal.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
+
 static DWORD ror(DWORD n, int k) { return (n >> k) | (n << (32-k)); }
 #define Ch(x,y,z)  (z ^ (x & (y ^ z)))
 #define Maj(x,y,z) ((x & y) | (z & (x | y)))
@@ -42,80 +46,322 @@ static const DWORD K[64] =
   0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
 };
 
-static void processblock(SHA256_CTX *ctx, const UCHAR *buffer)
+static void processblocks_c(DWORD *state, const UCHAR *buffer, ULONG count)
 {
     DWORD W[64], t1, t2, a, b, c, d, e, f, g, h;
     int i;
 
-    for (i = 0; i < 16; i++)
+    for (; count; count--, buffer += 64)
     {
-        W[i]  = (DWORD)buffer[4*i]<<24;
-        W[i] |= (DWORD)buffer[4*i+1]<<16;
-        W[i] |= (DWORD)buffer[4*i+2]<<8;
-        W[i] |= buffer[4*i+3];
+        for (i = 0; i < 16; i++)
+        {
+            W[i]  = (DWORD)buffer[4*i]<<24;
+            W[i] |= (DWORD)buffer[4*i+1]<<16;
+            W[i] |= (DWORD)buffer[4*i+2]<<8;
+            W[i] |= buffer[4*i+3];
+        }
+
+        for (; i < 64; i++)
+            W[i] = R1(W[i-2]) + W[i-7] + R0(W[i-15]) + W[i-16];
+
+        a = state[0];
+        b = state[1];
+        c = state[2];
+        d = state[3];
+        e = state[4];
+        f = state[5];
+        g = state[6];
+        h = state[7];
+
+        for (i = 0; i < 64; i++)
+        {
+            t1 = h + S1(e) + Ch(e,f,g) + K[i] + W[i];
+            t2 = S0(a) + Maj(a,b,c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
     }
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+
+/* The state is kept as ABEF and CDGH, as expected by the SHA extensions */
+#define SHANI_ROUNDS(w, k) \
+    msg = _mm_add_epi32(w, _mm_loadu_si128((const __m128i *)(k))); \
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg); \
+    state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0e))
+
+/* w0 = W[t-16..t-13] becomes W[t..t+3], w1..w3 hold the following words */
+#define SHANI_SCHEDULE(w0, w1, w2, w3) \
+    w0 = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(w0, w1), _mm_alignr_epi8(w3, w2, 4)), w3)
 
-    for (; i < 64; i++)
-        W[i] = R1(W[i-2]) + W[i-7] + R0(W[i-15]) + W[i-16];
+static void SHANI_TARGET processblocks_shani(DWORD *state, const UCHAR *buffer, ULONG count)
+{
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, save0, save1, msg, tmp, w0, w1, w2, w3;
+    int i;
 
-    a = ctx->h[0];
-    b = ctx->h[1];
-    c = ctx->h[2];
-    d = ctx->h[3];
-    e = ctx->h[4];
-    f = ctx->h[5];
-    g = ctx->h[6];
-    h = ctx->h[7];
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xb1);  /* CDAB */
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1b);  /* EFGH */
+    state0 = _mm_alignr_epi8(tmp, state1, 8);  /* ABEF */
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);  /* CDGH */
 
-    for (i = 0; i < 64; i++)
+    for (; count; count--, buffer += 64)
     {
-        t1 = h + S1(e) + Ch(e,f,g) + K[i] + W[i];
-        t2 = S0(a) + Maj(a,b,c);
-        h = g;
-        g = f;
-        f = e;
-        e = d + t1;
-        d = c;
-        c = b;
-        b = a;
-        a = t1 + t2;
+        save0 = state0;
+        save1 = state1;
+
+        w0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)buffer), bswap);
+        w1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buffer + 16)), bswap);
+        w2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buffer + 32)), bswap);
+        w3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buffer + 48)), bswap);
+        SHANI_ROUNDS(w0, K);
+        SHANI_ROUNDS(w1, K + 4);
+        SHANI_ROUNDS(w2, K + 8);
+        SHANI_ROUNDS(w3, K + 12);
+
+        for (i = 16; i < 64; i += 16)
+        {
+            SHANI_SCHEDULE(w0, w1, w2, w3);
+            SHANI_ROUNDS(w0, K + i);
+            SHANI_SCHEDULE(w1, w2, w3, w0);
+            SHANI_ROUNDS(w1, K + i + 4);
+            SHANI_SCHEDULE(w2, w3, w0, w1);
+            SHANI_ROUNDS(w2, K + i + 8);
+            SHANI_SCHEDULE(w3, w0, w1, w2);
+            SHANI_ROUNDS(w3, K + i + 12);
+        }
+
+        state0 = _mm_add_epi32(state0, save0);
+        state1 = _mm_add_epi32(state1, save1);
     }
 
-    ctx->h[0] += a;
-    ctx->h[1] += b;
-    ctx->h[2] += c;
-    ctx->h[3] += d;
-    ctx->h[4] += e;
-    ctx->h[5] += f;
-    ctx->h[6] += g;
-    ctx->h[7] += h;
+    tmp = _mm_shuffle_epi32(state0, 0x1b);  /* FEBA */
+    state1 = _mm_shuffle_epi32(state1, 0xb1);  /* DCHG */
+    _mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, state1, 0xf0));  /* DCBA */
+    _mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(state1, tmp, 8));  /* HGFE */
 }
 
-static void pad(SHA256_CTX *ctx)
+#define ROR8(x,k)  _mm256_or_si256(_mm256_srli_epi32(x, k), _mm256_slli_epi32(x, 32-(k)))
+#define XOR3(x,y,z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define S0_8(x)    XOR3(ROR8(x,2), ROR8(x,13), ROR8(x,22))
+#define S1_8(x)    XOR3(ROR8(x,6), ROR8(x,11), ROR8(x,25))
+#define R0_8(x)    XOR3(ROR8(x,7), ROR8(x,18), _mm256_srli_epi32(x,3))
+#define R1_8(x)    XOR3(ROR8(x,17), ROR8(x,19), _mm256_srli_epi32(x,10))
+#define Ch8(x,y,z)  _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+#define Maj8(x,y,z) _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_or_si256(x, y)))
+
+/* transpose eight rows of eight 32-bit words */
+static inline void AVX2_TARGET transpose8x8(__m256i *r)
 {
-    ULONG64 r = ctx->len % 64;
+    __m256i t0, t1, t2, t3, t4, t5, t6, t7, u0, u1, u2, u3, u4, u5, u6, u7;
+
+    t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+    u0 = _mm256_unpacklo_epi64(t0, t2);
+    u1 = _mm256_unpackhi_epi64(t0, t2);
+    u2 = _mm256_unpacklo_epi64(t1, t3);
+    u3 = _mm256_unpackhi_epi64(t1, t3);
+    u4 = _mm256_unpacklo_epi64(t4, t6);
+    u5 = _mm256_unpackhi_epi64(t4, t6);
+    u6 = _mm256_unpacklo_epi64(t5, t7);
+    u7 = _mm256_unpackhi_epi64(t5, t7);
+    r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+/* process the same number of blocks for eight independent messages, one per 32-bit lane */
+static void AVX2_TARGET processblocks_avx2_x8(DWORD **state, const UCHAR **buffer, ULONG count)
+{
+    const __m256i bswap = _mm256_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL,
+                                            0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m256i s[8], v[8], W[16], t1, t2;
+    DWORD words[8];
+    ULONG offset;
+    int i, j;
+
+    for (i = 0; i < 8; i++)
+    {
+        for (j = 0; j < 8; j++) words[j] = state[j][i];
+        s[i] = _mm256_loadu_si256((const __m256i *)words);
+    }
+
+    for (offset = 0; count; count--, offset += 64)
+    {
+        for (i = 0; i < 16; i += 8)
+        {
+            for (j = 0; j < 8; j++)
+                W[i + j] = _mm256_loadu_si256((const __m256i *)(buffer[j] + offset + 4 * i));
+            transpose8x8(W + i);
+            for (j = 0; j < 8; j++)
+                W[i + j] = _mm256_shuffle_epi8(W[i + j], bswap);
+        }
+
+        for (i = 0; i < 8; i++) v[i] = s[i];
+
+        for (i = 0; i < 64; i++)
+        {
+            if (i >= 16)
+                W[i & 15] = _mm256_add_epi32(_mm256_add_epi32(R1_8(W[(i - 2) & 15]), W[(i - 7) & 15]),
+                                             _mm256_add_epi32(R0_8(W[(i - 15) & 15]), W[i & 15]));
+            t1 = _mm256_add_epi32(_mm256_add_epi32(v[7], S1_8(v[4])),
+                                  _mm256_add_epi32(Ch8(v[4], v[5], v[6]),
+                                                   _mm256_add_epi32(_mm256_set1_epi32(K[i]), W[i & 15])));
+            t2 = _mm256_add_epi32(S0_8(v[0]), Maj8(v[0], v[1], v[2]));
+            v[7] = v[6];
+            v[6] = v[5];
+            v[5] = v[4];
+            v[4] = _mm256_add_epi32(v[3], t1);
+            v[3] = v[2];
+            v[2] = v[1];
+            v[1] = v[0];
+            v[0] = _mm256_add_epi32(t1, t2);
+        }
+
+        for (i = 0; i < 8; i++) s[i] = _mm256_add_epi32(s[i], v[i]);
+    }
+
+    for (i = 0; i < 8; i++)
+    {
+        _mm256_storeu_si256((__m256i *)words, s[i]);
+        for (j = 0; j < 8; j++) state[j][i] = words[j];
+    }
+}
+
+#endif  /* __i386__ || __x86_64__ */
+
+static void processblocks(DWORD *state, const UCHAR *buffer, ULONG count)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    if (sha_ni_supported)
+    {
+        processblocks_shani(state, buffer, count);
+        return;
+    }
+#endif
+    processblocks_c(state, buffer, count);
+}
 
-    ctx->buf[r++] = 0x80;
+struct job
+{
+    DWORD       *state;
+    const UCHAR *buffer;
+    ULONG        count;    /* number of blocks */
+};
+
+/* Run a set of jobs on independent states. With AVX2, the jobs are spread over eight lanes
+ * as long as enough of them are left; the SHA extensions are faster on a single message. */
+static void process_jobs(struct job *jobs, ULONG count)
+{
+    ULONG i = 0;
 
-    if (r > 56)
+#if defined(__i386__) || defined(__x86_64__)
+    if (avx2_supported && !sha_ni_supported)
     {
-        memset(ctx->buf + r, 0, 64 - r);
-        r = 0;
-        processblock(ctx, ctx->buf);
+        struct job *lanes[8] = { NULL };
+        DWORD *states[8], dummy[8][8];
+        const UCHAR *buffers[8], *any = NULL;
+        ULONG active, blocks, j;
+
+        for (;;)
+        {
+            for (j = 0; j < 8; j++)
+            {
+                while (!lanes[j] && i < count)
+                    if (jobs[i++].count) lanes[j] = &jobs[i - 1];
+            }
+
+            for (j = active = 0, blocks = ~0u; j < 8; j++)
+            {
+                if (!lanes[j]) continue;
+                active++;
+                blocks = min(blocks, lanes[j]->count);
+            }
+            if (active < 3) break;
+
+            for (j = 0; j < 8; j++) if (lanes[j]) any = lanes[j]->buffer;
+            for (j = 0; j < 8; j++)
+            {
+                /* idle lanes hash data from an active lane into a scratch state */
+                states[j] = lanes[j] ? lanes[j]->state : dummy[j];
+                buffers[j] = lanes[j] ? lanes[j]->buffer : any;
+            }
+            processblocks_avx2_x8(states, buffers, blocks);
+
+            for (j = 0; j < 8; j++)
+            {
+                if (!lanes[j]) continue;
+                lanes[j]->buffer += blocks * 64;
+                if (!(lanes[j]->count -= blocks)) lanes[j] = NULL;
+            }
+        }
+
+        for (j = 0; j < 8; j++)
+            if (lanes[j]) processblocks(lanes[j]->state, lanes[j]->buffer, lanes[j]->count);
     }
+#endif
+    for (; i < count; i++) processblocks(jobs[i].state, jobs[i].buffer, jobs[i].count);
+}
+
+/* Build the final blocks in buffer, returns their count */
+static ULONG pad(SHA256_CTX *ctx, UCHAR *buffer)
+{
+    ULONG64 r = ctx->len % 64, len = ctx->len * 8;
+    ULONG blocks = r < 56 ? 1 : 2;
+    UCHAR *end = buffer + blocks * 64;
+
+    memcpy(buffer, ctx->buf, r);
+    buffer[r++] = 0x80;
+    memset(buffer + r, 0, blocks * 64 - 8 - r);
+    end[-8] = len >> 56;
+    end[-7] = len >> 48;
+    end[-6] = len >> 40;
+    end[-5] = len >> 32;
+    end[-4] = len >> 24;
+    end[-3] = len >> 16;
+    end[-2] = len >> 8;
+    end[-1] = len;
+    return blocks;
+}
 
-    memset(ctx->buf + r, 0, 56 - r);
-    ctx->len *= 8;
-    ctx->buf[56] = ctx->len >> 56;
-    ctx->buf[57] = ctx->len >> 48;
-    ctx->buf[58] = ctx->len >> 40;
-    ctx->buf[59] = ctx->len >> 32;
-    ctx->buf[60] = ctx->len >> 24;
-    ctx->buf[61] = ctx->len >> 16;
-    ctx->buf[62] = ctx->len >> 8;
-    ctx->buf[63] = ctx->len;
-
-    processblock(ctx, ctx->buf);
+static void output(SHA256_CTX *ctx, UCHAR *buffer)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        buffer[4*i]   = ctx->h[i] >> 24;
+        buffer[4*i+1] = ctx->h[i] >> 16;
+        buffer[4*i+2] = ctx->h[i] >> 8;
+        buffer[4*i+3] = ctx->h[i];
+    }
 }
 
 void sha256_init(SHA256_CTX *ctx)
@@ -131,12 +377,15 @@ void sha256_init(SHA256_CTX *ctx)
     ctx->h[7] = 0x5be0cd19;
 }
 
-void sha256_update(SHA256_CTX *ctx, const UCHAR *buffer, ULONG len)
+/* Buffer the data that doesn't fill a block, and return the full blocks to process in job */
+static void prepare_update(SHA256_CTX *ctx, const UCHAR *buffer, ULONG len, struct job *job)
 {
     const UCHAR *p = buffer;
     ULONG64 r = ctx->len % 64;
 
     ctx->len += len;
+    job->state = ctx->h;
+    job->count = 0;
     if (r)
     {
         if (len < 64 - r)
@@ -147,23 +396,60 @@ void sha256_update(SHA256_CTX *ctx, const UCHAR *buffer, ULONG len)
         memcpy(ctx->buf + r, p, 64 - r);
         len -= 64 - r;
         p += 64 - r;
-        processblock(ctx, ctx->buf);
+        processblocks(ctx->h, ctx->buf, 1);
     }
-    for (; len >= 64; len -= 64, p += 64)
-        processblock(ctx, p);
-    memcpy(ctx->buf, p, len);
+    job->buffer = p;
+    job->count = len / 64;
+    memcpy(ctx->buf, p + len / 64 * 64, len % 64);
+}
+
+void sha256_update(SHA256_CTX *ctx, const UCHAR *buffer, ULONG len)
+{
+    struct job job;
+
+    prepare_update(ctx, buffer, len, &job);
+    if (job.count) processblocks(job.state, job.buffer, job.count);
 }
 
 void sha256_finalize(SHA256_CTX *ctx, UCHAR *buffer)
 {
-    int i;
+    UCHAR block[128];
 
-    pad(ctx);
-    for (i = 0; i < 8; i++)
+    processblocks(ctx->h, block, pad(ctx, block));
+    output(ctx, buffer);
+}
+
+#define MAX_JOBS 32
+
+void sha256_update_multi(SHA256_CTX **ctx, const UCHAR **buffer, const ULONG *len, ULONG count)
+{
+    struct job jobs[MAX_JOBS];
+    ULONG i, n;
+
+    for (; count; count -= n, ctx += n, buffer += n, len += n)
     {
-        buffer[4*i]   = ctx->h[i] >> 24;
-        buffer[4*i+1] = ctx->h[i] >> 16;
-        buffer[4*i+2] = ctx->h[i] >> 8;
-        buffer[4*i+3] = ctx->h[i];
+        n = min(count, MAX_JOBS);
+        for (i = 0; i < n; i++) prepare_update(ctx[i], buffer[i], len[i], &jobs[i]);
+        process_jobs(jobs, n);
+    }
+}
+
+void sha256_finalize_multi(SHA256_CTX **ctx, UCHAR **buffer, ULONG count)
+{
+    struct job jobs[MAX_JOBS];
+    UCHAR blocks[MAX_JOBS][128];
+    ULONG i, n;
+
+    for (; count; count -= n, ctx += n, buffer += n)
+    {
+        n = min(count, MAX_JOBS);
+        for (i = 0; i < n; i++)
+        {
+            jobs[i].state = ctx[i]->h;
+            jobs[i].buffer = blocks[i];
+            jobs[i].count = pad(ctx[i], blocks[i]);
+        }
+        process_jobs(jobs, n);
+        for (i = 0; i < n; i++) output(ctx[i], buffer[i]);
     }
 }
@@ -22,6 +22,10 @@
 
 #include "bcrypt_internal.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
+
 static ULONG64 ror(ULONG64 n, int k) { return (n >> k) | (n << (64-k)); }
 #define Ch(x,y,z)  (z ^ (x & (y ^ z)))
 #define Maj(x,y,z) ((x & y) | (z & (x | y)))
@@ -55,83 +59,247 @@ static const ULONG64 K[80] =
     ULL(0x4cc5d4be,0xcb3e42b6), ULL(0x597f299c,0xfc657e2a), ULL(0x5fcb6fab,0x3ad6faec), ULL(0x6c44198c,0x4a475817)
 };
 
-static void processblock(SHA512_CTX *ctx, const UCHAR *buffer)
+static void processblocks(ULONG64 *state, const UCHAR *buffer, ULONG count)
 {
     ULONG64 W[80], t1, t2, a, b, c, d, e, f, g, h;
     int i;
 
-    for (i = 0; i < 16; i++)
+    for (; count; count--, buffer += 128)
     {
-        W[i]  = (ULONG64)buffer[8*i]<<56;
-        W[i] |= (ULONG64)buffer[8*i+1]<<48;
-        W[i] |= (ULONG64)buffer[8*i+2]<<40;
-        W[i] |= (ULONG64)buffer[8*i+3]<<32;
-        W[i] |= (ULONG64)buffer[8*i+4]<<24;
-        W[i] |= (ULONG64)buffer[8*i+5]<<16;
-        W[i] |= (ULONG64)buffer[8*i+6]<<8;
-        W[i] |= buffer[8*i+7];
+        for (i = 0; i < 16; i++)
+        {
+            W[i]  = (ULONG64)buffer[8*i]<<56;
+            W[i] |= (ULONG64)buffer[8*i+1]<<48;
+            W[i] |= (ULONG64)buffer[8*i+2]<<40;
+            W[i] |= (ULONG64)buffer[8*i+3]<<32;
+            W[i] |= (ULONG64)buffer[8*i+4]<<24;
+            W[i] |= (ULONG64)buffer[8*i+5]<<16;
+            W[i] |= (ULONG64)buffer[8*i+6]<<8;
+            W[i] |= buffer[8*i+7];
+        }
+
+        for (; i < 80; i++)
+            W[i] = R1(W[i-2]) + W[i-7] + R0(W[i-15]) + W[i-16];
+
+        a = state[0];
+        b = state[1];
+        c = state[2];
+        d = state[3];
+        e = state[4];
+        f = state[5];
+        g = state[6];
+        h = state[7];
+
+        for (i = 0; i < 80; i++)
+        {
+            t1 = h + S1(e) + Ch(e,f,g) + K[i] + W[i];
+            t2 = S0(a) + Maj(a,b,c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
     }
+}
 
-    for (; i < 80; i++)
-        W[i] = R1(W[i-2]) + W[i-7] + R0(W[i-15]) + W[i-16];
+#if defined(__i386__) || defined(__x86_64__)
 
-    a = ctx->h[0];
-    b = ctx->h[1];
-    c = ctx->h[2];
-    d = ctx->h[3];
-    e = ctx->h[4];
-    f = ctx->h[5];
-    g = ctx->h[6];
-    h = ctx->h[7];
+#define ROR4(x,k)  _mm256_or_si256(_mm256_srli_epi64(x, k), _mm256_slli_epi64(x, 64-(k)))
+#define XOR3(x,y,z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define S0_4(x)    XOR3(ROR4(x,28), ROR4(x,34), ROR4(x,39))
+#define S1_4(x)    XOR3(ROR4(x,14), ROR4(x,18), ROR4(x,41))
+#define R0_4(x)    XOR3(ROR4(x,1), ROR4(x,8), _mm256_srli_epi64(x,7))
+#define R1_4(x)    XOR3(ROR4(x,19), ROR4(x,61), _mm256_srli_epi64(x,6))
+#define Ch4(x,y,z)  _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+#define Maj4(x,y,z) _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_or_si256(x, y)))
+
+/* transpose four rows of four 64-bit words */
+static inline void AVX2_TARGET transpose4x4(__m256i *r)
+{
+    __m256i t0, t1, t2, t3;
+
+    t0 = _mm256_unpacklo_epi64(r[0], r[1]);
+    t1 = _mm256_unpackhi_epi64(r[0], r[1]);
+    t2 = _mm256_unpacklo_epi64(r[2], r[3]);
+    t3 = _mm256_unpackhi_epi64(r[2], r[3]);
+    r[0] = _mm256_permute2x128_si256(t0, t2, 0x20);
+    r[1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+    r[2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+    r[3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+/* process the same number of blocks for four independent messages, one per 64-bit lane */
+static void AVX2_TARGET processblocks_avx2_x4(ULONG64 **state, const UCHAR **buffer, ULONG count)
+{
+    const __m256i bswap = _mm256_set_epi64x(0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL,
+                                            0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL);
+    __m256i s[8], v[8], W[16], t1, t2;
+    ULONG64 words[4];
+    ULONG offset;
+    int i, j;
+
+    for (i = 0; i < 8; i++)
+    {
+        for (j = 0; j < 4; j++) words[j] = state[j][i];
+        s[i] = _mm256_loadu_si256((const __m256i *)words);
+    }
 
-    for (i = 0; i < 80; i++)
+    for (offset = 0; count; count--, offset += 128)
     {
-        t1 = h + S1(e) + Ch(e,f,g) + K[i] + W[i];
-        t2 = S0(a) + Maj(a,b,c);
-        h = g;
-        g = f;
-        f = e;
-        e = d + t1;
-        d = c;
-        c = b;
-        b = a;
-        a = t1 + t2;
+        for (i = 0; i < 16; i += 4)
+        {
+            for (j = 0; j < 4; j++)
+                W[i + j] = _mm256_loadu_si256((const __m256i *)(buffer[j] + offset + 8 * i));
+            transpose4x4(W + i);
+            for (j = 0; j < 4; j++)
+                W[i + j] = _mm256_shuffle_epi8(W[i + j], bswap);
+        }
+
+        for (i = 0; i < 8; i++) v[i] = s[i];
+
+        for (i = 0; i < 80; i++)
+        {
+            if (i >= 16)
+                W[i & 15] = _mm256_add_epi64(_mm256_add_epi64(R1_4(W[(i - 2) & 15]), W[(i - 7) & 15]),
+                                             _mm256_add_epi64(R0_4(W[(i - 15) & 15]), W[i & 15]));
+            t1 = _mm256_add_epi64(_mm256_add_epi64(v[7], S1_4(v[4])),
+                                  _mm256_add_epi64(Ch4(v[4], v[5], v[6]),
+                                                   _mm256_add_epi64(_mm256_set1_epi64x(K[i]), W[i & 15])));
+            t2 = _mm256_add_epi64(S0_4(v[0]), Maj4(v[0], v[1], v[2]));
+            v[7] = v[6];
+            v[6] = v[5];
+            v[5] = v[4];
+            v[4] = _mm256_add_epi64(v[3], t1);
+            v[3] = v[2];
+            v[2] = v[1];
+            v[1] = v[0];
+            v[0] = _mm256_add_epi64(t1, t2);
+        }
+
+        for (i = 0; i < 8; i++) s[i] = _mm256_add_epi64(s[i], v[i]);
     }
 
-    ctx->h[0] += a;
-    ctx->h[1] += b;
-    ctx->h[2] += c;
-    ctx->h[3] += d;
-    ctx->h[4] += e;
-    ctx->h[5] += f;
-    ctx->h[6] += g;
-    ctx->h[7] += h;
+    for (i = 0; i < 8; i++)
+    {
+        _mm256_storeu_si256((__m256i *)words, s[i]);
+        for (j = 0; j < 4; j++) state[j][i] = words[j];
+    }
 }
 
-static void pad(SHA512_CTX *ctx)
+#endif  /* __i386__ || __x86_64__ */
+
+struct job
 {
-    ULONG64 r = ctx->len % 128;
+    ULONG64     *state;
+    const UCHAR *buffer;
+    ULONG        count;    /* number of blocks */
+};
 
-    ctx->buf[r++] = 0x80;
-    if (r > 112)
+/* Run a set of jobs on independent states, spread over four AVX2 lanes as long as
+ * at least two of them are left */
+static void process_jobs(struct job *jobs, ULONG count)
+{
+    ULONG i = 0;
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (avx2_supported)
     {
-        memset(ctx->buf + r, 0, 128 - r);
-        r = 0;
-        processblock(ctx, ctx->buf);
+        struct job *lanes[4] = { NULL };
+        ULONG64 *states[4], dummy[4][8];
+        const UCHAR *buffers[4], *any = NULL;
+        ULONG active, blocks, j;
+
+        for (;;)
+        {
+            for (j = 0; j < 4; j++)
+            {
+                while (!lanes[j] && i < count)
+                    if (jobs[i++].count) lanes[j] = &jobs[i - 1];
+            }
+
+            for (j = active = 0, blocks = ~0u; j < 4; j++)
+            {
+                if (!lanes[j]) continue;
+                active++;
+                blocks = min(blocks, lanes[j]->count);
+            }
+            if (active < 2) break;
+
+            for (j = 0; j < 4; j++) if (lanes[j]) any = lanes[j]->buffer;
+            for (j = 0; j < 4; j++)
+            {
+                /* idle lanes hash data from an active lane into a scratch state */
+                states[j] = lanes[j] ? lanes[j]->state : dummy[j];
+                buffers[j] = lanes[j] ? lanes[j]->buffer : any;
+            }
+            processblocks_avx2_x4(states, buffers, blocks);
+
+            for (j = 0; j < 4; j++)
+            {
+                if (!lanes[j]) continue;
+                lanes[j]->buffer += blocks * 128;
+                if (!(lanes[j]->count -= blocks)) lanes[j] = NULL;
+            }
+        }
+
+        for (j = 0; j < 4; j++)
+            if (lanes[j]) processblocks(lanes[j]->state, lanes[j]->buffer, lanes[j]->count);
     }
+#endif
+    for (; i < count; i++) processblocks(jobs[i].state, jobs[i].buffer, jobs[i].count);
+}
+
+/* Build the final blocks in buffer, returns their count */
+static ULONG pad(SHA512_CTX *ctx, UCHAR *buffer)
+{
+    ULONG64 r = ctx->len % 128, len = ctx->len * 8;
+    ULONG blocks = r < 112 ? 1 : 2;
+    UCHAR *end = buffer + blocks * 128;
+
+    memcpy(buffer, ctx->buf, r);
+    buffer[r++] = 0x80;
+    memset(buffer + r, 0, blocks * 128 - 8 - r);
+    end[-8] = len >> 56;
+    end[-7] = len >> 48;
+    end[-6] = len >> 40;
+    end[-5] = len >> 32;
+    end[-4] = len >> 24;
+    end[-3] = len >> 16;
+    end[-2] = len >> 8;
+    end[-1] = len;
+    return blocks;
+}
 
-    memset(ctx->buf + r, 0, 120 - r);
-    ctx->len *= 8;
-    ctx->buf[120] = ctx->len >> 56;
-    ctx->buf[121] = ctx->len >> 48;
-    ctx->buf[122] = ctx->len >> 40;
-    ctx->buf[123] = ctx->len >> 32;
-    ctx->buf[124] = ctx->len >> 24;
-    ctx->buf[125] = ctx->len >> 16;
-    ctx->buf[126] = ctx->len >> 8;
-    ctx->buf[127] = ctx->len;
+static void output(SHA512_CTX *ctx, UCHAR *buffer, ULONG size)
+{
+    UCHAR hash[64];
+    int i;
 
-    processblock(ctx, ctx->buf);
+    for (i = 0; i < 8; i++)
+    {
+        hash[8*i] = ctx->h[i] >> 56;
+        hash[8*i+1] = ctx->h[i] >> 48;
+        hash[8*i+2] = ctx->h[i] >> 40;
+        hash[8*i+3] = ctx->h[i] >> 32;
+        hash[8*i+4] = ctx->h[i] >> 24;
+        hash[8*i+5] = ctx->h[i] >> 16;
+        hash[8*i+6] = ctx->h[i] >> 8;
+        hash[8*i+7] = ctx->h[i];
+    }
+    memcpy(buffer, hash, size);
 }
 
 void sha512_init(SHA512_CTX *ctx)
@@ -147,12 +315,15 @@ void sha512_init(SHA512_CTX *ctx)
     ctx->h[7] = ULL(0x5be0cd19,0x137e2179);
 }
 
-void sha512_update(SHA512_CTX *ctx, const UCHAR *buffer, ULONG len)
+/* Buffer the data that doesn't fill a block, and return the full blocks to process in job */
+static void prepare_update(SHA512_CTX *ctx, const UCHAR *buffer, ULONG len, struct job *job)
 {
     const UCHAR *p = buffer;
     unsigned r = ctx->len % 128;
 
     ctx->len += len;
+    job->state = ctx->h;
+    job->count = 0;
     if (r)
     {
         if (len < 128 - r)
@@ -163,31 +334,27 @@ void sha512_update(SHA512_CTX *ctx, const UCHAR *buffer, ULONG len)
         memcpy(ctx->buf + r, p, 128 - r);
         len -= 128 - r;
         p += 128 - r;
-        processblock(ctx, ctx->buf);
+        processblocks(ctx->h, ctx->buf, 1);
     }
+    job->buffer = p;
+    job->count = len / 128;
+    memcpy(ctx->buf, p + len / 128 * 128, len % 128);
+}
 
-    for (; len >= 128; len -= 128, p += 128)
-        processblock(ctx, p);
+void sha512_update(SHA512_CTX *ctx, const UCHAR *buffer, ULONG len)
+{
+    struct job job;
 
-    memcpy(ctx->buf, p, len);
+    prepare_update(ctx, buffer, len, &job);
+    if (job.count) processblocks(job.state, job.buffer, job.count);
 }
 
 void sha512_finalize(SHA512_CTX *ctx, UCHAR *buffer)
 {
-    int i;
+    UCHAR block[256];
 
-    pad(ctx);
-    for (i = 0; i < 8; i++)
-    {
-        buffer[8*i] = ctx->h[i] >> 56;
-        buffer[8*i+1] = ctx->h[i] >> 48;
-        buffer[8*i+2] = ctx->h[i] >> 40;
-        buffer[8*i+3] = ctx->h[i] >> 32;
-        buffer[8*i+4] = ctx->h[i] >> 24;
-        buffer[8*i+5] = ctx->h[i] >> 16;
-        buffer[8*i+6] = ctx->h[i] >> 8;
-        buffer[8*i+7] = ctx->h[i];
-    }
+    processblocks(ctx->h, block, pad(ctx, block));
+    output(ctx, buffer, 64);
 }
 
 void sha384_init(SHA512_CTX *ctx)
@@ -205,8 +372,53 @@ void sha384_init(SHA512_CTX *ctx)
 
 void sha384_finalize(SHA512_CTX *ctx, UCHAR *buffer)
 {
-    UCHAR buffer512[64];
+    UCHAR block[256];
+
+    processblocks(ctx->h, block, pad(ctx, block));
+    output(ctx, buffer, 48);
+}
+
+#define MAX_JOBS 16
+
+void sha512_update_multi(SHA512_CTX **ctx, const UCHAR **buffer, const ULONG *len, ULONG count)
+{
+    struct job jobs[MAX_JOBS];
+    ULONG i, n;
+
+    for (; count; count -= n, ctx += n, buffer += n, len += n)
+    {
+        n = min(count, MAX_JOBS);
+        for (i = 0; i < n; i++) prepare_update(ctx[i], buffer[i], len[i], &jobs[i]);
+        process_jobs(jobs, n);
+    }
+}
+
+static void finalize_multi(SHA512_CTX **ctx, UCHAR **buffer, ULONG count, ULONG size)
+{
+    struct job jobs[MAX_JOBS];
+    UCHAR blocks[MAX_JOBS][256];
+    ULONG i, n;
 
-    sha512_finalize(ctx, buffer512);
-    memcpy(buffer, buffer512, 48);
+    for (; count; count -= n, ctx += n, buffer += n)
+    {
+        n = min(count, MAX_JOBS);
+        for (i = 0; i < n; i++)
+        {
+            jobs[i].state = ctx[i]->h;
+            jobs[i].buffer = blocks[i];
+            jobs[i].count = pad(ctx[i], blocks[i]);
+        }
+        process_jobs(jobs, n);
+        for (i = 0; i < n; i++) output(ctx[i], buffer[i], size);
+    }
+}
+
+void sha512_finalize_multi(SHA512_CTX **ctx, UCHAR **buffer, ULONG count)
+{
+    finalize_multi(ctx, buffer, count, 64);
+}
+
+void sha384_finalize_multi(SHA512_CTX **ctx, UCHAR **buffer, ULONG count)
+{
+    finalize_multi(ctx, buffer, count, 48);
 }
@@ -30,6 +30,8 @@
 static NTSTATUS (WINAPI *pBCryptCloseAlgorithmProvider)(BCRYPT_ALG_HANDLE, ULONG);
 static NTSTATUS (WINAPI *pBCryptCreateHash)(BCRYPT_ALG_HANDLE, BCRYPT_HASH_HANDLE *, PUCHAR, ULONG, PUCHAR,
                                             ULONG, ULONG);
+static NTSTATUS (WINAPI *pBCryptCreateMultiHash)(BCRYPT_ALG_HANDLE, BCRYPT_HASH_HANDLE *, ULONG, PUCHAR, ULONG, PUCHAR,
+                                                 ULONG, ULONG);
 static NTSTATUS (WINAPI *pBCryptDecrypt)(BCRYPT_KEY_HANDLE, PUCHAR, ULONG, VOID *, PUCHAR, ULONG, PUCHAR, ULONG,
                                          ULONG *, ULONG);
 static NTSTATUS (WINAPI *pBCryptDeriveKeyCapi)(BCRYPT_HASH_HANDLE, BCRYPT_ALG_HANDLE, UCHAR *, ULONG, ULONG);
@@ -60,6 +62,7 @@ static NTSTATUS (WINAPI *pBCryptImportKey)(BCRYPT_ALG_HANDLE, BCRYPT_KEY_HANDLE,
 static NTSTATUS (WINAPI *pBCryptImportKeyPair)(BCRYPT_ALG_HANDLE, BCRYPT_KEY_HANDLE, LPCWSTR, BCRYPT_KEY_HANDLE *,
                                                UCHAR *, ULONG, ULONG);
 static NTSTATUS (WINAPI *pBCryptOpenAlgorithmProvider)(BCRYPT_ALG_HANDLE *, LPCWSTR, LPCWSTR, ULONG);
+static NTSTATUS (WINAPI *pBCryptProcessMultiOperations)(BCRYPT_HANDLE, BCRYPT_MULTI_OPERATION_TYPE, void *, ULONG, ULONG);
 static NTSTATUS (WINAPI *pBCryptSetProperty)(BCRYPT_HANDLE, LPCWSTR, PUCHAR, ULONG, ULONG);
 static NTSTATUS (WINAPI *pBCryptSignHash)(BCRYPT_KEY_HANDLE, void *, UCHAR *, ULONG, UCHAR *, ULONG, ULONG *, ULONG);
 static NTSTATUS (WINAPI *pBCryptVerifySignature)(BCRYPT_KEY_HANDLE, VOID *, UCHAR *, ULONG, UCHAR *, ULONG, ULONG);
@@ -465,6 +468,101 @@ static void test_BcryptHash(void)
     ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
 }
 
+static void test_multi_hash(const WCHAR *alg_name, ULONG flags, ULONG hash_len)
+{
+    BCRYPT_MULTI_OBJECT_LENGTH_STRUCT len;
+    BCRYPT_MULTI_HASH_OPERATION ops[24];
+    BCRYPT_ALG_HANDLE alg, alg_single;
+    BCRYPT_HASH_HANDLE hash;
+    UCHAR data[8][300], output[8][64], expected[64];
+    UCHAR *key = flags ? (UCHAR *)"key" : NULL;
+    ULONG i, size, key_len = flags ? 3 : 0;
+    NTSTATUS ret;
+
+    ret = pBCryptOpenAlgorithmProvider(&alg, alg_name, MS_PRIMITIVE_PROVIDER, flags | BCRYPT_MULTI_FLAG);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ret = pBCryptOpenAlgorithmProvider(&alg_single, alg_name, MS_PRIMITIVE_PROVIDER, flags);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    size = 0;
+    memset(&len, 0, sizeof(len));
+    ret = pBCryptGetProperty(alg, BCRYPT_MULTI_OBJECT_LENGTH, (UCHAR *)&len, sizeof(len), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(size == sizeof(len), "got %u\n", size);
+    ok(len.cbPerObject > 0, "got %u\n", len.cbPerObject);
+    ok(len.cbPerElement > 0, "got %u\n", len.cbPerElement);
+
+    ret = pBCryptCreateMultiHash(alg_single, &hash, 8, NULL, 0, key, key_len, 0);
+    ok(ret == STATUS_INVALID_PARAMETER, "got %08x\n", ret);
+
+    hash = NULL;
+    ret = pBCryptCreateMultiHash(alg, &hash, 8, NULL, 0, key, key_len, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(hash != NULL, "hash not set\n");
+
+    for (i = 0; i < 8; i++) memset(data[i], 'a' + i, sizeof(data[i]));
+
+    /* messages of different lengths, hashed in two pieces */
+    for (i = 0; i < 8; i++)
+    {
+        ops[i].iHash = i;
+        ops[i].hashOperation = BCRYPT_HASH_OPERATION_HASH_DATA;
+        ops[i].pbBuffer = data[i];
+        ops[i].cbBuffer = 37 * i;
+        ops[8 + i].iHash = 7 - i;
+        ops[8 + i].hashOperation = BCRYPT_HASH_OPERATION_HASH_DATA;
+        ops[8 + i].pbBuffer = data[7 - i] + 37 * (7 - i);
+        ops[8 + i].cbBuffer = 11 * i;
+        ops[16 + i].iHash = i;
+        ops[16 + i].hashOperation = BCRYPT_HASH_OPERATION_FINISH_HASH;
+        ops[16 + i].pbBuffer = output[i];
+        ops[16 + i].cbBuffer = hash_len;
+    }
+    ret = pBCryptProcessMultiOperations(hash, BCRYPT_OPERATION_TYPE_HASH, ops, sizeof(ops), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    for (i = 0; i < 8; i++)
+    {
+        ret = pBCryptHash(alg_single, key, key_len, data[i], 37 * i + 11 * (7 - i), expected, hash_len);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        ok(!memcmp(output[i], expected, hash_len), "%s %u: wrong hash\n", wine_dbgstr_w(alg_name), i);
+    }
+
+    /* elements are reset after they are finished */
+    ret = pBCryptProcessMultiOperations(hash, BCRYPT_OPERATION_TYPE_HASH, ops + 16, sizeof(*ops), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ret = pBCryptHash(alg_single, key, key_len, NULL, 0, expected, hash_len);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ok(!memcmp(output[0], expected, hash_len), "%s: wrong hash\n", wine_dbgstr_w(alg_name));
+
+    ops[0].iHash = 8;
+    ret = pBCryptProcessMultiOperations(hash, BCRYPT_OPERATION_TYPE_HASH, ops, sizeof(*ops), 0);
+    ok(ret == STATUS_INVALID_PARAMETER, "got %08x\n", ret);
+
+    ret = pBCryptProcessMultiOperations(hash, BCRYPT_OPERATION_TYPE_HASH, ops, sizeof(*ops) - 1, 0);
+    ok(ret == STATUS_INVALID_PARAMETER, "got %08x\n", ret);
+
+    ret = pBCryptDestroyHash(hash);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    pBCryptCloseAlgorithmProvider(alg_single, 0);
+    pBCryptCloseAlgorithmProvider(alg, 0);
+}
+
+static void test_BCryptCreateMultiHash(void)
+{
+    if (!pBCryptCreateMultiHash) /* < Win10 1803 */
+    {
+        win_skip("BCryptCreateMultiHash is not available\n");
+        return;
+    }
+
+    test_multi_hash(BCRYPT_SHA256_ALGORITHM, 0, 32);
+    test_multi_hash(BCRYPT_SHA384_ALGORITHM, 0, 48);
+    test_multi_hash(BCRYPT_SHA512_ALGORITHM, 0, 64);
+    test_multi_hash(BCRYPT_SHA256_ALGORITHM, BCRYPT_ALG_HANDLE_HMAC_FLAG, 32);
+    test_multi_hash(BCRYPT_SHA1_ALGORITHM, 0, 20);
+}
+
 /* test vectors from RFC 6070 */
 static UCHAR password[] = "password";
 static UCHAR salt[] = "salt";
@@ -2839,6 +2937,7 @@ START_TEST(bcrypt)
 
     pBCryptCloseAlgorithmProvider = (void *)GetProcAddress(module, "BCryptCloseAlgorithmProvider");
     pBCryptCreateHash = (void *)GetProcAddress(module, "BCryptCreateHash");
+    pBCryptCreateMultiHash = (void *)GetProcAddress(module, "BCryptCreateMultiHash");
     pBCryptDecrypt = (void *)GetProcAddress(module, "BCryptDecrypt");
     pBCryptDeriveKeyCapi = (void *)GetProcAddress(module, "BCryptDeriveKeyCapi");
     pBCryptDeriveKeyPBKDF2 = (void *)GetProcAddress(module, "BCryptDeriveKeyPBKDF2");
@@ -2863,6 +2962,7 @@ START_TEST(bcrypt)
     pBCryptImportKey = (void *)GetProcAddress(module, "BCryptImportKey");
     pBCryptImportKeyPair = (void *)GetProcAddress(module, "BCryptImportKeyPair");
     pBCryptOpenAlgorithmProvider = (void *)GetProcAddress(module, "BCryptOpenAlgorithmProvider");
+    pBCryptProcessMultiOperations = (void *)GetProcAddress(module, "BCryptProcessMultiOperations");
     pBCryptSetProperty = (void *)GetProcAddress(module, "BCryptSetProperty");
     pBCryptSignHash = (void *)GetProcAddress(module, "BCryptSignHash");
     pBCryptVerifySignature = (void *)GetProcAddress(module, "BCryptVerifySignature");
@@ -2874,6 +2974,7 @@ START_TEST(bcrypt)
     test_BCryptGetFipsAlgorithmMode();
     test_hashes();
     test_BcryptHash();
+    test_BCryptCreateMultiHash();
     test_BcryptDeriveKeyPBKDF2();
     test_rng();
     test_3des();
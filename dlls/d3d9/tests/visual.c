@@ -26912,12 +26912,248 @@ static void test_sample_mask(void)
     DestroyWindow(window);
 }
 
+static void test_shader_cache_child(void)
+{
+    static const struct vec3 quad[] =
+    {
+        {-1.0f, -1.0f, 0.1f},
+        {-1.0f,  1.0f, 0.1f},
+        { 1.0f, -1.0f, 0.1f},
+        { 1.0f,  1.0f, 0.1f},
+    };
+    static const DWORD vs_code[] =
+    {
+        0xfffe0101,                                                             /* vs_1_1                         */
+        0x0000001f, 0x80000000, 0x900f0000,                                     /* dcl_position v0                */
+        0x00000001, 0xc00f0000, 0x90e40000,                                     /* mov oPos, v0                   */
+        0x0000ffff
+    };
+    static const DWORD ps_code[] =
+    {
+        0xffff0101,                                                             /* ps_1_1                         */
+        0x00000051, 0xa00f0000, 0x00000000, 0x3f800000, 0x00000000, 0x3f800000, /* def c0, 0.0, 1.0, 0.0, 1.0     */
+        0x00000001, 0x800f0000, 0xa0e40000,                                     /* mov r0, c0                     */
+        0x0000ffff
+    };
+    IDirect3DVertexShader9 *vs;
+    IDirect3DPixelShader9 *ps;
+    IDirect3DDevice9 *device;
+    IDirect3D9 *d3d;
+    D3DCOLOR color;
+    ULONG refcount;
+    D3DCAPS9 caps;
+    HWND window;
+    HRESULT hr;
+
+    window = create_window();
+    d3d = Direct3DCreate9(D3D_SDK_VERSION);
+    ok(!!d3d, "Failed to create a D3D object.\n");
+    if (!(device = create_device(d3d, window, window, TRUE)))
+    {
+        skip("Failed to create a D3D device, skipping tests.\n");
+        goto done;
+    }
+
+    hr = IDirect3DDevice9_GetDeviceCaps(device, &caps);
+    ok(SUCCEEDED(hr), "Failed to get device caps, hr %#x.\n", hr);
+    if (caps.VertexShaderVersion < D3DVS_VERSION(1, 1) || caps.PixelShaderVersion < D3DPS_VERSION(1, 1))
+    {
+        skip("No shader model 1.1 support, skipping tests.\n");
+        IDirect3DDevice9_Release(device);
+        goto done;
+    }
+
+    hr = IDirect3DDevice9_CreateVertexShader(device, vs_code, &vs);
+    ok(SUCCEEDED(hr), "Failed to create vertex shader, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_CreatePixelShader(device, ps_code, &ps);
+    ok(SUCCEEDED(hr), "Failed to create pixel shader, hr %#x.\n", hr);
+
+    hr = IDirect3DDevice9_SetVertexShader(device, vs);
+    ok(SUCCEEDED(hr), "Failed to set vertex shader, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetPixelShader(device, ps);
+    ok(SUCCEEDED(hr), "Failed to set pixel shader, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetFVF(device, D3DFVF_XYZ);
+    ok(SUCCEEDED(hr), "Failed to set FVF, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetRenderState(device, D3DRS_ZENABLE, D3DZB_FALSE);
+    ok(SUCCEEDED(hr), "Failed to disable depth test, hr %#x.\n", hr);
+
+    hr = IDirect3DDevice9_Clear(device, 0, NULL, D3DCLEAR_TARGET, 0xffff0000, 1.0f, 0);
+    ok(SUCCEEDED(hr), "Failed to clear, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_BeginScene(device);
+    ok(SUCCEEDED(hr), "Failed to begin scene, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_DrawPrimitiveUP(device, D3DPT_TRIANGLESTRIP, 2, quad, sizeof(*quad));
+    ok(SUCCEEDED(hr), "Failed to draw, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_EndScene(device);
+    ok(SUCCEEDED(hr), "Failed to end scene, hr %#x.\n", hr);
+
+    color = getPixelColor(device, 320, 240);
+    ok(color_match(color, 0x0000ff00, 1), "Got unexpected color 0x%08x.\n", color);
+
+    IDirect3DPixelShader9_Release(ps);
+    IDirect3DVertexShader9_Release(vs);
+    refcount = IDirect3DDevice9_Release(device);
+    ok(!refcount, "Device has %u references left.\n", refcount);
+done:
+    IDirect3D9_Release(d3d);
+    DestroyWindow(window);
+}
+
+struct shader_cache_file
+{
+    char name[MAX_PATH];
+    FILETIME write_time;
+};
+
+static unsigned int get_shader_cache_files(const char *path, struct shader_cache_file *files, unsigned int max_count)
+{
+    WIN32_FIND_DATAA data;
+    char pattern[MAX_PATH];
+    unsigned int count = 0;
+    HANDLE find;
+
+    sprintf(pattern, "%s\\*.bin", path);
+    if ((find = FindFirstFileA(pattern, &data)) == INVALID_HANDLE_VALUE)
+        return 0;
+    do
+    {
+        if (count < max_count)
+        {
+            sprintf(files[count].name, "%s\\%s", path, data.cFileName);
+            files[count].write_time = data.ftLastWriteTime;
+        }
+        ++count;
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+
+    return min(count, max_count);
+}
+
+static void run_shader_cache_child(void)
+{
+    STARTUPINFOA si = {sizeof(si)};
+    PROCESS_INFORMATION pi;
+    char cmdline[MAX_PATH];
+    char **argv;
+    BOOL ret;
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" visual shader_cache", argv[0]);
+    ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi);
+    ok(ret, "Failed to create process, error %u.\n", GetLastError());
+    if (!ret)
+        return;
+
+    wait_child_process(pi.hProcess);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+}
+
+/* The on-disk cache of linked programs is a Wine extension, configured through the "ShaderCachePath"
+ * setting. Programs missing from the cache are linked and stored, programs found in it are loaded
+ * without rewriting the file. */
+static void test_shader_cache(void)
+{
+    struct shader_cache_file files[64], files2[64];
+    char path[MAX_PATH], old_path[MAX_PATH], changed_name[MAX_PATH];
+    unsigned int count, count2, i, j;
+    DWORD size, offset, io_size;
+    BOOL have_old_path, ret;
+    BYTE byte, byte2;
+    HANDLE file;
+    HKEY key;
+
+    if (RegCreateKeyExA(HKEY_CURRENT_USER, "Software\\Wine\\Direct3D", 0, NULL, 0,
+            KEY_QUERY_VALUE | KEY_SET_VALUE, NULL, &key, NULL))
+    {
+        skip("Failed to open the Direct3D settings key.\n");
+        return;
+    }
+    size = sizeof(old_path);
+    have_old_path = !RegQueryValueExA(key, "ShaderCachePath", NULL, NULL, (BYTE *)old_path, &size);
+
+    GetTempPathA(ARRAY_SIZE(path), path);
+    GetTempFileNameA(path, "wsc", 0, path);
+    DeleteFileA(path);
+    ret = CreateDirectoryA(path, NULL);
+    ok(ret, "Failed to create directory, error %u.\n", GetLastError());
+    RegSetValueExA(key, "ShaderCachePath", 0, REG_SZ, (BYTE *)path, strlen(path) + 1);
+
+    /* Nothing is cached yet, every program is stored. */
+    run_shader_cache_child();
+    if (!(count = get_shader_cache_files(path, files, ARRAY_SIZE(files))))
+    {
+        skip("The shader cache is not used.\n");
+        goto done;
+    }
+
+    /* Change the stored key of the first entry. It no longer matches, so the program is linked and the
+     * entry rewritten; the other entries are cache hits. Keys start after the three DWORD header. */
+    offset = 3 * sizeof(DWORD);
+    strcpy(changed_name, files[0].name);
+    file = CreateFileA(changed_name, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to open %s, error %u.\n", changed_name, GetLastError());
+    SetFilePointer(file, offset, NULL, FILE_BEGIN);
+    ret = ReadFile(file, &byte, 1, &io_size, NULL);
+    ok(ret && io_size == 1, "Failed to read, error %u.\n", GetLastError());
+    byte2 = ~byte;
+    SetFilePointer(file, offset, NULL, FILE_BEGIN);
+    ret = WriteFile(file, &byte2, 1, &io_size, NULL);
+    ok(ret && io_size == 1, "Failed to write, error %u.\n", GetLastError());
+    CloseHandle(file);
+    count = get_shader_cache_files(path, files, ARRAY_SIZE(files));
+
+    run_shader_cache_child();
+    count2 = get_shader_cache_files(path, files2, ARRAY_SIZE(files2));
+    ok(count2 == count, "Got %u cache entries, expected %u.\n", count2, count);
+
+    for (i = 0; i < count2; ++i)
+    {
+        for (j = 0; j < count; ++j)
+        {
+            if (!strcmp(files2[i].name, files[j].name))
+                break;
+        }
+        ok(j < count, "Got unexpected cache entry %s.\n", files2[i].name);
+        if (j == count || !strcmp(files2[i].name, changed_name))
+            continue;
+        ok(!CompareFileTime(&files2[i].write_time, &files[j].write_time),
+                "Cache entry %s was rewritten.\n", files2[i].name);
+    }
+
+    file = CreateFileA(changed_name, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to open %s, error %u.\n", changed_name, GetLastError());
+    SetFilePointer(file, offset, NULL, FILE_BEGIN);
+    ret = ReadFile(file, &byte2, 1, &io_size, NULL);
+    ok(ret && io_size == 1, "Failed to read, error %u.\n", GetLastError());
+    ok(byte2 == byte, "Cache entry %s was not rewritten.\n", changed_name);
+    CloseHandle(file);
+
+done:
+    count = get_shader_cache_files(path, files, ARRAY_SIZE(files));
+    for (i = 0; i < count; ++i)
+        DeleteFileA(files[i].name);
+    RemoveDirectoryA(path);
+
+    if (have_old_path)
+        RegSetValueExA(key, "ShaderCachePath", 0, REG_SZ, (BYTE *)old_path, strlen(old_path) + 1);
+    else
+        RegDeleteValueA(key, "ShaderCachePath");
+    RegCloseKey(key);
+}
+
 START_TEST(visual)
 {
     D3DADAPTER_IDENTIFIER9 identifier;
     IDirect3D9 *d3d;
+    char **argv;
     HRESULT hr;
 
+    if (winetest_get_mainargs(&argv) >= 3 && !strcmp(argv[2], "shader_cache"))
+    {
+        test_shader_cache_child();
+        return;
+    }
+
     if (!(d3d = Direct3DCreate9(D3D_SDK_VERSION)))
     {
         skip("could not create D3D9 object\n");
@@ -27060,4 +27296,5 @@ START_TEST(visual)
     test_sample_attached_rendertarget();
     test_alpha_to_coverage();
     test_sample_mask();
+    test_shader_cache();
 }
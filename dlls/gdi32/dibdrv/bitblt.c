@@ -1194,6 +1194,180 @@ static DWORD calc_1d_stretch_params( INT dst_start, INT dst_length, INT dst_vis_
 }
 
 
+#define MAX_STRETCH_BANDS      16
+#define MIN_STRETCH_BAND_ROWS  32
+
+typedef void (*stretch_row_fn)(const dib_info *dst_dib, const POINT *dst_start,
+                               const dib_info *src_dib, const POINT *src_start,
+                               const struct stretch_params *params, int mode, BOOL keep_dst);
+
+/* a range of rows that can be stretched independently of the others */
+struct stretch_band
+{
+    POINT        dst_start;
+    POINT        src_start;
+    int          err;
+    unsigned int length;
+};
+
+struct stretch_job
+{
+    dib_info                    *dst_dib;
+    const dib_info              *src_dib;
+    const struct stretch_params *v_params;
+    const struct stretch_params *h_params;
+    stretch_row_fn               row_fn;
+    int                          mode;
+    BOOL                         vstretch;
+    int                          width;
+    LONG                         next;
+    unsigned int                 count;
+    struct stretch_band          bands[MAX_STRETCH_BANDS];
+};
+
+static unsigned int stretch_threshold;
+static unsigned int stretch_cpus;
+
+static BOOL WINAPI init_stretch_threads( INIT_ONCE *once, void *param, void **context )
+{
+    SYSTEM_INFO info;
+    WCHAR buffer[16];
+
+    /* parallel stretching is only done for destinations of at least that many pixels */
+    if (GetEnvironmentVariableW( L"WINESTRETCHTHRESHOLD", buffer, ARRAY_SIZE(buffer) ))
+        stretch_threshold = wcstol( buffer, NULL, 10 );
+
+    GetSystemInfo( &info );
+    stretch_cpus = min( info.dwNumberOfProcessors, MAX_STRETCH_BANDS );
+    return TRUE;
+}
+
+/* number of bands to split a destination of the given size into */
+static unsigned int get_stretch_band_count( unsigned int width, unsigned int height )
+{
+    static INIT_ONCE init_once = INIT_ONCE_STATIC_INIT;
+
+    InitOnceExecuteOnce( &init_once, init_stretch_threads, NULL, NULL );
+
+    if (!stretch_threshold || stretch_cpus < 2) return 1;
+    if ((ULONGLONG)width * height < stretch_threshold) return 1;
+    return max( 1, min( stretch_cpus, height / MIN_STRETCH_BAND_ROWS ));
+}
+
+/* Split the rows into bands by replaying the Bresenham error sequence. When
+ * shrinking, a band must start on a new destination row so that source rows
+ * are never merged across bands. */
+static void split_stretch_bands( struct stretch_job *job, POINT dst_start, POINT src_start,
+                                 int err, unsigned int length, unsigned int max_bands )
+{
+    const struct stretch_params *v_params = job->v_params;
+    unsigned int band_length = (length + max_bands - 1) / max_bands;
+    struct stretch_band *band = NULL;
+    BOOL new_row = TRUE;
+
+    job->count = 0;
+    while (length--)
+    {
+        if (!band || (new_row && band->length >= band_length && job->count < max_bands))
+        {
+            band = &job->bands[job->count++];
+            band->dst_start = dst_start;
+            band->src_start = src_start;
+            band->err       = err;
+            band->length    = 0;
+        }
+        band->length++;
+
+        new_row = job->vstretch;
+        if (err > 0)
+        {
+            if (job->vstretch) src_start.y += v_params->src_inc;
+            else
+            {
+                dst_start.y += v_params->dst_inc;
+                new_row = TRUE;
+            }
+            err += v_params->err_add_1;
+        }
+        else err += v_params->err_add_2;
+
+        if (job->vstretch) dst_start.y += v_params->dst_inc;
+        else src_start.y += v_params->src_inc;
+    }
+}
+
+static void stretch_band_rows( const struct stretch_job *job, const struct stretch_band *band )
+{
+    const struct stretch_params *v_params = job->v_params;
+    POINT dst_start = band->dst_start, src_start = band->src_start;
+    unsigned int length = band->length;
+    int err = band->err;
+
+    if (job->vstretch)
+    {
+        BOOL need_row = TRUE;
+        RECT last_row, this_row;
+        last_row.left = 0;
+        last_row.right = job->width;
+
+        while (length--)
+        {
+            if (need_row)
+            {
+                job->row_fn( job->dst_dib, &dst_start, job->src_dib, &src_start, job->h_params, job->mode, FALSE );
+                need_row = FALSE;
+            }
+            else
+            {
+                last_row.top = dst_start.y - v_params->dst_inc;
+                last_row.bottom = last_row.top + 1;
+                this_row = last_row;
+                offset_rect( &this_row, 0, v_params->dst_inc );
+                copy_rect( job->dst_dib, &this_row, job->dst_dib, &last_row, NULL, R2_COPYPEN );
+            }
+
+            if (err > 0)
+            {
+                src_start.y += v_params->src_inc;
+                need_row = TRUE;
+                err += v_params->err_add_1;
+            }
+            else err += v_params->err_add_2;
+            dst_start.y += v_params->dst_inc;
+        }
+    }
+    else
+    {
+        int merged_rows = 0;
+
+        while (length--)
+        {
+            if (job->mode != STRETCH_DELETESCANS || !merged_rows)
+                job->row_fn( job->dst_dib, &dst_start, job->src_dib, &src_start, job->h_params,
+                             job->mode, merged_rows != 0 );
+            merged_rows++;
+
+            if (err > 0)
+            {
+                dst_start.y += v_params->dst_inc;
+                merged_rows = 0;
+                err += v_params->err_add_1;
+            }
+            else err += v_params->err_add_2;
+            src_start.y += v_params->src_inc;
+        }
+    }
+}
+
+static void CALLBACK stretch_band_callback( TP_CALLBACK_INSTANCE *instance, void *context, TP_WORK *work )
+{
+    struct stretch_job *job = context;
+    unsigned int i;
+
+    while ((i = InterlockedIncrement( &job->next ) - 1) < job->count)
+        stretch_band_rows( job, &job->bands[i] );
+}
+
 DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
                           const BITMAPINFO *dst_info, void *dst_bits, struct bitblt_coords *dst,
                           INT mode )
@@ -1203,11 +1377,10 @@ DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bit
     RECT rect;
     BOOL hstretch, vstretch;
     struct stretch_params v_params, h_params;
-    int err;
+    struct stretch_job job;
+    TP_WORK *work;
+    unsigned int i;
     DWORD ret;
-    void (* row_fn)(const dib_info *dst_dib, const POINT *dst_start,
-                    const dib_info *src_dib, const POINT *src_start,
-                    const struct stretch_params *params, int mode, BOOL keep_dst);
 
     TRACE("dst %d, %d - %d x %d visrect %s src %d, %d - %d x %d visrect %s\n",
           dst->x, dst->y, dst->width, dst->height, wine_dbgstr_rect(&dst->visrect),
@@ -1247,63 +1420,31 @@ DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bit
     dst_start.x -= dst->visrect.left;
     dst_start.y -= dst->visrect.top;
 
-    err = v_params.err_start;
+    if (vstretch && hstretch) mode = STRETCH_DELETESCANS;
 
-    row_fn = hstretch ? dst_dib.funcs->stretch_row : dst_dib.funcs->shrink_row;
+    job.dst_dib  = &dst_dib;
+    job.src_dib  = &src_dib;
+    job.v_params = &v_params;
+    job.h_params = &h_params;
+    job.row_fn   = hstretch ? dst_dib.funcs->stretch_row : dst_dib.funcs->shrink_row;
+    job.mode     = mode;
+    job.vstretch = vstretch;
+    job.width    = dst->visrect.right - dst->visrect.left;
+    job.next     = 0;
 
-    if (vstretch)
-    {
-        BOOL need_row = TRUE;
-        RECT last_row, this_row;
-        if (hstretch) mode = STRETCH_DELETESCANS;
-        last_row.left = 0;
-        last_row.right = dst->visrect.right - dst->visrect.left;
+    split_stretch_bands( &job, dst_start, src_start, v_params.err_start, v_params.length,
+                         get_stretch_band_count( job.width, dst->visrect.bottom - dst->visrect.top ));
 
-        while (v_params.length--)
-        {
-            if (need_row)
-            {
-                row_fn( &dst_dib, &dst_start, &src_dib, &src_start, &h_params, mode, FALSE );
-                need_row = FALSE;
-            }
-            else
-            {
-                last_row.top = dst_start.y - v_params.dst_inc;
-                last_row.bottom = last_row.top + 1;
-                this_row = last_row;
-                offset_rect( &this_row, 0, v_params.dst_inc );
-                copy_rect( &dst_dib, &this_row, &dst_dib, &last_row, NULL, R2_COPYPEN );
-            }
-
-            if (err > 0)
-            {
-                src_start.y += v_params.src_inc;
-                need_row = TRUE;
-                err += v_params.err_add_1;
-            }
-            else err += v_params.err_add_2;
-            dst_start.y += v_params.dst_inc;
-        }
+    if (job.count > 1 && (work = CreateThreadpoolWork( stretch_band_callback, &job, NULL )))
+    {
+        for (i = 1; i < job.count; i++) SubmitThreadpoolWork( work );
+        stretch_band_callback( NULL, &job, NULL );
+        WaitForThreadpoolWorkCallbacks( work, FALSE );
+        CloseThreadpoolWork( work );
     }
     else
     {
-        int merged_rows = 0;
-
-        while (v_params.length--)
-        {
-            if (mode != STRETCH_DELETESCANS || !merged_rows)
-                row_fn( &dst_dib, &dst_start, &src_dib, &src_start, &h_params, mode, merged_rows != 0 );
-            merged_rows++;
-
-            if (err > 0)
-            {
-                dst_start.y += v_params.dst_inc;
-                merged_rows = 0;
-                err += v_params.err_add_1;
-            }
-            else err += v_params.err_add_2;
-            src_start.y += v_params.src_inc;
-        }
+        for (i = 0; i < job.count; i++) stretch_band_rows( &job, &job.bands[i] );
     }
 
 done:
@@ -19,6 +19,9 @@
  */
 
 #include <assert.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
 
 #include "gdi_private.h"
 #include "dibdrv.h"
@@ -27,6 +30,16 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(dib);
 
+#if defined(__i386__) || defined(__x86_64__)
+#ifdef __x86_64__
+#define SSE2_TARGET
+#else
+#define SSE2_TARGET __attribute__((target("sse2")))
+#endif
+#endif
+
+BOOL sse2_supported;
+
 /* Bayer matrices for dithering */
 
 static const BYTE bayer_4x4[4][4] =
@@ -264,6 +277,25 @@ static inline void memset_16( WORD *start, WORD val, DWORD size )
 #endif
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+/* SSE2 version of do_rop_32 for a row of pixels, four at a time */
+/* returns the number of pixels processed, the caller handles the rest */
+static int SSE2_TARGET solid_row_32_sse2( DWORD *ptr, int count, DWORD and, DWORD xor )
+{
+    const __m128i and_v = _mm_set1_epi32( and ), xor_v = _mm_set1_epi32( xor );
+    __m128i d;
+    int x;
+
+    for (x = 0; x + 4 <= count; x += 4)
+    {
+        d = _mm_loadu_si128( (const __m128i *)(ptr + x) );
+        d = _mm_xor_si128( _mm_and_si128( d, and_v ), xor_v );
+        _mm_storeu_si128( (__m128i *)(ptr + x), d );
+    }
+    return x;
+}
+#endif
+
 static void solid_rects_32(const dib_info *dib, int num, const RECT *rc, DWORD and, DWORD xor)
 {
     DWORD *ptr, *start;
@@ -276,8 +308,14 @@ static void solid_rects_32(const dib_info *dib, int num, const RECT *rc, DWORD a
         start = get_pixel_ptr_32(dib, rc->left, rc->top);
         if (and)
             for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
-                for(x = rc->left, ptr = start; x < rc->right; x++)
+            {
+                x = 0;
+#if defined(__i386__) || defined(__x86_64__)
+                if (sse2_supported) x = solid_row_32_sse2( start, rc->right - rc->left, and, xor );
+#endif
+                for(ptr = start + x, x += rc->left; x < rc->right; x++)
                     do_rop_32(ptr++, and, xor);
+            }
         else
             for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
                 memset_32( start, xor, rc->right - rc->left );
@@ -2215,6 +2253,31 @@ static inline BOOL bit_fields_match(const dib_info *d1, const dib_info *d2)
            d1->blue_mask  == d2->blue_mask;
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+/* SSE2 conversion of a row of 32-bpp pixels with 8-bit color fields, four at a time */
+/* returns the number of pixels processed, the caller handles the rest */
+static int SSE2_TARGET convert_row_888_sse2( DWORD *dst_pixel, const DWORD *src_pixel, int count,
+                                             const dib_info *dst, const dib_info *src )
+{
+    const __m128i mask = _mm_set1_epi32( 0xff );
+    const __m128i src_r = _mm_cvtsi32_si128( src->red_shift ), dst_r = _mm_cvtsi32_si128( dst->red_shift );
+    const __m128i src_g = _mm_cvtsi32_si128( src->green_shift ), dst_g = _mm_cvtsi32_si128( dst->green_shift );
+    const __m128i src_b = _mm_cvtsi32_si128( src->blue_shift ), dst_b = _mm_cvtsi32_si128( dst->blue_shift );
+    __m128i s, d;
+    int x;
+
+    for (x = 0; x + 4 <= count; x += 4)
+    {
+        s = _mm_loadu_si128( (const __m128i *)(src_pixel + x) );
+        d =                  _mm_sll_epi32( _mm_and_si128( _mm_srl_epi32( s, src_r ), mask ), dst_r );
+        d = _mm_or_si128( d, _mm_sll_epi32( _mm_and_si128( _mm_srl_epi32( s, src_g ), mask ), dst_g ));
+        d = _mm_or_si128( d, _mm_sll_epi32( _mm_and_si128( _mm_srl_epi32( s, src_b ), mask ), dst_b ));
+        _mm_storeu_si128( (__m128i *)(dst_pixel + x), d );
+    }
+    return x;
+}
+#endif
+
 static void convert_to_8888(dib_info *dst, const dib_info *src, const RECT *src_rect, BOOL dither)
 {
     DWORD *dst_start = get_pixel_ptr_32(dst, 0, 0), *dst_pixel, src_val;
@@ -2244,9 +2307,14 @@ static void convert_to_8888(dib_info *dst, const dib_info *src, const RECT *src_
         {
             for(y = src_rect->top; y < src_rect->bottom; y++)
             {
-                dst_pixel = dst_start;
-                src_pixel = src_start;
-                for(x = src_rect->left; x < src_rect->right; x++)
+                x = 0;
+#if defined(__i386__) || defined(__x86_64__)
+                if (sse2_supported)
+                    x = convert_row_888_sse2( dst_start, src_start, src_rect->right - src_rect->left, dst, src );
+#endif
+                dst_pixel = dst_start + x;
+                src_pixel = src_start + x;
+                for(x += src_rect->left; x < src_rect->right; x++)
                 {
                     src_val = *src_pixel++;
                     *dst_pixel++ = (((src_val >> src->red_shift)   & 0xff) << 16) |
@@ -2481,9 +2549,14 @@ static void convert_to_32(dib_info *dst, const dib_info *src, const RECT *src_re
         {
             for(y = src_rect->top; y < src_rect->bottom; y++)
             {
-                dst_pixel = dst_start;
-                src_pixel = src_start;
-                for(x = src_rect->left; x < src_rect->right; x++)
+                x = 0;
+#if defined(__i386__) || defined(__x86_64__)
+                if (sse2_supported && dst->red_len == 8 && dst->green_len == 8 && dst->blue_len == 8)
+                    x = convert_row_888_sse2( dst_start, src_start, src_rect->right - src_rect->left, dst, src );
+#endif
+                dst_pixel = dst_start + x;
+                src_pixel = src_start + x;
+                for(x += src_rect->left; x < src_rect->right; x++)
                 {
                     src_val = *src_pixel++;
                     *dst_pixel++ = rgb_to_pixel_masks(dst, src_val >> 16, src_val >> 8, src_val);
@@ -2513,9 +2586,14 @@ static void convert_to_32(dib_info *dst, const dib_info *src, const RECT *src_re
         {
             for(y = src_rect->top; y < src_rect->bottom; y++)
             {
-                dst_pixel = dst_start;
-                src_pixel = src_start;
-                for(x = src_rect->left; x < src_rect->right; x++)
+                x = 0;
+#if defined(__i386__) || defined(__x86_64__)
+                if (sse2_supported)
+                    x = convert_row_888_sse2( dst_start, src_start, src_rect->right - src_rect->left, dst, src );
+#endif
+                dst_pixel = dst_start + x;
+                src_pixel = src_start + x;
+                for(x += src_rect->left; x < src_rect->right; x++)
                 {
                     src_val = *src_pixel++;
                     *dst_pixel++ = (((src_val >> src->red_shift)   & 0xff) << dst->red_shift)   |
@@ -4648,6 +4726,62 @@ static inline DWORD blend_argb( DWORD dst, DWORD src )
             (alpha + ((BYTE)(dst >> 24) * (255 - alpha) + 127) / 255) << 24);
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+/* SSE2 version of blend_argb for a row of pixels, four at a time */
+/* returns the number of pixels processed, the caller handles the rest */
+static int SSE2_TARGET blend_argb_row_sse2( DWORD *dst, const DWORD *src, int count )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha_mask = _mm_set1_epi32( 0xff000000 );
+    const __m128i c255 = _mm_set1_epi16( 255 );
+    const __m128i c128 = _mm_set1_epi16( 128 );
+    __m128i s, d, a, s_lo, s_hi, d_lo, d_hi, inv;
+    int x, i;
+
+    for (x = 0; x + 4 <= count; x += 4)
+    {
+        s = _mm_loadu_si128( (const __m128i *)(src + x) );
+        a = _mm_and_si128( s, alpha_mask );
+
+        /* fully opaque source, the destination doesn't matter */
+        if (_mm_movemask_epi8( _mm_cmpeq_epi32( a, alpha_mask )) == 0xffff)
+        {
+            _mm_storeu_si128( (__m128i *)(dst + x), s );
+            continue;
+        }
+
+        /* the color components can overflow if they are larger than alpha,
+         * use the C version to get exactly the same results in that case */
+        a = _mm_srli_epi32( a, 24 );
+        a = _mm_or_si128( a, _mm_slli_epi32( a, 8 ));
+        a = _mm_or_si128( a, _mm_slli_epi32( a, 16 ));
+        if (_mm_movemask_epi8( _mm_cmpeq_epi8( _mm_subs_epu8( s, a ), zero )) != 0xffff)
+        {
+            for (i = x; i < x + 4; i++) dst[i] = blend_argb( dst[i], src[i] );
+            continue;
+        }
+
+        d = _mm_loadu_si128( (const __m128i *)(dst + x) );
+        s_lo = _mm_unpacklo_epi8( s, zero );
+        s_hi = _mm_unpackhi_epi8( s, zero );
+        d_lo = _mm_unpacklo_epi8( d, zero );
+        d_hi = _mm_unpackhi_epi8( d, zero );
+
+        /* (dst * (255 - alpha) + 127) / 255 is (v + (v >> 8)) >> 8 with v = dst * (255 - alpha) + 128 */
+        inv  = _mm_sub_epi16( c255, _mm_shufflehi_epi16( _mm_shufflelo_epi16( s_lo, 0xff ), 0xff ));
+        d_lo = _mm_add_epi16( _mm_mullo_epi16( d_lo, inv ), c128 );
+        d_lo = _mm_srli_epi16( _mm_add_epi16( d_lo, _mm_srli_epi16( d_lo, 8 )), 8 );
+        inv  = _mm_sub_epi16( c255, _mm_shufflehi_epi16( _mm_shufflelo_epi16( s_hi, 0xff ), 0xff ));
+        d_hi = _mm_add_epi16( _mm_mullo_epi16( d_hi, inv ), c128 );
+        d_hi = _mm_srli_epi16( _mm_add_epi16( d_hi, _mm_srli_epi16( d_hi, 8 )), 8 );
+
+        d = _mm_packus_epi16( _mm_add_epi16( s_lo, d_lo ), _mm_add_epi16( s_hi, d_hi ));
+        _mm_storeu_si128( (__m128i *)(dst + x), d );
+    }
+    return x;
+}
+#endif
+
 static inline DWORD blend_argb_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
     BYTE b = ((BYTE)src         * alpha + 127) / 255;
@@ -4692,8 +4826,14 @@ static void blend_rects_8888(const dib_info *dst, int num, const RECT *rc,
         {
             if (blend.SourceConstantAlpha == 255)
                 for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-                    for (x = 0; x < rc->right - rc->left; x++)
+                {
+                    x = 0;
+#if defined(__i386__) || defined(__x86_64__)
+                    if (sse2_supported) x = blend_argb_row_sse2( dst_ptr, src_ptr, rc->right - rc->left );
+#endif
+                    for (; x < rc->right - rc->left; x++)
                         dst_ptr[x] = blend_argb( dst_ptr[x], src_ptr[x] );
+                }
             else
                 for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
                     for (x = 0; x < rc->right - rc->left; x++)
@@ -628,6 +628,7 @@ BOOL WINAPI DllMain( HINSTANCE inst, DWORD reason, LPVOID reserved )
     gdi32_module = inst;
     DisableThreadLibraryCalls( inst );
     set_gdi_shared();
+    sse2_supported = IsProcessorFeaturePresent( PF_XMMI64_INSTRUCTIONS_AVAILABLE );
     font_init();
 
     /* create stock objects */
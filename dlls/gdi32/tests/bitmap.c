@@ -5941,9 +5941,143 @@ static void test_D3DKMTCreateDCFromMemory( void )
     }
 }
 
+#define BAND_WIDTH  300
+#define BAND_HEIGHT 400
+#define BAND_TESTS  5
+
+/* Stretches large enough to be split into bands when WINESTRETCHTHRESHOLD is set */
+static void stretch_bands( DWORD *results )
+{
+    static const struct
+    {
+        int mode;
+        int dst_x, dst_y, dst_width, dst_height;
+        int src_x, src_y, src_width, src_height;
+    }
+    tests[BAND_TESTS] =
+    {
+        { COLORONCOLOR, 0, 0, 300, 400, 0, 0, 97, 61 },
+        { BLACKONWHITE, 0, 0, 150, 200, 0, 0, 300, 400 },
+        { WHITEONBLACK, 7, 3, 141, 187, 1, 2, 297, 391 },
+        { COLORONCOLOR, 0, 0, 113, 301, 0, 0, 300, 400 },
+        { COLORONCOLOR, 299, 399, -251, -333, 3, 5, 61, 97 },
+    };
+    BITMAPINFO info;
+    HBITMAP src_dib, dst_dib, old_src, old_dst;
+    DWORD *src_bits, *dst_bits;
+    HDC src_dc, dst_dc;
+    int i;
+
+    memset( &info, 0, sizeof(info) );
+    info.bmiHeader.biSize = sizeof(info.bmiHeader);
+    info.bmiHeader.biWidth = BAND_WIDTH;
+    info.bmiHeader.biHeight = BAND_HEIGHT;
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+
+    src_dc = CreateCompatibleDC( NULL );
+    dst_dc = CreateCompatibleDC( NULL );
+    src_dib = CreateDIBSection( NULL, &info, DIB_RGB_COLORS, (void **)&src_bits, NULL, 0 );
+    dst_dib = CreateDIBSection( NULL, &info, DIB_RGB_COLORS, (void **)&dst_bits, NULL, 0 );
+    old_src = SelectObject( src_dc, src_dib );
+    old_dst = SelectObject( dst_dc, dst_dib );
+
+    for (i = 0; i < BAND_WIDTH * BAND_HEIGHT; i++) src_bits[i] = (i * 0x9e3779b1u) >> 8;
+
+    for (i = 0; i < BAND_TESTS; i++)
+    {
+        memset( dst_bits, 0x55, BAND_WIDTH * BAND_HEIGHT * sizeof(DWORD) );
+        SetStretchBltMode( dst_dc, tests[i].mode );
+        StretchBlt( dst_dc, tests[i].dst_x, tests[i].dst_y, tests[i].dst_width, tests[i].dst_height,
+                    src_dc, tests[i].src_x, tests[i].src_y, tests[i].src_width, tests[i].src_height, SRCCOPY );
+        GdiFlush();
+        memcpy( results + i * BAND_WIDTH * BAND_HEIGHT, dst_bits, BAND_WIDTH * BAND_HEIGHT * sizeof(DWORD) );
+    }
+
+    SelectObject( src_dc, old_src );
+    SelectObject( dst_dc, old_dst );
+    DeleteObject( src_dib );
+    DeleteObject( dst_dib );
+    DeleteDC( src_dc );
+    DeleteDC( dst_dc );
+}
+
+static void test_StretchBlt_bands_child( const char *file )
+{
+    static const SIZE_T size = BAND_TESTS * BAND_WIDTH * BAND_HEIGHT * sizeof(DWORD);
+    DWORD *expect, *results, read, i;
+    HANDLE handle;
+
+    expect = HeapAlloc( GetProcessHeap(), 0, size );
+    results = HeapAlloc( GetProcessHeap(), 0, size );
+
+    handle = CreateFileA( file, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL );
+    ok( handle != INVALID_HANDLE_VALUE, "failed to open %s, error %u\n", file, GetLastError() );
+    ok( ReadFile( handle, expect, size, &read, NULL ) && read == size, "failed to read %s\n", file );
+    CloseHandle( handle );
+
+    stretch_bands( results );
+    for (i = 0; i < BAND_TESTS; i++)
+        ok( !memcmp( expect + i * BAND_WIDTH * BAND_HEIGHT, results + i * BAND_WIDTH * BAND_HEIGHT,
+                     BAND_WIDTH * BAND_HEIGHT * sizeof(DWORD) ), "%u: banded stretch differs\n", i );
+
+    HeapFree( GetProcessHeap(), 0, expect );
+    HeapFree( GetProcessHeap(), 0, results );
+}
+
+/* compare the serial stretch with a child process that splits it into bands */
+static void test_StretchBlt_bands(void)
+{
+    static const SIZE_T size = BAND_TESTS * BAND_WIDTH * BAND_HEIGHT * sizeof(DWORD);
+    char path[MAX_PATH], file[MAX_PATH], cmdline[MAX_PATH * 2];
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA startup;
+    DWORD *results, written;
+    HANDLE handle;
+    char **argv;
+
+    results = HeapAlloc( GetProcessHeap(), 0, size );
+    stretch_bands( results );
+
+    GetTempPathA( MAX_PATH, path );
+    GetTempFileNameA( path, "str", 0, file );
+    handle = CreateFileA( file, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL );
+    ok( handle != INVALID_HANDLE_VALUE, "failed to create %s, error %u\n", file, GetLastError() );
+    ok( WriteFile( handle, results, size, &written, NULL ) && written == size, "failed to write %s\n", file );
+    CloseHandle( handle );
+    HeapFree( GetProcessHeap(), 0, results );
+
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "\"%s\" bitmap stretch_bands \"%s\"", argv[0], file );
+    memset( &startup, 0, sizeof(startup) );
+    startup.cb = sizeof(startup);
+    SetEnvironmentVariableA( "WINESTRETCHTHRESHOLD", "1" );
+    ok( CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &pi ),
+        "CreateProcess failed, error %u\n", GetLastError() );
+    SetEnvironmentVariableA( "WINESTRETCHTHRESHOLD", NULL );
+    wait_child_process( pi.hProcess );
+    CloseHandle( pi.hProcess );
+    CloseHandle( pi.hThread );
+
+    DeleteFileA( file );
+}
+
 START_TEST(bitmap)
 {
     HMODULE hdll;
+    char **argv;
+    int argc;
+
+    argc = winetest_get_mainargs( &argv );
+    if (argc >= 4 && !strcmp( argv[2], "stretch_bands" ))
+    {
+        test_StretchBlt_bands_child( argv[3] );
+        return;
+    }
+
+    /* the serial stretches are the reference for the banded ones */
+    SetEnvironmentVariableA( "WINESTRETCHTHRESHOLD", NULL );
 
     hdll = GetModuleHandleA("gdi32.dll");
     pD3DKMTCreateDCFromMemory  = (void *)GetProcAddress( hdll, "D3DKMTCreateDCFromMemory" );
@@ -5969,6 +6103,7 @@ START_TEST(bitmap)
     test_CreateBitmap();
     test_BitBlt();
     test_StretchBlt();
+    test_StretchBlt_bands();
     test_StretchDIBits();
     test_GdiAlphaBlend();
     test_GdiGradientFill();
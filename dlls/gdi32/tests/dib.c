@@ -3529,11 +3529,166 @@ static void test_simple_graphics(void)
     DeleteDC(mem_dc);
 }
 
+static DWORD blend_argb_ref( DWORD dst, DWORD src )
+{
+    DWORD alpha = src >> 24, ret = 0;
+    int i;
+
+    for (i = 0; i < 32; i += 8)
+        ret |= (((src >> i) & 0xff) + (((dst >> i) & 0xff) * (255 - alpha) + 127) / 255) << i;
+    return ret;
+}
+
+static HBITMAP create_row_test_dib( HDC hdc, int width, int height, const DWORD *masks, DWORD **bits )
+{
+    char bmibuf[sizeof(BITMAPINFOHEADER) + 3 * sizeof(DWORD)];
+    BITMAPINFO *bmi = (BITMAPINFO *)bmibuf;
+    HBITMAP dib;
+
+    memset( bmi, 0, sizeof(bmibuf) );
+    bmi->bmiHeader.biSize = sizeof(bmi->bmiHeader);
+    bmi->bmiHeader.biWidth = width;
+    bmi->bmiHeader.biHeight = -height;
+    bmi->bmiHeader.biBitCount = 32;
+    bmi->bmiHeader.biPlanes = 1;
+    bmi->bmiHeader.biCompression = masks ? BI_BITFIELDS : BI_RGB;
+    if (masks) memcpy( bmibuf + sizeof(BITMAPINFOHEADER), masks, 3 * sizeof(DWORD) );
+
+    dib = CreateDIBSection( hdc, bmi, DIB_RGB_COLORS, (void **)bits, NULL, 0 );
+    ok( dib != NULL, "CreateDIBSection failed\n" );
+    return dib;
+}
+
+static DWORD swap_red_blue( DWORD val )
+{
+    return (val & 0x00ff00) | (val >> 16 & 0xff) | (val & 0xff) << 16;
+}
+
+/* The 32-bpp blend, conversion and solid fill primitives process whole rows four pixels
+ * at a time and finish with a per-pixel tail. Check them against per-pixel reference
+ * results for odd widths and for rows that don't start on a 16-byte boundary. */
+static void test_row_primitives(void)
+{
+    static const DWORD rgb_masks[3] = { 0x0000ff, 0x00ff00, 0xff0000 };
+    static const struct { int left, width; } spans[] =
+    {
+        { 0, 37 }, { 1, 13 }, { 3, 7 }, { 5, 29 }, { 2, 3 }, { 6, 1 }
+    };
+    static const int width = 37, height = 3;
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+    DWORD *dst_bits, *src_bits, *rgb_bits, orig[37 * 3], expect, alpha, val;
+    HBITMAP dst_dib, src_dib, rgb_dib, orig_dst, orig_src, orig_rgb;
+    HDC dst_dc, src_dc, rgb_dc;
+    HBRUSH brush, orig_brush;
+    int i, x, y, s;
+
+    dst_dc = CreateCompatibleDC( NULL );
+    src_dc = CreateCompatibleDC( NULL );
+    rgb_dc = CreateCompatibleDC( NULL );
+    dst_dib = create_row_test_dib( dst_dc, width, height, NULL, &dst_bits );
+    src_dib = create_row_test_dib( src_dc, width, height, NULL, &src_bits );
+    rgb_dib = create_row_test_dib( rgb_dc, width, height, rgb_masks, &rgb_bits );
+    orig_dst = SelectObject( dst_dc, dst_dib );
+    orig_src = SelectObject( src_dc, src_dib );
+    orig_rgb = SelectObject( rgb_dc, rgb_dib );
+
+    for (i = 0; i < width * height; i++)
+    {
+        /* premultiplied source with opaque, transparent and partially transparent runs,
+         * plus a few components larger than alpha that the fast path can't handle,
+         * with a small enough destination that the sum doesn't overflow */
+        alpha = (i / 4 % 3 == 0) ? 0xff : (i % 7 == 0) ? 0 : (i * 89) & 0xff;
+        val = (i * 0x9e3779b1) & 0xffffff;
+        src_bits[i] = alpha << 24 | ((val >> 16 & 0xff) * alpha / 255) << 16 |
+                      ((val >> 8 & 0xff) * alpha / 255) << 8 | (val & 0xff) * alpha / 255;
+        if (i % 11 == 5) src_bits[i] = 0x40102080;
+        rgb_bits[i] = (i * 0x01234567) & 0xffffff;
+    }
+
+    for (s = 0; s < ARRAY_SIZE(spans); s++)
+    {
+        for (i = 0; i < width * height; i++)
+        {
+            orig[i] = (i * 0x6b43a9b5u) ^ (s << 24);
+            if (i % 11 == 5) orig[i] &= 0xff3f3f3f;
+            dst_bits[i] = orig[i];
+        }
+
+        GdiAlphaBlend( dst_dc, spans[s].left, 0, spans[s].width, height,
+                       src_dc, spans[s].left, 0, spans[s].width, height, blend );
+        for (y = 0; y < height; y++)
+            for (x = 0; x < width; x++)
+            {
+                i = y * width + x;
+                expect = orig[i];
+                if (x >= spans[s].left && x < spans[s].left + spans[s].width)
+                    expect = blend_argb_ref( orig[i], src_bits[i] );
+                ok( dst_bits[i] == expect, "blend %d,%d: %d,%d got %08x expected %08x\n",
+                    spans[s].left, spans[s].width, x, y, dst_bits[i], expect );
+            }
+
+        for (i = 0; i < width * height; i++) dst_bits[i] = orig[i];
+        brush = CreateSolidBrush( RGB( 0x12, 0x34, 0x56 ));
+        orig_brush = SelectObject( dst_dc, brush );
+        PatBlt( dst_dc, spans[s].left, 0, spans[s].width, height, PATINVERT );
+        SelectObject( dst_dc, orig_brush );
+        DeleteObject( brush );
+        for (y = 0; y < height; y++)
+            for (x = 0; x < width; x++)
+            {
+                i = y * width + x;
+                expect = orig[i];
+                if (x >= spans[s].left && x < spans[s].left + spans[s].width) expect ^= 0x123456;
+                ok( dst_bits[i] == expect, "patinvert %d,%d: %d,%d got %08x expected %08x\n",
+                    spans[s].left, spans[s].width, x, y, dst_bits[i], expect );
+            }
+
+        /* bitfields to a8r8g8b8 */
+        for (i = 0; i < width * height; i++) dst_bits[i] = orig[i];
+        BitBlt( dst_dc, spans[s].left, 0, spans[s].width, height, rgb_dc, spans[s].left, 0, SRCCOPY );
+        for (y = 0; y < height; y++)
+            for (x = 0; x < width; x++)
+            {
+                i = y * width + x;
+                expect = orig[i];
+                if (x >= spans[s].left && x < spans[s].left + spans[s].width)
+                    expect = swap_red_blue( rgb_bits[i] );
+                ok( dst_bits[i] == expect, "to 8888 %d,%d: %d,%d got %08x expected %08x\n",
+                    spans[s].left, spans[s].width, x, y, dst_bits[i], expect );
+            }
+
+        /* a8r8g8b8 to bitfields */
+        for (i = 0; i < width * height; i++) rgb_bits[i] = orig[i] & 0xffffff;
+        BitBlt( rgb_dc, spans[s].left, 0, spans[s].width, height, src_dc, spans[s].left, 0, SRCCOPY );
+        for (y = 0; y < height; y++)
+            for (x = 0; x < width; x++)
+            {
+                i = y * width + x;
+                expect = orig[i] & 0xffffff;
+                if (x >= spans[s].left && x < spans[s].left + spans[s].width)
+                    expect = swap_red_blue( src_bits[i] );
+                ok( rgb_bits[i] == expect, "from 8888 %d,%d: %d,%d got %08x expected %08x\n",
+                    spans[s].left, spans[s].width, x, y, rgb_bits[i], expect );
+            }
+    }
+
+    SelectObject( dst_dc, orig_dst );
+    SelectObject( src_dc, orig_src );
+    SelectObject( rgb_dc, orig_rgb );
+    DeleteObject( dst_dib );
+    DeleteObject( src_dib );
+    DeleteObject( rgb_dib );
+    DeleteDC( dst_dc );
+    DeleteDC( src_dc );
+    DeleteDC( rgb_dc );
+}
+
 START_TEST(dib)
 {
     CryptAcquireContextW(&crypt_prov, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT);
 
     test_simple_graphics();
+    test_row_primitives();
 
     CryptReleaseContext(crypt_prov, 0);
 }
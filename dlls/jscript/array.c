@@ -18,6 +18,7 @@
 
 
 #include <math.h>
+#include <limits.h>
 #include <assert.h>
 
 #include "jscript.h"
@@ -30,6 +31,11 @@ typedef struct {
     jsdisp_t dispex;
 
     DWORD length;
+
+    /* Dense store of elements [0, elem_cnt), see dispex.c for how they are exposed. */
+    jsval_t *elems;
+    DWORD elem_cnt;
+    DWORD elem_size;
 } ArrayInstance;
 
 static inline ArrayInstance *array_from_jsdisp(jsdisp_t *jsdisp)
@@ -53,6 +59,43 @@ unsigned array_get_length(jsdisp_t *array)
     return array_from_jsdisp(array)->length;
 }
 
+HRESULT array_append_elem(jsdisp_t *jsdisp, jsval_t val)
+{
+    ArrayInstance *array = array_from_jsdisp(jsdisp);
+    HRESULT hres;
+
+    if(array->elem_cnt == array->elem_size) {
+        DWORD new_size = array->elem_size ? array->elem_size*2 : 4;
+        jsval_t *new_elems;
+
+        if(new_size > UINT_MAX / sizeof(*new_elems))
+            return E_OUTOFMEMORY;
+
+        new_elems = heap_realloc(array->elems, new_size*sizeof(*new_elems));
+        if(!new_elems)
+            return E_OUTOFMEMORY;
+
+        array->elems = new_elems;
+        array->elem_size = new_size;
+    }
+
+    hres = jsval_copy(val, array->elems+array->elem_cnt);
+    if(FAILED(hres))
+        return hres;
+
+    if(++array->elem_cnt > array->length)
+        array->length = array->elem_cnt;
+    return S_OK;
+}
+
+void array_truncate_elems(jsdisp_t *jsdisp, DWORD cnt)
+{
+    ArrayInstance *array = array_from_jsdisp(jsdisp);
+
+    while(array->elem_cnt > cnt)
+        jsval_release(array->elems[--array->elem_cnt]);
+}
+
 static HRESULT get_length(script_ctx_t *ctx, vdisp_t *vdisp, jsdisp_t **jsthis, DWORD *ret)
 {
     ArrayInstance *array;
@@ -92,19 +135,23 @@ static HRESULT set_length(jsdisp_t *obj, DWORD length)
     return jsdisp_propput_name(obj, L"length", jsval_number(length));
 }
 
-static WCHAR *idx_to_str(DWORD idx, WCHAR *ptr)
+/* Elements moved up by unshift and splice are written starting from the top, past the end of
+ * the dense store. Extend the store first, if the array has no holes, to keep them in it. */
+static HRESULT grow_elems(jsdisp_t *jsthis, DWORD length, DWORD cnt)
 {
-    if(!idx) {
-        *ptr = '0';
-        return ptr;
-    }
+    DWORD i;
+    HRESULT hres;
+
+    if(!is_class(jsthis, JSCLASS_ARRAY) || array_from_jsdisp(jsthis)->elem_cnt != length)
+        return S_OK;
 
-    while(idx) {
-        *ptr-- = '0' + (idx%10);
-        idx /= 10;
+    for(i=0; i < cnt; i++) {
+        hres = jsdisp_propput_idx(jsthis, length+i, jsval_undefined());
+        if(FAILED(hres))
+            return hres;
     }
 
-    return ptr+1;
+    return S_OK;
 }
 
 static HRESULT Array_get_length(script_ctx_t *ctx, jsdisp_t *jsthis, jsval_t *r)
@@ -132,8 +179,9 @@ static HRESULT Array_set_length(script_ctx_t *ctx, jsdisp_t *jsthis, jsval_t val
     if(len!=(DWORD)len)
         return JS_E_INVALID_LENGTH;
 
-    for(i=len; i < This->length; i++) {
-        hres = jsdisp_delete_idx(&This->dispex, i);
+    /* Delete from the end, so that elements in the dense store don't need to be moved out of it. */
+    for(i=This->length; i > len; i--) {
+        hres = jsdisp_delete_idx(&This->dispex, i-1);
         if(FAILED(hres))
             return hres;
     }
@@ -876,6 +924,9 @@ static HRESULT Array_splice(script_ctx_t *ctx, vdisp_t *vthis, WORD flags, unsig
         for(i=length; SUCCEEDED(hres) && i != length-delete_cnt+add_args; i--)
             hres = jsdisp_delete_idx(jsthis, i-1);
     }else if(add_args > delete_cnt) {
+        if(SUCCEEDED(hres))
+            hres = grow_elems(jsthis, length, add_args-delete_cnt);
+
         for(i=length-delete_cnt; SUCCEEDED(hres) && i != start; i--) {
             hres = jsdisp_get_idx(jsthis, i+delete_cnt-1, &val);
             if(hres == DISP_E_UNKNOWNNAME) {
@@ -1167,10 +1218,8 @@ static HRESULT Array_unshift(script_ctx_t *ctx, vdisp_t *vthis, WORD flags, unsi
         jsval_t *r)
 {
     jsdisp_t *jsthis;
-    WCHAR buf[14], *buf_end, *str;
     DWORD i, length;
     jsval_t val;
-    DISPID id;
     HRESULT hres;
 
     TRACE("\n");
@@ -1180,23 +1229,15 @@ static HRESULT Array_unshift(script_ctx_t *ctx, vdisp_t *vthis, WORD flags, unsi
         return hres;
 
     if(argc) {
-        buf_end = buf + ARRAY_SIZE(buf)-1;
-        *buf_end-- = 0;
-        i = length;
-
-        while(i--) {
-            str = idx_to_str(i, buf_end);
+        hres = grow_elems(jsthis, length, argc);
 
-            hres = jsdisp_get_id(jsthis, str, 0, &id);
+        for(i=length; SUCCEEDED(hres) && i; i--) {
+            hres = jsdisp_get_idx(jsthis, i-1, &val);
             if(SUCCEEDED(hres)) {
-                hres = jsdisp_propget(jsthis, id, &val);
-                if(FAILED(hres))
-                    return hres;
-
-                hres = jsdisp_propput_idx(jsthis, i+argc, val);
+                hres = jsdisp_propput_idx(jsthis, i-1+argc, val);
                 jsval_release(val);
             }else if(hres == DISP_E_UNKNOWNNAME) {
-                hres = IDispatchEx_DeleteMemberByDispID(vthis->u.dispex, id);
+                hres = jsdisp_delete_idx(jsthis, i-1+argc);
             }
         }
 
@@ -1233,7 +1274,11 @@ static HRESULT Array_get_value(script_ctx_t *ctx, jsdisp_t *jsthis, jsval_t *r)
 
 static void Array_destructor(jsdisp_t *dispex)
 {
-    heap_free(dispex);
+    ArrayInstance *array = array_from_jsdisp(dispex);
+
+    array_truncate_elems(dispex, 0);
+    heap_free(array->elems);
+    heap_free(array);
 }
 
 static void Array_on_put(jsdisp_t *dispex, const WCHAR *name)
@@ -1257,6 +1302,37 @@ static void Array_on_put(jsdisp_t *dispex, const WCHAR *name)
         array->length = id+1;
 }
 
+static unsigned Array_idx_length(jsdisp_t *jsdisp)
+{
+    return array_from_jsdisp(jsdisp)->elem_cnt;
+}
+
+static HRESULT Array_idx_get(jsdisp_t *jsdisp, unsigned idx, jsval_t *r)
+{
+    ArrayInstance *array = array_from_jsdisp(jsdisp);
+
+    TRACE("%p[%u] = %s\n", array, idx, debugstr_jsval(array->elems[idx]));
+
+    return jsval_copy(array->elems[idx], r);
+}
+
+static HRESULT Array_idx_put(jsdisp_t *jsdisp, unsigned idx, jsval_t val)
+{
+    ArrayInstance *array = array_from_jsdisp(jsdisp);
+    jsval_t copy;
+    HRESULT hres;
+
+    TRACE("%p[%u] = %s\n", array, idx, debugstr_jsval(val));
+
+    hres = jsval_copy(val, &copy);
+    if(FAILED(hres))
+        return hres;
+
+    jsval_release(array->elems[idx]);
+    array->elems[idx] = copy;
+    return S_OK;
+}
+
 static const builtin_prop_t Array_props[] = {
     {L"concat",                Array_concat,               PROPF_METHOD|1},
     {L"forEach",               Array_forEach,              PROPF_METHOD|PROPF_ES5|1},
@@ -1283,7 +1359,10 @@ static const builtin_info_t Array_info = {
     ARRAY_SIZE(Array_props),
     Array_props,
     Array_destructor,
-    Array_on_put
+    Array_on_put,
+    Array_idx_length,
+    Array_idx_get,
+    Array_idx_put
 };
 
 static const builtin_prop_t ArrayInst_props[] = {
@@ -1296,7 +1375,10 @@ static const builtin_info_t ArrayInst_info = {
     ARRAY_SIZE(ArrayInst_props),
     ArrayInst_props,
     Array_destructor,
-    Array_on_put
+    Array_on_put,
+    Array_idx_length,
+    Array_idx_get,
+    Array_idx_put
 };
 
 /* ECMA-262 5.1 Edition    15.4.3.2 */
@@ -177,6 +177,91 @@ static inline HRESULT resize_props(jsdisp_t *This)
     return S_OK;
 }
 
+/*
+ * Array elements [0, idx_length) are kept in a dense store managed by array.c instead of
+ * the props table. PROP_IDX props are allocated for them lazily, when they are looked up
+ * by name, and elements outside of the store use regular props.
+ */
+static inline unsigned dense_length(jsdisp_t *This)
+{
+    return is_class(This, JSCLASS_ARRAY) ? This->builtin_info->idx_length(This) : 0;
+}
+
+static BOOL get_array_index(const WCHAR *name, DWORD *ret)
+{
+    const WCHAR *ptr;
+    UINT64 idx = 0;
+
+    if(!is_digit(*name) || (*name == '0' && name[1]))
+        return FALSE;
+
+    for(ptr = name; is_digit(*ptr); ptr++) {
+        idx = idx*10 + (*ptr-'0');
+        if(idx >= 0xffffffff)
+            return FALSE;
+    }
+    if(*ptr)
+        return FALSE;
+
+    *ret = idx;
+    return TRUE;
+}
+
+static const WCHAR *idx_to_str(DWORD idx, WCHAR *buf, unsigned size)
+{
+    WCHAR *ptr = buf + size - 1;
+
+    *ptr = 0;
+    do {
+        *--ptr = '0' + idx%10;
+        idx /= 10;
+    }while(idx);
+
+    return ptr;
+}
+
+static dispex_prop_t *lookup_prop(jsdisp_t *This, unsigned hash, const WCHAR *name)
+{
+    unsigned bucket, pos, prev = 0;
+
+    bucket = get_props_idx(This, hash);
+    pos = This->props[bucket].bucket_head;
+    while(pos != 0) {
+        if(!wcscmp(name, This->props[pos].name)) {
+            if(prev != 0) {
+                This->props[prev].bucket_next = This->props[pos].bucket_next;
+                This->props[pos].bucket_next = This->props[bucket].bucket_head;
+                This->props[bucket].bucket_head = pos;
+            }
+
+            return &This->props[pos];
+        }
+
+        prev = pos;
+        pos = This->props[pos].bucket_next;
+    }
+
+    return NULL;
+}
+
+static dispex_prop_t *lookup_idx_prop(jsdisp_t *This, DWORD idx)
+{
+    const WCHAR *name;
+    WCHAR buf[11];
+
+    name = idx_to_str(idx, buf, ARRAY_SIZE(buf));
+    return lookup_prop(This, string_hash(name), name);
+}
+
+/* Arrays with no index props outside of the dense store can append to it without a lookup. */
+static void note_idx_prop(jsdisp_t *This, const dispex_prop_t *prop)
+{
+    DWORD idx;
+
+    if(!This->idx_props && is_class(This, JSCLASS_ARRAY) && get_array_index(prop->name, &idx))
+        This->idx_props = TRUE;
+}
+
 static inline dispex_prop_t* alloc_prop(jsdisp_t *This, const WCHAR *name, prop_type_t type, DWORD flags)
 {
     dispex_prop_t *prop;
@@ -192,6 +277,8 @@ static inline dispex_prop_t* alloc_prop(jsdisp_t *This, const WCHAR *name, prop_
     prop->type = type;
     prop->flags = flags;
     prop->hash = string_hash(name);
+    if(type != PROP_IDX)
+        note_idx_prop(This, prop);
 
     bucket = get_props_idx(This, prop->hash);
     prop->bucket_next = This->props[bucket].bucket_head;
@@ -214,25 +301,22 @@ static dispex_prop_t *alloc_protref(jsdisp_t *This, const WCHAR *name, DWORD ref
 static HRESULT find_prop_name(jsdisp_t *This, unsigned hash, const WCHAR *name, dispex_prop_t **ret)
 {
     const builtin_prop_t *builtin;
-    unsigned bucket, pos, prev = 0;
     dispex_prop_t *prop;
 
-    bucket = get_props_idx(This, hash);
-    pos = This->props[bucket].bucket_head;
-    while(pos != 0) {
-        if(!wcscmp(name, This->props[pos].name)) {
-            if(prev != 0) {
-                This->props[prev].bucket_next = This->props[pos].bucket_next;
-                This->props[pos].bucket_next = This->props[bucket].bucket_head;
-                This->props[bucket].bucket_head = pos;
-            }
+    prop = lookup_prop(This, hash, name);
+    if(prop) {
+        DWORD idx;
 
-            *ret = &This->props[pos];
-            return S_OK;
+        /* The element was deleted and then added back to the dense store. */
+        if(prop->type == PROP_DELETED && dense_length(This) && get_array_index(name, &idx)
+           && idx < dense_length(This)) {
+            prop->type = PROP_IDX;
+            prop->flags = PROPF_ALL;
+            prop->u.idx = idx;
         }
 
-        prev = pos;
-        pos = This->props[pos].bucket_next;
+        *ret = prop;
+        return S_OK;
     }
 
     builtin = find_builtin_prop(This, name);
@@ -252,7 +336,19 @@ static HRESULT find_prop_name(jsdisp_t *This, unsigned hash, const WCHAR *name,
         return S_OK;
     }
 
-    if(This->builtin_info->idx_length) {
+    if(is_class(This, JSCLASS_ARRAY)) {
+        DWORD idx;
+
+        if(get_array_index(name, &idx) && idx < dense_length(This)) {
+            prop = alloc_prop(This, name, PROP_IDX, PROPF_ALL);
+            if(!prop)
+                return E_OUTOFMEMORY;
+
+            prop->u.idx = idx;
+            *ret = prop;
+            return S_OK;
+        }
+    }else if(This->builtin_info->idx_length) {
         const WCHAR *ptr;
         unsigned idx = 0;
 
@@ -296,6 +392,7 @@ static HRESULT find_prop_name_prot(jsdisp_t *This, unsigned hash, const WCHAR *n
             if(del) {
                 del->type = PROP_PROTREF;
                 del->u.ref = prop - This->prototype->props;
+                note_idx_prop(This, del);
                 prop = del;
             }else {
                 prop = alloc_protref(This, prop->name, prop - This->prototype->props);
@@ -325,6 +422,7 @@ static HRESULT ensure_prop_name(jsdisp_t *This, const WCHAR *name, DWORD create_
             prop->type = PROP_JSVAL;
             prop->flags = create_flags;
             prop->u.val = jsval_undefined();
+            note_idx_prop(This, prop);
         }else {
             prop = alloc_prop(This, name, PROP_JSVAL, create_flags);
             if(!prop)
@@ -338,6 +436,142 @@ static HRESULT ensure_prop_name(jsdisp_t *This, const WCHAR *name, DWORD create_
     return hres;
 }
 
+static void truncate_dense_elems(jsdisp_t *This, unsigned length)
+{
+    unsigned i, old_length = dense_length(This);
+    dispex_prop_t *prop;
+
+    for(i = length; i < old_length; i++) {
+        prop = lookup_idx_prop(This, i);
+        if(prop && prop->type == PROP_IDX)
+            prop->type = PROP_DELETED;
+    }
+
+    array_truncate_elems(This, length);
+}
+
+/* Moves elements [from, idx_length) out of the dense store to regular props. */
+static HRESULT spill_dense_elems(jsdisp_t *This, unsigned from)
+{
+    unsigned i, length = dense_length(This);
+    dispex_prop_t *prop;
+    const WCHAR *name;
+    WCHAR buf[11];
+    jsval_t *vals;
+    HRESULT hres = S_OK;
+
+    if(from >= length)
+        return S_OK;
+
+    TRACE("%p [%u, %u)\n", This, from, length);
+
+    vals = heap_alloc((length - from) * sizeof(*vals));
+    if(!vals)
+        return E_OUTOFMEMORY;
+
+    for(i = from; i < length; i++) {
+        hres = This->builtin_info->idx_get(This, i, vals + i - from);
+        if(FAILED(hres)) {
+            while(i-- > from)
+                jsval_release(vals[i - from]);
+            heap_free(vals);
+            return hres;
+        }
+    }
+
+    truncate_dense_elems(This, from);
+
+    for(i = from; i < length; i++) {
+        prop = NULL;
+        if(SUCCEEDED(hres)) {
+            name = idx_to_str(i, buf, ARRAY_SIZE(buf));
+            prop = lookup_prop(This, string_hash(name), name);
+            if(prop) {
+                prop->type = PROP_JSVAL;
+                prop->flags = PROPF_ALL;
+                note_idx_prop(This, prop);
+            }else {
+                prop = alloc_prop(This, name, PROP_JSVAL, PROPF_ALL);
+                if(!prop)
+                    hres = E_OUTOFMEMORY;
+            }
+        }
+
+        if(prop)
+            prop->u.val = vals[i - from];
+        else
+            jsval_release(vals[i - from]);
+    }
+
+    heap_free(vals);
+    return hres;
+}
+
+static HRESULT delete_dense_elem(jsdisp_t *This, unsigned idx)
+{
+    HRESULT hres;
+
+    /* The store can't have holes, so elements above idx become regular props. */
+    hres = spill_dense_elems(This, idx + 1);
+    if(FAILED(hres))
+        return hres;
+
+    truncate_dense_elems(This, idx);
+    return S_OK;
+}
+
+/* Returns S_FALSE if the element needs to be stored in a regular prop. */
+static HRESULT put_dense_elem(jsdisp_t *This, DWORD idx, jsval_t val)
+{
+    dispex_prop_t *prop;
+    jsdisp_t *iter;
+    unsigned length;
+
+    if(!is_class(This, JSCLASS_ARRAY))
+        return S_FALSE;
+
+    length = This->builtin_info->idx_length(This);
+    if(idx < length)
+        return This->builtin_info->idx_put(This, idx, val);
+
+    /* Only appending keeps the store dense. A regular prop with the same name, including
+     * a reference to the prototype, takes precedence over the store. */
+    if(idx != length || !This->extensible)
+        return S_FALSE;
+
+    if(This->idx_props) {
+        prop = lookup_idx_prop(This, idx);
+        if(prop && prop->type != PROP_DELETED)
+            return S_FALSE;
+    }
+
+    /* A setter in the prototype chain has to be called instead. */
+    for(iter = This->prototype; iter; iter = iter->prototype) {
+        if(iter->idx_accessors)
+            return S_FALSE;
+    }
+
+    return array_append_elem(This, val);
+}
+
+static HRESULT fill_dense_props(jsdisp_t *This)
+{
+    unsigned i, length = dense_length(This);
+    dispex_prop_t *prop;
+    const WCHAR *name;
+    WCHAR buf[11];
+    HRESULT hres;
+
+    for(i = 0; i < length; i++) {
+        name = idx_to_str(i, buf, ARRAY_SIZE(buf));
+        hres = find_prop_name(This, string_hash(name), name, &prop);
+        if(FAILED(hres))
+            return hres;
+    }
+
+    return S_OK;
+}
+
 static IDispatch *get_this(DISPPARAMS *dp)
 {
     DWORD i;
@@ -479,6 +713,7 @@ static HRESULT prop_put(jsdisp_t *This, dispex_prop_t *prop, jsval_t val)
         prop->type = PROP_JSVAL;
         prop->flags = PROPF_ENUMERABLE | PROPF_CONFIGURABLE | PROPF_WRITABLE;
         prop->u.val = jsval_undefined();
+        note_idx_prop(This, prop);
         break;
     case PROP_JSVAL:
         if(!(prop->flags & PROPF_WRITABLE))
@@ -614,6 +849,7 @@ static HRESULT fill_protrefs(jsdisp_t *This)
                 prop->type = PROP_PROTREF;
                 prop->flags = 0;
                 prop->u.ref = iter - This->prototype->props;
+                note_idx_prop(This, prop);
             }else {
                 prop = alloc_protref(This, iter->name, iter - This->prototype->props);
                 if(!prop)
@@ -1610,7 +1846,7 @@ static HRESULT WINAPI DispatchEx_InvokeEx(IDispatchEx *iface, DISPID id, LCID lc
     return leave_script(This->ctx, hres);
 }
 
-static HRESULT delete_prop(dispex_prop_t *prop, BOOL *ret)
+static HRESULT delete_prop(jsdisp_t *This, dispex_prop_t *prop, BOOL *ret)
 {
     if(!(prop->flags & PROPF_CONFIGURABLE)) {
         *ret = FALSE;
@@ -1623,6 +1859,8 @@ static HRESULT delete_prop(dispex_prop_t *prop, BOOL *ret)
         jsval_release(prop->u.val);
         prop->type = PROP_DELETED;
     }
+    if(prop->type == PROP_IDX && is_class(This, JSCLASS_ARRAY))
+        return delete_dense_elem(This, prop->u.idx);
     if(prop->type == PROP_ACCESSOR)
         FIXME("not supported on accessor property\n");
     return S_OK;
@@ -1648,7 +1886,7 @@ static HRESULT WINAPI DispatchEx_DeleteMemberByName(IDispatchEx *iface, BSTR bst
         return S_OK;
     }
 
-    return delete_prop(prop, &b);
+    return delete_prop(This, prop, &b);
 }
 
 static HRESULT WINAPI DispatchEx_DeleteMemberByDispID(IDispatchEx *iface, DISPID id)
@@ -1665,7 +1903,7 @@ static HRESULT WINAPI DispatchEx_DeleteMemberByDispID(IDispatchEx *iface, DISPID
         return DISP_E_MEMBERNOTFOUND;
     }
 
-    return delete_prop(prop, &b);
+    return delete_prop(This, prop, &b);
 }
 
 static HRESULT WINAPI DispatchEx_GetMemberProperties(IDispatchEx *iface, DISPID id, DWORD grfdexFetch, DWORD *pgrfdex)
@@ -1750,6 +1988,8 @@ HRESULT init_dispex(jsdisp_t *dispex, script_ctx_t *ctx, const builtin_info_t *b
     dispex->ref = 1;
     dispex->builtin_info = builtin_info;
     dispex->extensible = TRUE;
+    dispex->idx_accessors = FALSE;
+    dispex->idx_props = FALSE;
 
     dispex->props = heap_alloc_zero(sizeof(dispex_prop_t)*(dispex->buf_size=4));
     if(!dispex->props)
@@ -2143,7 +2383,7 @@ HRESULT disp_call_value(script_ctx_t *ctx, IDispatch *disp, IDispatch *jsthis, W
     return hres;
 }
 
-HRESULT jsdisp_propput(jsdisp_t *obj, const WCHAR *name, DWORD flags, BOOL throw, jsval_t val)
+static HRESULT propput(jsdisp_t *obj, const WCHAR *name, DWORD flags, BOOL throw, jsval_t val)
 {
     dispex_prop_t *prop;
     HRESULT hres;
@@ -2160,6 +2400,20 @@ HRESULT jsdisp_propput(jsdisp_t *obj, const WCHAR *name, DWORD flags, BOOL throw
     return prop_put(obj, prop, val);
 }
 
+HRESULT jsdisp_propput(jsdisp_t *obj, const WCHAR *name, DWORD flags, BOOL throw, jsval_t val)
+{
+    DWORD idx;
+    HRESULT hres;
+
+    if(flags == PROPF_ALL && is_class(obj, JSCLASS_ARRAY) && get_array_index(name, &idx)) {
+        hres = put_dense_elem(obj, idx, val);
+        if(hres != S_FALSE)
+            return hres;
+    }
+
+    return propput(obj, name, flags, throw, val);
+}
+
 HRESULT jsdisp_propput_name(jsdisp_t *obj, const WCHAR *name, jsval_t val)
 {
     return jsdisp_propput(obj, name, PROPF_ENUMERABLE | PROPF_CONFIGURABLE | PROPF_WRITABLE, FALSE, val);
@@ -2168,9 +2422,14 @@ HRESULT jsdisp_propput_name(jsdisp_t *obj, const WCHAR *name, jsval_t val)
 HRESULT jsdisp_propput_idx(jsdisp_t *obj, DWORD idx, jsval_t val)
 {
     WCHAR buf[12];
+    HRESULT hres;
+
+    hres = put_dense_elem(obj, idx, val);
+    if(hres != S_FALSE)
+        return hres;
 
     swprintf(buf, ARRAY_SIZE(buf), L"%d", idx);
-    return jsdisp_propput(obj, buf, PROPF_ENUMERABLE | PROPF_CONFIGURABLE | PROPF_WRITABLE, TRUE, val);
+    return propput(obj, buf, PROPF_ENUMERABLE | PROPF_CONFIGURABLE | PROPF_WRITABLE, TRUE, val);
 }
 
 HRESULT disp_propput(script_ctx_t *ctx, IDispatch *disp, DISPID id, jsval_t val)
@@ -2241,6 +2500,23 @@ HRESULT disp_propput_name(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name,
     return jsdisp_propput_name(jsdisp, name, val);
 }
 
+HRESULT disp_propput_idx(script_ctx_t *ctx, IDispatch *disp, DWORD idx, jsval_t val)
+{
+    jsdisp_t *jsdisp;
+    WCHAR buf[12];
+    HRESULT hres;
+
+    jsdisp = to_jsdisp(disp);
+    if(jsdisp && jsdisp->ctx == ctx) {
+        hres = put_dense_elem(jsdisp, idx, val);
+        if(hres != S_FALSE)
+            return hres;
+    }
+
+    swprintf(buf, ARRAY_SIZE(buf), L"%u", idx);
+    return disp_propput_name(ctx, disp, buf, val);
+}
+
 HRESULT jsdisp_propget_name(jsdisp_t *obj, const WCHAR *name, jsval_t *val)
 {
     dispex_prop_t *prop;
@@ -2264,6 +2540,9 @@ HRESULT jsdisp_get_idx(jsdisp_t *obj, DWORD idx, jsval_t *r)
     dispex_prop_t *prop;
     HRESULT hres;
 
+    if(idx < dense_length(obj))
+        return obj->builtin_info->idx_get(obj, idx, r);
+
     swprintf(name, ARRAY_SIZE(name), L"%d", idx);
 
     hres = find_prop_name_prot(obj, string_hash(name), name, &prop);
@@ -2319,13 +2598,16 @@ HRESULT jsdisp_delete_idx(jsdisp_t *obj, DWORD idx)
     BOOL b;
     HRESULT hres;
 
+    if(idx < dense_length(obj))
+        return delete_dense_elem(obj, idx);
+
     swprintf(buf, ARRAY_SIZE(buf), L"%d", idx);
 
     hres = find_prop_name(obj, string_hash(buf), buf, &prop);
     if(FAILED(hres) || !prop)
         return hres;
 
-    hres = delete_prop(prop, &b);
+    hres = delete_prop(obj, prop, &b);
     if(FAILED(hres))
         return hres;
     return b ? S_OK : JS_E_INVALID_ACTION;
@@ -2343,7 +2625,7 @@ HRESULT disp_delete(IDispatch *disp, DISPID id, BOOL *ret)
 
         prop = get_prop(jsdisp, id);
         if(prop)
-            hres = delete_prop(prop, ret);
+            hres = delete_prop(jsdisp, prop, ret);
         else
             hres = DISP_E_MEMBERNOTFOUND;
 
@@ -2371,6 +2653,12 @@ HRESULT jsdisp_next_prop(jsdisp_t *obj, DISPID id, enum jsdisp_enum_type enum_ty
     dispex_prop_t *iter;
     HRESULT hres;
 
+    if(id == DISPID_STARTENUM && dense_length(obj)) {
+        hres = fill_dense_props(obj);
+        if(FAILED(hres))
+            return hres;
+    }
+
     if(id == DISPID_STARTENUM && enum_type == JSDISP_ENUM_ALL) {
         hres = fill_protrefs(obj);
         if(FAILED(hres))
@@ -2414,7 +2702,7 @@ HRESULT disp_delete_name(script_ctx_t *ctx, IDispatch *disp, jsstr_t *name, BOOL
 
         hres = find_prop_name(jsdisp, string_hash(ptr), ptr, &prop);
         if(prop) {
-            hres = delete_prop(prop, ret);
+            hres = delete_prop(jsdisp, prop, ret);
         }else {
             *ret = TRUE;
             hres = S_OK;
@@ -2469,6 +2757,10 @@ HRESULT jsdisp_get_own_property(jsdisp_t *obj, const WCHAR *name, BOOL flags_onl
     memset(desc, 0, sizeof(*desc));
 
     switch(prop->type) {
+    case PROP_IDX:
+        if(!is_class(obj, JSCLASS_ARRAY))
+            return DISP_E_UNKNOWNNAME;
+        /* fall through */
     case PROP_BUILTIN:
     case PROP_JSVAL:
         desc->mask |= PROPF_WRITABLE;
@@ -2501,11 +2793,25 @@ HRESULT jsdisp_define_property(jsdisp_t *obj, const WCHAR *name, property_desc_t
 {
     dispex_prop_t *prop;
     HRESULT hres;
+    DWORD idx;
 
     hres = find_prop_name(obj, string_hash(name), name, &prop);
     if(FAILED(hres))
         return hres;
 
+    if((desc->explicit_getter || desc->explicit_setter) && get_array_index(name, &idx))
+        obj->idx_accessors = TRUE;
+
+    if(prop && prop->type == PROP_IDX && is_class(obj, JSCLASS_ARRAY)) {
+        DISPID id = prop_to_id(obj, prop);
+
+        /* The dense store holds only plain data props. */
+        hres = spill_dense_elems(obj, prop->u.idx);
+        if(FAILED(hres))
+            return hres;
+        prop = obj->props + id;
+    }
+
     if((!prop || prop->type == PROP_DELETED) && !obj->extensible)
         return throw_error(obj->ctx, JS_E_OBJECT_NONEXTENSIBLE, name);
 
@@ -2513,6 +2819,7 @@ HRESULT jsdisp_define_property(jsdisp_t *obj, const WCHAR *name, property_desc_t
        return E_OUTOFMEMORY;
 
     if(prop->type == PROP_DELETED || prop->type == PROP_PROTREF) {
+        note_idx_prop(obj, prop);
         prop->flags = desc->flags;
         if(desc->explicit_getter || desc->explicit_setter) {
             prop->type = PROP_ACCESSOR;
@@ -2631,9 +2938,14 @@ HRESULT jsdisp_define_data_property(jsdisp_t *obj, const WCHAR *name, unsigned f
     return jsdisp_define_property(obj, name, &prop_desc);
 }
 
-void jsdisp_freeze(jsdisp_t *obj, BOOL seal)
+HRESULT jsdisp_freeze(jsdisp_t *obj, BOOL seal)
 {
     unsigned int i;
+    HRESULT hres;
+
+    hres = spill_dense_elems(obj, 0);
+    if(FAILED(hres))
+        return hres;
 
     for(i = 0; i < obj->prop_cnt; i++) {
         if(!seal && obj->props[i].type == PROP_JSVAL)
@@ -2642,13 +2954,14 @@ void jsdisp_freeze(jsdisp_t *obj, BOOL seal)
     }
 
     obj->extensible = FALSE;
+    return S_OK;
 }
 
 BOOL jsdisp_is_frozen(jsdisp_t *obj, BOOL sealed)
 {
     unsigned int i;
 
-    if(obj->extensible)
+    if(obj->extensible || dense_length(obj))
         return FALSE;
 
     for(i = 0; i < obj->prop_cnt; i++) {
@@ -56,6 +56,12 @@ typedef struct {
 
 static const size_t stack_size = 0x40000;
 
+/* Number usable directly as an element index, see interp_to_string. */
+static inline BOOL is_index(jsval_t v)
+{
+    return is_number(v) && get_number(v) >= 0 && is_int32(get_number(v));
+}
+
 static HRESULT stack_push(script_ctx_t *ctx, jsval_t v)
 {
     if(ctx->stack_top == stack_size)
@@ -1225,6 +1231,20 @@ static HRESULT interp_array(script_ctx_t *ctx)
         return hres;
     }
 
+    if(is_index(namev)) {
+        jsdisp_t *jsdisp = to_jsdisp(obj);
+
+        if(jsdisp && jsdisp->ctx == ctx) {
+            hres = jsdisp_get_idx(jsdisp, get_number(namev), &v);
+            IDispatch_Release(obj);
+            if(hres == DISP_E_UNKNOWNNAME)
+                hres = S_OK;
+            if(FAILED(hres))
+                return hres;
+            return stack_push(ctx, v);
+        }
+    }
+
     hres = to_flat_string(ctx, namev, &name_str, &name);
     jsval_release(namev);
     if(FAILED(hres)) {
@@ -2696,6 +2716,11 @@ static HRESULT interp_to_string(script_ctx_t *ctx)
     jsval_t v;
     HRESULT hres;
 
+    /* Converting an element index has no side effects, so leave it to the consumer,
+     * which may then skip the conversion. */
+    if(is_index(stack_top(ctx)))
+        return S_OK;
+
     v = stack_pop(ctx);
     TRACE("%s\n", debugstr_jsval(v));
     hres = to_string(ctx, v, &str);
@@ -2744,19 +2769,21 @@ static HRESULT interp_set_member(script_ctx_t *ctx)
 
     value = stack_pop(ctx);
     namev = stack_pop(ctx);
-    assert(is_string(namev));
+    assert(is_string(namev) || is_index(namev));
     objv = stack_pop(ctx);
 
     TRACE("%s.%s = %s\n", debugstr_jsval(objv), debugstr_jsval(namev), debugstr_jsval(value));
 
     hres = to_object(ctx, objv, &obj);
     jsval_release(objv);
-    if(SUCCEEDED(hres) && !(name = jsstr_flatten(get_string(namev)))) {
+    if(SUCCEEDED(hres) && is_index(namev)) {
+        hres = disp_propput_idx(ctx, obj, get_number(namev), value);
         IDispatch_Release(obj);
-        hres = E_OUTOFMEMORY;
-    }
-    if(SUCCEEDED(hres)) {
-        hres = disp_propput_name(ctx, obj, name, value);
+    }else if(SUCCEEDED(hres)) {
+        if((name = jsstr_flatten(get_string(namev))))
+            hres = disp_propput_name(ctx, obj, name, value);
+        else
+            hres = E_OUTOFMEMORY;
         IDispatch_Release(obj);
         jsstr_release(get_string(namev));
     }
@@ -716,6 +716,7 @@ static HRESULT Object_freeze(script_ctx_t *ctx, vdisp_t *jsthis, WORD flags, uns
                              jsval_t *argv, jsval_t *r)
 {
     jsdisp_t *obj;
+    HRESULT hres;
 
     if(!argc || !is_object_instance(argv[0]) || !get_object(argv[0])) {
         WARN("argument is not an object\n");
@@ -730,7 +731,10 @@ static HRESULT Object_freeze(script_ctx_t *ctx, vdisp_t *jsthis, WORD flags, uns
         return E_NOTIMPL;
     }
 
-    jsdisp_freeze(obj, FALSE);
+    hres = jsdisp_freeze(obj, FALSE);
+    if(FAILED(hres))
+        return hres;
+
     if(r) *r = jsval_obj(jsdisp_addref(obj));
     return S_OK;
 }
@@ -739,6 +743,7 @@ static HRESULT Object_seal(script_ctx_t *ctx, vdisp_t *jsthis, WORD flags, unsig
                            jsval_t *argv, jsval_t *r)
 {
     jsdisp_t *obj;
+    HRESULT hres;
 
     if(!argc || !is_object_instance(argv[0]) || !get_object(argv[0])) {
         WARN("argument is not an object\n");
@@ -753,7 +758,10 @@ static HRESULT Object_seal(script_ctx_t *ctx, vdisp_t *jsthis, WORD flags, unsig
         return E_NOTIMPL;
     }
 
-    jsdisp_freeze(obj, TRUE);
+    hres = jsdisp_freeze(obj, TRUE);
+    if(FAILED(hres))
+        return hres;
+
     if(r) *r = jsval_obj(jsdisp_addref(obj));
     return S_OK;
 }
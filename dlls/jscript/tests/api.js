@@ -1170,6 +1170,39 @@ ok(tmp === (invokeVersion < 2 ? undefined : 3), "unshift returned " +tmp);
 ok(arr.length === 3, "arr.length = " + arr.length);
 ok(arr[0] === 0 && arr[1] === 1 && arr[2] === 2, "unexpected array");
 
+arr = [1,2,3,4];
+delete arr[1];
+ok(arr.length === 4, "arr.length = " + arr.length);
+ok(!arr.hasOwnProperty("1") && arr.hasOwnProperty("2"), "unexpected own properties");
+ok(arr.toString() === "1,,3,4", "arr.toString() = " + arr.toString());
+arr[1] = 5;
+arr.push(6);
+ok(arr.toString() === "1,5,3,4,6", "arr.toString() = " + arr.toString());
+arr.length = 1;
+ok(!arr.hasOwnProperty("1") && arr[1] === undefined, "arr[1] = " + arr[1]);
+arr.push(7);
+ok(arr.hasOwnProperty("1") && arr[1] === 7, "arr[1] = " + arr[1]);
+arr[5] = 8;
+arr[2] = 9;
+ok(arr.length === 6, "arr.length = " + arr.length);
+ok(arr.toString() === "1,7,9,,,8", "arr.toString() = " + arr.toString());
+arr = [1,2];
+arr.push(3);
+arr[3] = 4;
+tmp = "";
+for(var iter in arr)
+    tmp += iter + ",";
+ok(tmp === "0,1,2,3,", "for in = " + tmp);
+arr = [1,2,3];
+delete arr[1];
+arr[1] = "a";
+arr[2] = "b";
+arr.push("c");
+ok(arr.length === 4, "arr.length = " + arr.length);
+ok(arr.toString() === "1,a,b,c", "arr.toString() = " + arr.toString());
+delete arr[2];
+ok(arr.toString() === "1,a,,c", "arr.toString() = " + arr.toString());
+
 arr = [1,2,,4];
 tmp = arr.shift();
 ok(tmp === 1, "[1,2,,4].shift() = " + tmp);
@@ -889,6 +889,83 @@ static void test_HeapQueryInformation(void)
     ok(info == 0 || info == 1 || info == 2, "expected 0, 1 or 2, got %u\n", info);
 }
 
+static void test_HeapSetInformation(void)
+{
+    ULONG info;
+    HANDLE heap;
+    BYTE *ptrs[300], *p;
+    SIZE_T size;
+    unsigned int i, j;
+    BOOL ret;
+
+    if (!pHeapQueryInformation)
+    {
+        win_skip("HeapQueryInformation is not available\n");
+        return;
+    }
+
+    heap = HeapCreate( HEAP_NO_SERIALIZE, 0, 0 );
+    ok( heap != NULL, "HeapCreate failed\n" );
+    info = 2;
+    ret = HeapSetInformation( heap, HeapCompatibilityInformation, &info, sizeof(info) );
+    ok( !ret, "HeapSetInformation succeeded\n" );
+    HeapDestroy( heap );
+
+    heap = HeapCreate( 0, 0, 0 );
+    ok( heap != NULL, "HeapCreate failed\n" );
+    info = 2;
+    ret = HeapSetInformation( heap, HeapCompatibilityInformation, &info, sizeof(info) );
+    ok( ret, "HeapSetInformation error %u\n", GetLastError() );
+    info = 0xdeadbeef;
+    ret = pHeapQueryInformation( heap, HeapCompatibilityInformation, &info, sizeof(info), NULL );
+    ok( ret, "HeapQueryInformation error %u\n", GetLastError() );
+    ok( info == 2, "expected 2, got %u\n", info );
+
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        size = 1 + i % 600;
+        ptrs[i] = HeapAlloc( heap, HEAP_ZERO_MEMORY, size );
+        ok( ptrs[i] != NULL, "HeapAlloc failed\n" );
+        ok( !((ULONG_PTR)ptrs[i] % (2 * sizeof(void *))), "got unaligned block %p\n", ptrs[i] );
+        ok( HeapSize( heap, 0, ptrs[i] ) == size, "got size %lu\n", HeapSize( heap, 0, ptrs[i] ) );
+        for (j = 0; j < size; j++) if (ptrs[i][j]) break;
+        ok( j == size, "block %p not zeroed at %u\n", ptrs[i], j );
+        memset( ptrs[i], i, size );
+    }
+    ok( HeapValidate( heap, 0, ptrs[10] ), "HeapValidate failed\n" );
+    ok( HeapValidate( heap, 0, NULL ), "HeapValidate failed\n" );
+
+    /* invalid pointers must not crash the front end */
+    p = VirtualAlloc( NULL, 0x1000, MEM_COMMIT, PAGE_READWRITE );
+    ok( p != NULL, "VirtualAlloc failed\n" );
+    ret = VirtualFree( p, 0, MEM_RELEASE );
+    ok( ret, "VirtualFree failed\n" );
+    ok( !HeapValidate( heap, 0, p + 0x10 ), "HeapValidate succeeded\n" );
+
+    for (i = 0; i < ARRAY_SIZE(ptrs); i += 2)
+    {
+        size = 1 + i % 600;
+        p = HeapReAlloc( heap, 0, ptrs[i], size + 100 );
+        ok( p != NULL, "HeapReAlloc failed\n" );
+        ok( HeapSize( heap, 0, p ) == size + 100, "got size %lu\n", HeapSize( heap, 0, p ) );
+        for (j = 0; j < size; j++) if (p[j] != (BYTE)i) break;
+        ok( j == size, "block %p content lost at %u\n", p, j );
+        ptrs[i] = p;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        ret = HeapFree( heap, 0, ptrs[i] );
+        ok( ret, "HeapFree failed\n" );
+    }
+    ok( HeapValidate( heap, 0, NULL ), "HeapValidate failed\n" );
+
+    info = 0;
+    ret = HeapSetInformation( heap, HeapCompatibilityInformation, &info, sizeof(info) );
+    ok( !ret, "HeapSetInformation succeeded\n" );
+    HeapDestroy( heap );
+}
+
 static void test_heap_checks( DWORD flags )
 {
     BYTE old, *p, *p2;
@@ -1296,6 +1373,7 @@ START_TEST(heap)
     test_sized_HeapReAlloc((1 << 20), 1);
 
     test_HeapQueryInformation();
+    test_HeapSetInformation();
     test_GetPhysicallyInstalledSystemMemory();
     test_GlobalMemoryStatus();
 
@@ -28,6 +28,7 @@
 #define WIN32_NO_STATUS
 #include "windef.h"
 #include "winbase.h"
+#include "winreg.h"
 #include "winternl.h"
 #include "winnls.h"
 #include "wine/test.h"
@@ -4031,6 +4032,293 @@ static void test_Wow64Transition(void)
             debugstr_wn(name->SectionFileName.Buffer, name->SectionFileName.Length / sizeof(WCHAR)));
 }
 
+static void create_import_dll( const char *dll_name, const char *module, const char *function )
+{
+    DWORD dummy;
+    HANDLE hfile;
+    struct imports
+    {
+        IMAGE_IMPORT_DESCRIPTOR descr[2];
+        IMAGE_THUNK_DATA original_thunks[2];
+        IMAGE_THUNK_DATA thunks[2];
+        char module[16];
+        struct { WORD hint; char name[32]; } function;
+    } data;
+    IMAGE_NT_HEADERS nt;
+    IMAGE_SECTION_HEADER section;
+
+#define DATA_RVA(ptr) (page_size + ((char *)(ptr) - (char *)&data))
+    nt = nt_header_template;
+    nt.FileHeader.NumberOfSections = 1;
+    nt.FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER);
+    nt.FileHeader.Characteristics = IMAGE_FILE_EXECUTABLE_IMAGE | IMAGE_FILE_32BIT_MACHINE |
+                                    IMAGE_FILE_RELOCS_STRIPPED | IMAGE_FILE_DLL;
+    nt.OptionalHeader.SectionAlignment = page_size;
+    nt.OptionalHeader.FileAlignment = 0x200;
+    nt.OptionalHeader.ImageBase = 0x12340000;
+    nt.OptionalHeader.SizeOfImage = 2 * page_size;
+    nt.OptionalHeader.SizeOfHeaders = nt.OptionalHeader.FileAlignment;
+    nt.OptionalHeader.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+    memset( nt.OptionalHeader.DataDirectory, 0, sizeof(nt.OptionalHeader.DataDirectory) );
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].Size = sizeof(data.descr);
+    nt.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT].VirtualAddress = DATA_RVA(data.descr);
+
+    memset( &data, 0, sizeof(data) );
+    U(data.descr[0]).OriginalFirstThunk = DATA_RVA( data.original_thunks );
+    data.descr[0].FirstThunk = DATA_RVA( data.thunks );
+    data.descr[0].Name = DATA_RVA( data.module );
+    strcpy( data.module, module );
+    strcpy( data.function.name, function );
+    data.original_thunks[0].u1.AddressOfData = DATA_RVA( &data.function );
+    data.thunks[0].u1.AddressOfData = 0xdeadbeef;
+
+    hfile = CreateFileA( dll_name, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, 0, 0 );
+    ok( hfile != INVALID_HANDLE_VALUE, "failed to create %s err %u\n", dll_name, GetLastError() );
+
+    memset( &section, 0, sizeof(section) );
+    memcpy( section.Name, ".text", sizeof(".text") );
+    section.PointerToRawData = nt.OptionalHeader.FileAlignment;
+    section.VirtualAddress = nt.OptionalHeader.SectionAlignment;
+    section.Misc.VirtualSize = sizeof(data);
+    section.SizeOfRawData = sizeof(data);
+    section.Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ | IMAGE_SCN_MEM_WRITE;
+
+    WriteFile( hfile, &dos_header, sizeof(dos_header), &dummy, NULL );
+    WriteFile( hfile, &nt, sizeof(nt), &dummy, NULL );
+    WriteFile( hfile, &section, sizeof(section), &dummy, NULL );
+    SetFilePointer( hfile, section.PointerToRawData, NULL, SEEK_SET );
+    WriteFile( hfile, &data, sizeof(data), &dummy, NULL );
+    CloseHandle( hfile );
+#undef DATA_RVA
+}
+
+static const char parallel_manifest[] =
+"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+"<assembly xmlns=\"urn:schemas-microsoft-com:asm.v1\" manifestVersion=\"1.0\">\n"
+"  <dependency>\n"
+"    <dependentAssembly>\n"
+"      <assemblyIdentity type=\"win32\" name=\"Microsoft.Windows.Common-Controls\" version=\"6.0.0.0\"\n"
+"                        processorArchitecture=\"*\" publicKeyToken=\"6595b64144ccf1df\" language=\"*\"/>\n"
+"    </dependentAssembly>\n"
+"  </dependency>\n"
+"</assembly>\n";
+
+static char *append_module_list( char *str, const char *title, const LIST_ENTRY *mark, unsigned int offset )
+{
+    const LIST_ENTRY *entry;
+
+    str += sprintf( str, "%s:", title );
+    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
+    {
+        const LDR_DATA_TABLE_ENTRY *mod = (const LDR_DATA_TABLE_ENTRY *)((const char *)entry - offset);
+        *str++ = ' ';
+        str += WideCharToMultiByte( CP_ACP, 0, mod->BaseDllName.Buffer, mod->BaseDllName.Length / sizeof(WCHAR),
+                                    str, MAX_PATH, NULL, NULL );
+    }
+    return str + sprintf( str, "\n" );
+}
+
+/* load some modules and dump the resulting loader state, to compare serial and parallel loading */
+static void child_parallel_load( const char *dir )
+{
+    static const char * const dlls[] = { "oleaut32.dll", "shell32.dll", "setupapi.dll", "wininet.dll" };
+    static char result[32768];
+    PEB_LDR_DATA *ldr = NtCurrentTeb()->Peb->LdrData;
+    char path[MAX_PATH], module_path[MAX_PATH];
+    char *str = result;
+    ACTCTXA actctx;
+    HANDLE context, hfile;
+    ULONG_PTR cookie;
+    HMODULE mod, imported;
+    IMAGE_THUNK_DATA *thunk;
+    DWORD dummy;
+    unsigned int i;
+
+    /* imports redirected by the activation context */
+    sprintf( path, "%s\\parallel.manifest", dir );
+    memset( &actctx, 0, sizeof(actctx) );
+    actctx.cbSize = sizeof(actctx);
+    actctx.lpSource = path;
+    context = CreateActCtxA( &actctx );
+    ok( context != INVALID_HANDLE_VALUE, "CreateActCtx failed err %u\n", GetLastError() );
+    if (context != INVALID_HANDLE_VALUE)
+    {
+        ActivateActCtx( context, &cookie );
+        sprintf( path, "%s\\ldrctl.dll", dir );
+        mod = LoadLibraryA( path );
+        ok( mod != NULL, "failed to load %s err %u\n", path, GetLastError() );
+        DeactivateActCtx( 0, cookie );
+        ReleaseActCtx( context );
+        if (mod)
+        {
+            thunk = (IMAGE_THUNK_DATA *)((char *)mod + page_size + 2 * sizeof(IMAGE_IMPORT_DESCRIPTOR) +
+                                         2 * sizeof(IMAGE_THUNK_DATA));
+            imported = NULL;
+            GetModuleHandleExA( GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                                (const char *)thunk->u1.Function, &imported );
+            ok( imported != NULL, "import not resolved\n" );
+            module_path[0] = 0;
+            GetModuleFileNameA( imported, module_path, MAX_PATH );
+            str += sprintf( str, "actctx import: %s\n", module_path );
+        }
+    }
+
+    /* modules with many dependencies */
+    for (i = 0; i < ARRAY_SIZE(dlls); i++)
+    {
+        mod = LoadLibraryA( dlls[i] );
+        ok( mod != NULL, "failed to load %s err %u\n", dlls[i], GetLastError() );
+    }
+
+    /* failing dependencies */
+    sprintf( path, "%s\\ldrmissing.dll", dir );
+    SetLastError( 0xdeadbeef );
+    mod = LoadLibraryA( path );
+    ok( !mod && GetLastError() == ERROR_MOD_NOT_FOUND, "got %p err %u\n", mod, GetLastError() );
+    str += sprintf( str, "missing dll: %u\n", GetLastError() );
+
+    sprintf( path, "%s\\ldrnoproc.dll", dir );
+    SetLastError( 0xdeadbeef );
+    mod = LoadLibraryA( path );
+    ok( !mod && GetLastError() == ERROR_PROC_NOT_FOUND, "got %p err %u\n", mod, GetLastError() );
+    str += sprintf( str, "missing function: %u\n", GetLastError() );
+
+    str = append_module_list( str, "load order", &ldr->InLoadOrderModuleList,
+                              offsetof( LDR_DATA_TABLE_ENTRY, InLoadOrderLinks ));
+    str = append_module_list( str, "init order", &ldr->InInitializationOrderModuleList,
+                              offsetof( LDR_DATA_TABLE_ENTRY, InInitializationOrderLinks ));
+
+    sprintf( path, "%s\\result.txt", dir );
+    hfile = CreateFileA( path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, 0 );
+    ok( hfile != INVALID_HANDLE_VALUE, "failed to create %s err %u\n", path, GetLastError() );
+    WriteFile( hfile, result, str - result, &dummy, NULL );
+    CloseHandle( hfile );
+}
+
+static char *run_parallel_load( const char *exe, const char *dir )
+{
+    STARTUPINFOA si = { sizeof(si) };
+    PROCESS_INFORMATION pi;
+    char cmdline[2 * MAX_PATH + 32], path[MAX_PATH];
+    char *result = NULL;
+    HANDLE hfile;
+    DWORD size;
+    BOOL ret;
+
+    sprintf( path, "%s\\result.txt", dir );
+    DeleteFileA( path );
+    sprintf( cmdline, "\"%s\" loader parallel_load \"%s\"", exe, dir );
+    ret = CreateProcessA( exe, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi );
+    ok( ret, "CreateProcess failed err %u\n", GetLastError() );
+    if (!ret) return NULL;
+    winetest_wait_child_process( pi.hProcess );
+    CloseHandle( pi.hProcess );
+    CloseHandle( pi.hThread );
+
+    hfile = CreateFileA( path, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, 0 );
+    ok( hfile != INVALID_HANDLE_VALUE, "no result from child\n" );
+    if (hfile == INVALID_HANDLE_VALUE) return NULL;
+    size = GetFileSize( hfile, NULL );
+    result = malloc( size + 1 );
+    ReadFile( hfile, result, size, &size, NULL );
+    result[size] = 0;
+    CloseHandle( hfile );
+    DeleteFileA( path );
+    return result;
+}
+
+static void compare_parallel_load( const char *serial, const char *parallel, DWORD threads )
+{
+    const char *end1, *end2;
+
+    while (*serial || *parallel)
+    {
+        if (!(end1 = strchr( serial, '\n' ))) end1 = serial + strlen( serial );
+        if (!(end2 = strchr( parallel, '\n' ))) end2 = parallel + strlen( parallel );
+        ok( end1 - serial == end2 - parallel && !memcmp( serial, parallel, end1 - serial ),
+            "%u threads: got %.*s, expected %.*s\n", threads,
+            (int)(end2 - parallel), parallel, (int)(end1 - serial), serial );
+        if (!*end1 || !*end2) break;
+        serial = end1 + 1;
+        parallel = end2 + 1;
+    }
+}
+
+/* the MaxLoaderThreads option must not change the loader behavior */
+static void test_parallel_load(void)
+{
+    static const DWORD thread_counts[] = { 2, 4, 16 };
+    char exe[MAX_PATH], dir[MAX_PATH], path[MAX_PATH], key_name[MAX_PATH];
+    char *serial, *parallel, **argv;
+    const char *name;
+    DWORD dummy, i;
+    HANDLE hfile;
+    HKEY key;
+    LONG res;
+
+    winetest_get_mainargs( &argv );
+    GetTempPathA( MAX_PATH, path );
+    GetTempFileNameA( path, "ldr", 0, dir );
+    DeleteFileA( dir );
+    ok( CreateDirectoryA( dir, NULL ), "failed to create dir err %u\n", GetLastError() );
+
+    /* the option is set for a copy of the test, to leave the other child processes alone */
+    sprintf( exe, "%s\\ldrpar.exe", dir );
+    if (!CopyFileA( argv[0], exe, FALSE ))
+    {
+        skip( "failed to copy %s err %u\n", argv[0], GetLastError() );
+        RemoveDirectoryA( dir );
+        return;
+    }
+    name = strrchr( exe, '\\' ) + 1;
+    sprintf( key_name, "Software\\Microsoft\\Windows NT\\CurrentVersion\\Image File Execution Options\\%s", name );
+    res = RegCreateKeyExA( HKEY_LOCAL_MACHINE, key_name, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &key, NULL );
+    if (res == ERROR_ACCESS_DENIED)
+    {
+        skip( "not enough privileges to set image file execution options\n" );
+        DeleteFileA( exe );
+        RemoveDirectoryA( dir );
+        return;
+    }
+    ok( !res, "RegCreateKeyEx failed err %u\n", res );
+
+    sprintf( path, "%s\\parallel.manifest", dir );
+    hfile = CreateFileA( path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, 0 );
+    WriteFile( hfile, parallel_manifest, sizeof(parallel_manifest) - 1, &dummy, NULL );
+    CloseHandle( hfile );
+    sprintf( path, "%s\\ldrctl.dll", dir );
+    create_import_dll( path, "comctl32.dll", "InitCommonControlsEx" );
+    sprintf( path, "%s\\ldrmissing.dll", dir );
+    create_import_dll( path, "ldrnone.dll", "dummy" );
+    sprintf( path, "%s\\ldrnoproc.dll", dir );
+    create_import_dll( path, "oleaut32.dll", "ldrnone" );
+
+    serial = run_parallel_load( exe, dir );
+    ok( serial != NULL, "serial load failed\n" );
+    for (i = 0; serial && i < ARRAY_SIZE(thread_counts); i++)
+    {
+        RegSetValueExA( key, "MaxLoaderThreads", 0, REG_DWORD, (BYTE *)&thread_counts[i], sizeof(DWORD) );
+        if (!(parallel = run_parallel_load( exe, dir ))) continue;
+        compare_parallel_load( serial, parallel, thread_counts[i] );
+        free( parallel );
+    }
+    free( serial );
+
+    RegDeleteValueA( key, "MaxLoaderThreads" );
+    RegCloseKey( key );
+    RegDeleteKeyA( HKEY_LOCAL_MACHINE, key_name );
+    sprintf( path, "%s\\parallel.manifest", dir );
+    DeleteFileA( path );
+    sprintf( path, "%s\\ldrctl.dll", dir );
+    DeleteFileA( path );
+    sprintf( path, "%s\\ldrmissing.dll", dir );
+    DeleteFileA( path );
+    sprintf( path, "%s\\ldrnoproc.dll", dir );
+    DeleteFileA( path );
+    DeleteFileA( exe );
+    RemoveDirectoryA( dir );
+}
+
 START_TEST(loader)
 {
     int argc;
@@ -4087,6 +4375,11 @@ START_TEST(loader)
         *child_failures = -1;
 
     argc = winetest_get_mainargs(&argv);
+    if (argc > 3 && !strcmp( argv[2], "parallel_load" ))
+    {
+        child_parallel_load( argv[3] );
+        return;
+    }
     if (argc > 4)
     {
         test_dll_phase = atoi(argv[4]);
@@ -4108,6 +4401,7 @@ START_TEST(loader)
     test_dll_file( "advapi32.dll" );
     test_dll_file( "user32.dll" );
     test_Wow64Transition();
+    test_parallel_load();
     /* loader test must be last, it can corrupt the internal loader state on Windows */
     test_Loader();
 }
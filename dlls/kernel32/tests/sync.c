@@ -2707,6 +2707,228 @@ static void test_crit_section(void)
     ok(cs.DebugInfo == NULL, "Unexpected debug info pointer %p.\n", cs.DebugInfo);
 }
 
+static DWORD WINAPI wait_object_thread(LPVOID arg)
+{
+    return WaitForSingleObject(arg, 5000);
+}
+
+static DWORD WINAPI acquire_mutex_thread(LPVOID arg)
+{
+    return WaitForSingleObject(arg, 0);
+}
+
+struct mutex_holder
+{
+    HANDLE mutex;
+    HANDLE acquired;
+    HANDLE done;
+};
+
+static DWORD WINAPI hold_mutex_thread(LPVOID arg)
+{
+    struct mutex_holder *holder = arg;
+    DWORD ret = WaitForSingleObject(holder->mutex, 0);
+
+    SetEvent(holder->acquired);
+    WaitForSingleObject(holder->done, 5000);
+    return ret;  /* exit without releasing the mutex */
+}
+
+/* wait until a thread is blocked in a wait, so that the object has waiters */
+static void start_waiter(HANDLE *thread, LPTHREAD_START_ROUTINE proc, HANDLE object)
+{
+    *thread = CreateThread(NULL, 0, proc, object, 0, NULL);
+    ok(*thread != NULL, "CreateThread failed with %u\n", GetLastError());
+    ok(WaitForSingleObject(*thread, 200) == WAIT_TIMEOUT, "thread didn't block\n");
+}
+
+static DWORD finish_thread(HANDLE thread)
+{
+    DWORD ret, code = 0xdeadbeef;
+
+    ret = WaitForSingleObject(thread, 5000);
+    ok(ret == WAIT_OBJECT_0, "thread didn't finish, got %u\n", ret);
+    GetExitCodeThread(thread, &code);
+    CloseHandle(thread);
+    return code;
+}
+
+static void child_unnamed_sync(const char *event_str, const char *sem_str)
+{
+    HANDLE event, sem;
+    DWORD ret;
+
+    sscanf(event_str, "%p", &event);
+    sscanf(sem_str, "%p", &sem);
+    /* the parent signals the event while we are blocked on it */
+    ret = WaitForSingleObject(event, 5000);
+    ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    ret = ReleaseSemaphore(sem, 1, NULL);
+    ok(ret, "ReleaseSemaphore failed with %u\n", GetLastError());
+}
+
+/* unnamed objects may be handled in-process; make sure they behave like the others */
+static void test_unnamed_sync_objects(void)
+{
+    HANDLE event, manual, sem, mutex, dup, thread, objs[2];
+    struct mutex_holder holder;
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si = { sizeof(si) };
+    char cmdline[MAX_PATH];
+    LONG prev;
+    DWORD ret;
+    char **argv;
+    int i;
+
+    /* waits on signaled objects */
+    event = CreateEventA(NULL, FALSE, TRUE, NULL);
+    manual = CreateEventA(NULL, TRUE, TRUE, NULL);
+    sem = CreateSemaphoreA(NULL, 2, 3, NULL);
+    mutex = CreateMutexA(NULL, TRUE, NULL);
+    ok(event && manual && sem && mutex, "failed to create objects, error %u\n", GetLastError());
+
+    ret = WaitForSingleObject(event, 0);
+    ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    ret = WaitForSingleObject(event, 0);
+    ok(ret == WAIT_TIMEOUT, "got %u\n", ret);
+    for (i = 0; i < 2; i++)
+    {
+        ret = WaitForSingleObject(manual, 0);
+        ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    }
+    for (i = 0; i < 2; i++)
+    {
+        ret = WaitForSingleObject(sem, 0);
+        ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    }
+    ret = WaitForSingleObject(sem, 0);
+    ok(ret == WAIT_TIMEOUT, "got %u\n", ret);
+    ret = ReleaseSemaphore(sem, 2, &prev);
+    ok(ret && prev == 0, "got %u, prev %d\n", ret, prev);
+    SetLastError(0xdeadbeef);
+    ret = ReleaseSemaphore(sem, 2, &prev);
+    ok(!ret && GetLastError() == ERROR_TOO_MANY_POSTS, "got %u, error %u\n", ret, GetLastError());
+
+    ret = WaitForSingleObject(mutex, 0);
+    ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    thread = CreateThread(NULL, 0, acquire_mutex_thread, mutex, 0, NULL);
+    ret = finish_thread(thread);
+    ok(ret == WAIT_TIMEOUT, "mutex acquired by another thread, got %u\n", ret);
+    ok(ReleaseMutex(mutex), "ReleaseMutex failed with %u\n", GetLastError());
+    ok(ReleaseMutex(mutex), "ReleaseMutex failed with %u\n", GetLastError());
+    SetLastError(0xdeadbeef);
+    ok(!ReleaseMutex(mutex), "ReleaseMutex succeeded\n");
+    ok(GetLastError() == ERROR_NOT_OWNER, "got %u\n", GetLastError());
+
+    /* zero timeout waits on unsignaled objects */
+    ResetEvent(manual);
+    objs[0] = event;
+    objs[1] = manual;
+    ret = WaitForMultipleObjects(2, objs, FALSE, 0);
+    ok(ret == WAIT_TIMEOUT, "got %u\n", ret);
+    objs[1] = sem;
+    ret = WaitForMultipleObjects(2, objs, FALSE, 0);
+    ok(ret == WAIT_OBJECT_0 + 1, "got %u\n", ret);
+
+    /* duplicated handles */
+    ret = DuplicateHandle(GetCurrentProcess(), event, GetCurrentProcess(), &dup, 0, FALSE, DUPLICATE_SAME_ACCESS);
+    ok(ret, "DuplicateHandle failed with %u\n", GetLastError());
+    ok(SetEvent(dup), "SetEvent failed with %u\n", GetLastError());
+    ret = WaitForSingleObject(event, 0);
+    ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    ret = WaitForSingleObject(dup, 0);
+    ok(ret == WAIT_TIMEOUT, "got %u\n", ret);
+    CloseHandle(dup);
+    ret = DuplicateHandle(GetCurrentProcess(), event, GetCurrentProcess(), &dup, SYNCHRONIZE, FALSE, 0);
+    ok(ret, "DuplicateHandle failed with %u\n", GetLastError());
+    SetLastError(0xdeadbeef);
+    ok(!SetEvent(dup), "SetEvent succeeded\n");
+    ok(GetLastError() == ERROR_ACCESS_DENIED, "got %u\n", GetLastError());
+    ok(SetEvent(event), "SetEvent failed with %u\n", GetLastError());
+    ret = DuplicateHandle(GetCurrentProcess(), event, GetCurrentProcess(), &objs[0], 0, FALSE,
+                          DUPLICATE_SAME_ACCESS | DUPLICATE_CLOSE_SOURCE);
+    ok(ret, "DuplicateHandle failed with %u\n", GetLastError());
+    event = objs[0];
+    ret = WaitForSingleObject(dup, 0);
+    ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    CloseHandle(dup);
+
+    /* duplicated into another process, signaled while the child waits */
+    ret = DuplicateHandle(GetCurrentProcess(), manual, GetCurrentProcess(), &objs[0], 0, TRUE, DUPLICATE_SAME_ACCESS);
+    ok(ret, "DuplicateHandle failed with %u\n", GetLastError());
+    ret = DuplicateHandle(GetCurrentProcess(), sem, GetCurrentProcess(), &objs[1], 0, TRUE, DUPLICATE_SAME_ACCESS);
+    ok(ret, "DuplicateHandle failed with %u\n", GetLastError());
+    while (WaitForSingleObject(sem, 0) == WAIT_OBJECT_0);
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" sync unnamed_sync %p %p", argv[0], objs[0], objs[1]);
+    ret = CreateProcessA(argv[0], cmdline, NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi);
+    ok(ret, "CreateProcess failed with %u\n", GetLastError());
+    Sleep(200);
+    ok(SetEvent(manual), "SetEvent failed with %u\n", GetLastError());
+    ret = WaitForSingleObject(sem, 5000);
+    ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    winetest_wait_child_process(pi.hProcess);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+    CloseHandle(objs[0]);
+    CloseHandle(objs[1]);
+
+    /* signaling objects that have waiters wakes them up and satisfies the wait */
+    ResetEvent(event);
+    start_waiter(&thread, wait_object_thread, event);
+    ok(SetEvent(event), "SetEvent failed with %u\n", GetLastError());
+    ret = finish_thread(thread);
+    ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    ret = WaitForSingleObject(event, 0);
+    ok(ret == WAIT_TIMEOUT, "auto-reset event still signaled, got %u\n", ret);
+
+    start_waiter(&thread, wait_object_thread, sem);
+    ret = ReleaseSemaphore(sem, 1, &prev);
+    ok(ret && prev == 0, "got %u, prev %d\n", ret, prev);
+    ret = finish_thread(thread);
+    ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    ret = WaitForSingleObject(sem, 0);
+    ok(ret == WAIT_TIMEOUT, "semaphore still signaled, got %u\n", ret);
+
+    ret = WaitForSingleObject(mutex, 0);
+    ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    start_waiter(&thread, wait_object_thread, mutex);
+    ok(ReleaseMutex(mutex), "ReleaseMutex failed with %u\n", GetLastError());
+    ret = finish_thread(thread);  /* the thread exits with the mutex */
+    ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+
+    /* mutex abandonment */
+    ret = WaitForSingleObject(mutex, 0);
+    ok(ret == WAIT_ABANDONED, "got %u\n", ret);
+    ok(ReleaseMutex(mutex), "ReleaseMutex failed with %u\n", GetLastError());
+    ret = WaitForSingleObject(mutex, 0);
+    ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    ok(ReleaseMutex(mutex), "ReleaseMutex failed with %u\n", GetLastError());
+
+    holder.mutex = mutex;
+    holder.acquired = CreateEventA(NULL, FALSE, FALSE, NULL);
+    holder.done = CreateEventA(NULL, FALSE, FALSE, NULL);
+    thread = CreateThread(NULL, 0, hold_mutex_thread, &holder, 0, NULL);
+    ret = WaitForSingleObject(holder.acquired, 5000);
+    ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    start_waiter(&dup, wait_object_thread, mutex);
+    SetEvent(holder.done);
+    ret = finish_thread(thread);
+    ok(ret == WAIT_OBJECT_0, "got %u\n", ret);
+    ret = finish_thread(dup);  /* the waiter exits with the mutex too */
+    ok(ret == WAIT_ABANDONED, "got %u\n", ret);
+    ret = WaitForSingleObject(mutex, 0);
+    ok(ret == WAIT_ABANDONED, "got %u\n", ret);
+    ok(ReleaseMutex(mutex), "ReleaseMutex failed with %u\n", GetLastError());
+    CloseHandle(holder.acquired);
+    CloseHandle(holder.done);
+
+    CloseHandle(event);
+    CloseHandle(manual);
+    CloseHandle(sem);
+    CloseHandle(mutex);
+}
+
 static DWORD WINAPI thread_proc(LPVOID unused)
 {
     Sleep(INFINITE);
@@ -2818,6 +3040,8 @@ START_TEST(sync)
         {
             for (;;) SleepEx(INFINITE, TRUE);
         }
+        if (!strcmp(argv[2], "unnamed_sync") && argc >= 5)
+            child_unnamed_sync(argv[3], argv[4]);
         return;
     }
 
@@ -2844,4 +3068,5 @@ START_TEST(sync)
     test_alertable_wait();
     test_apc_deadlock();
     test_crit_section();
+    test_unnamed_sync_objects();
 }
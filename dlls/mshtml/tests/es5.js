@@ -528,6 +528,30 @@ sync_test("defineProperty", function() {
     ok(obj.funcprop(100) === 10, "obj.funcprop() = " + obj.funcprop(100));
 });
 
+sync_test("array_index_setter", function() {
+    var arr, log = "";
+
+    Object.defineProperty(Array.prototype, "0", {
+        get: function() { return "get"; },
+        set: function(v) { log += v + ","; },
+        configurable: true
+    });
+
+    arr = [];
+    arr[0] = 1;
+    arr.push(2);
+    ok(log === "1,2,", "log = " + log);
+    ok(!arr.hasOwnProperty("0"), "arr has own property 0");
+    ok(arr[0] === "get", "arr[0] = " + arr[0]);
+    ok(arr.length === 1, "arr.length = " + arr.length);
+
+    delete Array.prototype[0];
+    arr = [];
+    arr[0] = 3;
+    ok(log === "1,2,", "log = " + log);
+    ok(arr.hasOwnProperty("0") && arr[0] === 3, "arr[0] = " + arr[0]);
+});
+
 sync_test("defineProperties", function() {
     var o, defined, descs;
 
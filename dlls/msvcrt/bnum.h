@@ -24,6 +24,32 @@
 
 static const int p10s[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
 
+/* powers of ten that fit in ULONGLONG, used by the fast conversion paths */
+static const ULONGLONG p10s64[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+    10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL
+};
+
+/* returns the low 64 bits of a * b and stores the high ones in *hi */
+static inline ULONGLONG mul64(ULONGLONG a, ULONGLONG b, ULONGLONG *hi)
+{
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 r = (unsigned __int128)a * b;
+
+    *hi = r >> 64;
+    return r;
+#else
+    ULONGLONG a_lo = (DWORD)a, a_hi = a >> 32, b_lo = (DWORD)b, b_hi = b >> 32;
+    ULONGLONG lo_lo = a_lo * b_lo, lo_hi = a_lo * b_hi, hi_lo = a_hi * b_lo;
+    ULONGLONG mid = (lo_lo >> 32) + (DWORD)lo_hi + (DWORD)hi_lo;
+
+    *hi = a_hi * b_hi + (lo_hi >> 32) + (hi_lo >> 32) + (mid >> 32);
+    return (mid << 32) | (DWORD)lo_lo;
+#endif
+}
+
 #define LIMB_DIGITS 9           /* each DWORD stores up to 9 digits */
 #define LIMB_MAX 1000000000     /* 10^9 */
 
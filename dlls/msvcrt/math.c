@@ -49,6 +49,10 @@
 #include "wine/asm.h"
 #include "wine/debug.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
+
 WINE_DEFAULT_DEBUG_CHANNEL(msvcrt);
 
 #undef div
@@ -64,13 +68,37 @@ typedef int (CDECL *MSVCRT_matherr_func)(struct _exception *);
 static MSVCRT_matherr_func MSVCRT_default_matherr_func = NULL;
 
 BOOL sse2_supported;
+BOOL avx2_supported;
 static BOOL sse2_enabled;
 
 static const struct unix_funcs *unix_funcs;
 
+static BOOL is_avx2_supported( void )
+{
+#if defined(__i386__) || defined(__x86_64__)
+    unsigned int xcr0_lo, xcr0_hi;
+    int regs[4];
+
+    __cpuid( regs, 0 );
+    if (regs[0] < 7) return FALSE;
+
+    /* AVX and OSXSAVE, and the OS saving the YMM state */
+    __cpuid( regs, 1 );
+    if ((regs[2] & 0x18000000) != 0x18000000) return FALSE;
+    __asm__ __volatile__( "xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0) );
+    if ((xcr0_lo & 6) != 6) return FALSE;
+
+    __cpuidex( regs, 7, 0 );
+    return (regs[1] & 0x20) != 0;
+#else
+    return FALSE;
+#endif
+}
+
 void msvcrt_init_math( void *module )
 {
     sse2_supported = IsProcessorFeaturePresent( PF_XMMI64_INSTRUCTIONS_AVAILABLE );
+    avx2_supported = sse2_supported && is_avx2_supported();
 #if _MSVCR_VER <=71
     sse2_enabled = FALSE;
 #else
@@ -34,6 +34,16 @@
 #undef wcsncpy
 
 extern BOOL sse2_supported DECLSPEC_HIDDEN;
+extern BOOL avx2_supported DECLSPEC_HIDDEN;
+
+#if defined(__i386__) || defined(__x86_64__)
+#ifdef __x86_64__
+#define SSE2_TARGET
+#else
+#define SSE2_TARGET __attribute__((target("sse2")))
+#endif
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
 
 #define DBL80_MAX_10_EXP 4932
 #define DBL80_MIN_10_EXP -4951
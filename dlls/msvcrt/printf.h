@@ -586,6 +586,182 @@ static inline void FUNC_NAME(pf_integer_conv)(APICHAR *buf, pf_flags *flags, LON
     }
 }
 
+#ifndef PRINTF_FP_HELPERS
+#define PRINTF_FP_HELPERS
+/* pf_fp_scale: computes *q = trunc(v * 10^s) for positive finite v and
+   compares the dropped fraction with 1/2 (*half_cmp is <0, 0 or >0).
+   Returns FALSE if the result can't be computed exactly in 64 bits */
+static inline BOOL pf_fp_scale(double v, int s, ULONGLONG *q, int *half_cmp)
+{
+    ULONGLONG m = *(ULONGLONG*)&v, hi, lo, rem_hi, rem_lo, half_hi, half_lo;
+    int e2 = (m >> (MANT_BITS - 1)) & ((1 << EXP_BITS) - 1);
+
+    m &= ((ULONGLONG)1 << (MANT_BITS - 1)) - 1;
+    if(e2) {
+        m |= (ULONGLONG)1 << (MANT_BITS - 1);
+        e2 -= (1 << (EXP_BITS - 1)) - 1 + MANT_BITS - 1;
+    } else {
+        e2 = 2 - (1 << (EXP_BITS - 1)) - (MANT_BITS - 1);
+    }
+
+    if(s < 0) {
+        ULONGLONG d, r;
+        BOOL frac;
+
+        if(-s >= ARRAY_SIZE(p10s64) || e2 > 64 - MANT_BITS) return FALSE;
+
+        if(e2 >= 0) {
+            hi = m << e2;
+            frac = FALSE;
+        } else if(e2 > -64) {
+            hi = m >> -e2;
+            frac = (m << (64 + e2)) != 0;
+        } else {
+            hi = 0;
+            frac = TRUE;
+        }
+
+        d = p10s64[-s];
+        *q = hi / d;
+        r = hi % d;
+        if(r != d / 2) *half_cmp = r < d / 2 ? -1 : 1;
+        else *half_cmp = frac;
+        return TRUE;
+    }
+
+    if(s >= ARRAY_SIZE(p10s64)) return FALSE;
+    lo = mul64(m, p10s64[s], &hi);
+
+    if(e2 >= 0) {
+        if(hi || e2 >= 64 || (e2 && lo >> (64 - e2))) return FALSE;
+        *q = lo << e2;
+        *half_cmp = -1;
+        return TRUE;
+    }
+
+    e2 = -e2;
+    if(e2 < 64) {
+        if(hi >> e2) return FALSE;
+        *q = (hi << (64 - e2)) | (lo >> e2);
+        rem_hi = 0;
+        rem_lo = lo & (((ULONGLONG)1 << e2) - 1);
+        half_hi = 0;
+        half_lo = (ULONGLONG)1 << (e2 - 1);
+    } else if(e2 < 128) {
+        *q = hi >> (e2 - 64);
+        rem_hi = hi & (((ULONGLONG)1 << (e2 - 64)) - 1);
+        rem_lo = lo;
+        half_hi = e2 == 64 ? 0 : (ULONGLONG)1 << (e2 - 65);
+        half_lo = e2 == 64 ? (ULONGLONG)1 << 63 : 0;
+    } else {
+        *q = 0;
+        *half_cmp = -1;
+        return TRUE;
+    }
+
+    if(rem_hi != half_hi) *half_cmp = rem_hi < half_hi ? -1 : 1;
+    else if(rem_lo != half_lo) *half_cmp = rem_lo < half_lo ? -1 : 1;
+    else *half_cmp = 0;
+    return TRUE;
+}
+#endif
+
+/* pf_put_digits: stores x in buf using at least count digits */
+static inline int FUNC_NAME(pf_put_digits)(APICHAR *buf, ULONGLONG x, int count)
+{
+    APICHAR tmp[20];
+    int i = 0, len = 0;
+
+    do {
+        tmp[i++] = '0' + x % 10;
+        x /= 10;
+    } while(x || i < count);
+
+    while(i) buf[len++] = tmp[--i];
+    return len;
+}
+
+/* pf_format_fp_fast: formats positive finite v the same way as pf_output_fp
+   (without sign and padding) when all the digits fit in 64-bit integers.
+   Returns the number of characters stored in buf or -1 if the big number
+   code needs to be used */
+static inline int FUNC_NAME(pf_format_fp_fast)(APICHAR *buf, double v,
+        const pf_flags *flags, _locale_t locale, BOOL three_digit_exp,
+        BOOL standard_rounding)
+{
+    int prec = flags->Precision, k = 0, n, i, half_cmp, len;
+    APICHAR format = flags->Format;
+    BOOL trim_tail = FALSE;
+    ULONGLONG q, ip;
+
+    if(!v || prec > 17)
+        return -1;
+
+    if(format == 'f' || format == 'F') {
+        if(!pf_fp_scale(v, prec, &q, &half_cmp) || q >= p10s64[18])
+            return -1;
+        n = 0;
+    } else {
+        n = prec;
+        if(!prec || format == 'e' || format == 'E') n++;
+        if(n > 17)
+            return -1;
+
+        /* log10 may be off by one next to powers of 10 */
+        k = floor(log10(v));
+        for(i = 0; ; i++) {
+            if(i == 3 || !pf_fp_scale(v, n - 1 - k, &q, &half_cmp))
+                return -1;
+            if(q >= p10s64[n]) k++;
+            else if(q < p10s64[n - 1]) k--;
+            else break;
+        }
+    }
+
+    if(half_cmp > 0 || (!half_cmp && (!standard_rounding || (q & 1))))
+        q++;
+    if(!q) /* let the generic code handle values rounded to 0 */
+        return -1;
+    if(n && q == p10s64[n]) {
+        q = p10s64[n - 1];
+        k++;
+    }
+
+    if(format == 'g' || format == 'G') {
+        trim_tail = TRUE;
+
+        if(k + 1 >= -3 && k + 1 <= prec) {
+            format -= 1;
+            if(!prec) prec++;
+            prec -= k + 1;
+        } else {
+            format -= 2;
+            if(prec > 0) prec--;
+        }
+    }
+
+    if(trim_tail && !flags->Alternate) {
+        while(prec > 0 && !(q % 10)) {
+            q /= 10;
+            prec--;
+        }
+    }
+
+    ip = q / p10s64[prec];
+    len = FUNC_NAME(pf_put_digits)(buf, ip, 1);
+    if(prec || flags->Alternate)
+        buf[len++] = *(locale ? locale->locinfo : get_locinfo())->lconv->decimal_point;
+    if(prec)
+        len += FUNC_NAME(pf_put_digits)(buf + len, q % p10s64[prec], prec);
+
+    if((format == 'e' || format == 'E') && (!trim_tail || k)) {
+        buf[len++] = format;
+        buf[len++] = k < 0 ? '-' : '+';
+        len += FUNC_NAME(pf_put_digits)(buf + len, k < 0 ? -k : k, three_digit_exp ? 3 : 2);
+    }
+    return len;
+}
+
 static inline int FUNC_NAME(pf_output_fp)(FUNC_NAME(puts_clbk) pf_puts, void *puts_ctx,
         double v, pf_flags *flags, _locale_t locale, BOOL three_digit_exp,
         BOOL standard_rounding)
@@ -593,7 +769,7 @@ static inline int FUNC_NAME(pf_output_fp)(FUNC_NAME(puts_clbk) pf_puts, void *pu
     int e2, e10 = 0, round_pos, round_limb, radix_pos, first_limb_len, i, len, r, ret;
     BYTE bnum_data[FIELD_OFFSET(struct bnum, data[BNUM_PREC64])];
     struct bnum *b = (struct bnum*)bnum_data;
-    APICHAR buf[LIMB_DIGITS + 1];
+    APICHAR buf[LIMB_DIGITS + 1], fast_buf[64];
     BOOL trim_tail = FALSE, round_up = FALSE;
     pf_flags f;
     int limb_len, prec;
@@ -603,6 +779,22 @@ static inline int FUNC_NAME(pf_output_fp)(FUNC_NAME(puts_clbk) pf_puts, void *pu
     if(flags->Precision == -1)
         flags->Precision = 6;
 
+    len = FUNC_NAME(pf_format_fp_fast)(fast_buf, v, flags, locale,
+            three_digit_exp, standard_rounding);
+    if(len >= 0) {
+        r = FUNC_NAME(pf_fill)(pf_puts, puts_ctx, len, flags, TRUE);
+        if(r < 0) return r;
+        ret = r;
+
+        r = pf_puts(puts_ctx, len, fast_buf);
+        if(r < 0) return r;
+        ret += r;
+
+        r = FUNC_NAME(pf_fill)(pf_puts, puts_ctx, len, flags, FALSE);
+        if(r < 0) return r;
+        return ret + r;
+    }
+
     v = frexp(v, &e2);
     if(v) {
         m = (ULONGLONG)1 << (MANT_BITS - 1);
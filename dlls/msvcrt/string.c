@@ -34,8 +34,199 @@
 #include "wine/asm.h"
 #include "wine/debug.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
+
 WINE_DEFAULT_DEBUG_CHANNEL(msvcrt);
 
+#if defined(__i386__) || defined(__x86_64__)
+
+/* The string scanning functions below read whole aligned vectors. These may
+ * extend past the end of the string, but never cross a page boundary. */
+
+static size_t SSE2_TARGET sse2_strlen(const char *str)
+{
+    const char *p = (const char *)((ULONG_PTR)str & ~15);
+    const __m128i zero = _mm_setzero_si128();
+    DWORD mask, i;
+
+    mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)p), zero));
+    mask &= ~0u << (str - p);
+    while (!mask)
+    {
+        p += 16;
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)p), zero));
+    }
+    BitScanForward(&i, mask);
+    return p + i - str;
+}
+
+static size_t AVX2_TARGET avx2_strlen(const char *str)
+{
+    const char *p = (const char *)((ULONG_PTR)str & ~31);
+    const __m256i zero = _mm256_setzero_si256();
+    DWORD mask, i;
+
+    mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)p), zero));
+    mask &= ~0u << (str - p);
+    while (!mask)
+    {
+        p += 32;
+        mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)p), zero));
+    }
+    BitScanForward(&i, mask);
+    return p + i - str;
+}
+
+static char * SSE2_TARGET sse2_strchr(const char *str, char c)
+{
+    const char *p = (const char *)((ULONG_PTR)str & ~15);
+    const __m128i zero = _mm_setzero_si128(), chr = _mm_set1_epi8(c);
+    __m128i v = _mm_load_si128((const __m128i *)p);
+    DWORD mask, i;
+
+    mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, zero), _mm_cmpeq_epi8(v, chr)));
+    mask &= ~0u << (str - p);
+    while (!mask)
+    {
+        p += 16;
+        v = _mm_load_si128((const __m128i *)p);
+        mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, zero), _mm_cmpeq_epi8(v, chr)));
+    }
+    BitScanForward(&i, mask);
+    return p[i] == c ? (char *)p + i : NULL;
+}
+
+static char * AVX2_TARGET avx2_strchr(const char *str, char c)
+{
+    const char *p = (const char *)((ULONG_PTR)str & ~31);
+    const __m256i zero = _mm256_setzero_si256(), chr = _mm256_set1_epi8(c);
+    __m256i v = _mm256_load_si256((const __m256i *)p);
+    DWORD mask, i;
+
+    mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, zero), _mm256_cmpeq_epi8(v, chr)));
+    mask &= ~0u << (str - p);
+    while (!mask)
+    {
+        p += 32;
+        v = _mm256_load_si256((const __m256i *)p);
+        mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, zero), _mm256_cmpeq_epi8(v, chr)));
+    }
+    BitScanForward(&i, mask);
+    return p[i] == c ? (char *)p + i : NULL;
+}
+
+static void * SSE2_TARGET sse2_memchr(const unsigned char *ptr, unsigned char c, size_t n)
+{
+    const unsigned char *p = (const unsigned char *)((ULONG_PTR)ptr & ~15);
+    const __m128i chr = _mm_set1_epi8(c);
+    size_t offset = p - ptr;
+    DWORD mask, i;
+
+    mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)p), chr));
+    mask &= ~0u << (ptr - p);
+    for (;;)
+    {
+        if (mask)
+        {
+            BitScanForward(&i, mask);
+            return offset + i < n ? (void *)(p + i) : NULL;
+        }
+        p += 16;
+        offset += 16;
+        if (offset >= n) return NULL;
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)p), chr));
+    }
+}
+
+static void * AVX2_TARGET avx2_memchr(const unsigned char *ptr, unsigned char c, size_t n)
+{
+    const unsigned char *p = (const unsigned char *)((ULONG_PTR)ptr & ~31);
+    const __m256i chr = _mm256_set1_epi8(c);
+    size_t offset = p - ptr;
+    DWORD mask, i;
+
+    mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)p), chr));
+    mask &= ~0u << (ptr - p);
+    for (;;)
+    {
+        if (mask)
+        {
+            BitScanForward(&i, mask);
+            return offset + i < n ? (void *)(p + i) : NULL;
+        }
+        p += 32;
+        offset += 32;
+        if (offset >= n) return NULL;
+        mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)p), chr));
+    }
+}
+
+/* Returns the length of the common prefix, rounded down to whole vectors
+ * if the buffers are equal. */
+static size_t SSE2_TARGET sse2_memcmp_prefix(const unsigned char *p1, const unsigned char *p2, size_t n)
+{
+    size_t i;
+    DWORD mask, j;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p1 + i)),
+                _mm_loadu_si128((const __m128i *)(p2 + i)))) ^ 0xffff;
+        if (mask)
+        {
+            BitScanForward(&j, mask);
+            return i + j;
+        }
+    }
+    return i;
+}
+
+static size_t AVX2_TARGET avx2_memcmp_prefix(const unsigned char *p1, const unsigned char *p2, size_t n)
+{
+    size_t i;
+    DWORD mask, j;
+
+    for (i = 0; i + 32 <= n; i += 32)
+    {
+        mask = ~_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p1 + i)),
+                _mm256_loadu_si256((const __m256i *)(p2 + i))));
+        if (mask)
+        {
+            BitScanForward(&j, mask);
+            return i + j;
+        }
+    }
+    return i;
+}
+
+/* n must be at least 16. */
+static void SSE2_TARGET sse2_memset(unsigned char *d, int c, size_t n)
+{
+    unsigned char *end = d + n;
+    const __m128i v = _mm_set1_epi8(c);
+
+    _mm_storeu_si128((__m128i *)d, v);
+    for (d = (unsigned char *)(((ULONG_PTR)d + 16) & ~15); d + 16 <= end; d += 16)
+        _mm_store_si128((__m128i *)d, v);
+    _mm_storeu_si128((__m128i *)(end - 16), v);
+}
+
+/* n must be at least 32. */
+static void AVX2_TARGET avx2_memset(unsigned char *d, int c, size_t n)
+{
+    unsigned char *end = d + n;
+    const __m256i v = _mm256_set1_epi8(c);
+
+    _mm256_storeu_si256((__m256i *)d, v);
+    for (d = (unsigned char *)(((ULONG_PTR)d + 32) & ~31); d + 32 <= end; d += 32)
+        _mm256_store_si256((__m256i *)d, v);
+    _mm256_storeu_si256((__m256i *)(end - 32), v);
+}
+
+#endif
+
 /*********************************************************************
  *		_mbsdup (MSVCRT.@)
  *		_strdup (MSVCRT.@)
@@ -742,6 +933,316 @@ static inline BOOL bnum_to_mant(struct bnum *b, ULONGLONG *m)
     return TRUE;
 }
 
+#define POW5_MIN_EXP -128
+#define POW5_MAX_EXP 128
+
+/* 128-bit approximations of 5^POW5_MIN_EXP..5^POW5_MAX_EXP, most significant bit set */
+static const ULONGLONG pow5_128[][2] = {
+    { 0xddd0467c64bce4a0ULL, 0xac7cb3f6d05ddbdeULL },
+    { 0x8aa22c0dbef60ee4ULL, 0x6bcdf07a423aa96bULL },
+    { 0xad4ab7112eb3929dULL, 0x86c16c98d2c953c6ULL },
+    { 0xd89d64d57a607744ULL, 0xe871c7bf077ba8b7ULL },
+    { 0x87625f056c7c4a8bULL, 0x11471cd764ad4972ULL },
+    { 0xa93af6c6c79b5d2dULL, 0xd598e40d3dd89bcfULL },
+    { 0xd389b47879823479ULL, 0x4aff1d108d4ec2c3ULL },
+    { 0x843610cb4bf160cbULL, 0xcedf722a585139baULL },
+    { 0xa54394fe1eedb8feULL, 0xc2974eb4ee658828ULL },
+    { 0xce947a3da6a9273eULL, 0x733d226229feea32ULL },
+    { 0x811ccc668829b887ULL, 0x0806357d5a3f525fULL },
+    { 0xa163ff802a3426a8ULL, 0xca07c2dcb0cf26f7ULL },
+    { 0xc9bcff6034c13052ULL, 0xfc89b393dd02f0b5ULL },
+    { 0xfc2c3f3841f17c67ULL, 0xbbac2078d443ace2ULL },
+    { 0x9d9ba7832936edc0ULL, 0xd54b944b84aa4c0dULL },
+    { 0xc5029163f384a931ULL, 0x0a9e795e65d4df11ULL },
+    { 0xf64335bcf065d37dULL, 0x4d4617b5ff4a16d5ULL },
+    { 0x99ea0196163fa42eULL, 0x504bced1bf8e4e45ULL },
+    { 0xc06481fb9bcf8d39ULL, 0xe45ec2862f71e1d6ULL },
+    { 0xf07da27a82c37088ULL, 0x5d767327bb4e5a4cULL },
+    { 0x964e858c91ba2655ULL, 0x3a6a07f8d510f86fULL },
+    { 0xbbe226efb628afeaULL, 0x890489f70a55368bULL },
+    { 0xeadab0aba3b2dbe5ULL, 0x2b45ac74ccea842eULL },
+    { 0x92c8ae6b464fc96fULL, 0x3b0b8bc90012929dULL },
+    { 0xb77ada0617e3bbcbULL, 0x09ce6ebb40173744ULL },
+    { 0xe55990879ddcaabdULL, 0xcc420a6a101d0515ULL },
+    { 0x8f57fa54c2a9eab6ULL, 0x9fa946824a12232dULL },
+    { 0xb32df8e9f3546564ULL, 0x47939822dc96abf9ULL },
+    { 0xdff9772470297ebdULL, 0x59787e2b93bc56f7ULL },
+    { 0x8bfbea76c619ef36ULL, 0x57eb4edb3c55b65aULL },
+    { 0xaefae51477a06b03ULL, 0xede622920b6b23f1ULL },
+    { 0xdab99e59958885c4ULL, 0xe95fab368e45ecedULL },
+    { 0x88b402f7fd75539bULL, 0x11dbcb0218ebb414ULL },
+    { 0xaae103b5fcd2a881ULL, 0xd652bdc29f26a119ULL },
+    { 0xd59944a37c0752a2ULL, 0x4be76d3346f0495fULL },
+    { 0x857fcae62d8493a5ULL, 0x6f70a4400c562ddbULL },
+    { 0xa6dfbd9fb8e5b88eULL, 0xcb4ccd500f6bb952ULL },
+    { 0xd097ad07a71f26b2ULL, 0x7e2000a41346a7a7ULL },
+    { 0x825ecc24c873782fULL, 0x8ed400668c0c28c8ULL },
+    { 0xa2f67f2dfa90563bULL, 0x728900802f0f32faULL },
+    { 0xcbb41ef979346bcaULL, 0x4f2b40a03ad2ffb9ULL },
+    { 0xfea126b7d78186bcULL, 0xe2f610c84987bfa8ULL },
+    { 0x9f24b832e6b0f436ULL, 0x0dd9ca7d2df4d7c9ULL },
+    { 0xc6ede63fa05d3143ULL, 0x91503d1c79720dbbULL },
+    { 0xf8a95fcf88747d94ULL, 0x75a44c6397ce912aULL },
+    { 0x9b69dbe1b548ce7cULL, 0xc986afbe3ee11abaULL },
+    { 0xc24452da229b021bULL, 0xfbe85badce996168ULL },
+    { 0xf2d56790ab41c2a2ULL, 0xfae27299423fb9c3ULL },
+    { 0x97c560ba6b0919a5ULL, 0xdccd879fc967d41aULL },
+    { 0xbdb6b8e905cb600fULL, 0x5400e987bbc1c920ULL },
+    { 0xed246723473e3813ULL, 0x290123e9aab23b68ULL },
+    { 0x9436c0760c86e30bULL, 0xf9a0b6720aaf6521ULL },
+    { 0xb94470938fa89bceULL, 0xf808e40e8d5b3e69ULL },
+    { 0xe7958cb87392c2c2ULL, 0xb60b1d1230b20e04ULL },
+    { 0x90bd77f3483bb9b9ULL, 0xb1c6f22b5e6f48c2ULL },
+    { 0xb4ecd5f01a4aa828ULL, 0x1e38aeb6360b1af3ULL },
+    { 0xe2280b6c20dd5232ULL, 0x25c6da63c38de1b0ULL },
+    { 0x8d590723948a535fULL, 0x579c487e5a38ad0eULL },
+    { 0xb0af48ec79ace837ULL, 0x2d835a9df0c6d851ULL },
+    { 0xdcdb1b2798182244ULL, 0xf8e431456cf88e65ULL },
+    { 0x8a08f0f8bf0f156bULL, 0x1b8e9ecb641b58ffULL },
+    { 0xac8b2d36eed2dac5ULL, 0xe272467e3d222f3fULL },
+    { 0xd7adf884aa879177ULL, 0x5b0ed81dcc6abb0fULL },
+    { 0x86ccbb52ea94baeaULL, 0x98e947129fc2b4e9ULL },
+    { 0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL },
+    { 0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL },
+    { 0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL },
+    { 0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL },
+    { 0xcdb02555653131b6ULL, 0x3792f412cb06794dULL },
+    { 0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL },
+    { 0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL },
+    { 0xc8de047564d20a8bULL, 0xf245825a5a445275ULL },
+    { 0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL },
+    { 0x9ced737bb6c4183dULL, 0x55464dd69685606bULL },
+    { 0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL },
+    { 0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL },
+    { 0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL },
+    { 0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL },
+    { 0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL },
+    { 0x95a8637627989aadULL, 0xdde7001379a44aa8ULL },
+    { 0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL },
+    { 0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL },
+    { 0x9226712162ab070dULL, 0xcab3961304ca70e8ULL },
+    { 0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL },
+    { 0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL },
+    { 0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL },
+    { 0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL },
+    { 0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL },
+    { 0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL },
+    { 0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL },
+    { 0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL },
+    { 0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL },
+    { 0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL },
+    { 0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL },
+    { 0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL },
+    { 0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL },
+    { 0xcfb11ead453994baULL, 0x67de18eda5814af2ULL },
+    { 0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL },
+    { 0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL },
+    { 0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL },
+    { 0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL },
+    { 0x9e74d1b791e07e48ULL, 0x775ea264cf55347eULL },
+    { 0xc612062576589ddaULL, 0x95364afe032a819eULL },
+    { 0xf79687aed3eec551ULL, 0x3a83ddbd83f52205ULL },
+    { 0x9abe14cd44753b52ULL, 0xc4926a9672793543ULL },
+    { 0xc16d9a0095928a27ULL, 0x75b7053c0f178294ULL },
+    { 0xf1c90080baf72cb1ULL, 0x5324c68b12dd6339ULL },
+    { 0x971da05074da7beeULL, 0xd3f6fc16ebca5e04ULL },
+    { 0xbce5086492111aeaULL, 0x88f4bb1ca6bcf585ULL },
+    { 0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e6ULL },
+    { 0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL },
+    { 0xb877aa3236a4b449ULL, 0x09befeb9fad487c3ULL },
+    { 0xe69594bec44de15bULL, 0x4c2ebe687989a9b4ULL },
+    { 0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a11ULL },
+    { 0xb424dc35095cd80fULL, 0x538484c19ef38c95ULL },
+    { 0xe12e13424bb40e13ULL, 0x2865a5f206b06fbaULL },
+    { 0x8cbccc096f5088cbULL, 0xf93f87b7442e45d4ULL },
+    { 0xafebff0bcb24aafeULL, 0xf78f69a51539d749ULL },
+    { 0xdbe6fecebdedd5beULL, 0xb573440e5a884d1cULL },
+    { 0x89705f4136b4a597ULL, 0x31680a88f8953031ULL },
+    { 0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3eULL },
+    { 0xd6bf94d5e57a42bcULL, 0x3d32907604691b4dULL },
+    { 0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b110ULL },
+    { 0xa7c5ac471b478423ULL, 0x0fcf80dc33721d54ULL },
+    { 0xd1b71758e219652bULL, 0xd3c36113404ea4a9ULL },
+    { 0x83126e978d4fdf3bULL, 0x645a1cac083126eaULL },
+    { 0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a4ULL },
+    { 0xccccccccccccccccULL, 0xcccccccccccccccdULL },
+    { 0x8000000000000000ULL, 0x0000000000000000ULL },
+    { 0xa000000000000000ULL, 0x0000000000000000ULL },
+    { 0xc800000000000000ULL, 0x0000000000000000ULL },
+    { 0xfa00000000000000ULL, 0x0000000000000000ULL },
+    { 0x9c40000000000000ULL, 0x0000000000000000ULL },
+    { 0xc350000000000000ULL, 0x0000000000000000ULL },
+    { 0xf424000000000000ULL, 0x0000000000000000ULL },
+    { 0x9896800000000000ULL, 0x0000000000000000ULL },
+    { 0xbebc200000000000ULL, 0x0000000000000000ULL },
+    { 0xee6b280000000000ULL, 0x0000000000000000ULL },
+    { 0x9502f90000000000ULL, 0x0000000000000000ULL },
+    { 0xba43b74000000000ULL, 0x0000000000000000ULL },
+    { 0xe8d4a51000000000ULL, 0x0000000000000000ULL },
+    { 0x9184e72a00000000ULL, 0x0000000000000000ULL },
+    { 0xb5e620f480000000ULL, 0x0000000000000000ULL },
+    { 0xe35fa931a0000000ULL, 0x0000000000000000ULL },
+    { 0x8e1bc9bf04000000ULL, 0x0000000000000000ULL },
+    { 0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL },
+    { 0xde0b6b3a76400000ULL, 0x0000000000000000ULL },
+    { 0x8ac7230489e80000ULL, 0x0000000000000000ULL },
+    { 0xad78ebc5ac620000ULL, 0x0000000000000000ULL },
+    { 0xd8d726b7177a8000ULL, 0x0000000000000000ULL },
+    { 0x878678326eac9000ULL, 0x0000000000000000ULL },
+    { 0xa968163f0a57b400ULL, 0x0000000000000000ULL },
+    { 0xd3c21bcecceda100ULL, 0x0000000000000000ULL },
+    { 0x84595161401484a0ULL, 0x0000000000000000ULL },
+    { 0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL },
+    { 0xcecb8f27f4200f3aULL, 0x0000000000000000ULL },
+    { 0x813f3978f8940984ULL, 0x4000000000000000ULL },
+    { 0xa18f07d736b90be5ULL, 0x5000000000000000ULL },
+    { 0xc9f2c9cd04674edeULL, 0xa400000000000000ULL },
+    { 0xfc6f7c4045812296ULL, 0x4d00000000000000ULL },
+    { 0x9dc5ada82b70b59dULL, 0xf020000000000000ULL },
+    { 0xc5371912364ce305ULL, 0x6c28000000000000ULL },
+    { 0xf684df56c3e01bc6ULL, 0xc732000000000000ULL },
+    { 0x9a130b963a6c115cULL, 0x3c7f400000000000ULL },
+    { 0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL },
+    { 0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL },
+    { 0x96769950b50d88f4ULL, 0x1314448000000000ULL },
+    { 0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL },
+    { 0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL },
+    { 0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL },
+    { 0xb7abc627050305adULL, 0xf14a3d9e40000000ULL },
+    { 0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL },
+    { 0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL },
+    { 0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL },
+    { 0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL },
+    { 0x8c213d9da502de45ULL, 0x4526f422cc340000ULL },
+    { 0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL },
+    { 0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL },
+    { 0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL },
+    { 0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL },
+    { 0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL },
+    { 0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL },
+    { 0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL },
+    { 0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL },
+    { 0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL },
+    { 0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL },
+    { 0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL },
+    { 0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL },
+    { 0x9f4f2726179a2245ULL, 0x01d762422c946590ULL },
+    { 0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL },
+    { 0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL },
+    { 0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL },
+    { 0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL },
+    { 0xf316271c7fc3908aULL, 0x8bef464e3945ef7aULL },
+    { 0x97edd871cfda3a56ULL, 0x97758bf0e3cbb5acULL },
+    { 0xbde94e8e43d0c8ecULL, 0x3d52eeed1cbea317ULL },
+    { 0xed63a231d4c4fb27ULL, 0x4ca7aaa863ee4bddULL },
+    { 0x945e455f24fb1cf8ULL, 0x8fe8caa93e74ef6aULL },
+    { 0xb975d6b6ee39e436ULL, 0xb3e2fd538e122b44ULL },
+    { 0xe7d34c64a9c85d44ULL, 0x60dbbca87196b616ULL },
+    { 0x90e40fbeea1d3a4aULL, 0xbc8955e946fe31cdULL },
+    { 0xb51d13aea4a488ddULL, 0x6babab6398bdbe41ULL },
+    { 0xe264589a4dcdab14ULL, 0xc696963c7eed2dd1ULL },
+    { 0x8d7eb76070a08aecULL, 0xfc1e1de5cf543ca2ULL },
+    { 0xb0de65388cc8ada8ULL, 0x3b25a55f43294bcbULL },
+    { 0xdd15fe86affad912ULL, 0x49ef0eb713f39ebeULL },
+    { 0x8a2dbf142dfcc7abULL, 0x6e3569326c784337ULL },
+    { 0xacb92ed9397bf996ULL, 0x49c2c37f07965404ULL },
+    { 0xd7e77a8f87daf7fbULL, 0xdc33745ec97be906ULL },
+    { 0x86f0ac99b4e8dafdULL, 0x69a028bb3ded71a3ULL },
+    { 0xa8acd7c0222311bcULL, 0xc40832ea0d68ce0cULL },
+    { 0xd2d80db02aabd62bULL, 0xf50a3fa490c30190ULL },
+    { 0x83c7088e1aab65dbULL, 0x792667c6da79e0faULL },
+    { 0xa4b8cab1a1563f52ULL, 0x577001b891185938ULL },
+    { 0xcde6fd5e09abcf26ULL, 0xed4c0226b55e6f86ULL },
+    { 0x80b05e5ac60b6178ULL, 0x544f8158315b05b4ULL },
+    { 0xa0dc75f1778e39d6ULL, 0x696361ae3db1c721ULL },
+    { 0xc913936dd571c84cULL, 0x03bc3a19cd1e38e9ULL },
+    { 0xfb5878494ace3a5fULL, 0x04ab48a04065c723ULL },
+    { 0x9d174b2dcec0e47bULL, 0x62eb0d64283f9c76ULL },
+    { 0xc45d1df942711d9aULL, 0x3ba5d0bd324f8394ULL },
+    { 0xf5746577930d6500ULL, 0xca8f44ec7ee36479ULL },
+    { 0x9968bf6abbe85f20ULL, 0x7e998b13cf4e1ecbULL },
+    { 0xbfc2ef456ae276e8ULL, 0x9e3fedd8c321a67eULL },
+    { 0xefb3ab16c59b14a2ULL, 0xc5cfe94ef3ea101eULL },
+    { 0x95d04aee3b80ece5ULL, 0xbba1f1d158724a12ULL },
+    { 0xbb445da9ca61281fULL, 0x2a8a6e45ae8edc97ULL },
+    { 0xea1575143cf97226ULL, 0xf52d09d71a3293bdULL },
+    { 0x924d692ca61be758ULL, 0x593c2626705f9c56ULL },
+    { 0xb6e0c377cfa2e12eULL, 0x6f8b2fb00c77836cULL },
+    { 0xe498f455c38b997aULL, 0x0b6dfb9c0f956447ULL },
+    { 0x8edf98b59a373fecULL, 0x4724bd4189bd5eacULL },
+    { 0xb2977ee300c50fe7ULL, 0x58edec91ec2cb657ULL },
+    { 0xdf3d5e9bc0f653e1ULL, 0x2f2967b66737e3edULL },
+    { 0x8b865b215899f46cULL, 0xbd79e0d20082ee74ULL },
+    { 0xae67f1e9aec07187ULL, 0xecd8590680a3aa11ULL },
+    { 0xda01ee641a708de9ULL, 0xe80e6f4820cc9495ULL },
+    { 0x884134fe908658b2ULL, 0x3109058d147fdcddULL },
+    { 0xaa51823e34a7eedeULL, 0xbd4b46f0599fd415ULL },
+    { 0xd4e5e2cdc1d1ea96ULL, 0x6c9e18ac7007c91aULL },
+    { 0x850fadc09923329eULL, 0x03e2cf6bc604ddb0ULL },
+    { 0xa6539930bf6bff45ULL, 0x84db8346b786151cULL },
+    { 0xcfe87f7cef46ff16ULL, 0xe612641865679a63ULL },
+    { 0x81f14fae158c5f6eULL, 0x4fcb7e8f3f60c07eULL },
+    { 0xa26da3999aef7749ULL, 0xe3be5e330f38f09dULL },
+    { 0xcb090c8001ab551cULL, 0x5cadf5bfd3072cc5ULL },
+    { 0xfdcb4fa002162a63ULL, 0x73d9732fc7c8f7f6ULL },
+    { 0x9e9f11c4014dda7eULL, 0x2867e7fddcdd9afaULL },
+    { 0xc646d63501a1511dULL, 0xb281e1fd541501b8ULL },
+    { 0xf7d88bc24209a565ULL, 0x1f225a7ca91a4226ULL },
+    { 0x9ae757596946075fULL, 0x3375788de9b06958ULL },
+    { 0xc1a12d2fc3978937ULL, 0x0052d6b1641c83aeULL },
+    { 0xf209787bb47d6b84ULL, 0xc0678c5dbd23a49aULL },
+    { 0x9745eb4d50ce6332ULL, 0xf840b7ba963646e0ULL },
+    { 0xbd176620a501fbffULL, 0xb650e5a93bc3d898ULL },
+    { 0xec5d3fa8ce427affULL, 0xa3e51f138ab4cebeULL },
+    { 0x93ba47c980e98cdfULL, 0xc66f336c36b10137ULL }
+};
+
+/* Converts w*10^q to double mantissa and exponent using Eisel-Lemire algorithm */
+/* Return FALSE if the result is subnormal, overflows or can't be rounded reliably */
+static BOOL fpnum_fast_double(ULONGLONG w, int q, ULONGLONG *m, int *e2)
+{
+    ULONGLONG hi, lo, hi2, mant;
+    int lz = 0, upper, exp;
+
+    if(!w || q < POW5_MIN_EXP || q > POW5_MAX_EXP) return FALSE;
+
+    for(upper = 32; upper; upper /= 2) {
+        if(!(w >> (64 - upper))) {
+            w <<= upper;
+            lz += upper;
+        }
+    }
+
+    lo = mul64(w, pow5_128[q - POW5_MIN_EXP][0], &hi);
+    if((hi & 0x1ff) == 0x1ff) {
+        mul64(w, pow5_128[q - POW5_MIN_EXP][1], &hi2);
+        lo += hi2;
+        if(lo < hi2) hi++;
+    }
+    if(lo == UI64_MAX && (q < -27 || q > 55)) return FALSE;
+
+    upper = hi >> 63;
+    mant = hi >> (upper + 64 - MANT_BITS - 2);
+    /* floor(log2(10^q)) + 63 + exponent bias */
+    exp = ((217706 * q) >> 16) + 63 + upper - lz + (1 << (EXP_BITS - 1)) - 1;
+    if(exp <= 0) return FALSE;
+
+    /* the product may be exactly in the middle, round to even */
+    if(lo <= 1 && q >= -4 && q <= 23 && (mant & 3) == 1 &&
+            mant << (upper + 64 - MANT_BITS - 2) == hi)
+        mant &= ~(ULONGLONG)1;
+    mant = (mant + (mant & 1)) >> 1;
+    if(mant >> MANT_BITS) {
+        mant >>= 1;
+        exp++;
+    }
+    if(exp >= (1 << EXP_BITS) - 1) return FALSE;
+
+    *m = mant;
+    *e2 = exp - (1 << (EXP_BITS - 1)) + 1 - (MANT_BITS - 1);
+    return TRUE;
+}
+
 static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(void *ctx),
         void *ctx, pthreadlocinfo locinfo, BOOL ldouble, struct bnum *b)
 {
@@ -756,6 +1257,10 @@ static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(vo
     enum fpmod round = FP_ROUND_ZERO;
     wchar_t nch;
     ULONGLONG m;
+    /* up to 19 leading significant digits for the fast path */
+    ULONGLONG dec_m = 0, fast_m[2];
+    int dec_digits = 0, fast_e2[2];
+    BOOL dec_trunc = FALSE;
 
     nch = get(ctx);
     if(nch == '-') {
@@ -826,11 +1331,20 @@ static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(vo
 
         b->data[bnum_idx(b, b->b)] = b->data[bnum_idx(b, b->b)] * 10 + nch - '0';
         limb_digits++;
+        if(dec_digits < 19) {
+            dec_m = dec_m * 10 + nch - '0';
+            dec_digits++;
+        } else if(nch != '0') {
+            dec_trunc = TRUE;
+        }
         nch = get(ctx);
         dp++;
     }
     while(nch>='0' && nch<='9') {
-        if(nch != '0') b->data[bnum_idx(b, b->b)] |= 1;
+        if(nch != '0') {
+            b->data[bnum_idx(b, b->b)] |= 1;
+            dec_trunc = TRUE;
+        }
         nch = get(ctx);
         dp++;
     }
@@ -862,10 +1376,19 @@ static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(vo
 
         b->data[bnum_idx(b, b->b)] = b->data[bnum_idx(b, b->b)] * 10 + nch - '0';
         limb_digits++;
+        if(dec_digits < 19) {
+            dec_m = dec_m * 10 + nch - '0';
+            dec_digits++;
+        } else if(nch != '0') {
+            dec_trunc = TRUE;
+        }
         nch = get(ctx);
     }
     while(nch>='0' && nch<='9') {
-        if(nch != '0') b->data[bnum_idx(b, b->b)] |= 1;
+        if(nch != '0') {
+            b->data[bnum_idx(b, b->b)] |= 1;
+            dec_trunc = TRUE;
+        }
         nch = get(ctx);
     }
 
@@ -917,6 +1440,14 @@ static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(vo
     if(!b->data[bnum_idx(b, b->e-1)])
         return fpnum(sign, 0, 0, 0);
 
+    /* The number is in [dec_m, dec_m+1) * 10^(dp-dec_digits) range, there's
+     * no need to use bnum if both ends round to the same double */
+    if(!ldouble && dp >= POW5_MIN_EXP && dp <= POW5_MAX_EXP + 19 &&
+            fpnum_fast_double(dec_m, dp - dec_digits, &fast_m[0], &fast_e2[0]) &&
+            (!dec_trunc || (fpnum_fast_double(dec_m + 1, dp - dec_digits, &fast_m[1], &fast_e2[1]) &&
+                            fast_m[0] == fast_m[1] && fast_e2[0] == fast_e2[1])))
+        return fpnum(sign, fast_e2[0], fast_m[0], FP_ROUND_ZERO);
+
     /* Fill last limb with 0 if needed */
     if(b->b+1 != b->e) {
         for(; limb_digits != LIMB_DIGITS; limb_digits++)
@@ -1507,6 +2038,12 @@ int CDECL _atoldbl(_LDOUBLE *value, char *str)
 size_t __cdecl strlen(const char *str)
 {
     const char *s = str;
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (avx2_supported) return avx2_strlen(str);
+    if (sse2_supported) return sse2_strlen(str);
+#endif
+
     while (*s) s++;
     return s - str;
 }
@@ -2465,9 +3002,20 @@ int CDECL I10_OUTPUT(MSVCRT__LDOUBLE ld80, int prec, int flag, struct _I10_OUTPU
  */
 int __cdecl memcmp(const void *ptr1, const void *ptr2, size_t n)
 {
-    const unsigned char *p1, *p2;
+    const unsigned char *p1 = ptr1, *p2 = ptr2;
 
-    for (p1 = ptr1, p2 = ptr2; n; n--, p1++, p2++)
+#if defined(__i386__) || defined(__x86_64__)
+    if (n >= 16 && sse2_supported)
+    {
+        size_t i = avx2_supported ? avx2_memcmp_prefix(p1, p2, n) : sse2_memcmp_prefix(p1, p2, n);
+
+        p1 += i;
+        p2 += i;
+        n -= i;
+    }
+#endif
+
+    for (; n; n--, p1++, p2++)
     {
         if (*p1 < *p2) return -1;
         if (*p1 > *p2) return 1;
@@ -2855,6 +3403,20 @@ void * __cdecl memcpy(void *dst, const void *src, size_t n)
 void* __cdecl memset(void *dst, int c, size_t n)
 {
     volatile unsigned char *d = dst;  /* avoid gcc optimizations */
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (n >= 32 && avx2_supported)
+    {
+        avx2_memset(dst, c, n);
+        return dst;
+    }
+    if (n >= 16 && sse2_supported)
+    {
+        sse2_memset(dst, c, n);
+        return dst;
+    }
+#endif
+
     while (n--) *d++ = c;
     return dst;
 }
@@ -2864,6 +3426,11 @@ void* __cdecl memset(void *dst, int c, size_t n)
  */
 char* __cdecl strchr(const char *str, int c)
 {
+#if defined(__i386__) || defined(__x86_64__)
+    if (avx2_supported) return avx2_strchr(str, c);
+    if (sse2_supported) return sse2_strchr(str, c);
+#endif
+
     do
     {
         if (*str == (char)c) return (char*)str;
@@ -2888,6 +3455,11 @@ void* __cdecl memchr(const void *ptr, int c, size_t n)
 {
     const unsigned char *p = ptr;
 
+#if defined(__i386__) || defined(__x86_64__)
+    if (n && avx2_supported) return avx2_memchr(ptr, c, n);
+    if (n && sse2_supported) return sse2_memchr(ptr, c, n);
+#endif
+
     for (p = ptr; n; n--, p++) if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
     return NULL;
 }
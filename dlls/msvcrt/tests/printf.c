@@ -251,6 +251,14 @@ static void test_sprintf( void )
         { "%.0f", "-1", 0, DOUBLE_ARG, 0, 0, -0.5 },
         { "%.0f", "1", 0, DOUBLE_ARG, 0, 0, 0.5 },
         { "%.0f", "2", 0, DOUBLE_ARG, 0, 0, 1.5 },
+        { "%.17g", "0.10000000000000001", 0, DOUBLE_ARG, 0, 0, 0.1 },
+        { "%.3f", "2.001", 0, DOUBLE_ARG, 0, 0, 2.0005 },
+        { "%.2f", "1000.00", 0, DOUBLE_ARG, 0, 0, 999.995 },
+        { "%e", "1.000000e+001", 0, DOUBLE_ARG, 0, 0, 9.9999996 },
+        { "%g", "1e-005", 0, DOUBLE_ARG, 0, 0, 1e-5 },
+        { "%.6g", "0.000123457", 0, DOUBLE_ARG, 0, 0, 0.0001234567 },
+        { "%.15g", "123456789012345", 0, DOUBLE_ARG, 0, 0, 123456789012345.0 },
+        { "%.3G", "1E+100", 0, DOUBLE_ARG, 0, 0, 1e100 },
         { "%.30f", "0.333333333333333310000000000000", 0, TODO_FLAG | DOUBLE_ARG, 0, 0, 1.0/3.0 },
         { "%.30lf", "1.414213562373095100000000000000", 0, TODO_FLAG | DOUBLE_ARG, 0, 0, sqrt(2) },
     };
@@ -60,6 +60,13 @@ static int (__cdecl *p_memcpy_s)(void *, size_t, const void *, size_t);
 static int (__cdecl *p_memmove_s)(void *, size_t, const void *, size_t);
 static int* (__cdecl *pmemcmp)(void *, const void *, size_t n);
 static int (__cdecl *p_strcmp)(const char *, const char *);
+static size_t (__cdecl *p_strlen)(const char *);
+static char* (__cdecl *p_strchr)(const char *, int);
+static void* (__cdecl *p_memchr)(const void *, int, size_t);
+static int (__cdecl *p_memcmp)(const void *, const void *, size_t);
+static void* (__cdecl *p_memset)(void *, int, size_t);
+static size_t (__cdecl *p_wcslen)(const wchar_t *);
+static int (__cdecl *p_wcscmp)(const wchar_t *, const wchar_t *);
 static int (__cdecl *p_strncmp)(const char *, const char *, size_t);
 static int (__cdecl *p_strcpy)(char *dst, const char *src);
 static int (__cdecl *pstrcpy_s)(char *dst, size_t len, const char *src);
@@ -1980,6 +1987,12 @@ static void test__strtod(void)
         { ".00", 3, 0 },
         { "-0.", 3, 0 },
         { "0e13", 4, 0 },
+        { "9007199254740993", 16, 9007199254740992.0 },
+        { "9007199254740995", 16, 9007199254740996.0 },
+        { "9007199254740993.0000000001", 27, 9007199254740994.0 },
+        { "12345678901234567890123e-3", 26, 12345678901234567890.123 },
+        { "1.00000000000000011102230246251565404236316680908203125", 55, 1.0 },
+        { "1.00000000000000011102230246251565404236316680908203126", 55, 1.0000000000000002 },
     };
     const char overflow[] = "1d9999999999999999999";
 
@@ -4271,6 +4284,188 @@ static void test_wcscmp(void)
     ok(!r, "wcscmp returned %d\n", r);
 }
 
+static void test_string_scan_bounds(void)
+{
+    unsigned char *page, *str, *ret, buf[160];
+    wchar_t *wstr, *copy;
+    size_t len, off, i;
+    DWORD old_prot;
+    int r;
+
+    page = VirtualAlloc(NULL, 0x2000, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    ok(page != NULL, "VirtualAlloc failed\n");
+    VirtualProtect(page + 0x1000, 0x1000, PAGE_NOACCESS, &old_prot);
+
+    /* Strings and buffers ending right before an inaccessible page, at every alignment. */
+    for (len = 0; len < 80; len++)
+    {
+        str = page + 0x1000 - len - 1;
+        memset(str, 'a', len);
+        str[len] = 0;
+
+        r = p_strlen((char *)str);
+        ok(r == len, "len %Iu: strlen returned %d\n", len, r);
+        ret = (unsigned char *)p_strchr((char *)str, 0);
+        ok(ret == str + len, "len %Iu: strchr returned %p, expected %p\n", len, ret, str + len);
+        ret = (unsigned char *)p_strchr((char *)str, 'b');
+        ok(!ret, "len %Iu: strchr returned %p\n", len, ret);
+        ret = p_memchr(str, 'b', len + 1);
+        ok(!ret, "len %Iu: memchr returned %p\n", len, ret);
+
+        if (len)
+        {
+            str[len - 1] = 'b';
+            ret = (unsigned char *)p_strchr((char *)str, 'b');
+            ok(ret == str + len - 1, "len %Iu: strchr returned %p, expected %p\n", len, ret, str + len - 1);
+            ret = p_memchr(str, 'b', len + 1);
+            ok(ret == str + len - 1, "len %Iu: memchr returned %p, expected %p\n", len, ret, str + len - 1);
+            ret = p_memchr(str, 'b', len - 1);
+            ok(!ret, "len %Iu: memchr returned %p\n", len, ret);
+        }
+
+        wstr = (wchar_t *)(page + 0x1000) - len - 1;
+        copy = (wchar_t *)page + 3;
+        for (i = 0; i < len; i++) wstr[i] = copy[i] = 0x3b1;
+        wstr[len] = copy[len] = 0;
+
+        r = p_wcslen(wstr);
+        ok(r == len, "len %Iu: wcslen returned %d\n", len, r);
+        r = p_wcscmp(wstr, copy);
+        ok(!r, "len %Iu: wcscmp returned %d\n", len, r);
+        if (len)
+        {
+            copy[len - 1] = 0x3b2;
+            r = p_wcscmp(wstr, copy);
+            ok(r == -1, "len %Iu: wcscmp returned %d\n", len, r);
+            r = p_wcscmp(copy, wstr);
+            ok(r == 1, "len %Iu: wcscmp returned %d\n", len, r);
+        }
+    }
+
+    for (len = 1; len < 80; len++)
+    {
+        str = page + 0x1000 - len;
+        memset(str, 0x5a, len);
+        memset(buf, 0x5a, len);
+        r = p_memcmp(str, buf, len);
+        ok(!r, "len %Iu: memcmp returned %d\n", len, r);
+
+        for (i = 0; i < len; i++)
+        {
+            buf[i] = 0x5b;
+            r = p_memcmp(str, buf, len);
+            ok(r < 0, "len %Iu, diff %Iu: memcmp returned %d\n", len, i, r);
+            r = p_memcmp(buf, str, len);
+            ok(r > 0, "len %Iu, diff %Iu: memcmp returned %d\n", len, i, r);
+            buf[i] = 0x5a;
+        }
+    }
+
+    VirtualFree(page, 0, MEM_RELEASE);
+
+    for (off = 0; off < 32; off++)
+    {
+        for (len = 0; len < 100; len++)
+        {
+            memset(buf, 0xcc, sizeof(buf));
+            ret = p_memset(buf + off, 0x5a, len);
+            ok(ret == buf + off, "memset returned %p, expected %p\n", ret, buf + off);
+            for (i = 0; i < sizeof(buf); i++)
+                if (buf[i] != (i >= off && i < off + len ? 0x5a : 0xcc)) break;
+            ok(i == sizeof(buf), "offset %Iu, len %Iu: wrong byte %#x at %Iu\n", off, len, buf[i], i);
+        }
+    }
+}
+
+static size_t scalar_strlen(const char *str)
+{
+    const volatile char *s = str;
+    while (*s) s++;
+    return s - str;
+}
+
+static const void *scalar_memchr(const void *ptr, int c, size_t n)
+{
+    const volatile unsigned char *p;
+    for (p = ptr; n; n--, p++) if (*p == (unsigned char)c) return (const void *)p;
+    return NULL;
+}
+
+static int scalar_memcmp(const void *ptr1, const void *ptr2, size_t n)
+{
+    const volatile unsigned char *p1 = ptr1, *p2 = ptr2;
+    for (; n; n--, p1++, p2++) if (*p1 != *p2) return *p1 < *p2 ? -1 : 1;
+    return 0;
+}
+
+static void scalar_memset(void *dst, int c, size_t n)
+{
+    volatile unsigned char *d = dst;
+    while (n--) *d++ = c;
+}
+
+static size_t scalar_wcslen(const wchar_t *str)
+{
+    const volatile wchar_t *s = str;
+    while (*s) s++;
+    return s - str;
+}
+
+static double get_throughput(LARGE_INTEGER start, size_t bytes)
+{
+    LARGE_INTEGER end, freq;
+
+    QueryPerformanceCounter(&end);
+    QueryPerformanceFrequency(&freq);
+    return bytes / 1048576.0 * freq.QuadPart / max(end.QuadPart - start.QuadPart, 1);
+}
+
+static void test_string_performance(void)
+{
+    static const size_t size = 0x10000, count = 2000;
+    double msvcrt, scalar;
+    LARGE_INTEGER start;
+    char *buf1, *buf2;
+    wchar_t *wbuf;
+    size_t i, res;
+
+    if (!winetest_interactive)
+    {
+        skip("Skipping string function benchmarks, set WINETEST_INTERACTIVE to run them.\n");
+        return;
+    }
+
+    buf1 = malloc(size);
+    buf2 = malloc(size);
+    wbuf = malloc(size);
+    memset(buf1, 'a', size);
+    memset(buf2, 'a', size);
+    buf1[size - 1] = 0;
+    for (i = 0; i < size / sizeof(wchar_t); i++) wbuf[i] = 'a';
+    wbuf[size / sizeof(wchar_t) - 1] = 0;
+
+#define BENCHMARK(name, expr, scalar_expr) \
+    QueryPerformanceCounter(&start); \
+    for (i = res = 0; i < count; i++) res += (size_t)(expr); \
+    msvcrt = get_throughput(start, size * count); \
+    QueryPerformanceCounter(&start); \
+    for (i = 0; i < count; i++) res -= (size_t)(scalar_expr); \
+    scalar = get_throughput(start, size * count); \
+    ok(!res, name ": results differ\n"); \
+    trace(name ": %.0f MiB/s, scalar %.0f MiB/s, %.2fx\n", msvcrt, scalar, msvcrt / scalar);
+
+    BENCHMARK("strlen", p_strlen(buf1), scalar_strlen(buf1));
+    BENCHMARK("memchr", p_memchr(buf1, 'b', size), scalar_memchr(buf1, 'b', size));
+    BENCHMARK("memcmp", p_memcmp(buf1, buf2, size), scalar_memcmp(buf1, buf2, size));
+    BENCHMARK("memset", p_memset(buf2, 'a', size) == buf2, (scalar_memset(buf2, 'a', size), 1));
+    BENCHMARK("wcslen", p_wcslen(wbuf), scalar_wcslen(wbuf));
+#undef BENCHMARK
+
+    free(wbuf);
+    free(buf2);
+    free(buf1);
+}
+
 static const char* debugstr_ldouble(_LDOUBLE *v)
 {
     static char buf[2 * ARRAY_SIZE(v->ld) + 1];
@@ -4495,6 +4690,13 @@ START_TEST(string)
     SET(p__mb_cur_max,"__mb_cur_max");
     SET(p_strcpy, "strcpy");
     SET(p_strcmp, "strcmp");
+    SET(p_strlen, "strlen");
+    SET(p_strchr, "strchr");
+    SET(p_memchr, "memchr");
+    SET(p_memcmp, "memcmp");
+    SET(p_memset, "memset");
+    SET(p_wcslen, "wcslen");
+    SET(p_wcscmp, "wcscmp");
     SET(p_strncmp, "strncmp");
     pstrcpy_s = (void *)GetProcAddress( hMsvcrt,"strcpy_s" );
     pstrcat_s = (void *)GetProcAddress( hMsvcrt,"strcat_s" );
@@ -4629,6 +4831,8 @@ START_TEST(string)
     test_strstr();
     test_iswdigit();
     test_wcscmp();
+    test_string_scan_bounds();
+    test_string_performance();
     test___STRINGTOLD();
     test_SpecialCasing();
     test__mbbtype();
@@ -31,6 +31,10 @@
 #include "wtypes.h"
 #include "wine/debug.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
+
 WINE_DEFAULT_DEBUG_CHANNEL(msvcrt);
 
 typedef struct
@@ -1837,11 +1841,56 @@ int WINAPIV _swprintf_p_l(wchar_t *buffer, size_t length,
     return r;
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+
+/* Returns the index of the first character that differs or terminates
+ * str1. Unaligned vectors are only loaded when they don't cross a page. */
+static size_t SSE2_TARGET sse2_wcscmp_prefix(const wchar_t *str1, const wchar_t *str2)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i v1, v2;
+    DWORD mask, j;
+    size_t i = 0;
+
+    for (;;)
+    {
+        if (((ULONG_PTR)(str1 + i) & 0xfff) > 0xff0 || ((ULONG_PTR)(str2 + i) & 0xfff) > 0xff0)
+        {
+            if (!str1[i] || str1[i] != str2[i]) return i;
+            i++;
+            continue;
+        }
+
+        v1 = _mm_loadu_si128((const __m128i *)(str1 + i));
+        v2 = _mm_loadu_si128((const __m128i *)(str2 + i));
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi16(v1, v2)) ^ 0xffff;
+        mask |= _mm_movemask_epi8(_mm_cmpeq_epi16(v1, zero));
+        if (mask)
+        {
+            BitScanForward(&j, mask);
+            return i + j / 2;
+        }
+        i += 8;
+    }
+}
+
+#endif
+
 /*********************************************************************
  *              wcscmp (MSVCRT.@)
  */
 int CDECL wcscmp(const wchar_t *str1, const wchar_t *str2)
 {
+#if defined(__i386__) || defined(__x86_64__)
+    if (sse2_supported)
+    {
+        size_t i = sse2_wcscmp_prefix(str1, str2);
+
+        str1 += i;
+        str2 += i;
+    }
+#endif
+
     while (*str1 && (*str1 == *str2))
     {
         str1++;
@@ -2833,12 +2882,40 @@ wchar_t* CDECL wcsrchr(const wchar_t *str, wchar_t ch)
     return ret;
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+
+/* str must be aligned to a character. Like the narrow string functions,
+ * this reads whole aligned vectors, which never cross a page. */
+static size_t SSE2_TARGET sse2_wcslen(const wchar_t *str)
+{
+    const char *p = (const char *)((ULONG_PTR)str & ~15);
+    const __m128i zero = _mm_setzero_si128();
+    DWORD mask, i;
+
+    mask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_load_si128((const __m128i *)p), zero));
+    mask &= ~0u << ((const char *)str - p);
+    while (!mask)
+    {
+        p += 16;
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_load_si128((const __m128i *)p), zero));
+    }
+    BitScanForward(&i, mask);
+    return (p + i - (const char *)str) / sizeof(wchar_t);
+}
+
+#endif
+
 /***********************************************************************
  *              wcslen (MSVCRT.@)
  */
 size_t CDECL wcslen(const wchar_t *str)
 {
     const wchar_t *s = str;
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (sse2_supported && !((ULONG_PTR)str & 1)) return sse2_wcslen(str);
+#endif
+
     while (*s) s++;
     return s - str;
 }
@@ -35,6 +35,7 @@
 #include "winternl.h"
 #include "ntdll_misc.h"
 #include "wine/list.h"
+#include "wine/exception.h"
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(heap);
@@ -163,10 +164,58 @@ typedef struct tagHEAP
     ARENA_INUSE    **pending_free;  /* Ring buffer for pending free requests */
     RTL_CRITICAL_SECTION critSection; /* Critical section for serialization */
     FREE_LIST_ENTRY *freeList;      /* Free lists */
+    struct lfh_bin  *lfh_bins;      /* Low fragmentation heap bins, NULL if not enabled */
+    ULONG            compat_info;   /* HeapCompatibilityInformation value */
+    ULONG            lfh_count;     /* Number of small allocations before automatic LFH activation */
 } HEAP;
 
 #define HEAP_MAGIC       ((DWORD)('H' | ('E'<<8) | ('A'<<16) | ('P'<<24)))
 
+/* Low fragmentation heap front end.
+ *
+ * Small blocks are carved out of groups of HEAP_LFH_GROUP_BLOCKS blocks of the same size,
+ * which are themselves regular in-use blocks of the heap. A group is either owned by a thread
+ * allocating from it, cached in one of the per-affinity slots of its bin, queued in the bin
+ * list, or full and detached; in the latter case the thread freeing one of its blocks puts it
+ * back in the bin list. This allows allocating and freeing small blocks without taking the heap
+ * critical section, which is only needed to allocate new groups.
+ */
+
+#define HEAP_STD                 0
+#define HEAP_LFH                 2
+
+#define HEAP_LFH_BIN_COUNT       128   /* number of size classes, ALIGNMENT bytes apart */
+#define HEAP_LFH_MAX_BLOCK_SIZE  (HEAP_LFH_BIN_COUNT * ALIGNMENT)
+#define HEAP_LFH_AFFINITY_COUNT  8     /* number of affinity slots per bin */
+#define HEAP_LFH_GROUP_BLOCKS    32    /* number of blocks in a group, one bit each in free_bits */
+#define HEAP_LFH_THRESHOLD       0x800 /* small allocations before enabling the LFH automatically */
+
+/* Value for arena 'magic' field of blocks belonging to an LFH group */
+#define ARENA_LFH_MAGIC          0x48464c
+
+struct lfh_group
+{
+    SLIST_ENTRY      entry;         /* Entry in bin groups list */
+    HEAP            *heap;          /* Heap the group belongs to */
+    DWORD            magic;         /* Magic number */
+    DWORD            block_size;    /* Size of the blocks, including the arena */
+    LONG             free_bits;     /* Bitmap of the free blocks */
+};
+
+#define LFH_GROUP_MAGIC  ((DWORD)('L' | ('F'<<8) | ('H'<<16) | ('G'<<24)))
+
+/* free_bits value of a group with all its blocks free */
+#define LFH_GROUP_ALL_FREE       (~0u >> (32 - HEAP_LFH_GROUP_BLOCKS))
+
+/* offset of the first block arena in a group, so that block data is correctly aligned */
+#define LFH_GROUP_HEADER_SIZE    ROUND_SIZE( sizeof(struct lfh_group) )
+
+struct lfh_bin
+{
+    SLIST_HEADER      groups;                            /* Groups with free blocks */
+    struct lfh_group *affinity[HEAP_LFH_AFFINITY_COUNT]; /* Groups cached for each affinity slot */
+};
+
 #define HEAP_DEF_SIZE        0x110000   /* Default heap size = 1Mb + 64Kb */
 #define COMMIT_MASK          0xffff  /* bitmask for commit/decommit granularity */
 #define MAX_FREE_PENDING     1024    /* max number of free requests to delay */
@@ -869,6 +918,58 @@ static BOOL validate_large_arena( HEAP *heap, const ARENA_LARGE *arena, BOOL qui
 }
 
 
+/***********************************************************************
+ *           lfh_check_block
+ *
+ * Helper for lfh_find_group, may fault on invalid pointers.
+ */
+static struct lfh_group *lfh_check_block( const HEAP *heap, const ARENA_INUSE *arena )
+{
+    struct lfh_group *group;
+    DWORD offset, index;
+
+    if (arena->magic != ARENA_LFH_MAGIC) return NULL;
+
+    if (arena->size < LFH_GROUP_HEADER_SIZE) return NULL;
+
+    group = (struct lfh_group *)((char *)arena - arena->size);
+    if (group->magic != LFH_GROUP_MAGIC || group->heap != heap) return NULL;
+
+    offset = arena->size - LFH_GROUP_HEADER_SIZE;
+    if (offset % group->block_size) return NULL;
+    if ((index = offset / group->block_size) >= HEAP_LFH_GROUP_BLOCKS) return NULL;
+    if (group->free_bits & (1u << index)) return NULL;
+    return group;
+}
+
+
+/***********************************************************************
+ *           lfh_find_group
+ *
+ * Find the LFH group containing an in-use block, or NULL if the block doesn't
+ * belong to the heap low fragmentation front end.
+ */
+static struct lfh_group *lfh_find_group( const HEAP *heap, const ARENA_INUSE *arena )
+{
+    struct lfh_group *group;
+
+    if (!heap->lfh_bins) return NULL;
+    if ((ULONG_PTR)arena % ALIGNMENT != ARENA_OFFSET) return NULL;
+
+    /* this is done before any other validation, so the pointer may not be readable */
+    __TRY
+    {
+        group = lfh_check_block( heap, arena );
+    }
+    __EXCEPT_PAGE_FAULT
+    {
+        group = NULL;
+    }
+    __ENDTRY
+    return group;
+}
+
+
 /***********************************************************************
  *           HEAP_CreateSubHeap
  */
@@ -924,6 +1025,9 @@ static SUBHEAP *HEAP_CreateSubHeap( HEAP *heap, LPVOID address, DWORD flags,
         heap->flags         = flags;
         heap->magic         = HEAP_MAGIC;
         heap->grow_size     = max( HEAP_DEF_SIZE, totalSize );
+        heap->lfh_bins      = NULL;
+        heap->compat_info   = HEAP_STD;
+        heap->lfh_count     = 0;
         list_init( &heap->subheap_list );
         list_init( &heap->large_list );
 
@@ -1344,7 +1448,8 @@ static BOOL HEAP_IsRealArena( HEAP *heapPtr,   /* [in] ptr to the heap */
     {
         const ARENA_INUSE *arena = (const ARENA_INUSE *)block - 1;
 
-        if (!(subheap = HEAP_FindSubHeap( heapPtr, arena )) ||
+        if (lfh_find_group( heapPtr, arena )) ret = TRUE;
+        else if (!(subheap = HEAP_FindSubHeap( heapPtr, arena )) ||
             ((const char *)arena < (char *)subheap->base + subheap->headerSize))
         {
             if (!(large_arena = find_large_block( heapPtr, block )))
@@ -1437,6 +1542,236 @@ static BOOL validate_block_pointer( HEAP *heap, SUBHEAP **ret_subheap, const ARE
 }
 
 
+/***********************************************************************
+ *           heap_allocate_block
+ *
+ * Allocate a block from the heap arenas. The heap must be locked.
+ */
+static void *heap_allocate_block( HEAP *heap, DWORD flags, SIZE_T size, SIZE_T rounded_size )
+{
+    ARENA_FREE *pArena;
+    ARENA_INUSE *pInUse;
+    SUBHEAP *subheap;
+
+    if (rounded_size >= HEAP_MIN_LARGE_BLOCK_SIZE && (flags & HEAP_GROWABLE))
+        return allocate_large_block( heap, flags, size );
+
+    /* Locate a suitable free block */
+
+    if (!(pArena = HEAP_FindFreeBlock( heap, rounded_size, &subheap ))) return NULL;
+
+    /* Remove the arena from the free list */
+
+    list_remove( &pArena->entry );
+
+    /* Build the in-use arena */
+
+    pInUse = (ARENA_INUSE *)pArena;
+
+    /* in-use arena is smaller than free arena,
+     * so we have to add the difference to the size */
+    pInUse->size  = (pInUse->size & ~ARENA_FLAG_FREE) + sizeof(ARENA_FREE) - sizeof(ARENA_INUSE);
+    pInUse->magic = ARENA_INUSE_MAGIC;
+
+    /* Shrink the block */
+
+    HEAP_ShrinkBlock( subheap, pInUse, rounded_size );
+    pInUse->unused_bytes = (pInUse->size & ARENA_SIZE_MASK) - size;
+
+    notify_alloc( pInUse + 1, size, flags & HEAP_ZERO_MEMORY );
+    initialize_block( pInUse + 1, size, pInUse->unused_bytes, flags );
+    return pInUse + 1;
+}
+
+
+/***********************************************************************
+ *           lfh_can_be_enabled
+ *
+ * Check whether the low fragmentation front end can be used for a heap.
+ * Like on Windows, it's not available for fixed size, non-serialized or debug heaps.
+ */
+static BOOL lfh_can_be_enabled( const HEAP *heap )
+{
+    if (!(heap->flags & HEAP_GROWABLE)) return FALSE;
+    if (heap->flags & (HEAP_NO_SERIALIZE | HEAP_SHARED | HEAP_PAGE_ALLOCS | HEAP_VALIDATE |
+                       HEAP_TAIL_CHECKING_ENABLED | HEAP_FREE_CHECKING_ENABLED)) return FALSE;
+    return !heap->pending_free;
+}
+
+
+/***********************************************************************
+ *           lfh_enable
+ *
+ * Enable the low fragmentation front end of a heap. The heap must be locked.
+ */
+static BOOL lfh_enable( HEAP *heap )
+{
+    struct lfh_bin *bins;
+    SIZE_T size = HEAP_LFH_BIN_COUNT * sizeof(*bins);
+    unsigned int i;
+
+    if (heap->lfh_bins) return TRUE;
+    if (!lfh_can_be_enabled( heap )) return FALSE;
+    if (!(bins = heap_allocate_block( heap, heap->flags | HEAP_ZERO_MEMORY, size, ROUND_SIZE(size) )))
+        return FALSE;
+    for (i = 0; i < HEAP_LFH_BIN_COUNT; i++) RtlInitializeSListHead( &bins[i].groups );
+
+    TRACE( "enabling LFH for heap %p\n", heap );
+    heap->compat_info = HEAP_LFH;
+    InterlockedExchangePointer( (void **)&heap->lfh_bins, bins );
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           lfh_get_affinity
+ *
+ * Get the affinity slot of the current thread, assigning one on first use.
+ */
+static inline ULONG lfh_get_affinity(void)
+{
+    static LONG next_affinity;
+    TEB *teb = NtCurrentTeb();
+
+    if (!teb->HeapVirtualAffinity)
+        teb->HeapVirtualAffinity = (InterlockedIncrement( &next_affinity ) & 0xffff) + 1;
+    return teb->HeapVirtualAffinity % HEAP_LFH_AFFINITY_COUNT;
+}
+
+
+/***********************************************************************
+ *           lfh_acquire_group
+ *
+ * Get a group with free blocks from a bin, allocating a new one if needed.
+ * The returned group is owned by the caller, and isn't in any bin list.
+ */
+static struct lfh_group *lfh_acquire_group( HEAP *heap, struct lfh_bin *bin, ULONG affinity,
+                                            DWORD block_size )
+{
+    SIZE_T size = LFH_GROUP_HEADER_SIZE + HEAP_LFH_GROUP_BLOCKS * block_size - sizeof(ARENA_INUSE);
+    struct lfh_group *group;
+    SLIST_ENTRY *entry;
+
+    if ((group = InterlockedExchangePointer( (void **)&bin->affinity[affinity], NULL ))) return group;
+    if ((entry = RtlInterlockedPopEntrySList( &bin->groups )))
+        return CONTAINING_RECORD( entry, struct lfh_group, entry );
+
+    RtlEnterCriticalSection( &heap->critSection );
+    group = heap_allocate_block( heap, heap->flags & ~HEAP_ZERO_MEMORY, size, ROUND_SIZE(size) );
+    RtlLeaveCriticalSection( &heap->critSection );
+    if (!group) return NULL;
+
+    TRACE( "heap %p: new group %p for %u byte blocks\n", heap, group, block_size );
+    group->heap = heap;
+    group->magic = LFH_GROUP_MAGIC;
+    group->block_size = block_size;
+    group->free_bits = ~0u >> (32 - HEAP_LFH_GROUP_BLOCKS);
+    return group;
+}
+
+
+/***********************************************************************
+ *           lfh_allocate_block
+ *
+ * Allocate a small block from the low fragmentation front end, without locking the heap.
+ */
+static void *lfh_allocate_block( HEAP *heap, DWORD flags, SIZE_T size, SIZE_T rounded_size )
+{
+    DWORD block_size = rounded_size + sizeof(ARENA_INUSE);
+    struct lfh_group *group, *prev;
+    struct lfh_bin *bin;
+    ARENA_INUSE *arena;
+    ULONG affinity;
+    LONG bits;
+    int index;
+
+    if (block_size > HEAP_LFH_MAX_BLOCK_SIZE) return NULL;
+    bin = heap->lfh_bins + block_size / ALIGNMENT - 1;
+    affinity = lfh_get_affinity();
+    if (!(group = lfh_acquire_group( heap, bin, affinity, block_size ))) return NULL;
+
+    /* only the owner clears free bits, but other threads may set them concurrently */
+    index = RtlFindLeastSignificantBit( (ULONG)group->free_bits );
+    bits = InterlockedAnd( &group->free_bits, ~(1u << index) ) & ~(1u << index);
+
+    /* if the group is now full, the next thread freeing one of its blocks will requeue it */
+    if (bits && (prev = InterlockedExchangePointer( (void **)&bin->affinity[affinity], group )))
+        RtlInterlockedPushEntrySList( &bin->groups, &prev->entry );
+
+    arena = (ARENA_INUSE *)((char *)group + LFH_GROUP_HEADER_SIZE + index * block_size);
+    arena->size = (char *)arena - (char *)group;
+    arena->magic = ARENA_LFH_MAGIC;
+    arena->unused_bytes = rounded_size - size;
+
+    notify_alloc( arena + 1, size, flags & HEAP_ZERO_MEMORY );
+    initialize_block( arena + 1, size, arena->unused_bytes, flags );
+    return arena + 1;
+}
+
+
+/***********************************************************************
+ *           lfh_release_empty_groups
+ *
+ * Return the groups of a bin list without any allocated block to the heap.
+ * Groups in the list have no owner and their free bits are only ever set, so
+ * once taken off the list, a group with all blocks free can't be used by other
+ * threads anymore. Groups cached in the affinity slots are kept.
+ */
+static void lfh_release_empty_groups( HEAP *heap, struct lfh_bin *bin )
+{
+    SLIST_ENTRY *entry, *next;
+    struct lfh_group *group;
+    ARENA_INUSE *arena;
+    SUBHEAP *subheap;
+
+    for (entry = RtlInterlockedFlushSList( &bin->groups ); entry; entry = next)
+    {
+        next = entry->Next;
+        group = CONTAINING_RECORD( entry, struct lfh_group, entry );
+        if (group->free_bits != LFH_GROUP_ALL_FREE)
+        {
+            RtlInterlockedPushEntrySList( &bin->groups, &group->entry );
+            continue;
+        }
+
+        TRACE( "heap %p: releasing empty group %p\n", heap, group );
+        group->magic = 0;
+        arena = (ARENA_INUSE *)group - 1;
+
+        RtlEnterCriticalSection( &heap->critSection );
+        notify_free( group );
+        if ((subheap = HEAP_FindSubHeap( heap, arena ))) HEAP_MakeInUseBlockFree( subheap, arena );
+        else free_large_block( heap, heap->flags, group );
+        RtlLeaveCriticalSection( &heap->critSection );
+    }
+}
+
+
+/***********************************************************************
+ *           lfh_free_block
+ *
+ * Free a block belonging to a low fragmentation front end group, without locking the heap.
+ */
+static BOOL lfh_free_block( HEAP *heap, struct lfh_group *group, ARENA_INUSE *arena )
+{
+    struct lfh_bin *bin = heap->lfh_bins + group->block_size / ALIGNMENT - 1;
+    DWORD index = (arena->size - LFH_GROUP_HEADER_SIZE) / group->block_size;
+    LONG bits;
+
+    mark_block_free( arena + 1, group->block_size - sizeof(*arena), heap->flags );
+    bits = InterlockedOr( &group->free_bits, 1u << index );
+    if (bits & (1u << index))
+    {
+        WARN( "Heap %p: block %p freed twice\n", heap, arena + 1 );
+        return FALSE;
+    }
+    /* the group was full and detached, put it back in the bin list */
+    if (!bits) RtlInterlockedPushEntrySList( &bin->groups, &group->entry );
+    else if ((bits | (1u << index)) == LFH_GROUP_ALL_FREE) lfh_release_empty_groups( heap, bin );
+    return TRUE;
+}
+
+
 /***********************************************************************
  *           heap_set_debug_flags
  */
@@ -1650,11 +1985,9 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
  */
 void * WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_T size )
 {
-    ARENA_FREE *pArena;
-    ARENA_INUSE *pInUse;
-    SUBHEAP *subheap;
     HEAP *heapPtr = HEAP_GetPtr( heap );
     SIZE_T rounded_size;
+    void *ret;
 
     /* Validate the parameters */
 
@@ -1669,53 +2002,26 @@ void * WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_
     }
     if (rounded_size < HEAP_MIN_DATA_SIZE) rounded_size = HEAP_MIN_DATA_SIZE;
 
-    if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
-
-    if (rounded_size >= HEAP_MIN_LARGE_BLOCK_SIZE && (flags & HEAP_GROWABLE))
+    if (heapPtr->lfh_bins && (ret = lfh_allocate_block( heapPtr, flags, size, rounded_size )))
     {
-        void *ret = allocate_large_block( heap, flags, size );
-        if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
-        if (!ret && (flags & HEAP_GENERATE_EXCEPTIONS)) RtlRaiseStatus( STATUS_NO_MEMORY );
         TRACE("(%p,%08x,%08lx): returning %p\n", heap, flags, size, ret );
         return ret;
     }
 
-    /* Locate a suitable free block */
-
-    if (!(pArena = HEAP_FindFreeBlock( heapPtr, rounded_size, &subheap )))
-    {
-        TRACE("(%p,%08x,%08lx): returning NULL\n",
-                  heap, flags, size  );
-        if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
-        if (flags & HEAP_GENERATE_EXCEPTIONS) RtlRaiseStatus( STATUS_NO_MEMORY );
-        return NULL;
-    }
-
-    /* Remove the arena from the free list */
-
-    list_remove( &pArena->entry );
-
-    /* Build the in-use arena */
-
-    pInUse = (ARENA_INUSE *)pArena;
+    if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
-    /* in-use arena is smaller than free arena,
-     * so we have to add the difference to the size */
-    pInUse->size  = (pInUse->size & ~ARENA_FLAG_FREE) + sizeof(ARENA_FREE) - sizeof(ARENA_INUSE);
-    pInUse->magic = ARENA_INUSE_MAGIC;
+    ret = heap_allocate_block( heapPtr, flags, size, rounded_size );
 
-    /* Shrink the block */
-
-    HEAP_ShrinkBlock( subheap, pInUse, rounded_size );
-    pInUse->unused_bytes = (pInUse->size & ARENA_SIZE_MASK) - size;
-
-    notify_alloc( pInUse + 1, size, flags & HEAP_ZERO_MEMORY );
-    initialize_block( pInUse + 1, size, pInUse->unused_bytes, flags );
+    /* switch to the low fragmentation front end once the heap is used for many small blocks */
+    if (!heapPtr->lfh_bins && rounded_size + sizeof(ARENA_INUSE) <= HEAP_LFH_MAX_BLOCK_SIZE &&
+        heapPtr->lfh_count < HEAP_LFH_THRESHOLD && ++heapPtr->lfh_count == HEAP_LFH_THRESHOLD)
+        lfh_enable( heapPtr );
 
     if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
 
-    TRACE("(%p,%08x,%08lx): returning %p\n", heap, flags, size, pInUse + 1 );
-    return pInUse + 1;
+    if (!ret && (flags & HEAP_GENERATE_EXCEPTIONS)) RtlRaiseStatus( STATUS_NO_MEMORY );
+    TRACE("(%p,%08x,%08lx): returning %p\n", heap, flags, size, ret );
+    return ret;
 }
 
 
@@ -1735,6 +2041,7 @@ void * WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_
  */
 BOOLEAN WINAPI DECLSPEC_HOTPATCH RtlFreeHeap( HANDLE heap, ULONG flags, void *ptr )
 {
+    struct lfh_group *group;
     ARENA_INUSE *pInUse;
     SUBHEAP *subheap;
     HEAP *heapPtr;
@@ -1752,13 +2059,27 @@ BOOLEAN WINAPI DECLSPEC_HOTPATCH RtlFreeHeap( HANDLE heap, ULONG flags, void *pt
 
     flags &= HEAP_NO_SERIALIZE;
     flags |= heapPtr->flags;
+    pInUse  = (ARENA_INUSE *)ptr - 1;
+
+    if ((group = lfh_find_group( heapPtr, pInUse )))
+    {
+        notify_free( ptr );
+        if (!lfh_free_block( heapPtr, group, pInUse ))
+        {
+            RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_PARAMETER );
+            TRACE("(%p,%08x,%p): returning FALSE\n", heap, flags, ptr );
+            return FALSE;
+        }
+        TRACE("(%p,%08x,%p): returning TRUE\n", heap, flags, ptr );
+        return TRUE;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     /* Inform valgrind we are trying to free memory, so it can throw up an error message */
     notify_free( ptr );
 
     /* Some sanity checks */
-    pInUse  = (ARENA_INUSE *)ptr - 1;
     if (!validate_block_pointer( heapPtr, &subheap, pInUse )) goto error;
 
     if (!subheap)
@@ -1795,6 +2116,7 @@ error:
  */
 PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size )
 {
+    struct lfh_group *group;
     ARENA_INUSE *pArena;
     HEAP *heapPtr;
     SUBHEAP *subheap;
@@ -1813,13 +2135,53 @@ PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size
     flags &= HEAP_GENERATE_EXCEPTIONS | HEAP_NO_SERIALIZE | HEAP_ZERO_MEMORY |
              HEAP_REALLOC_IN_PLACE_ONLY;
     flags |= heapPtr->flags;
+    pArena = (ARENA_INUSE *)ptr - 1;
+
+    if ((group = lfh_find_group( heapPtr, pArena )))
+    {
+        rounded_size = ROUND_SIZE(size);
+        if (rounded_size < size) goto lfh_oom;  /* overflow */
+        if (rounded_size < HEAP_MIN_DATA_SIZE) rounded_size = HEAP_MIN_DATA_SIZE;
+
+        oldBlockSize = group->block_size - sizeof(ARENA_INUSE);
+        oldActualSize = oldBlockSize - pArena->unused_bytes;
+
+        /* blocks can only be resized in place within the same size class */
+        if (rounded_size == oldBlockSize)
+        {
+            notify_realloc( ptr, oldActualSize, size );
+            pArena->unused_bytes = oldBlockSize - size;
+            if (size > oldActualSize)
+                initialize_block( (char *)ptr + oldActualSize, size - oldActualSize,
+                                  pArena->unused_bytes, flags );
+            else
+                mark_block_tail( (char *)ptr + size, pArena->unused_bytes, flags );
+            ret = ptr;
+        }
+        else
+        {
+            if (flags & HEAP_REALLOC_IN_PLACE_ONLY) goto lfh_oom;
+            if (!(ret = RtlAllocateHeap( heap, flags & ~HEAP_GENERATE_EXCEPTIONS, size ))) goto lfh_oom;
+            memcpy( ret, ptr, min( oldActualSize, size ));
+            notify_free( ptr );
+            lfh_free_block( heapPtr, group, pArena );
+        }
+        TRACE("(%p,%08x,%p,%08lx): returning %p\n", heap, flags, ptr, size, ret );
+        return ret;
+
+    lfh_oom:
+        if (flags & HEAP_GENERATE_EXCEPTIONS) RtlRaiseStatus( STATUS_NO_MEMORY );
+        RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_NO_MEMORY );
+        TRACE("(%p,%08x,%p,%08lx): returning NULL\n", heap, flags, ptr, size );
+        return NULL;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     rounded_size = ROUND_SIZE(size) + HEAP_TAIL_EXTRA_SIZE(flags);
     if (rounded_size < size) goto oom;  /* overflow */
     if (rounded_size < HEAP_MIN_DATA_SIZE) rounded_size = HEAP_MIN_DATA_SIZE;
 
-    pArena = (ARENA_INUSE *)ptr - 1;
     if (!validate_block_pointer( heapPtr, &subheap, pArena )) goto error;
     if (!subheap)
     {
@@ -2010,6 +2372,7 @@ BOOLEAN WINAPI RtlUnlockHeap( HANDLE heap )
  */
 SIZE_T WINAPI RtlSizeHeap( HANDLE heap, ULONG flags, const void *ptr )
 {
+    struct lfh_group *group;
     SIZE_T ret;
     const ARENA_INUSE *pArena;
     SUBHEAP *subheap;
@@ -2022,9 +2385,17 @@ SIZE_T WINAPI RtlSizeHeap( HANDLE heap, ULONG flags, const void *ptr )
     }
     flags &= HEAP_NO_SERIALIZE;
     flags |= heapPtr->flags;
+    pArena = (const ARENA_INUSE *)ptr - 1;
+
+    if ((group = lfh_find_group( heapPtr, pArena )))
+    {
+        ret = group->block_size - sizeof(ARENA_INUSE) - pArena->unused_bytes;
+        TRACE("(%p,%08x,%p): returning %08lx\n", heap, flags, ptr, ret );
+        return ret;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
-    pArena = (const ARENA_INUSE *)ptr - 1;
     if (!validate_block_pointer( heapPtr, &subheap, pArena ))
     {
         RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_PARAMETER );
@@ -2232,6 +2603,8 @@ ULONG WINAPI RtlGetProcessHeaps( ULONG count, HANDLE *heaps )
 NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class,
                                          PVOID info, SIZE_T size_in, PSIZE_T size_out)
 {
+    HEAP *heapPtr;
+
     switch (info_class)
     {
     case HeapCompatibilityInformation:
@@ -2240,7 +2613,9 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
         if (size_in < sizeof(ULONG))
             return STATUS_BUFFER_TOO_SMALL;
 
-        *(ULONG *)info = 0; /* standard heap */
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_HANDLE;
+
+        *(ULONG *)info = heapPtr->compat_info;
         return STATUS_SUCCESS;
 
     default:
@@ -2254,6 +2629,32 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
  */
 NTSTATUS WINAPI RtlSetHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class, PVOID info, SIZE_T size)
 {
-    FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
-    return STATUS_SUCCESS;
+    HEAP *heapPtr;
+    ULONG compat_info;
+    BOOL ret;
+
+    switch (info_class)
+    {
+    case HeapCompatibilityInformation:
+        if (size < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_HANDLE;
+        if (heapPtr->flags & HEAP_NO_SERIALIZE) return STATUS_INVALID_PARAMETER;
+
+        compat_info = *(ULONG *)info;
+        if (compat_info == heapPtr->compat_info) return STATUS_SUCCESS;
+        if (compat_info != HEAP_LFH)
+        {
+            FIXME("HeapCompatibilityInformation %u not implemented\n", compat_info);
+            return STATUS_UNSUCCESSFUL;
+        }
+
+        RtlEnterCriticalSection( &heapPtr->critSection );
+        ret = lfh_enable( heapPtr );
+        RtlLeaveCriticalSection( &heapPtr->critSection );
+        return ret ? STATUS_SUCCESS : STATUS_UNSUCCESSFUL;
+
+    default:
+        FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
+        return STATUS_SUCCESS;
+    }
 }
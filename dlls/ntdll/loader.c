@@ -136,8 +136,115 @@ typedef struct _wine_modref
     int                   alloc_deps;
     int                   nDeps;
     struct _wine_modref **deps;
+    struct import_digest *exports_digest; /* digest of the export tables, for the import cache */
 } WINE_MODREF;
 
+/* Persistent cache of resolved import address tables, enabled with WINEIMPORTCACHE=1.
+ * Each import descriptor of a module is stored with the identity of both modules and
+ * digests of the imported names and of the export tables, so that a stale entry is never
+ * used even if a file is replaced in place. The imports are stored as indexes in the
+ * export table, which are checked against it before use, so that a damaged cache file
+ * can't make us jump outside of the exporting module. */
+
+#define IMPORT_CACHE_MAGIC    0x32434957  /* "WIC2" */
+#define IMPORT_CACHE_MAX_SIZE (16 * 1024 * 1024)
+#ifdef _WIN64
+#define IMPORT_CACHE_SUFFIX   "64"
+#else
+#define IMPORT_CACHE_SUFFIX   "32"
+#endif
+
+struct import_cache_header
+{
+    DWORD magic;
+    DWORD ptr_size;
+    DWORD count;        /* number of records */
+    DWORD size;         /* total file size */
+};
+
+struct import_digest
+{
+    DWORD data[5];  /* SHA-1 */
+};
+
+struct import_cache_record
+{
+    struct file_id       importer_id;
+    struct file_id       exporter_id;
+    DWORD                importer_time;  /* TimeDateStamp of the importing module */
+    DWORD                exporter_time;  /* TimeDateStamp of the exporting module */
+    DWORD                thunk_rva;      /* FirstThunk of the import descriptor */
+    struct import_digest names_digest;   /* digest of the imported names and ordinals */
+    struct import_digest exports_digest; /* digest of the export tables of the exporting module */
+    DWORD                count;          /* number of thunks */
+    DWORD                functions[1];   /* index of each import in the export address table */
+};
+
+typedef struct
+{
+    ULONG unknown[6];
+    ULONG state[5];
+    ULONG count[2];
+    UCHAR buffer[64];
+} SHA_CTX;
+
+extern void WINAPI A_SHAInit( SHA_CTX * );
+extern void WINAPI A_SHAUpdate( SHA_CTX *, const unsigned char *, unsigned int );
+extern void WINAPI A_SHAFinal( SHA_CTX *, ULONG * );
+
+static BOOL use_import_cache;
+static BOOL import_cache_loaded;
+static BOOL import_cache_dirty;
+static struct import_cache_record **import_cache;  /* open addressing hash table */
+static unsigned int import_cache_size;
+static unsigned int import_cache_count;
+static char *import_cache_data;       /* contents of the cache file */
+static SIZE_T import_cache_data_size;
+
+/* Parallel loading, enabled with the MaxLoaderThreads image file execution option.
+ * Loader worker threads search, map and relocate the dependencies of the modules
+ * being loaded ahead of the loader thread, which then picks up the mapped views.
+ * Module lists, import resolution and DllMain calls stay on the loader thread.
+ * The workers are started on first use and wait on prefetch_cv between loads;
+ * they exit after staying idle for a while, like the Windows loader workers. */
+
+#define TEB_LOADER_WORKER     0x2000  /* SameTebFlags bit of the loader worker threads */
+#define MAX_LOADER_WORKERS    16
+#define LOADER_WORKER_IDLE_TIMEOUT  (-5 * (ULONGLONG)10000000)  /* 5 seconds */
+
+enum prefetch_state
+{
+    PREFETCH_QUEUED,   /* waiting for a worker */
+    PREFETCH_RUNNING,  /* being mapped by a worker */
+    PREFETCH_DONE,     /* mapping finished, successfully or not */
+    PREFETCH_TAKEN     /* claimed by the loader thread */
+};
+
+struct prefetch_dll
+{
+    struct list                entry;
+    struct list                queue_entry; /* entry in the queue while in PREFETCH_QUEUED state */
+    enum prefetch_state        state;
+    NTSTATUS                   status;
+    WCHAR                     *name;        /* dll name with extension */
+    UNICODE_STRING             nt_name;     /* file that was found */
+    HANDLE                     mapping;
+    SECTION_IMAGE_INFORMATION  image_info;
+    struct file_id             id;
+    BOOL                       has_id;
+    void                      *module;      /* mapped and relocated view */
+};
+
+static unsigned int loader_worker_count;   /* number of worker threads, 0 if disabled */
+static struct list prefetch_list = LIST_INIT( prefetch_list );
+static struct list prefetch_queue = LIST_INIT( prefetch_queue );
+static BOOL prefetch_active;
+static unsigned int loader_workers;        /* number of running worker threads */
+static unsigned int prefetch_busy;         /* number of worker threads mapping a dll */
+static LPCWSTR prefetch_load_path;
+static RTL_SRWLOCK prefetch_lock = RTL_SRWLOCK_INIT;
+static RTL_CONDITION_VARIABLE prefetch_cv = RTL_CONDITION_VARIABLE_INIT;
+
 static UINT tls_module_count;      /* number of modules with TLS directory */
 static IMAGE_TLS_DIRECTORY *tls_dirs;  /* array of TLS directories */
 LIST_ENTRY tls_links = { &tls_links, &tls_links };
@@ -187,6 +294,10 @@ static WINE_MODREF *last_failed_modref;
 static NTSTATUS load_dll( const WCHAR *load_path, const WCHAR *libname, const WCHAR *default_ext,
                           DWORD flags, WINE_MODREF** pwm );
 static NTSTATUS process_attach( WINE_MODREF *wm, LPVOID lpReserved );
+static NTSTATUS get_env_var( const WCHAR *name, SIZE_T extra, UNICODE_STRING *ret );
+static BOOL begin_parallel_load( WINE_MODREF *wm, LPCWSTR load_path );
+static NTSTATUS find_actctx_dll( LPCWSTR libname, LPWSTR *fullname );
+static void end_parallel_load(void);
 static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
                                     DWORD exp_size, DWORD ordinal, LPCWSTR load_path );
 static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
@@ -798,6 +909,433 @@ void * WINAPI RtlFindExportedRoutineByName( HMODULE module, const char *name )
 }
 
 
+/*************************************************************************
+ *		hash_import_data
+ *
+ * FNV-1a hash of the given data, processed 16 bits at a time. Only used for the hash table.
+ */
+static DWORD hash_import_data( DWORD hash, const void *data, SIZE_T size )
+{
+    const BYTE *ptr = data;
+
+    for (; size >= sizeof(WORD); size -= sizeof(WORD), ptr += sizeof(WORD))
+        hash = (hash ^ (ptr[0] | (ptr[1] << 8))) * 0x01000193;
+    if (size) hash = (hash ^ ptr[0]) * 0x01000193;
+    return hash;
+}
+
+
+/*************************************************************************
+ *		get_exports_digest
+ *
+ * Digest of the export tables of a module, computed once per module.
+ */
+static const struct import_digest *get_exports_digest( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports )
+{
+    HMODULE module = wm->ldr.DllBase;
+    struct import_digest *digest;
+    SHA_CTX ctx;
+
+    if (wm->exports_digest) return wm->exports_digest;
+    if (!(digest = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*digest) ))) return NULL;
+
+    A_SHAInit( &ctx );
+    A_SHAUpdate( &ctx, (const unsigned char *)exports, sizeof(*exports) );
+    A_SHAUpdate( &ctx, get_rva( module, exports->AddressOfFunctions ),
+                 exports->NumberOfFunctions * sizeof(DWORD) );
+    A_SHAUpdate( &ctx, get_rva( module, exports->AddressOfNames ),
+                 exports->NumberOfNames * sizeof(DWORD) );
+    A_SHAUpdate( &ctx, get_rva( module, exports->AddressOfNameOrdinals ),
+                 exports->NumberOfNames * sizeof(WORD) );
+    A_SHAFinal( &ctx, digest->data );
+    return wm->exports_digest = digest;
+}
+
+
+/*************************************************************************
+ *		get_import_names_digest
+ *
+ * Digest of the names and ordinals imported by an import descriptor.
+ */
+static void get_import_names_digest( HMODULE module, const IMAGE_THUNK_DATA *import_list,
+                                     struct import_digest *digest )
+{
+    SHA_CTX ctx;
+
+    A_SHAInit( &ctx );
+    for (; import_list->u1.Ordinal; import_list++)
+    {
+        if (IMAGE_SNAP_BY_ORDINAL(import_list->u1.Ordinal))
+        {
+            WORD ordinal = IMAGE_ORDINAL(import_list->u1.Ordinal);
+            A_SHAUpdate( &ctx, (const unsigned char *)&ordinal, sizeof(ordinal) );
+        }
+        else
+        {
+            const IMAGE_IMPORT_BY_NAME *pe_name = get_rva( module, (DWORD)import_list->u1.AddressOfData );
+            A_SHAUpdate( &ctx, pe_name->Name, strlen( (const char *)pe_name->Name ) + 1 );
+        }
+    }
+    A_SHAFinal( &ctx, digest->data );
+}
+
+
+static inline BOOL has_file_id( const WINE_MODREF *wm )
+{
+    static const struct file_id zero_id;
+    return memcmp( &wm->id, &zero_id, sizeof(zero_id) ) != 0;
+}
+
+static inline unsigned int import_cache_record_size( DWORD count )
+{
+    return FIELD_OFFSET( struct import_cache_record, functions[count] );
+}
+
+
+/*************************************************************************
+ *		find_import_cache_slot
+ *
+ * Find the hash table slot of the record for an import descriptor, or the free slot to use for it.
+ */
+static struct import_cache_record **find_import_cache_slot( const struct file_id *id, DWORD thunk_rva )
+{
+    unsigned int i, mask = import_cache_size - 1;
+
+    i = hash_import_data( hash_import_data( 0x811c9dc5, id, sizeof(*id) ), &thunk_rva, sizeof(thunk_rva) );
+    for (i &= mask; import_cache[i]; i = (i + 1) & mask)
+    {
+        if (import_cache[i]->thunk_rva == thunk_rva &&
+            !memcmp( &import_cache[i]->importer_id, id, sizeof(*id) ))
+            break;
+    }
+    return &import_cache[i];
+}
+
+
+/*************************************************************************
+ *		free_import_cache_record
+ */
+static void free_import_cache_record( struct import_cache_record *record )
+{
+    /* records read from the cache file live in a single buffer */
+    if ((char *)record >= import_cache_data && (char *)record < import_cache_data + import_cache_data_size)
+        return;
+    RtlFreeHeap( GetProcessHeap(), 0, record );
+}
+
+
+/*************************************************************************
+ *		add_import_cache_record
+ *
+ * Add a record to the hash table, replacing an older record for the same import descriptor.
+ */
+static BOOL add_import_cache_record( struct import_cache_record *record )
+{
+    struct import_cache_record **slot;
+
+    if ((import_cache_count + 1) * 2 > import_cache_size)
+    {
+        struct import_cache_record **old_cache = import_cache;
+        unsigned int i, old_size = import_cache_size;
+
+        import_cache_size = max( 256, old_size * 2 );
+        if (!(import_cache = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                              import_cache_size * sizeof(*import_cache) )))
+        {
+            import_cache = old_cache;
+            import_cache_size = old_size;
+            return FALSE;
+        }
+        for (i = 0; i < old_size; i++)
+        {
+            if (!old_cache[i]) continue;
+            *find_import_cache_slot( &old_cache[i]->importer_id, old_cache[i]->thunk_rva ) = old_cache[i];
+        }
+        RtlFreeHeap( GetProcessHeap(), 0, old_cache );
+    }
+
+    slot = find_import_cache_slot( &record->importer_id, record->thunk_rva );
+    if (*slot) free_import_cache_record( *slot );
+    else import_cache_count++;
+    *slot = record;
+    return TRUE;
+}
+
+
+/*************************************************************************
+ *		get_import_cache_name
+ *
+ * Build the NT name of the import cache file in the configuration directory.
+ */
+static BOOL get_import_cache_name( UNICODE_STRING *name )
+{
+    static const WCHAR cache_name[] = L"\\importcache" IMPORT_CACHE_SUFFIX ".bin";
+
+    if (get_env_var( L"WINECONFIGDIR", ARRAY_SIZE(cache_name), name )) return FALSE;
+    wcscat( name->Buffer, cache_name );
+    name->Length = wcslen( name->Buffer ) * sizeof(WCHAR);
+    return TRUE;
+}
+
+
+/*************************************************************************
+ *		load_import_cache
+ *
+ * Read the import cache file of the prefix, if any.
+ * The loader_section must be locked while calling this function.
+ */
+static void load_import_cache(void)
+{
+    const struct import_cache_header *header;
+    FILE_STANDARD_INFORMATION info;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING name;
+    IO_STATUS_BLOCK io;
+    HANDLE handle;
+    SIZE_T pos;
+    DWORD i;
+
+    import_cache_loaded = TRUE;
+    if (!get_import_cache_name( &name )) return;
+
+    InitializeObjectAttributes( &attr, &name, OBJ_CASE_INSENSITIVE, 0, NULL );
+    if (NtOpenFile( &handle, GENERIC_READ | SYNCHRONIZE, &attr, &io, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                    FILE_SYNCHRONOUS_IO_NONALERT | FILE_NON_DIRECTORY_FILE ))
+        goto done;
+
+    if (!NtQueryInformationFile( handle, &io, &info, sizeof(info), FileStandardInformation ) &&
+        info.EndOfFile.QuadPart >= sizeof(*header) && info.EndOfFile.QuadPart <= IMPORT_CACHE_MAX_SIZE &&
+        (import_cache_data = RtlAllocateHeap( GetProcessHeap(), 0, info.EndOfFile.QuadPart )))
+    {
+        import_cache_data_size = info.EndOfFile.QuadPart;
+        if (NtReadFile( handle, 0, NULL, NULL, &io, import_cache_data, import_cache_data_size, NULL, NULL ) ||
+            io.Information != import_cache_data_size)
+            import_cache_data_size = 0;
+    }
+    NtClose( handle );
+
+    header = (const struct import_cache_header *)import_cache_data;
+    if (import_cache_data_size < sizeof(*header) || header->magic != IMPORT_CACHE_MAGIC ||
+        header->ptr_size != sizeof(void *) || header->size != import_cache_data_size)
+    {
+        if (import_cache_data_size) WARN( "ignoring invalid import cache %s\n", debugstr_us(&name) );
+        RtlFreeHeap( GetProcessHeap(), 0, import_cache_data );
+        import_cache_data = NULL;
+        import_cache_data_size = 0;
+        goto done;
+    }
+
+    pos = sizeof(*header);
+    for (i = 0; i < header->count; i++)
+    {
+        struct import_cache_record *record = (struct import_cache_record *)(import_cache_data + pos);
+
+        if (import_cache_data_size - pos < import_cache_record_size( 0 ) ||
+            record->count > (import_cache_data_size - pos - import_cache_record_size( 0 )) / sizeof(DWORD))
+            break;
+        if (!add_import_cache_record( record )) break;
+        pos += import_cache_record_size( record->count );
+    }
+    TRACE( "loaded %u import descriptors from %s\n", import_cache_count, debugstr_us(&name) );
+
+done:
+    RtlFreeUnicodeString( &name );
+}
+
+
+/*************************************************************************
+ *		save_import_cache
+ *
+ * Write the import cache file back if new import descriptors were resolved.
+ * The file is replaced atomically so that concurrent processes only see complete files.
+ * The loader_section must be locked while calling this function.
+ */
+static void save_import_cache(void)
+{
+    struct import_cache_header header;
+    FILE_DISPOSITION_INFORMATION disp;
+    FILE_RENAME_INFORMATION *rename;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING name, tmp_name;
+    IO_STATUS_BLOCK io;
+    HANDLE handle;
+    NTSTATUS status = STATUS_SUCCESS;
+    unsigned int i;
+
+    if (!import_cache_dirty) return;
+    import_cache_dirty = FALSE;
+
+    if (!get_import_cache_name( &name )) return;
+    if (!(rename = RtlAllocateHeap( GetProcessHeap(), 0,
+                                    FIELD_OFFSET( FILE_RENAME_INFORMATION, FileName[name.Length / sizeof(WCHAR)] ))))
+        goto done;
+
+    tmp_name.MaximumLength = name.Length + 16 * sizeof(WCHAR);
+    if (!(tmp_name.Buffer = RtlAllocateHeap( GetProcessHeap(), 0, tmp_name.MaximumLength ))) goto done;
+    swprintf( tmp_name.Buffer, tmp_name.MaximumLength / sizeof(WCHAR), L"%s.%x", name.Buffer,
+              HandleToULong( NtCurrentTeb()->ClientId.UniqueProcess ));
+    tmp_name.Length = wcslen( tmp_name.Buffer ) * sizeof(WCHAR);
+
+    InitializeObjectAttributes( &attr, &tmp_name, OBJ_CASE_INSENSITIVE, 0, NULL );
+    if (NtCreateFile( &handle, GENERIC_WRITE | DELETE | SYNCHRONIZE, &attr, &io, NULL, FILE_ATTRIBUTE_NORMAL,
+                      0, FILE_OVERWRITE_IF, FILE_SYNCHRONOUS_IO_NONALERT | FILE_NON_DIRECTORY_FILE, NULL, 0 ))
+    {
+        RtlFreeUnicodeString( &tmp_name );
+        goto done;
+    }
+
+    header.magic = IMPORT_CACHE_MAGIC;
+    header.ptr_size = sizeof(void *);
+    header.count = 0;
+    header.size = sizeof(header);
+    for (i = 0; i < import_cache_size; i++)
+    {
+        if (!import_cache[i]) continue;
+        if (header.size + import_cache_record_size( import_cache[i]->count ) > IMPORT_CACHE_MAX_SIZE) continue;
+        header.size += import_cache_record_size( import_cache[i]->count );
+        header.count++;
+    }
+
+    status = NtWriteFile( handle, 0, NULL, NULL, &io, &header, sizeof(header), NULL, NULL );
+    for (i = 0, header.size = sizeof(header); !status && i < import_cache_size; i++)
+    {
+        DWORD size;
+
+        if (!import_cache[i]) continue;
+        size = import_cache_record_size( import_cache[i]->count );
+        if (header.size + size > IMPORT_CACHE_MAX_SIZE) continue;
+        header.size += size;
+        status = NtWriteFile( handle, 0, NULL, NULL, &io, import_cache[i], size, NULL, NULL );
+    }
+
+    if (!status)
+    {
+        rename->ReplaceIfExists = TRUE;
+        rename->RootDirectory = 0;
+        rename->FileNameLength = name.Length;
+        memcpy( rename->FileName, name.Buffer, name.Length );
+        status = NtSetInformationFile( handle, &io, rename,
+                                       FIELD_OFFSET( FILE_RENAME_INFORMATION, FileName[name.Length / sizeof(WCHAR)] ),
+                                       FileRenameInformation );
+    }
+    if (status)
+    {
+        WARN( "failed to write import cache %s, status %x\n", debugstr_us(&name), status );
+        disp.DoDeleteFile = TRUE;
+        NtSetInformationFile( handle, &io, &disp, sizeof(disp), FileDispositionInformation );
+    }
+    else TRACE( "saved %u import descriptors to %s\n", header.count, debugstr_us(&name) );
+    NtClose( handle );
+    RtlFreeUnicodeString( &tmp_name );
+
+done:
+    RtlFreeHeap( GetProcessHeap(), 0, rename );
+    RtlFreeUnicodeString( &name );
+}
+
+
+/*************************************************************************
+ *		get_cached_imports
+ *
+ * Fill the import address table of an import descriptor from the cache.
+ * The loader_section must be locked while calling this function.
+ */
+static BOOL get_cached_imports( WINE_MODREF *importer, const IMAGE_IMPORT_DESCRIPTOR *descr,
+                                WINE_MODREF *exporter, const IMAGE_EXPORT_DIRECTORY *exports, DWORD exp_size,
+                                const struct import_digest *names_digest, IMAGE_THUNK_DATA *thunk_list, DWORD count )
+{
+    HMODULE module = exporter->ldr.DllBase;
+    DWORD i, exp_rva = (const char *)exports - (const char *)module;
+    const struct import_cache_record *record;
+    const struct import_digest *exports_digest;
+    const DWORD *functions;
+
+    if (!import_cache_loaded) load_import_cache();
+    if (!import_cache_count) return FALSE;
+
+    record = *find_import_cache_slot( &importer->id, descr->FirstThunk );
+    if (!record) return FALSE;
+    if (record->importer_time != importer->ldr.TimeDateStamp ||
+        record->exporter_time != exporter->ldr.TimeDateStamp ||
+        memcmp( &record->exporter_id, &exporter->id, sizeof(exporter->id) ) ||
+        memcmp( &record->names_digest, names_digest, sizeof(*names_digest) ) ||
+        record->count != count ||
+        !(exports_digest = get_exports_digest( exporter, exports )) ||
+        memcmp( &record->exports_digest, exports_digest, sizeof(*exports_digest) ))
+        return FALSE;
+
+    /* only accept entries of the export table that resolve to code in the module */
+    functions = get_rva( module, exports->AddressOfFunctions );
+    for (i = 0; i < count; i++)
+    {
+        DWORD index = record->functions[i], rva;
+
+        if (index >= exports->NumberOfFunctions) return FALSE;
+        rva = functions[index];
+        if (!rva || rva >= exporter->ldr.SizeOfImage) return FALSE;
+        if (rva >= exp_rva && rva < exp_rva + exp_size) return FALSE;  /* forward */
+        thunk_list[i].u1.Function = (ULONG_PTR)module + rva;
+    }
+    return TRUE;
+}
+
+
+/*************************************************************************
+ *		put_cached_imports
+ *
+ * Store the resolved import address table of an import descriptor in the cache.
+ * Imports that don't resolve directly to an entry of the export table, such as
+ * stubs and forwarded exports, make the descriptor uncacheable.
+ * The loader_section must be locked while calling this function.
+ */
+static void put_cached_imports( WINE_MODREF *importer, const IMAGE_IMPORT_DESCRIPTOR *descr,
+                                WINE_MODREF *exporter, const IMAGE_EXPORT_DIRECTORY *exports,
+                                const struct import_digest *names_digest, const IMAGE_THUNK_DATA *import_list,
+                                const IMAGE_THUNK_DATA *thunk_list, DWORD count )
+{
+    HMODULE module = exporter->ldr.DllBase;
+    const DWORD *functions = get_rva( module, exports->AddressOfFunctions );
+    const struct import_digest *exports_digest;
+    struct import_cache_record *record;
+    DWORD i;
+    int index;
+
+    if (!(exports_digest = get_exports_digest( exporter, exports ))) return;
+    if (!(record = RtlAllocateHeap( GetProcessHeap(), 0, import_cache_record_size( count ) ))) return;
+
+    for (i = 0; i < count; i++)
+    {
+        if (IMAGE_SNAP_BY_ORDINAL(import_list[i].u1.Ordinal))
+            index = IMAGE_ORDINAL(import_list[i].u1.Ordinal) - exports->Base;
+        else
+        {
+            const IMAGE_IMPORT_BY_NAME *pe_name = get_rva( importer->ldr.DllBase,
+                                                           (DWORD)import_list[i].u1.AddressOfData );
+            index = find_name_in_exports( module, exports, (const char *)pe_name->Name );
+        }
+        if (index < 0 || index >= exports->NumberOfFunctions ||
+            thunk_list[i].u1.Function != (ULONG_PTR)module + functions[index])
+        {
+            RtlFreeHeap( GetProcessHeap(), 0, record );
+            return;
+        }
+        record->functions[i] = index;
+    }
+
+    record->importer_id = importer->id;
+    record->exporter_id = exporter->id;
+    record->importer_time = importer->ldr.TimeDateStamp;
+    record->exporter_time = exporter->ldr.TimeDateStamp;
+    record->thunk_rva = descr->FirstThunk;
+    record->names_digest = *names_digest;
+    record->exports_digest = *exports_digest;
+    record->count = count;
+
+    if (add_import_cache_record( record )) import_cache_dirty = TRUE;
+    else RtlFreeHeap( GetProcessHeap(), 0, record );
+}
+
+
 /*************************************************************************
  *		import_dll
  *
@@ -818,7 +1356,9 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
     DWORD len = strlen(name);
     PVOID protect_base;
     SIZE_T protect_size = 0;
-    DWORD protect_old;
+    DWORD protect_old, count;
+    struct import_digest names_digest;
+    BOOL cacheable;
 
     thunk_list = get_rva( module, (DWORD)descr->FirstThunk );
     if (descr->u.OriginalFirstThunk)
@@ -865,6 +1405,7 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
     /* unprotect the import address table since it can be located in
      * readonly section */
     while (import_list[protect_size].u1.Ordinal) protect_size++;
+    count = protect_size;
     protect_base = thunk_list;
     protect_size *= sizeof(*thunk_list);
     NtProtectVirtualMemory( NtCurrentProcess(), &protect_base,
@@ -899,6 +1440,19 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
         goto done;
     }
 
+    /* relay and snoop thunks are different in every process */
+    cacheable = use_import_cache && !TRACE_ON(relay) && !TRACE_ON(snoop) &&
+                has_file_id( current_modref ) && has_file_id( wmImp );
+    if (cacheable)
+    {
+        get_import_names_digest( module, import_list, &names_digest );
+        if (get_cached_imports( current_modref, descr, wmImp, exports, exp_size, &names_digest, thunk_list, count ))
+        {
+            TRACE_(imports)( "--- %s imports from cache\n", name );
+            goto done;
+        }
+    }
+
     while (import_list->u1.Ordinal)
     {
         if (IMAGE_SNAP_BY_ORDINAL(import_list->u1.Ordinal))
@@ -936,6 +1490,9 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
         import_list++;
         thunk_list++;
     }
+    if (cacheable)
+        put_cached_imports( current_modref, descr, wmImp, exports, &names_digest,
+                            import_list - count, thunk_list - count, count );
 
 done:
     /* restore old protection of the import address table */
@@ -1160,6 +1717,7 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
     DWORD size;
     NTSTATUS status;
     ULONG_PTR cookie;
+    BOOL parallel;
 
     if (!(wm->ldr.Flags & LDR_DONT_RESOLVE_REFS)) return STATUS_SUCCESS;  /* already done */
     wm->ldr.Flags &= ~LDR_DONT_RESOLVE_REFS;
@@ -1184,6 +1742,7 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
      */
     prev = current_modref;
     current_modref = wm;
+    parallel = begin_parallel_load( wm, load_path );
     status = STATUS_SUCCESS;
     for (i = 0; i < nb_imports; i++)
     {
@@ -1196,6 +1755,7 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
         }
         wm->deps[dep] = imp;
     }
+    if (parallel) end_parallel_load();
     current_modref = prev;
     if (wm->ldr.ActivationContext) RtlDeactivateActivationContext( 0, cookie );
     return status;
@@ -1886,7 +2446,7 @@ static NTSTATUS perform_relocations( void *module, IMAGE_NT_HEADERS *nt, SIZE_T
  */
 static NTSTATUS build_module( LPCWSTR load_path, const UNICODE_STRING *nt_name, void **module,
                               const SECTION_IMAGE_INFORMATION *image_info, const struct file_id *id,
-                              DWORD flags, WINE_MODREF **pwm )
+                              DWORD flags, BOOL relocated, WINE_MODREF **pwm )
 {
     static const char builtin_signature[] = "Wine builtin DLL";
     char *signature = (char *)((IMAGE_DOS_HEADER *)*module + 1);
@@ -1899,7 +2459,7 @@ static NTSTATUS build_module( LPCWSTR load_path, const UNICODE_STRING *nt_name,
     if (!(nt = RtlImageNtHeader( *module ))) return STATUS_INVALID_IMAGE_FORMAT;
 
     map_size = (nt->OptionalHeader.SizeOfImage + page_size - 1) & ~(page_size - 1);
-    if ((status = perform_relocations( *module, nt, map_size ))) return status;
+    if (!relocated && (status = perform_relocations( *module, nt, map_size ))) return status;
 
     is_builtin = ((char *)nt - signature >= sizeof(builtin_signature) &&
                   !memcmp( signature, builtin_signature, sizeof(builtin_signature) ));
@@ -2260,6 +2820,473 @@ static NTSTATUS get_dll_load_path_search_flags( LPCWSTR module, DWORD flags, WCH
 }
 
 
+/***********************************************************************
+ *	find_prefetch_dll
+ *
+ * Find the prefetch entry of a dll. The prefetch lock must be held.
+ */
+static struct prefetch_dll *find_prefetch_dll( const WCHAR *name )
+{
+    struct prefetch_dll *dll;
+
+    LIST_FOR_EACH_ENTRY( dll, &prefetch_list, struct prefetch_dll, entry )
+        if (!wcsicmp( dll->name, name )) return dll;
+    return NULL;
+}
+
+
+/***********************************************************************
+ *	add_prefetch_dll
+ *
+ * Add a dll to the prefetch list. The prefetch lock must be held.
+ */
+static struct prefetch_dll *add_prefetch_dll( const WCHAR *name, enum prefetch_state state )
+{
+    struct prefetch_dll *dll;
+
+    if (!(dll = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*dll) ))) return NULL;
+    if (!(dll->name = RtlAllocateHeap( GetProcessHeap(), 0, (wcslen(name) + 1) * sizeof(WCHAR) )))
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, dll );
+        return NULL;
+    }
+    wcscpy( dll->name, name );
+    dll->state = state;
+    dll->status = STATUS_DLL_NOT_FOUND;
+    list_add_tail( &prefetch_list, &dll->entry );
+    if (state == PREFETCH_QUEUED) list_add_tail( &prefetch_queue, &dll->queue_entry );
+    return dll;
+}
+
+
+/***********************************************************************
+ *	get_prefetch_name
+ *
+ * Build the name of an imported dll the same way as import_dll and find_dll_file.
+ * Returns FALSE for names that are not searched in the load path.
+ */
+static BOOL get_prefetch_name( const char *name, DWORD max_len, WCHAR *buffer, DWORD size )
+{
+    DWORD len = 0;
+
+    while (len < max_len && name[len]) len++;
+    if (len == max_len) return FALSE;
+    while (len && name[len - 1] == ' ') len--;  /* remove trailing spaces */
+    if (!len || len + 5 > size) return FALSE;
+
+    ascii_to_unicode( buffer, name, len );
+    buffer[len] = 0;
+    if (contains_path( buffer )) return FALSE;
+    if (!wcschr( buffer, '.' )) wcscat( buffer, L".dll" );
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *	queue_module_imports
+ *
+ * Queue the imports of a module that are not known yet. The prefetch lock must be held.
+ * The loaded modules and the activation context are only checked on the loader thread.
+ */
+static void queue_module_imports( HMODULE module, BOOL loader_thread )
+{
+    const IMAGE_NT_HEADERS *nt = RtlImageNtHeader( module );
+    const IMAGE_IMPORT_DESCRIPTOR *imports;
+    WCHAR name[64], *fullname;
+    DWORD size, image_size;
+
+    if (!nt) return;
+    if (!(imports = RtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_IMPORT, &size )))
+        return;
+    image_size = nt->OptionalHeader.SizeOfImage;
+
+    for ( ; (char *)(imports + 1) <= (char *)module + image_size; imports++)
+    {
+        if (!imports->Name || !imports->FirstThunk) break;
+        if (imports->Name >= image_size) continue;
+        if (!get_prefetch_name( get_rva( module, imports->Name ), image_size - imports->Name,
+                                name, ARRAY_SIZE(name) ))
+            continue;
+        if (find_prefetch_dll( name )) continue;
+        if (loader_thread)
+        {
+            if (find_basename_module( name )) continue;
+            fullname = NULL;
+            if (find_actctx_dll( name, &fullname ) != STATUS_SXS_KEY_NOT_FOUND)
+            {
+                RtlFreeHeap( GetProcessHeap(), 0, fullname );
+                continue;
+            }
+        }
+        add_prefetch_dll( name, PREFETCH_QUEUED );
+    }
+}
+
+
+/***********************************************************************
+ *	open_prefetch_file
+ *
+ * Open the file of a prefetched dll and create its mapping. Same as open_dll_file,
+ * except that the loaded modules are left to the loader thread.
+ */
+static NTSTATUS open_prefetch_file( struct prefetch_dll *dll )
+{
+    FILE_BASIC_INFORMATION info;
+    OBJECT_ATTRIBUTES attr;
+    IO_STATUS_BLOCK io;
+    LARGE_INTEGER size;
+    FILE_OBJECTID_BUFFER fid;
+    NTSTATUS status;
+    HANDLE handle;
+
+    attr.Length = sizeof(attr);
+    attr.RootDirectory = 0;
+    attr.Attributes = OBJ_CASE_INSENSITIVE;
+    attr.ObjectName = &dll->nt_name;
+    attr.SecurityDescriptor = NULL;
+    attr.SecurityQualityOfService = NULL;
+    if ((status = NtOpenFile( &handle, GENERIC_READ | SYNCHRONIZE, &attr, &io,
+                              FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              FILE_SYNCHRONOUS_IO_NONALERT | FILE_NON_DIRECTORY_FILE )))
+    {
+        if (status != STATUS_OBJECT_PATH_NOT_FOUND &&
+            status != STATUS_OBJECT_NAME_NOT_FOUND &&
+            !NtQueryAttributesFile( &attr, &info ))
+            return status;
+        return STATUS_DLL_NOT_FOUND;
+    }
+
+    if (!NtFsControlFile( handle, 0, NULL, NULL, &io, FSCTL_GET_OBJECT_ID, NULL, 0, &fid, sizeof(fid) ))
+    {
+        memcpy( &dll->id, fid.ObjectId, sizeof(dll->id) );
+        dll->has_id = TRUE;
+    }
+
+    size.QuadPart = 0;
+    status = NtCreateSection( &dll->mapping, STANDARD_RIGHTS_REQUIRED | SECTION_QUERY |
+                              SECTION_MAP_READ | SECTION_MAP_EXECUTE,
+                              NULL, &size, PAGE_EXECUTE_READ, SEC_IMAGE, handle );
+    if (!status)
+    {
+        NtQuerySection( dll->mapping, SectionImageInformation, &dll->image_info, sizeof(dll->image_info), NULL );
+        if (!is_valid_binary( handle, &dll->image_info ))
+        {
+            status = STATUS_IMAGE_MACHINE_TYPE_MISMATCH;
+            NtClose( dll->mapping );
+            dll->mapping = 0;
+        }
+    }
+    NtClose( handle );
+    return status;
+}
+
+
+/***********************************************************************
+ *	map_prefetch_dll
+ *
+ * Search, map and relocate a prefetched dll. Runs on a loader worker thread.
+ */
+static void map_prefetch_dll( struct prefetch_dll *dll, LPCWSTR paths )
+{
+    IMAGE_NT_HEADERS *nt;
+    NTSTATUS status = STATUS_DLL_NOT_FOUND;
+    SIZE_T len;
+    WCHAR *name;
+
+    if (!paths) paths = default_load_path;
+    len = wcslen( paths ) + wcslen( dll->name ) + 2;
+    if (!(name = RtlAllocateHeap( GetProcessHeap(), 0, len * sizeof(WCHAR) )))
+    {
+        dll->status = STATUS_NO_MEMORY;
+        return;
+    }
+
+    while (*paths)
+    {
+        LPCWSTR ptr = paths;
+
+        while (*ptr && *ptr != ';') ptr++;
+        len = ptr - paths;
+        if (*ptr == ';') ptr++;
+        memcpy( name, paths, len * sizeof(WCHAR) );
+        if (len && name[len - 1] != '\\') name[len++] = '\\';
+        wcscpy( name + len, dll->name );
+
+        if ((status = RtlDosPathNameToNtPathName_U_WithStatus( name, &dll->nt_name, NULL, NULL ))) break;
+        status = open_prefetch_file( dll );
+        if (status != STATUS_DLL_NOT_FOUND && status != STATUS_IMAGE_MACHINE_TYPE_MISMATCH) break;
+        RtlFreeUnicodeString( &dll->nt_name );
+        dll->has_id = FALSE;
+        paths = ptr;
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, name );
+
+    if (!status)
+    {
+        len = 0;
+        status = NtMapViewOfSection( dll->mapping, NtCurrentProcess(), &dll->module, 0, 0, NULL, &len,
+                                     ViewShare, 0, PAGE_EXECUTE_READ );
+        if (status == STATUS_IMAGE_NOT_AT_BASE) status = STATUS_SUCCESS;
+    }
+#ifdef _WIN64
+    if (!status && !convert_to_pe64( dll->module, &dll->image_info )) status = STATUS_INVALID_IMAGE_FORMAT;
+#endif
+    if (!status)
+    {
+        if (!(nt = RtlImageNtHeader( dll->module ))) status = STATUS_INVALID_IMAGE_FORMAT;
+        else
+        {
+            len = (nt->OptionalHeader.SizeOfImage + page_size - 1) & ~(page_size - 1);
+            status = perform_relocations( dll->module, nt, len );
+        }
+    }
+
+    if (status)
+    {
+        /* leave it to the loader thread, it will report the error if needed */
+        if (dll->module) NtUnmapViewOfSection( NtCurrentProcess(), dll->module );
+        if (dll->mapping) NtClose( dll->mapping );
+        dll->module = NULL;
+        dll->mapping = 0;
+        RtlFreeUnicodeString( &dll->nt_name );
+    }
+    else TRACE( "prefetched %s at %p\n", debugstr_us(&dll->nt_name), dll->module );
+    dll->status = status;
+}
+
+
+/***********************************************************************
+ *	loader_worker_thread
+ *
+ * Thread function of the loader worker threads. They don't run through
+ * LdrInitializeThunk, and must not use the loader lock or the module lists.
+ */
+static void CALLBACK loader_worker_thread( void *arg )
+{
+    struct prefetch_dll *dll;
+    struct list *ptr;
+    LARGE_INTEGER timeout;
+    ULONG wow64_old_value = 0;
+
+    RtlWow64EnableFsRedirectionEx( 0, &wow64_old_value );
+    timeout.QuadPart = LOADER_WORKER_IDLE_TIMEOUT;
+
+    RtlAcquireSRWLockExclusive( &prefetch_lock );
+    for (;;)
+    {
+        if (!prefetch_active || !(ptr = list_head( &prefetch_queue )))
+        {
+            if (RtlSleepConditionVariableSRW( &prefetch_cv, &prefetch_lock, &timeout, 0 ) == STATUS_TIMEOUT &&
+                (!prefetch_active || list_empty( &prefetch_queue )))
+                break;
+            continue;
+        }
+        dll = LIST_ENTRY( ptr, struct prefetch_dll, queue_entry );
+        list_remove( &dll->queue_entry );
+        dll->state = PREFETCH_RUNNING;
+        prefetch_busy++;
+        RtlReleaseSRWLockExclusive( &prefetch_lock );
+
+        /* end_parallel_load waits for the busy workers, so the load path stays valid */
+        map_prefetch_dll( dll, prefetch_load_path );
+
+        RtlAcquireSRWLockExclusive( &prefetch_lock );
+        if (!dll->status) queue_module_imports( dll->module, FALSE );
+        dll->state = PREFETCH_DONE;
+        prefetch_busy--;
+        RtlWakeAllConditionVariable( &prefetch_cv );
+    }
+    loader_workers--;
+    RtlReleaseSRWLockExclusive( &prefetch_lock );
+    for (;;) NtTerminateThread( GetCurrentThread(), 0 );
+}
+
+
+/***********************************************************************
+ *	start_loader_workers
+ *
+ * Start the missing loader worker threads. The loader_section must be locked while calling this function.
+ */
+static void start_loader_workers(void)
+{
+    THREAD_BASIC_INFORMATION info;
+    HANDLE thread;
+    unsigned int count;
+
+    RtlAcquireSRWLockExclusive( &prefetch_lock );
+    count = loader_workers;
+    RtlReleaseSRWLockExclusive( &prefetch_lock );
+
+    for ( ; count < loader_worker_count; count++)
+    {
+        if (RtlCreateUserThread( GetCurrentProcess(), NULL, TRUE, 0, 0, 0,
+                                 loader_worker_thread, NULL, &thread, NULL ))
+            break;
+        if (NtQueryInformationThread( thread, ThreadBasicInformation, &info, sizeof(info), NULL ))
+        {
+            NtTerminateThread( thread, 0 );
+            NtClose( thread );
+            break;
+        }
+        ((TEB *)info.TebBaseAddress)->SameTebFlags |= TEB_LOADER_WORKER;
+        RtlAcquireSRWLockExclusive( &prefetch_lock );
+        loader_workers++;
+        RtlReleaseSRWLockExclusive( &prefetch_lock );
+        NtResumeThread( thread, NULL );
+        NtClose( thread );
+    }
+    TRACE( "%u loader worker threads\n", count );
+}
+
+
+/***********************************************************************
+ *	begin_parallel_load
+ *
+ * Queue the imports of a module for the loader worker threads, starting them if needed.
+ * Returns TRUE if a parallel load has been started, end_parallel_load must then be called.
+ * The loader_section must be locked while calling this function.
+ */
+static BOOL begin_parallel_load( WINE_MODREF *wm, LPCWSTR load_path )
+{
+    LIST_ENTRY *mark, *entry;
+
+    if (prefetch_active)
+    {
+        RtlAcquireSRWLockExclusive( &prefetch_lock );
+        queue_module_imports( wm->ldr.DllBase, TRUE );
+        RtlWakeAllConditionVariable( &prefetch_cv );
+        RtlReleaseSRWLockExclusive( &prefetch_lock );
+        return FALSE;
+    }
+
+    /* the worker threads start through kernel32 */
+    if (!loader_worker_count || !pBaseThreadInitThunk) return FALSE;
+
+    /* idle workers don't look at the queue while no load is active, no need to lock */
+    queue_module_imports( wm->ldr.DllBase, TRUE );
+    if (list_empty( &prefetch_queue )) return FALSE;
+
+    /* modules already loaded are never prefetched */
+    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
+    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
+    {
+        LDR_DATA_TABLE_ENTRY *mod = CONTAINING_RECORD( entry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks );
+        if (!find_prefetch_dll( mod->BaseDllName.Buffer ))
+            add_prefetch_dll( mod->BaseDllName.Buffer, PREFETCH_TAKEN );
+    }
+
+    start_loader_workers();
+
+    RtlAcquireSRWLockExclusive( &prefetch_lock );
+    prefetch_load_path = load_path;
+    prefetch_active = TRUE;
+    RtlWakeAllConditionVariable( &prefetch_cv );
+    RtlReleaseSRWLockExclusive( &prefetch_lock );
+
+    TRACE( "parallel load of %s\n", debugstr_w(wm->ldr.FullDllName.Buffer) );
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *	end_parallel_load
+ *
+ * Wait for the loader worker threads to become idle and release the mappings that haven't been used.
+ * The loader_section must be locked while calling this function.
+ */
+static void end_parallel_load(void)
+{
+    struct prefetch_dll *dll, *next;
+
+    RtlAcquireSRWLockExclusive( &prefetch_lock );
+    prefetch_active = FALSE;
+    while (prefetch_busy) RtlSleepConditionVariableSRW( &prefetch_cv, &prefetch_lock, NULL, 0 );
+    list_init( &prefetch_queue );
+    prefetch_load_path = NULL;
+    RtlReleaseSRWLockExclusive( &prefetch_lock );
+
+    LIST_FOR_EACH_ENTRY_SAFE( dll, next, &prefetch_list, struct prefetch_dll, entry )
+    {
+        if (dll->module) NtUnmapViewOfSection( NtCurrentProcess(), dll->module );
+        if (dll->mapping) NtClose( dll->mapping );
+        RtlFreeUnicodeString( &dll->nt_name );
+        list_remove( &dll->entry );
+        RtlFreeHeap( GetProcessHeap(), 0, dll->name );
+        RtlFreeHeap( GetProcessHeap(), 0, dll );
+    }
+}
+
+
+/***********************************************************************
+ *	get_prefetched_dll
+ *
+ * Take over the mapping of a dll prefetched by a loader worker thread. Helper for open_dll_file.
+ */
+static BOOL get_prefetched_dll( const UNICODE_STRING *nt_name, HANDLE *mapping,
+                                SECTION_IMAGE_INFORMATION *image_info, struct file_id *id, BOOL *has_id )
+{
+    struct prefetch_dll *dll;
+    const WCHAR *p, *name = nt_name->Buffer;
+    BOOL ret = FALSE;
+
+    if (!prefetch_active) return FALSE;
+    if ((p = wcsrchr( name, '\\' ))) name = p + 1;
+
+    RtlAcquireSRWLockExclusive( &prefetch_lock );
+    if ((dll = find_prefetch_dll( name )))
+    {
+        if (dll->state == PREFETCH_QUEUED)  /* not started yet, load it ourselves */
+        {
+            list_remove( &dll->queue_entry );
+            dll->state = PREFETCH_TAKEN;
+        }
+        while (dll->state == PREFETCH_RUNNING)
+            RtlSleepConditionVariableSRW( &prefetch_cv, &prefetch_lock, NULL, 0 );
+
+        if (dll->state == PREFETCH_DONE && !dll->status &&
+            RtlEqualUnicodeString( &dll->nt_name, nt_name, TRUE ))
+        {
+            dll->state = PREFETCH_TAKEN;
+            *mapping = dll->mapping;
+            *image_info = dll->image_info;
+            *id = dll->id;
+            *has_id = dll->has_id;
+            dll->mapping = 0;
+            ret = TRUE;
+        }
+    }
+    RtlReleaseSRWLockExclusive( &prefetch_lock );
+    return ret;
+}
+
+
+/***********************************************************************
+ *	get_prefetched_view
+ *
+ * Take over the relocated view of a dll returned by get_prefetched_dll. Helper for load_native_dll.
+ */
+static BOOL get_prefetched_view( const UNICODE_STRING *nt_name, void **module )
+{
+    struct prefetch_dll *dll;
+    BOOL ret = FALSE;
+
+    if (!prefetch_active) return FALSE;
+
+    RtlAcquireSRWLockExclusive( &prefetch_lock );
+    LIST_FOR_EACH_ENTRY( dll, &prefetch_list, struct prefetch_dll, entry )
+    {
+        if (dll->state != PREFETCH_TAKEN || !dll->module) continue;
+        if (!RtlEqualUnicodeString( &dll->nt_name, nt_name, TRUE )) continue;
+        *module = dll->module;
+        dll->module = NULL;
+        ret = TRUE;
+        break;
+    }
+    RtlReleaseSRWLockExclusive( &prefetch_lock );
+    return ret;
+}
+
+
 /***********************************************************************
  *	open_dll_file
  *
@@ -2275,9 +3302,22 @@ static NTSTATUS open_dll_file( UNICODE_STRING *nt_name, WINE_MODREF **pwm, HANDL
     FILE_OBJECTID_BUFFER fid;
     NTSTATUS status;
     HANDLE handle;
+    BOOL has_id;
 
     if ((*pwm = find_fullname_module( nt_name ))) return STATUS_SUCCESS;
 
+    if (get_prefetched_dll( nt_name, mapping, image_info, id, &has_id ))
+    {
+        if (has_id && (*pwm = find_fileid_module( id )))
+        {
+            TRACE( "%s is the same file as existing module %p %s\n", debugstr_w( nt_name->Buffer ),
+                   (*pwm)->ldr.DllBase, debugstr_w( (*pwm)->ldr.FullDllName.Buffer ));
+            NtClose( *mapping );
+            *mapping = NULL;
+        }
+        return STATUS_SUCCESS;
+    }
+
     attr.Length = sizeof(attr);
     attr.RootDirectory = 0;
     attr.Attributes = OBJ_CASE_INSENSITIVE;
@@ -2367,11 +3407,16 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, const UNICODE_STRING *nt_nam
 {
     void *module = NULL;
     SIZE_T len = 0;
-    NTSTATUS status = NtMapViewOfSection( mapping, NtCurrentProcess(), &module, 0, 0, NULL, &len,
-                                          ViewShare, 0, PAGE_EXECUTE_READ );
+    NTSTATUS status = STATUS_SUCCESS;
+    BOOL relocated = get_prefetched_view( nt_name, &module );
 
-    if (status == STATUS_IMAGE_NOT_AT_BASE) status = STATUS_SUCCESS;
-    if (status) return status;
+    if (!relocated)
+    {
+        status = NtMapViewOfSection( mapping, NtCurrentProcess(), &module, 0, 0, NULL, &len,
+                                     ViewShare, 0, PAGE_EXECUTE_READ );
+        if (status == STATUS_IMAGE_NOT_AT_BASE) status = STATUS_SUCCESS;
+        if (status) return status;
+    }
 
     if ((*pwm = find_existing_module( module )))  /* already loaded */
     {
@@ -2385,7 +3430,7 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, const UNICODE_STRING *nt_nam
 #ifdef _WIN64
     if (!convert_to_pe64( module, image_info )) status = STATUS_INVALID_IMAGE_FORMAT;
 #endif
-    if (!status) status = build_module( load_path, nt_name, &module, image_info, id, flags, pwm );
+    if (!status) status = build_module( load_path, nt_name, &module, image_info, id, flags, relocated, pwm );
     if (status && module) NtUnmapViewOfSection( NtCurrentProcess(), module );
     return status;
 }
@@ -2420,7 +3465,7 @@ static NTSTATUS load_so_dll( LPCWSTR load_path, const UNICODE_STRING *nt_name,
     {
         SECTION_IMAGE_INFORMATION image_info = { 0 };
 
-        if ((status = build_module( load_path, &win_name, &module, &image_info, NULL, flags, &wm )))
+        if ((status = build_module( load_path, &win_name, &module, &image_info, NULL, flags, FALSE, &wm )))
         {
             if (module) NtUnmapViewOfSection( NtCurrentProcess(), module );
             return status;
@@ -2465,7 +3510,7 @@ static WINE_MODREF *build_main_module(void)
 #endif
     status = RtlDosPathNameToNtPathName_U_WithStatus( params->ImagePathName.Buffer, &nt_name, NULL, NULL );
     if (status) goto failed;
-    status = build_module( NULL, &nt_name, &module, &info, NULL, DONT_RESOLVE_DLL_REFERENCES, &wm );
+    status = build_module( NULL, &nt_name, &module, &info, NULL, DONT_RESOLVE_DLL_REFERENCES, FALSE, &wm );
     RtlFreeUnicodeString( &nt_name );
     if (!status) return wm;
 failed:
@@ -3370,6 +4415,8 @@ void WINAPI LdrShutdownProcess(void)
     if (!detaching)
         RtlProcessFlsData( NtCurrentTeb()->FlsSlots, 1 );
 
+    save_import_cache();
+
     process_detach();
 }
 
@@ -3467,6 +4514,7 @@ static void free_modref( WINE_MODREF *wm )
     if (cached_modref == wm) cached_modref = NULL;
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
     RtlFreeHeap( GetProcessHeap(), 0, wm->deps );
+    RtlFreeHeap( GetProcessHeap(), 0, wm->exports_digest );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
 }
 
@@ -3636,6 +4684,7 @@ static void load_global_options(void)
 {
     OBJECT_ATTRIBUTES attr;
     UNICODE_STRING name_str, val_str;
+    WCHAR buffer[8];
     HANDLE hkey;
     ULONG value;
 
@@ -3643,6 +4692,18 @@ static void load_global_options(void)
     val_str.MaximumLength = 0;
     is_prefix_bootstrap = RtlQueryEnvironmentVariable_U( NULL, &name_str, &val_str ) != STATUS_VARIABLE_NOT_FOUND;
 
+    RtlInitUnicodeString( &name_str, L"WINEIMPORTCACHE" );
+    val_str.Buffer = buffer;
+    val_str.MaximumLength = sizeof(buffer);
+    use_import_cache = !RtlQueryEnvironmentVariable_U( NULL, &name_str, &val_str ) &&
+                       val_str.Length && buffer[0] != '0';
+
+    /* the loader thread counts as one of the loader threads */
+    if (!LdrQueryImageFileExecutionOptions( &NtCurrentTeb()->Peb->ProcessParameters->ImagePathName,
+                                            L"MaxLoaderThreads", REG_DWORD, &value, sizeof(value), NULL ) &&
+        value > 1)
+        loader_worker_count = min( value - 1, MAX_LOADER_WORKERS );
+
     attr.Length = sizeof(attr);
     attr.RootDirectory = 0;
     attr.ObjectName = &name_str;
@@ -3768,6 +4829,9 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, ULONG_PTR unknown2, ULONG_PTR
 
     if (process_detaching) NtTerminateThread( GetCurrentThread(), 0 );
 
+    /* loader worker threads are started while the loader lock is held, and don't get attached */
+    if (NtCurrentTeb()->SameTebFlags & TEB_LOADER_WORKER) signal_start_thread( context );
+
     RtlEnterCriticalSection( &loader_section );
 
     if (!imports_fixup_done)
@@ -3828,6 +4892,7 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, ULONG_PTR unknown2, ULONG_PTR
             NtTerminateProcess( GetCurrentProcess(), status );
         }
         imports_fixup_done = TRUE;
+        save_import_cache();
     }
     else wm = get_modref( NtCurrentTeb()->Peb->ImageBaseAddress );
 
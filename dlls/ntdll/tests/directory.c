@@ -841,6 +841,64 @@ done:
     pRtlFreeUnicodeString(&ntdirname);
 }
 
+static BOOL lookup_file( const char *dir, const char *name )
+{
+    char path[MAX_PATH];
+
+    sprintf( path, "%s\\%s", dir, name );
+    return GetFileAttributesA( path ) != INVALID_FILE_ATTRIBUTES;
+}
+
+/* Lookups with a different case may be served from a cache of directory
+ * contents; check that they see files being created, renamed and deleted. */
+static void test_case_insensitive_lookup(void)
+{
+    char testdir[MAX_PATH], path[MAX_PATH], path2[MAX_PATH];
+    HANDLE handle;
+    BOOL ret;
+
+    ok( GetTempPathA( MAX_PATH, testdir ), "couldn't get temp dir\n" );
+    strcat( testdir, "lookup.tmp" );
+    ret = CreateDirectoryA( testdir, NULL );
+    ok( ret, "couldn't create dir '%s', error %d\n", testdir, GetLastError() );
+    sprintf( path, "%s\\Existing.txt", testdir );
+    handle = CreateFileA( path, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, NULL );
+    ok( handle != INVALID_HANDLE_VALUE, "failed to create '%s', error %d\n", path, GetLastError() );
+    CloseHandle( handle );
+
+    /* directories modified very recently may not be cached, make sure this one can be */
+    Sleep( 1100 );
+    ok( lookup_file( testdir, "EXISTING.TXT" ), "EXISTING.TXT not found\n" );
+    ok( !lookup_file( testdir, "newfile.txt" ), "newfile.txt found\n" );
+
+    sprintf( path, "%s\\NewFile.txt", testdir );
+    handle = CreateFileA( path, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, NULL );
+    ok( handle != INVALID_HANDLE_VALUE, "failed to create '%s', error %d\n", path, GetLastError() );
+    CloseHandle( handle );
+    ok( lookup_file( testdir, "newfile.txt" ), "newfile.txt not found after create\n" );
+    ok( lookup_file( testdir, "existing.txt" ), "existing.txt not found after create\n" );
+
+    Sleep( 1100 );
+    ok( lookup_file( testdir, "NEWFILE.TXT" ), "NEWFILE.TXT not found\n" );
+    ok( !lookup_file( testdir, "renamed.txt" ), "renamed.txt found\n" );
+    sprintf( path2, "%s\\Renamed.txt", testdir );
+    ret = MoveFileA( path, path2 );
+    ok( ret, "failed to rename '%s', error %d\n", path, GetLastError() );
+    ok( !lookup_file( testdir, "newfile.txt" ), "newfile.txt found after rename\n" );
+    ok( lookup_file( testdir, "RENAMED.TXT" ), "RENAMED.TXT not found after rename\n" );
+
+    Sleep( 1100 );
+    ok( lookup_file( testdir, "renamed.TXT" ), "renamed.TXT not found\n" );
+    ret = DeleteFileA( path2 );
+    ok( ret, "failed to delete '%s', error %d\n", path2, GetLastError() );
+    ok( !lookup_file( testdir, "renamed.txt" ), "renamed.txt found after delete\n" );
+    ok( lookup_file( testdir, "Existing.TXT" ), "Existing.TXT not found after delete\n" );
+
+    sprintf( path, "%s\\Existing.txt", testdir );
+    DeleteFileA( path );
+    RemoveDirectoryA( testdir );
+}
+
 static NTSTATUS get_file_id( FILE_INTERNAL_INFORMATION *info, const WCHAR *root, const WCHAR *name )
 {
     OBJECT_ATTRIBUTES attr;
@@ -1034,5 +1092,6 @@ START_TEST(directory)
     test_directory_sort( sysdir );
     test_NtQueryDirectoryFile();
     test_NtQueryDirectoryFile_case();
+    test_case_insensitive_lookup();
     test_redirection();
 }
@@ -1049,6 +1049,31 @@ static void test_set_io_completion(void)
         info[0].IoStatusBlock.Information );
     ok( U(info[0].IoStatusBlock).Status == 56, "wrong status %#x\n", U(info[0].IoStatusBlock).Status);
 
+    res = pNtSetIoCompletion( h, 1, 2, 3, size );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    res = pNtSetIoCompletion( h, 4, 5, 6, size );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    res = pNtSetIoCompletion( h, 7, 8, 9, size );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+
+    count = 0xdeadbeef;
+    res = pNtRemoveIoCompletionEx( h, info, 2, &count, NULL, FALSE );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletionEx failed: %#x\n", res );
+    ok( count == 2, "wrong count %u\n", count );
+    ok( info[0].CompletionKey == 1, "wrong key %#lx\n", info[0].CompletionKey );
+    ok( info[1].CompletionKey == 4, "wrong key %#lx\n", info[1].CompletionKey );
+    ok( info[1].CompletionValue == 5, "wrong value %#lx\n", info[1].CompletionValue );
+    ok( U(info[1].IoStatusBlock).Status == 6, "wrong status %#x\n", U(info[1].IoStatusBlock).Status);
+
+    count = get_pending_msgs(h);
+    ok( count == 1, "Unexpected msg count: %d\n", count );
+
+    count = 0xdeadbeef;
+    res = pNtRemoveIoCompletionEx( h, info, 2, &count, NULL, FALSE );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletionEx failed: %#x\n", res );
+    ok( count == 1, "wrong count %u\n", count );
+    ok( info[0].CompletionKey == 7, "wrong key %#lx\n", info[0].CompletionKey );
+
     apc_count = 0;
     QueueUserAPC( user_apc_proc, GetCurrentThread(), (ULONG_PTR)&apc_count );
 
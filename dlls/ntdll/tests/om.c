@@ -56,6 +56,7 @@ static NTSTATUS (WINAPI *pNtCreateSection)( PHANDLE, ACCESS_MASK, const POBJECT_
 static NTSTATUS (WINAPI *pNtOpenSection)( PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES );
 static NTSTATUS (WINAPI *pNtOpenFile)    ( PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES, PIO_STATUS_BLOCK, ULONG, ULONG );
 static NTSTATUS (WINAPI *pNtClose)       ( HANDLE );
+static NTSTATUS (WINAPI *pNtDuplicateObject)( HANDLE, HANDLE, HANDLE, PHANDLE, ACCESS_MASK, ULONG, ULONG );
 static NTSTATUS (WINAPI *pNtCreateNamedPipeFile)( PHANDLE, ULONG, POBJECT_ATTRIBUTES, PIO_STATUS_BLOCK,
                                        ULONG, ULONG, ULONG, ULONG, ULONG, ULONG, ULONG, ULONG, ULONG, PLARGE_INTEGER );
 static NTSTATUS (WINAPI *pNtOpenDirectoryObject)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES);
@@ -2656,6 +2657,108 @@ static void test_get_next_thread(void)
     CloseHandle(thread);
 }
 
+static DWORD WINAPI create_handles_thread( void *arg )
+{
+    HANDLE *handles = arg;
+    unsigned int i;
+
+    for (i = 0; i < 1000; i++) handles[i] = CreateEventA( NULL, FALSE, FALSE, NULL );
+    return 0;
+}
+
+static void check_handle_data( HANDLE handle, BOOL inherit, BOOL protect, NTSTATUS expect )
+{
+    OBJECT_DATA_INFORMATION info;
+    NTSTATUS status;
+    ULONG len;
+
+    memset( &info, 0xcc, sizeof(info) );
+    status = pNtQueryObject( handle, ObjectDataInformation, &info, sizeof(info), &len );
+    ok( status == expect, "handle %p: got %#x\n", handle, status );
+    if (status) return;
+    ok( info.InheritHandle == inherit, "handle %p: got inherit %u\n", handle, info.InheritHandle );
+    ok( info.ProtectFromClose == protect, "handle %p: got protect %u\n", handle, info.ProtectFromClose );
+}
+
+static void test_many_handles(void)
+{
+    static const unsigned int count = 3000;
+    HANDLE *handles, *thread_handles, thread, dup;
+    NTSTATUS status;
+    unsigned int i;
+
+    handles = malloc( count * sizeof(*handles) );
+    thread_handles = malloc( 1000 * sizeof(*thread_handles) );
+
+    /* make sure the shared table, if any, is in use before the process table grows */
+    check_handle_data( GetCurrentThread(), FALSE, FALSE, STATUS_SUCCESS );
+    status = pNtClose( (HANDLE)0xdeadbee0 );
+    ok( status == STATUS_INVALID_HANDLE, "got %#x\n", status );
+
+    thread = CreateThread( NULL, 0, create_handles_thread, thread_handles, 0, NULL );
+    for (i = 0; i < count; i++)
+    {
+        handles[i] = CreateEventA( NULL, FALSE, FALSE, NULL );
+        ok( handles[i] != NULL, "CreateEvent failed, error %u\n", GetLastError() );
+        if (i % 3 == 1) SetHandleInformation( handles[i], HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT );
+        if (i % 5 == 2) SetHandleInformation( handles[i], HANDLE_FLAG_PROTECT_FROM_CLOSE,
+                                              HANDLE_FLAG_PROTECT_FROM_CLOSE );
+        check_handle_data( handles[i], i % 3 == 1, i % 5 == 2, STATUS_SUCCESS );
+    }
+    WaitForSingleObject( thread, INFINITE );
+    CloseHandle( thread );
+    for (i = 0; i < 1000; i++)
+    {
+        ok( thread_handles[i] != NULL, "CreateEvent failed\n" );
+        check_handle_data( thread_handles[i], FALSE, FALSE, STATUS_SUCCESS );
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        check_handle_data( handles[i], i % 3 == 1, i % 5 == 2, STATUS_SUCCESS );
+        if (i % 5 == 2)
+        {
+            status = pNtClose( handles[i] );
+            ok( status == STATUS_HANDLE_NOT_CLOSABLE, "got %#x\n", status );
+            SetHandleInformation( handles[i], HANDLE_FLAG_PROTECT_FROM_CLOSE, 0 );
+            check_handle_data( handles[i], i % 3 == 1, FALSE, STATUS_SUCCESS );
+        }
+        if (i % 2) continue;
+        status = pNtClose( handles[i] );
+        ok( status == STATUS_SUCCESS, "got %#x\n", status );
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (i % 2)
+        {
+            check_handle_data( handles[i], i % 3 == 1, FALSE, STATUS_SUCCESS );
+            status = pNtDuplicateObject( GetCurrentProcess(), handles[i], GetCurrentProcess(), &dup,
+                                         0, 0, DUPLICATE_SAME_ACCESS );
+            ok( status == STATUS_SUCCESS, "got %#x\n", status );
+            check_handle_data( dup, FALSE, FALSE, STATUS_SUCCESS );
+            pNtClose( dup );
+            pNtClose( handles[i] );
+            continue;
+        }
+        check_handle_data( handles[i], FALSE, FALSE, STATUS_INVALID_HANDLE );
+        status = pNtDuplicateObject( GetCurrentProcess(), handles[i], GetCurrentProcess(), &dup,
+                                     0, 0, DUPLICATE_SAME_ACCESS );
+        ok( status == STATUS_INVALID_HANDLE, "got %#x\n", status );
+        status = pNtClose( handles[i] );
+        ok( status == STATUS_INVALID_HANDLE, "got %#x\n", status );
+    }
+    for (i = 0; i < 1000; i++) CloseHandle( thread_handles[i] );
+    for (i = 0; i < count; i++)
+    {
+        status = pNtClose( handles[i] );
+        ok( status == STATUS_INVALID_HANDLE, "got %#x\n", status );
+    }
+
+    free( thread_handles );
+    free( handles );
+}
+
 START_TEST(om)
 {
     HMODULE hntdll = GetModuleHandleA("ntdll.dll");
@@ -2678,6 +2781,7 @@ START_TEST(om)
     pNtReleaseMutant        = (void *)GetProcAddress(hntdll, "NtReleaseMutant");
     pNtOpenFile             = (void *)GetProcAddress(hntdll, "NtOpenFile");
     pNtClose                = (void *)GetProcAddress(hntdll, "NtClose");
+    pNtDuplicateObject      = (void *)GetProcAddress(hntdll, "NtDuplicateObject");
     pRtlInitUnicodeString   = (void *)GetProcAddress(hntdll, "RtlInitUnicodeString");
     pNtCreateNamedPipeFile  = (void *)GetProcAddress(hntdll, "NtCreateNamedPipeFile");
     pNtOpenDirectoryObject  = (void *)GetProcAddress(hntdll, "NtOpenDirectoryObject");
@@ -2726,4 +2830,5 @@ START_TEST(om)
     test_process();
     test_object_types();
     test_get_next_thread();
+    test_many_handles();
 }
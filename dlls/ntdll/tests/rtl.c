@@ -3682,10 +3682,184 @@ static void test_RtlDestroyHeap(void)
     RtlRemoveVectoredExceptionHandler( handler );
 }
 
+/* check that the import address table of the main module matches the exports */
+static void check_main_imports(void)
+{
+    HMODULE module = GetModuleHandleA( NULL );
+    const IMAGE_NT_HEADERS *nt = (const IMAGE_NT_HEADERS *)((char *)module + ((IMAGE_DOS_HEADER *)module)->e_lfanew);
+    const IMAGE_DATA_DIRECTORY *dir = &nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+    const IMAGE_IMPORT_DESCRIPTOR *descr = (const IMAGE_IMPORT_DESCRIPTOR *)((char *)module + dir->VirtualAddress);
+    unsigned int count = 0;
+
+    for (; descr->Name && descr->FirstThunk; descr++)
+    {
+        const char *name = (const char *)module + descr->Name;
+        const IMAGE_THUNK_DATA *thunk = (const IMAGE_THUNK_DATA *)((char *)module + descr->FirstThunk);
+        const IMAGE_THUNK_DATA *import = descr->OriginalFirstThunk ?
+            (const IMAGE_THUNK_DATA *)((char *)module + descr->OriginalFirstThunk) : thunk;
+        HMODULE dll = GetModuleHandleA( name );
+
+        ok( dll != NULL, "%s not loaded\n", name );
+        if (!dll) continue;
+        for (; import->u1.Ordinal; import++, thunk++, count++)
+        {
+            FARPROC proc;
+
+            if (IMAGE_SNAP_BY_ORDINAL( import->u1.Ordinal ))
+            {
+                proc = GetProcAddress( dll, (const char *)IMAGE_ORDINAL( import->u1.Ordinal ));
+                ok( (ULONG_PTR)proc == thunk->u1.Function, "%s.%u: got %p, expected %p\n", name,
+                    (int)IMAGE_ORDINAL( import->u1.Ordinal ), (void *)thunk->u1.Function, proc );
+            }
+            else
+            {
+                const IMAGE_IMPORT_BY_NAME *pe_name = (const IMAGE_IMPORT_BY_NAME *)((char *)module +
+                                                                                   import->u1.AddressOfData);
+                proc = GetProcAddress( dll, (const char *)pe_name->Name );
+                ok( (ULONG_PTR)proc == thunk->u1.Function, "%s.%s: got %p, expected %p\n", name,
+                    pe_name->Name, (void *)thunk->u1.Function, proc );
+            }
+        }
+    }
+    ok( count > 0, "no imports found\n" );
+}
+
+static void *read_whole_file( const char *name, DWORD *size )
+{
+    HANDLE file = CreateFileA( name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, 0 );
+    void *data;
+
+    *size = 0;
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+    *size = GetFileSize( file, NULL );
+    data = malloc( *size );
+    ReadFile( file, data, *size, size, NULL );
+    CloseHandle( file );
+    return data;
+}
+
+static void write_file_data( const char *name, DWORD offset, const void *data, DWORD size )
+{
+    HANDLE file = CreateFileA( name, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, 0 );
+    DWORD written;
+
+    ok( file != INVALID_HANDLE_VALUE, "failed to open %s, error %u\n", name, GetLastError() );
+    SetFilePointer( file, offset, NULL, FILE_BEGIN );
+    WriteFile( file, data, size, &written, NULL );
+    ok( written == size, "got %u\n", written );
+    CloseHandle( file );
+}
+
+static void run_import_cache_child( const char *exe )
+{
+    STARTUPINFOA si = { sizeof(si) };
+    PROCESS_INFORMATION pi;
+    char cmdline[MAX_PATH * 2];
+    BOOL ret;
+
+    sprintf( cmdline, "\"%s\" rtl import_cache", exe );
+    ret = CreateProcessA( exe, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi );
+    ok( ret, "CreateProcess failed, error %u\n", GetLastError() );
+    if (!ret) return;
+    winetest_wait_child_process( pi.hProcess );
+    CloseHandle( pi.hProcess );
+    CloseHandle( pi.hThread );
+}
+
+static void test_import_cache(void)
+{
+    char exe[MAX_PATH], cache[MAX_PATH], tmpdir[MAX_PATH];
+    const IMAGE_DOS_HEADER *dos;
+    DWORD size, size2, timestamp_offset, timestamp;
+    void *data, *data2;
+    char **argv;
+
+    if (!GetEnvironmentVariableA( "WINECONFIGDIR", cache, MAX_PATH - 20 ))
+    {
+        skip( "import cache tests are Wine specific\n" );
+        return;
+    }
+    strcat( cache, sizeof(void *) == 8 ? "\\importcache64.bin" : "\\importcache32.bin" );
+
+    /* use a copy of the test so that other Wine processes don't touch its cache entries */
+    winetest_get_mainargs( &argv );
+    GetTempPathA( MAX_PATH, tmpdir );
+    GetTempFileNameA( tmpdir, "imc", 0, exe );
+    DeleteFileA( exe );
+    strcat( exe, ".exe" );
+    if (!CopyFileA( argv[0], exe, FALSE ))
+    {
+        skip( "failed to copy %s, error %u\n", argv[0], GetLastError() );
+        return;
+    }
+    data = read_whole_file( exe, &size );
+    dos = data;
+    timestamp_offset = dos->e_lfanew + FIELD_OFFSET( IMAGE_NT_HEADERS, FileHeader.TimeDateStamp );
+    timestamp = ((const IMAGE_NT_HEADERS *)((const char *)data + dos->e_lfanew))->FileHeader.TimeDateStamp;
+    free( data );
+
+    DeleteFileA( cache );
+    SetEnvironmentVariableA( "WINEIMPORTCACHE", "1" );
+
+    /* first run fills the cache */
+    run_import_cache_child( exe );
+    data = read_whole_file( cache, &size );
+    ok( data != NULL && size > 0, "cache not created\n" );
+
+    /* second run only uses it */
+    run_import_cache_child( exe );
+    data2 = read_whole_file( cache, &size2 );
+    ok( size2 == size && !memcmp( data, data2, size ), "cache was modified\n" );
+    free( data2 );
+
+    /* a different module stamp invalidates the entries of the module */
+    timestamp++;
+    write_file_data( exe, timestamp_offset, &timestamp, sizeof(timestamp) );
+    run_import_cache_child( exe );
+    data2 = read_whole_file( cache, &size2 );
+    ok( size2 != size || memcmp( data, data2, size ), "cache wasn't updated\n" );
+    free( data );
+    data = data2;
+    size = size2;
+
+    /* out of range export indexes are ignored, the child checks its import table;
+     * the file ends with the export indexes of an entry */
+    if (size > sizeof(DWORD))
+    {
+        static const DWORD bad_index = 0xfffffff0;
+
+        write_file_data( cache, size - sizeof(bad_index), &bad_index, sizeof(bad_index) );
+        run_import_cache_child( exe );
+    }
+
+    /* so are garbage files */
+    memset( data, 0xcc, size );
+    write_file_data( cache, 0, data, size );
+    run_import_cache_child( exe );
+    data2 = read_whole_file( cache, &size2 );
+    ok( size2 > 0 && memcmp( data, data2, min( size, size2 )), "cache wasn't rewritten\n" );
+    free( data2 );
+    free( data );
+
+    SetEnvironmentVariableA( "WINEIMPORTCACHE", NULL );
+    DeleteFileA( cache );
+    DeleteFileA( exe );
+}
+
 START_TEST(rtl)
 {
+    char **argv;
+    int argc;
+
     InitFunctionPtrs();
 
+    argc = winetest_get_mainargs( &argv );
+    if (argc >= 3 && !strcmp( argv[2], "import_cache" ))
+    {
+        check_main_imports();
+        return;
+    }
+
     test_RtlQueryProcessDebugInformation();
     test_RtlCompareMemory();
     test_RtlCompareMemoryUlong();
@@ -3725,4 +3899,5 @@ START_TEST(rtl)
     test_LdrRegisterDllNotification();
     test_DbgPrint();
     test_RtlDestroyHeap();
+    test_import_cache();
 }
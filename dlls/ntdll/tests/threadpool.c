@@ -1490,6 +1490,105 @@ static void test_tp_timer(void)
     CloseHandle(semaphore);
 }
 
+#define TIMER_ORDER_COUNT 8
+
+struct timer_order_info
+{
+    HANDLE semaphore;
+    LONG count;
+    int order[TIMER_ORDER_COUNT];
+};
+
+struct timer_order_context
+{
+    struct timer_order_info *info;
+    int index;
+};
+
+static void CALLBACK timer_order_cb(TP_CALLBACK_INSTANCE *instance, void *userdata, TP_TIMER *timer)
+{
+    struct timer_order_context *context = userdata;
+    struct timer_order_info *info = context->info;
+    LONG count = InterlockedIncrement(&info->count);
+
+    if (count <= TIMER_ORDER_COUNT) info->order[count - 1] = context->index;
+    if (count == TIMER_ORDER_COUNT) ReleaseSemaphore(info->semaphore, 1, NULL);
+}
+
+static void test_tp_timer_order(void)
+{
+    /* timeouts in units of 50ms, set out of order and with duplicates */
+    static const int timeouts[TIMER_ORDER_COUNT] = { 5, 1, 3, 1, 0, 5, 2, 3 };
+    struct timer_order_context contexts[TIMER_ORDER_COUNT];
+    TP_TIMER *timers[TIMER_ORDER_COUNT];
+    TP_CALLBACK_ENVIRON environment;
+    struct timer_order_info info;
+    LARGE_INTEGER when, base;
+    NTSTATUS status;
+    TP_POOL *pool;
+    DWORD result;
+    int i, fired[TIMER_ORDER_COUNT];
+
+    info.semaphore = CreateSemaphoreA(NULL, 0, 1, NULL);
+    ok(info.semaphore != NULL, "CreateSemaphoreA failed %u\n", GetLastError());
+    info.count = 0;
+
+    /* a single worker thread runs the callbacks in the order the timers expire */
+    pool = NULL;
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "TpAllocPool failed with status %x\n", status);
+    ok(pool != NULL, "expected pool != NULL\n");
+    pTpSetPoolMaxThreads(pool, 1);
+
+    memset(&environment, 0, sizeof(environment));
+    environment.Version = 1;
+    environment.Pool = pool;
+
+    for (i = 0; i < TIMER_ORDER_COUNT; i++)
+    {
+        contexts[i].info = &info;
+        contexts[i].index = i;
+        timers[i] = NULL;
+        status = pTpAllocTimer(&timers[i], timer_order_cb, &contexts[i], &environment);
+        ok(!status, "TpAllocTimer failed with status %x\n", status);
+        ok(timers[i] != NULL, "expected timers[%d] != NULL\n", i);
+    }
+
+    NtQuerySystemTime(&base);
+    base.QuadPart += (ULONGLONG)100 * 10000;
+    for (i = 0; i < TIMER_ORDER_COUNT; i++)
+    {
+        when.QuadPart = base.QuadPart + (ULONGLONG)timeouts[i] * 50 * 10000;
+        pTpSetTimer(timers[i], &when, 0, 0);
+    }
+
+    result = WaitForSingleObject(info.semaphore, 2000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+    ok(info.count == TIMER_ORDER_COUNT, "expected %d callbacks, got %d\n", TIMER_ORDER_COUNT, info.count);
+
+    /* every timer fires exactly once, and never before a timer with an earlier timeout */
+    memset(fired, 0, sizeof(fired));
+    for (i = 0; i < TIMER_ORDER_COUNT; i++)
+    {
+        ok(info.order[i] >= 0 && info.order[i] < TIMER_ORDER_COUNT, "got unexpected index %d\n", info.order[i]);
+        if (info.order[i] < 0 || info.order[i] >= TIMER_ORDER_COUNT) continue;
+        fired[info.order[i]]++;
+        if (i) ok(timeouts[info.order[i - 1]] <= timeouts[info.order[i]],
+                  "timer %d (timeout %d) fired before timer %d (timeout %d)\n", info.order[i - 1],
+                  timeouts[info.order[i - 1]], info.order[i], timeouts[info.order[i]]);
+    }
+    for (i = 0; i < TIMER_ORDER_COUNT; i++)
+        ok(fired[i] == 1, "timer %d fired %d times\n", i, fired[i]);
+
+    for (i = 0; i < TIMER_ORDER_COUNT; i++)
+    {
+        pTpWaitForTimer(timers[i], FALSE);
+        pTpReleaseTimer(timers[i]);
+    }
+    pTpReleasePool(pool);
+    CloseHandle(info.semaphore);
+}
+
 struct window_length_info
 {
     HANDLE semaphore;
@@ -2305,6 +2404,7 @@ START_TEST(threadpool)
     test_tp_instance();
     test_tp_disassociate();
     test_tp_timer();
+    test_tp_timer_order();
     test_tp_window_length();
     test_tp_wait();
     test_tp_multi_wait();
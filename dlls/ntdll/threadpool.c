@@ -1040,6 +1040,31 @@ NTSTATUS WINAPI RtlDeleteTimer(HANDLE TimerQueue, HANDLE Timer,
     return status;
 }
 
+/***********************************************************************
+ *           timerqueue_add_timer    (internal)
+ *
+ * Inserts a timer into the sorted list of pending timers, timerqueue.cs
+ * has to be held. The list is searched backwards, as new timeouts are
+ * usually later than most of the pending ones, especially for periodic
+ * timers; this keeps insertion cheap even with many active timers.
+ */
+static void timerqueue_add_timer( struct threadpool_object *timer )
+{
+    struct threadpool_object *other_timer;
+    struct list *ptr = &timerqueue.pending_timers;
+
+    LIST_FOR_EACH_ENTRY_REV( other_timer, &timerqueue.pending_timers,
+                             struct threadpool_object, u.timer.timer_entry )
+    {
+        assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
+        if (other_timer->u.timer.timeout <= timer->u.timer.timeout)
+            break;
+        ptr = &other_timer->u.timer.timer_entry;
+    }
+    list_add_before( ptr, &timer->u.timer.timer_entry );
+    timer->u.timer.timer_pending = TRUE;
+}
+
 /***********************************************************************
  *           timerqueue_thread_proc    (internal)
  */
@@ -1078,15 +1103,7 @@ static void CALLBACK timerqueue_thread_proc( void *param )
                 if (timer->u.timer.timeout <= now.QuadPart)
                     timer->u.timer.timeout = now.QuadPart + 1;
 
-                LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                                     struct threadpool_object, u.timer.timer_entry )
-                {
-                    assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-                    if (timer->u.timer.timeout < other_timer->u.timer.timeout)
-                        break;
-                }
-                list_add_before( &other_timer->u.timer.timer_entry, &timer->u.timer.timer_entry );
-                timer->u.timer.timer_pending = TRUE;
+                timerqueue_add_timer( timer );
             }
         }
 
@@ -1946,17 +1963,28 @@ static void tp_object_prio_queue( struct threadpool_object *object )
 static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
 {
     struct threadpool *pool = object->pool;
-    NTSTATUS status = STATUS_UNSUCCESSFUL;
+    BOOL new_thread = FALSE, wake = FALSE;
+    NTSTATUS status;
+    HANDLE thread;
 
     assert( !object->shutdown );
     assert( !pool->shutdown );
 
     RtlEnterCriticalSection( &pool->cs );
 
-    /* Start new worker threads if required. */
-    if (pool->num_busy_workers >= pool->num_workers &&
-        pool->num_workers < pool->max_workers)
-        status = tp_new_worker_thread( pool );
+    /* Start a new worker thread if required. It is accounted for right away, but
+     * created after leaving the pool lock, which all submitters contend for. If all
+     * threads already have work queued for them, they will also pick up this item. */
+    if (pool->num_busy_workers >= pool->num_workers)
+    {
+        if (pool->num_workers < pool->max_workers)
+        {
+            InterlockedIncrement( &pool->refcount );
+            pool->num_workers++;
+            new_thread = TRUE;
+        }
+    }
+    else wake = TRUE;
 
     /* Queue work item and increment refcount. */
     InterlockedIncrement( &object->refcount );
@@ -1967,14 +1995,29 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
     if (object->type == TP_OBJECT_TYPE_WAIT && signaled)
         object->u.wait.signaled++;
 
-    /* No new thread started - wake up one existing thread. */
-    if (status != STATUS_SUCCESS)
+    RtlLeaveCriticalSection( &pool->cs );
+
+    if (new_thread)
     {
+        status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, 0, 0, 0,
+                                      threadpool_worker_proc, pool, &thread, NULL );
+        if (status == STATUS_SUCCESS)
+        {
+            NtClose( thread );
+            return;
+        }
+
+        /* No new thread started - wake up one existing thread. */
+        RtlEnterCriticalSection( &pool->cs );
+        pool->num_workers--;
         assert( pool->num_workers > 0 );
-        RtlWakeConditionVariable( &pool->update_event );
+        RtlLeaveCriticalSection( &pool->cs );
+        InterlockedDecrement( &pool->refcount );
+        wake = TRUE;
     }
 
-    RtlLeaveCriticalSection( &pool->cs );
+    /* Waking up after leaving the lock saves the woken thread from blocking on it. */
+    if (wake) RtlWakeConditionVariable( &pool->update_event );
 }
 
 /***********************************************************************
@@ -2906,7 +2949,6 @@ BOOL WINAPI TpSetPoolMinThreads( TP_POOL *pool, DWORD minimum )
 VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LONG window_length )
 {
     struct threadpool_object *this = impl_from_TP_TIMER( timer );
-    struct threadpool_object *other_timer;
     BOOL submit_timer = FALSE;
     ULONGLONG timestamp;
 
@@ -2956,20 +2998,11 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
         this->u.timer.period        = period;
         this->u.timer.window_length = window_length;
 
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
-        {
-            assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-            if (this->u.timer.timeout < other_timer->u.timer.timeout)
-                break;
-        }
-        list_add_before( &other_timer->u.timer.timer_entry, &this->u.timer.timer_entry );
+        timerqueue_add_timer( this );
 
         /* Wake up the timer thread when the timeout has to be updated. */
         if (list_head( &timerqueue.pending_timers ) == &this->u.timer.timer_entry )
             RtlWakeAllConditionVariable( &timerqueue.update_event );
-
-        this->u.timer.timer_pending = TRUE;
     }
 
     RtlLeaveCriticalSection( &timerqueue.cs );
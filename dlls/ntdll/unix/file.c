@@ -235,6 +235,21 @@ static const unsigned int dir_data_names_initial_size  = 64;
 static struct dir_data **dir_data_cache;
 static unsigned int dir_data_cache_size;
 
+/* directory contents cached for case-insensitive file lookups */
+struct lookup_dir
+{
+    struct file_identity id;         /* directory file identity */
+    time_t               mtime;      /* directory modification time when it was read */
+    unsigned long        mtime_nsec;
+    struct dir_data     *data;       /* directory file names, sorted */
+};
+
+#define MAX_LOOKUP_DIRS 64
+
+static struct lookup_dir lookup_dirs[MAX_LOOKUP_DIRS];
+static unsigned int lookup_dirs_next;  /* next entry to replace */
+static pthread_mutex_t lookup_dirs_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static BOOL show_dot_files;
 static mode_t start_umask;
 
@@ -2467,6 +2482,135 @@ NTSTATUS WINAPI NtQueryDirectoryFile( HANDLE handle, HANDLE event, PIO_APC_ROUTI
 }
 
 
+/* get the modification time of a directory with the best available precision */
+static inline unsigned long get_dir_mtime_nsec( const struct stat *st )
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    return st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    return st->st_mtimespec.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+
+/***********************************************************************
+ *           read_lookup_dir_data
+ *
+ * Read the names of a directory for the lookup cache.
+ */
+static struct dir_data *read_lookup_dir_data( const char *unix_name )
+{
+    struct dir_data *data;
+    struct dirent *de;
+    DIR *dir;
+
+    if (!(dir = opendir( unix_name ))) return NULL;
+    if ((data = calloc( 1, sizeof(*data) )))
+    {
+        while ((de = readdir( dir )))
+        {
+            if (!strcmp( de->d_name, "." ) || !strcmp( de->d_name, ".." )) continue;
+            if (append_entry( data, de->d_name, NULL, NULL )) continue;
+            free_dir_data( data );
+            data = NULL;
+            break;
+        }
+    }
+    closedir( dir );
+    if (data) qsort( data->names, data->count, sizeof(*data->names), name_compare );
+    return data;
+}
+
+
+/***********************************************************************
+ *           find_file_in_cached_dir
+ *
+ * Look for a file in the cached contents of a directory, reading them if necessary;
+ * helper for find_file_in_dir. The file found is appended to unix_name at pos.
+ * Returns STATUS_NOT_IMPLEMENTED if the directory cannot be cached.
+ */
+static NTSTATUS find_file_in_cached_dir( char *unix_name, int pos, const WCHAR *name, int length,
+                                         BOOLEAN is_name_8_dot_3 )
+{
+    const struct dir_data_names *found = NULL;
+    struct lookup_dir *entry = NULL;
+    struct dir_data *data;
+    struct stat st;
+    unsigned int i;
+    int min, max, res;
+
+    /* a directory modified in the last second could change again without its mtime changing */
+    if (stat( unix_name, &st ) == -1 || st.st_mtime >= time( NULL ) - 1) return STATUS_NOT_IMPLEMENTED;
+
+    mutex_lock( &lookup_dirs_mutex );
+
+    for (i = 0; i < MAX_LOOKUP_DIRS; i++)
+    {
+        if (!lookup_dirs[i].data) continue;
+        if (lookup_dirs[i].id.dev != st.st_dev || lookup_dirs[i].id.ino != st.st_ino) continue;
+        entry = &lookup_dirs[i];
+        break;
+    }
+    if (!entry || entry->mtime != st.st_mtime || entry->mtime_nsec != get_dir_mtime_nsec( &st ))
+    {
+        if (!(data = read_lookup_dir_data( unix_name )))
+        {
+            mutex_unlock( &lookup_dirs_mutex );
+            return STATUS_NOT_IMPLEMENTED;
+        }
+        if (!entry) entry = &lookup_dirs[lookup_dirs_next++ % MAX_LOOKUP_DIRS];
+        free_dir_data( entry->data );
+        entry->id.dev     = st.st_dev;
+        entry->id.ino     = st.st_ino;
+        entry->mtime      = st.st_mtime;
+        entry->mtime_nsec = get_dir_mtime_nsec( &st );
+        entry->data       = data;
+    }
+    data = entry->data;
+
+    /* the names are sorted case-insensitively, so we can use a binary search on long names */
+    min = 0;
+    max = data->count - 1;
+    while (min <= max)
+    {
+        i = (min + max) / 2;
+        if (!(res = wcsnicmp( data->names[i].long_name, name, length )))
+        {
+            if (!data->names[i].long_name[length])
+            {
+                found = &data->names[i];
+                break;
+            }
+            res = 1;
+        }
+        if (res > 0) max = i - 1;
+        else min = i + 1;
+    }
+
+    /* generated short names always have a tilde at the fifth position */
+    if (!found && is_name_8_dot_3 && length >= 8 && name[4] == '~')
+    {
+        for (i = 0; i < data->count; i++)
+        {
+            if (wcslen( data->names[i].short_name ) != length) continue;
+            if (wcsnicmp( data->names[i].short_name, name, length )) continue;
+            found = &data->names[i];
+            break;
+        }
+    }
+
+    if (found)
+    {
+        unix_name[pos - 1] = '/';
+        strcpy( unix_name + pos, found->unix_name );
+    }
+    mutex_unlock( &lookup_dirs_mutex );
+    return found ? STATUS_SUCCESS : STATUS_OBJECT_PATH_NOT_FOUND;
+}
+
+
 /***********************************************************************
  *           find_file_in_dir
  *
@@ -2479,6 +2623,7 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
 {
     WCHAR buffer[MAX_DIR_ENTRY_LEN];
     BOOLEAN is_name_8_dot_3;
+    NTSTATUS status;
     DIR *dir;
     struct dirent *de;
     struct stat st;
@@ -2557,6 +2702,10 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
     }
 #endif /* VFAT_IOCTL_READDIR_BOTH */
 
+    status = find_file_in_cached_dir( unix_name, pos, name, length, is_name_8_dot_3 );
+    if (status == STATUS_SUCCESS) return status;
+    if (status == STATUS_OBJECT_PATH_NOT_FOUND) goto not_found;
+
     if (!(dir = opendir( unix_name ))) return errno_to_status( errno );
 
     unix_name[pos - 1] = '/';
@@ -6887,9 +7036,19 @@ NTSTATUS WINAPI NtQueryObject( HANDLE handle, OBJECT_INFORMATION_CLASS info_clas
     case ObjectDataInformation:
     {
         OBJECT_DATA_INFORMATION* p = ptr;
+        shared_handle_t info;
 
         if (len < sizeof(*p)) return STATUS_INVALID_BUFFER_SIZE;
 
+        if ((status = get_shared_handle( handle, &info )) != STATUS_NOT_IMPLEMENTED)
+        {
+            if (status) break;
+            p->InheritHandle = (info.s.flags & HANDLE_FLAG_INHERIT) != 0;
+            p->ProtectFromClose = (info.s.flags & HANDLE_FLAG_PROTECT_FROM_CLOSE) != 0;
+            if (used_len) *used_len = sizeof(*p);
+            break;
+        }
+
         SERVER_START_REQ( set_handle_info )
         {
             req->handle = wine_server_obj_handle( handle );
@@ -961,6 +961,7 @@ static void relocate_ntdll( void *module )
 
 
 static void *callback_module;
+static pthread_mutex_t dlopen_mutex = PTHREAD_MUTEX_INITIALIZER;  /* protects callback_module */
 
 /***********************************************************************
  *           load_builtin_callback
@@ -1050,18 +1051,20 @@ static NTSTATUS dlopen_dll( const char *so_name, UNICODE_STRING *nt_name, void *
     void *module, *handle;
     const IMAGE_NT_HEADERS *nt;
 
+    pthread_mutex_lock( &dlopen_mutex );
     callback_module = (void *)1;
     handle = dlopen( so_name, RTLD_NOW );
+    module = callback_module;
+    pthread_mutex_unlock( &dlopen_mutex );
     if (!handle)
     {
         WARN( "failed to load .so lib %s: %s\n", debugstr_a(so_name), dlerror() );
         return STATUS_INVALID_IMAGE_FORMAT;
     }
-    if (callback_module != (void *)1)  /* callback was called */
+    if (module != (void *)1)  /* callback was called */
     {
-        if (!callback_module) return STATUS_NO_MEMORY;
+        if (!module) return STATUS_NO_MEMORY;
         WARN( "got old-style builtin library %s, constructors won't work\n", debugstr_a(so_name) );
-        module = callback_module;
         if (get_builtin_so_handle( module )) goto already_loaded;
     }
     else if ((nt = dlsym( handle, "__wine_spec_nt_header" )))
@@ -257,9 +257,28 @@ static void read_reply_data( void *buffer, size_t size )
  */
 static inline unsigned int wait_reply( struct __server_request_info *req )
 {
-    read_reply_data( &req->u.reply, sizeof(req->u.reply) );
-    if (req->u.reply.reply_header.reply_size)
-        read_reply_data( req->reply_data, req->u.reply.reply_header.reply_size );
+    struct iovec vec[2];
+    int ret;
+
+    /* read the reply data along with the reply whenever possible */
+    vec[0].iov_base = &req->u.reply;
+    vec[0].iov_len  = sizeof(req->u.reply);
+    vec[1].iov_base = req->reply_data;
+    vec[1].iov_len  = req->u.req.request_header.reply_size;
+
+    while ((ret = readv( ntdll_get_thread_data()->reply_fd, vec, vec[1].iov_len ? 2 : 1 )) == -1 &&
+           errno == EINTR);
+
+    if (ret < (int)sizeof(req->u.reply))
+    {
+        if (ret < 0 && errno != EPIPE) server_protocol_perror( "read" );
+        if (ret <= 0) abort_thread(0);  /* the server closed the connection */
+        read_reply_data( (char *)&req->u.reply + ret, sizeof(req->u.reply) - ret );
+        ret = sizeof(req->u.reply);
+    }
+    ret -= sizeof(req->u.reply);
+    if (req->u.reply.reply_header.reply_size > ret)
+        read_reply_data( (char *)req->reply_data + ret, req->u.reply.reply_header.reply_size - ret );
     return req->u.reply.reply_header.error;
 }
 
@@ -991,6 +1010,182 @@ static int remove_fd_from_cache( HANDLE handle )
 }
 
 
+/***********************************************************************/
+/* in-process sync cache support */
+
+union inproc_sync_cache_entry
+{
+    LONG64 data;
+    struct
+    {
+        unsigned int index;   /* index of the shared slot, 0 if not cached */
+        unsigned int serial;  /* serial number of the slot when the handle was created */
+    } s;
+};
+
+C_ASSERT( sizeof(union inproc_sync_cache_entry) == sizeof(LONG64) );
+
+static union inproc_sync_cache_entry *inproc_sync_cache[FD_CACHE_ENTRIES];
+
+
+/***********************************************************************
+ *           add_inproc_sync_to_cache
+ */
+void add_inproc_sync_to_cache( HANDLE handle, unsigned int index, unsigned int serial )
+{
+    unsigned int entry, idx = handle_to_index( handle, &entry );
+    union inproc_sync_cache_entry cache;
+    sigset_t sigset;
+
+    if (entry >= FD_CACHE_ENTRIES) return;
+
+    server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
+    if (!inproc_sync_cache[entry])  /* do we need to allocate a new block of entries? */
+    {
+        void *ptr = anon_mmap_alloc( FD_CACHE_BLOCK_SIZE * sizeof(union inproc_sync_cache_entry),
+                                     PROT_READ | PROT_WRITE );
+        if (ptr != MAP_FAILED) inproc_sync_cache[entry] = ptr;
+    }
+    if (inproc_sync_cache[entry])
+    {
+        cache.s.index = index;
+        cache.s.serial = serial;
+        interlocked_xchg64( &inproc_sync_cache[entry][idx].data, cache.data );
+    }
+    server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
+}
+
+
+/***********************************************************************
+ *           get_cached_inproc_sync
+ *
+ * Return the shared slot index of a handle, or 0 if it's not cached.
+ */
+unsigned int get_cached_inproc_sync( HANDLE handle, unsigned int *serial )
+{
+    unsigned int entry, idx = handle_to_index( handle, &entry );
+    union inproc_sync_cache_entry cache;
+
+    if (entry >= FD_CACHE_ENTRIES || !inproc_sync_cache[entry]) return 0;
+
+    cache.data = InterlockedCompareExchange64( &inproc_sync_cache[entry][idx].data, 0, 0 );
+    *serial = cache.s.serial;
+    return cache.s.index;
+}
+
+
+/***********************************************************************
+ *           remove_inproc_sync_from_cache
+ */
+static void remove_inproc_sync_from_cache( HANDLE handle )
+{
+    unsigned int entry, idx = handle_to_index( handle, &entry );
+
+    if (entry < FD_CACHE_ENTRIES && inproc_sync_cache[entry])
+        interlocked_xchg64( &inproc_sync_cache[entry][idx].data, 0 );
+}
+
+
+/***********************************************************************/
+/* shared handle table support */
+
+/* the table grows with the server handle table; both are published with release */
+/* semantics, the pointer first, so that a reader that sees a count also sees a */
+/* view that is at least that large. Replaced views are never unmapped since */
+/* other threads may still be reading them. */
+static const shared_handle_t *shared_handles;
+static unsigned int shared_handles_count;
+static BOOL shared_handles_failed;
+static pthread_mutex_t shared_handles_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/***********************************************************************
+ *           map_shared_handle_table
+ *
+ * Map a view of the shared handle table that covers the given index, if the
+ * server has one. Returns the number of entries that can be read.
+ */
+static unsigned int map_shared_handle_table( unsigned int idx )
+{
+    unsigned int count;
+    void *ptr = MAP_FAILED;
+    HANDLE mapping = 0;
+    int fd, needs_close;
+    sigset_t sigset;
+    NTSTATUS ret;
+
+    server_enter_uninterrupted_section( &shared_handles_mutex, &sigset );
+
+    count = shared_handles_count;
+    if (shared_handles_failed || idx < count) goto done;
+
+    SERVER_START_REQ( get_shared_handle_table )
+    {
+        req->count = count;
+        if (!(ret = wine_server_call( req )))
+        {
+            mapping = wine_server_ptr_handle( reply->handle );
+            count = reply->count;
+        }
+    }
+    SERVER_END_REQ;
+    if (ret)
+    {
+        shared_handles_failed = TRUE;
+        count = shared_handles_count;
+        goto done;
+    }
+    if (!mapping) goto done;  /* the server table has not grown */
+
+    if (!server_get_unix_fd( mapping, 0, &fd, &needs_close, NULL, NULL ))
+    {
+        ptr = mmap( NULL, count * sizeof(*shared_handles), PROT_READ, MAP_SHARED, fd, 0 );
+        if (needs_close) close( fd );
+    }
+    if (ptr != MAP_FAILED)
+    {
+        __atomic_store_n( &shared_handles, ptr, __ATOMIC_RELEASE );
+        __atomic_store_n( &shared_handles_count, count, __ATOMIC_RELEASE );
+    }
+    else
+    {
+        shared_handles_failed = TRUE;
+        count = shared_handles_count;
+    }
+
+done:
+    server_leave_uninterrupted_section( &shared_handles_mutex, &sigset );
+    /* closing outside of the mutex; the handle is normally covered by the new view, */
+    /* and if not the server won't return another one until the table grows again */
+    if (mapping) NtClose( mapping );
+    return count;
+}
+
+
+/***********************************************************************
+ *           get_shared_handle
+ *
+ * Retrieve the server information about a handle of the current process
+ * without a server call. Returns STATUS_NOT_IMPLEMENTED if the handle
+ * cannot be checked that way (pseudo-handles, global handles...).
+ */
+NTSTATUS get_shared_handle( HANDLE handle, shared_handle_t *info )
+{
+    obj_handle_t value = wine_server_obj_handle( handle );
+    const shared_handle_t *table;
+    unsigned int idx = (value >> 2) - 1, count;
+
+    if (!value || idx >= SHARED_HANDLE_MAX_ENTRIES) return STATUS_NOT_IMPLEMENTED;
+    count = __atomic_load_n( &shared_handles_count, __ATOMIC_ACQUIRE );
+    if (idx >= count) count = map_shared_handle_table( idx );
+    if (idx >= count) return STATUS_NOT_IMPLEMENTED;
+    table = __atomic_load_n( &shared_handles, __ATOMIC_ACQUIRE );
+
+    info->data = InterlockedCompareExchange64( (LONG64 *)&table[idx].data, 0, 0 );
+    return info->s.type ? STATUS_SUCCESS : STATUS_INVALID_HANDLE;
+}
+
+
 /***********************************************************************
  *           server_get_unix_fd
  *
@@ -1659,6 +1854,7 @@ NTSTATUS WINAPI DbgUiIssueRemoteBreakin( HANDLE process )
 NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE dest_process, HANDLE *dest,
                                    ACCESS_MASK access, ULONG attributes, ULONG options )
 {
+    shared_handle_t info;
     sigset_t sigset;
     NTSTATUS ret;
     int fd = -1;
@@ -1684,12 +1880,19 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
         return result.dup_handle.status;
     }
 
+    /* fail early on handles the server doesn't know about */
+    if (source_process == NtCurrentProcess() && get_shared_handle( source, &info ) == STATUS_INVALID_HANDLE)
+        return STATUS_INVALID_HANDLE;
+
     server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
 
     /* always remove the cached fd; if the server request fails we'll just
      * retrieve it again */
     if (options & DUPLICATE_CLOSE_SOURCE)
+    {
         fd = remove_fd_from_cache( source );
+        remove_inproc_sync_from_cache( source );
+    }
 
     SERVER_START_REQ( dup_handle )
     {
@@ -1718,23 +1921,33 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
  */
 NTSTATUS WINAPI NtClose( HANDLE handle )
 {
+    shared_handle_t info;
+    BOOL invalid;
     sigset_t sigset;
     HANDLE port;
     NTSTATUS ret;
     int fd;
 
+    /* this may need to map the table, so do it before taking the lock */
+    invalid = get_shared_handle( handle, &info ) == STATUS_INVALID_HANDLE;
+
     server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
 
     /* always remove the cached fd; if the server request fails we'll just
      * retrieve it again */
     fd = remove_fd_from_cache( handle );
+    remove_inproc_sync_from_cache( handle );
 
-    SERVER_START_REQ( close_handle )
+    if (invalid) ret = STATUS_INVALID_HANDLE;
+    else
     {
-        req->handle = wine_server_obj_handle( handle );
-        ret = wine_server_call( req );
+        SERVER_START_REQ( close_handle )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            ret = wine_server_call( req );
+        }
+        SERVER_END_REQ;
     }
-    SERVER_END_REQ;
 
     server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
 
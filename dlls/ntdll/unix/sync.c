@@ -32,6 +32,9 @@
 #include <errno.h>
 #include <limits.h>
 #include <signal.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #ifdef HAVE_SYS_SYSCALL_H
 #include <sys/syscall.h>
 #endif
@@ -309,6 +312,208 @@ static NTSTATUS validate_open_object_attributes( const OBJECT_ATTRIBUTES *attr )
 }
 
 
+/* In-process synchronization: the server keeps the state of unnamed events,
+ * semaphores and mutexes created by this process in memory shared with us
+ * only, which lets us signal them and acquire them when already signaled
+ * without a server call. Anything that needs to block, or any object the
+ * server has waiters on, goes through the server. */
+
+static inproc_sync_t *inproc_syncs;
+
+#define INPROC_SYNC_SIZE (INPROC_SYNC_MAX_OBJECTS * sizeof(inproc_sync_t))
+
+static BOOL map_inproc_syncs(void)
+{
+    void *ptr = MAP_FAILED;
+    HANDLE section;
+    int fd, needs_close;
+    NTSTATUS ret;
+
+    if (inproc_syncs) return TRUE;
+
+    SERVER_START_REQ( get_inproc_sync_mapping )
+    {
+        ret = wine_server_call( req );
+        section = wine_server_ptr_handle( reply->handle );
+    }
+    SERVER_END_REQ;
+    if (ret) return FALSE;
+
+    if (!server_get_unix_fd( section, 0, &fd, &needs_close, NULL, NULL ))
+    {
+        ptr = mmap( NULL, INPROC_SYNC_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+        if (needs_close) close( fd );
+    }
+    NtClose( section );
+    if (ptr == MAP_FAILED) return FALSE;
+    if (InterlockedCompareExchangePointer( (void **)&inproc_syncs, ptr, NULL ))
+        munmap( ptr, INPROC_SYNC_SIZE );
+    return TRUE;
+}
+
+/* remember the shared slot returned by a create request */
+static void cache_inproc_sync( HANDLE handle, unsigned int index )
+{
+    if (!index || !map_inproc_syncs()) return;
+    add_inproc_sync_to_cache( handle, index, inproc_syncs[index].serial );
+}
+
+static inproc_sync_t *get_inproc_sync( HANDLE handle )
+{
+    unsigned int index, serial;
+    inproc_sync_t *sync;
+
+    if (!inproc_syncs) return NULL;
+    if (!(index = get_cached_inproc_sync( handle, &serial ))) return NULL;
+    sync = &inproc_syncs[index];
+    if (sync->serial != serial) return NULL;  /* the object is gone */
+    return sync;
+}
+
+static inline unsigned int get_inproc_sync_type( const inproc_sync_t *sync )
+{
+    return sync->flags & INPROC_SYNC_TYPE_MASK;
+}
+
+static inline int get_inproc_sync_state( const inproc_sync_t *sync )
+{
+    return *(volatile const int *)&sync->state;
+}
+
+/* change the state value, unless the server has waiters on the object */
+static inline BOOL cmpxchg_inproc_sync_state( inproc_sync_t *sync, int *cur, int new )
+{
+    int prev = InterlockedCompareExchange( (LONG *)&sync->state, new, *cur );
+
+    if (prev == *cur) return TRUE;
+    *cur = prev;
+    return FALSE;
+}
+
+static NTSTATUS inproc_set_event( inproc_sync_t *sync, int signaled, LONG *prev_state )
+{
+    int cur = get_inproc_sync_state( sync );
+
+    do if (cur & INPROC_SYNC_WAITERS) return STATUS_NOT_IMPLEMENTED;
+    while (cur != signaled && !cmpxchg_inproc_sync_state( sync, &cur, signaled ));
+
+    if (prev_state) *prev_state = cur;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS inproc_release_semaphore( inproc_sync_t *sync, ULONG count, ULONG *previous )
+{
+    int cur = get_inproc_sync_state( sync );
+
+    do
+    {
+        if (cur & INPROC_SYNC_WAITERS) return STATUS_NOT_IMPLEMENTED;
+        if (count > (ULONG)(sync->count - cur)) return STATUS_SEMAPHORE_LIMIT_EXCEEDED;
+    }
+    while (!cmpxchg_inproc_sync_state( sync, &cur, cur + count ));
+
+    if (previous) *previous = cur;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS inproc_release_mutant( inproc_sync_t *sync, LONG *prev_count )
+{
+    int tid = HandleToULong( NtCurrentTeb()->ClientId.UniqueThread );
+    int cur = get_inproc_sync_state( sync );
+    int count;
+
+    /* only the owner can change the state to or from its own id */
+    if ((cur & ~INPROC_SYNC_WAITERS) != tid) return STATUS_MUTANT_NOT_OWNED;
+    if (cur & INPROC_SYNC_WAITERS) return STATUS_NOT_IMPLEMENTED;
+
+    count = sync->count;
+    if (count == 1)
+    {
+        sync->count = 0;
+        if (!cmpxchg_inproc_sync_state( sync, &cur, 0 ))
+        {
+            /* the server got a waiter in the meantime, let it do the release */
+            sync->count = count;
+            return STATUS_NOT_IMPLEMENTED;
+        }
+    }
+    else sync->count = count - 1;
+
+    if (prev_count) *prev_count = 1 - count;
+    return STATUS_SUCCESS;
+}
+
+/* try to acquire an object without blocking */
+/* returns STATUS_TIMEOUT if it isn't signaled */
+static NTSTATUS inproc_try_acquire( inproc_sync_t *sync )
+{
+    int tid = HandleToULong( NtCurrentTeb()->ClientId.UniqueThread );
+    int cur = get_inproc_sync_state( sync );
+
+    switch (get_inproc_sync_type( sync ))
+    {
+    case INPROC_SYNC_EVENT:
+        do
+        {
+            if (cur & INPROC_SYNC_WAITERS) return STATUS_NOT_IMPLEMENTED;
+            if (!cur) return STATUS_TIMEOUT;
+            if (sync->flags & INPROC_SYNC_MANUAL_RESET) return STATUS_SUCCESS;
+        }
+        while (!cmpxchg_inproc_sync_state( sync, &cur, 0 ));
+        return STATUS_SUCCESS;
+
+    case INPROC_SYNC_SEMAPHORE:
+        do
+        {
+            if (cur & INPROC_SYNC_WAITERS) return STATUS_NOT_IMPLEMENTED;
+            if (!cur) return STATUS_TIMEOUT;
+        }
+        while (!cmpxchg_inproc_sync_state( sync, &cur, cur - 1 ));
+        return STATUS_SUCCESS;
+
+    case INPROC_SYNC_MUTEX:
+        if (cur & INPROC_SYNC_WAITERS) return STATUS_NOT_IMPLEMENTED;
+        if (cur == tid)
+        {
+            sync->count++;
+            return STATUS_SUCCESS;
+        }
+        if (cur) return STATUS_TIMEOUT;
+        if (!cmpxchg_inproc_sync_state( sync, &cur, tid )) return STATUS_NOT_IMPLEMENTED;
+        sync->count = 1;
+        if (InterlockedAnd( (LONG *)&sync->flags, ~INPROC_SYNC_ABANDONED ) & INPROC_SYNC_ABANDONED)
+            return STATUS_ABANDONED_WAIT_0;
+        return STATUS_SUCCESS;
+    }
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+/* satisfy a wait without a server call if one of the objects is already signaled */
+static NTSTATUS inproc_wait( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
+                             const LARGE_INTEGER *timeout )
+{
+    inproc_sync_t *syncs[MAXIMUM_WAIT_OBJECTS];
+    NTSTATUS ret;
+    DWORD i;
+
+    if (!wait_any && count > 1) return STATUS_NOT_IMPLEMENTED;
+
+    for (i = 0; i < count; i++)
+        if (!(syncs[i] = get_inproc_sync( handles[i] ))) return STATUS_NOT_IMPLEMENTED;
+
+    for (i = 0; i < count; i++)
+    {
+        if ((ret = inproc_try_acquire( syncs[i] )) == STATUS_TIMEOUT) continue;
+        if (ret == STATUS_SUCCESS) return STATUS_WAIT_0 + i;
+        if (ret == STATUS_ABANDONED_WAIT_0) return STATUS_ABANDONED_WAIT_0 + i;
+        return ret;
+    }
+
+    if (timeout && !timeout->QuadPart) return STATUS_TIMEOUT;
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+
 /******************************************************************************
  *              NtCreateSemaphore (NTDLL.@)
  */
@@ -330,6 +535,7 @@ NTSTATUS WINAPI NtCreateSemaphore( HANDLE *handle, ACCESS_MASK access, const OBJ
         wine_server_add_data( req, objattr, len );
         ret = wine_server_call( req );
         *handle = wine_server_ptr_handle( reply->handle );
+        if (!ret) cache_inproc_sync( *handle, reply->inproc_sync );
     }
     SERVER_END_REQ;
 
@@ -370,6 +576,7 @@ NTSTATUS WINAPI NtQuerySemaphore( HANDLE handle, SEMAPHORE_INFORMATION_CLASS cla
 {
     NTSTATUS ret;
     SEMAPHORE_BASIC_INFORMATION *out = info;
+    inproc_sync_t *sync;
 
     TRACE("(%p, %u, %p, %u, %p)\n", handle, class, info, len, ret_len);
 
@@ -381,6 +588,14 @@ NTSTATUS WINAPI NtQuerySemaphore( HANDLE handle, SEMAPHORE_INFORMATION_CLASS cla
 
     if (len != sizeof(SEMAPHORE_BASIC_INFORMATION)) return STATUS_INFO_LENGTH_MISMATCH;
 
+    if ((sync = get_inproc_sync( handle )) && get_inproc_sync_type( sync ) == INPROC_SYNC_SEMAPHORE)
+    {
+        out->CurrentCount = get_inproc_sync_state( sync ) & ~INPROC_SYNC_WAITERS;
+        out->MaximumCount = sync->count;
+        if (ret_len) *ret_len = sizeof(SEMAPHORE_BASIC_INFORMATION);
+        return STATUS_SUCCESS;
+    }
+
     SERVER_START_REQ( query_semaphore )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -401,8 +616,13 @@ NTSTATUS WINAPI NtQuerySemaphore( HANDLE handle, SEMAPHORE_INFORMATION_CLASS cla
  */
 NTSTATUS WINAPI NtReleaseSemaphore( HANDLE handle, ULONG count, ULONG *previous )
 {
+    inproc_sync_t *sync;
     NTSTATUS ret;
 
+    if ((sync = get_inproc_sync( handle )) && get_inproc_sync_type( sync ) == INPROC_SYNC_SEMAPHORE &&
+        (ret = inproc_release_semaphore( sync, count, previous )) != STATUS_NOT_IMPLEMENTED)
+        return ret;
+
     SERVER_START_REQ( release_semaphore )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -438,6 +658,7 @@ NTSTATUS WINAPI NtCreateEvent( HANDLE *handle, ACCESS_MASK access, const OBJECT_
         wine_server_add_data( req, objattr, len );
         ret = wine_server_call( req );
         *handle = wine_server_ptr_handle( reply->handle );
+        if (!ret) cache_inproc_sync( *handle, reply->inproc_sync );
     }
     SERVER_END_REQ;
 
@@ -475,8 +696,13 @@ NTSTATUS WINAPI NtOpenEvent( HANDLE *handle, ACCESS_MASK access, const OBJECT_AT
  */
 NTSTATUS WINAPI NtSetEvent( HANDLE handle, LONG *prev_state )
 {
+    inproc_sync_t *sync;
     NTSTATUS ret;
 
+    if ((sync = get_inproc_sync( handle )) && get_inproc_sync_type( sync ) == INPROC_SYNC_EVENT &&
+        (ret = inproc_set_event( sync, 1, prev_state )) != STATUS_NOT_IMPLEMENTED)
+        return ret;
+
     SERVER_START_REQ( event_op )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -494,8 +720,13 @@ NTSTATUS WINAPI NtSetEvent( HANDLE handle, LONG *prev_state )
  */
 NTSTATUS WINAPI NtResetEvent( HANDLE handle, LONG *prev_state )
 {
+    inproc_sync_t *sync;
     NTSTATUS ret;
 
+    if ((sync = get_inproc_sync( handle )) && get_inproc_sync_type( sync ) == INPROC_SYNC_EVENT &&
+        (ret = inproc_set_event( sync, 0, prev_state )) != STATUS_NOT_IMPLEMENTED)
+        return ret;
+
     SERVER_START_REQ( event_op )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -545,6 +776,7 @@ NTSTATUS WINAPI NtQueryEvent( HANDLE handle, EVENT_INFORMATION_CLASS class,
 {
     NTSTATUS ret;
     EVENT_BASIC_INFORMATION *out = info;
+    inproc_sync_t *sync;
 
     TRACE("(%p, %u, %p, %u, %p)\n", handle, class, info, len, ret_len);
 
@@ -557,6 +789,14 @@ NTSTATUS WINAPI NtQueryEvent( HANDLE handle, EVENT_INFORMATION_CLASS class,
 
     if (len != sizeof(EVENT_BASIC_INFORMATION)) return STATUS_INFO_LENGTH_MISMATCH;
 
+    if ((sync = get_inproc_sync( handle )) && get_inproc_sync_type( sync ) == INPROC_SYNC_EVENT)
+    {
+        out->EventType  = (sync->flags & INPROC_SYNC_MANUAL_RESET) ? NotificationEvent : SynchronizationEvent;
+        out->EventState = get_inproc_sync_state( sync ) & ~INPROC_SYNC_WAITERS;
+        if (ret_len) *ret_len = sizeof(EVENT_BASIC_INFORMATION);
+        return STATUS_SUCCESS;
+    }
+
     SERVER_START_REQ( query_event )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -591,6 +831,7 @@ NTSTATUS WINAPI NtCreateMutant( HANDLE *handle, ACCESS_MASK access, const OBJECT
         wine_server_add_data( req, objattr, len );
         ret = wine_server_call( req );
         *handle = wine_server_ptr_handle( reply->handle );
+        if (!ret) cache_inproc_sync( *handle, reply->inproc_sync );
     }
     SERVER_END_REQ;
 
@@ -628,8 +869,13 @@ NTSTATUS WINAPI NtOpenMutant( HANDLE *handle, ACCESS_MASK access, const OBJECT_A
  */
 NTSTATUS WINAPI NtReleaseMutant( HANDLE handle, LONG *prev_count )
 {
+    inproc_sync_t *sync;
     NTSTATUS ret;
 
+    if ((sync = get_inproc_sync( handle )) && get_inproc_sync_type( sync ) == INPROC_SYNC_MUTEX &&
+        (ret = inproc_release_mutant( sync, prev_count )) != STATUS_NOT_IMPLEMENTED)
+        return ret;
+
     SERVER_START_REQ( release_mutex )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -649,6 +895,7 @@ NTSTATUS WINAPI NtQueryMutant( HANDLE handle, MUTANT_INFORMATION_CLASS class,
 {
     NTSTATUS ret;
     MUTANT_BASIC_INFORMATION *out = info;
+    inproc_sync_t *sync;
 
     TRACE("(%p, %u, %p, %u, %p)\n", handle, class, info, len, ret_len);
 
@@ -660,6 +907,17 @@ NTSTATUS WINAPI NtQueryMutant( HANDLE handle, MUTANT_INFORMATION_CLASS class,
 
     if (len != sizeof(MUTANT_BASIC_INFORMATION)) return STATUS_INFO_LENGTH_MISMATCH;
 
+    if ((sync = get_inproc_sync( handle )) && get_inproc_sync_type( sync ) == INPROC_SYNC_MUTEX)
+    {
+        int owner = get_inproc_sync_state( sync ) & ~INPROC_SYNC_WAITERS;
+
+        out->CurrentCount   = 1 - (owner ? sync->count : 0);
+        out->OwnedByCaller  = (owner == HandleToULong( NtCurrentTeb()->ClientId.UniqueThread ));
+        out->AbandonedState = !!(sync->flags & INPROC_SYNC_ABANDONED);
+        if (ret_len) *ret_len = sizeof(MUTANT_BASIC_INFORMATION);
+        return STATUS_SUCCESS;
+    }
+
     SERVER_START_REQ( query_mutex )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -1427,6 +1685,12 @@ NTSTATUS WINAPI NtWaitForMultipleObjects( DWORD count, const HANDLE *handles, BO
 
     if (!count || count > MAXIMUM_WAIT_OBJECTS) return STATUS_INVALID_PARAMETER_1;
 
+    if (!alertable && inproc_syncs)
+    {
+        NTSTATUS ret = inproc_wait( count, handles, wait_any, timeout );
+        if (ret != STATUS_NOT_IMPLEMENTED) return ret;
+    }
+
     if (alertable) flags |= SELECT_ALERTABLE;
     select_op.wait.op = wait_any ? SELECT_WAIT : SELECT_WAIT_ALL;
     for (i = 0; i < count; i++) select_op.wait.handles[i] = wine_server_obj_handle( handles[i] );
@@ -1843,8 +2107,9 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE handle, ULONG_PTR *key, ULONG_PTR *
 NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE handle, FILE_IO_COMPLETION_INFORMATION *info, ULONG count,
                                         ULONG *written, LARGE_INTEGER *timeout, BOOLEAN alertable )
 {
+    struct completion_info more[64];
     NTSTATUS status;
-    ULONG i = 0;
+    ULONG i = 0, j, extra, got = 0;
 
     TRACE( "%p %p %u %p %p %u\n", handle, info, count, written, timeout, alertable );
 
@@ -1852,20 +2117,33 @@ NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE handle, FILE_IO_COMPLETION_INFORM
     {
         while (i < count)
         {
+            /* fetch the following completions in the same request if there is room for them */
+            extra = min( count - i - 1, ARRAY_SIZE(more) );
+
             SERVER_START_REQ( remove_completion )
             {
                 req->handle = wine_server_obj_handle( handle );
+                if (extra) wine_server_set_reply( req, more, extra * sizeof(more[0]) );
                 if (!(status = wine_server_call( req )))
                 {
                     info[i].CompletionKey             = reply->ckey;
                     info[i].CompletionValue           = reply->cvalue;
                     info[i].IoStatusBlock.Information = reply->information;
                     info[i].IoStatusBlock.u.Status    = reply->status;
+                    got = wine_server_reply_size( reply ) / sizeof(more[0]);
                 }
             }
             SERVER_END_REQ;
             if (status != STATUS_SUCCESS) break;
             ++i;
+            for (j = 0; j < got; j++, i++)
+            {
+                info[i].CompletionKey             = more[j].ckey;
+                info[i].CompletionValue           = more[j].cvalue;
+                info[i].IoStatusBlock.Information = more[j].information;
+                info[i].IoStatusBlock.u.Status    = more[j].status;
+            }
+            if (got < extra) break;  /* the queue is empty now */
         }
         if (i || status != STATUS_PENDING)
         {
@@ -175,6 +175,9 @@ extern unsigned int server_queue_process_apc( HANDLE process, const apc_call_t *
 extern int server_get_unix_fd( HANDLE handle, unsigned int wanted_access, int *unix_fd,
                                int *needs_close, enum server_fd_type *type, unsigned int *options ) DECLSPEC_HIDDEN;
 extern void wine_server_send_fd( int fd ) DECLSPEC_HIDDEN;
+extern void add_inproc_sync_to_cache( HANDLE handle, unsigned int index, unsigned int serial ) DECLSPEC_HIDDEN;
+extern unsigned int get_cached_inproc_sync( HANDLE handle, unsigned int *serial ) DECLSPEC_HIDDEN;
+extern NTSTATUS get_shared_handle( HANDLE handle, shared_handle_t *info ) DECLSPEC_HIDDEN;
 extern void process_exit_wrapper( int status ) DECLSPEC_HIDDEN;
 extern size_t server_init_process(void) DECLSPEC_HIDDEN;
 extern void server_init_process_done(void) DECLSPEC_HIDDEN;
@@ -30,6 +30,10 @@
 
 #include "tomcrypt.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
+
 static const ulong32 TE0[256] = {
     0xc66363a5UL, 0xf87c7c84UL, 0xee777799UL, 0xf67b7b8dUL,
     0xfff2f20dUL, 0xd66b6bbdUL, 0xde6f6fb1UL, 0x91c5c554UL,
@@ -926,6 +930,177 @@ static const ulong32 rcon[] = {
     0x1B000000UL, 0x36000000UL
 };
 
+#if defined(__i386__) || defined(__x86_64__)
+
+#define AESNI_TARGET __attribute__((target("aes")))
+
+static int aesni_supported = -1;
+
+static int have_aesni(void)
+{
+    int regs[4];
+
+    if (aesni_supported == -1) {
+        __cpuid(regs, 1);
+        aesni_supported = (regs[2] & 0x02000000) != 0;
+    }
+    return aesni_supported;
+}
+
+/* AES-NI takes the same round keys as the tables, stored in memory byte order */
+static void aesni_setup(aes_key *skey)
+{
+    int i;
+
+    for (i = 0; i < (skey->Nr + 1) * 4; i++) {
+        STORE32H(skey->eK[i], skey->ni_eK + 4 * i);
+        STORE32H(skey->dK[i], skey->ni_dK + 4 * i);
+    }
+    skey->ni = 1;
+}
+
+#define AESNI_LOAD(p)     _mm_loadu_si128((const __m128i *)(p))
+#define AESNI_STORE(p, x) _mm_storeu_si128((__m128i *)(p), x)
+
+static inline void AESNI_TARGET aesni_load_keys(__m128i *k, const unsigned char *rk, int Nr)
+{
+    int r;
+
+    for (r = 0; r <= Nr; r++) k[r] = AESNI_LOAD(rk + 16 * r);
+}
+
+static inline __m128i AESNI_TARGET aesni_encrypt1(__m128i b, const __m128i *k, int Nr)
+{
+    int r;
+
+    b = _mm_xor_si128(b, k[0]);
+    for (r = 1; r < Nr; r++) b = _mm_aesenc_si128(b, k[r]);
+    return _mm_aesenclast_si128(b, k[Nr]);
+}
+
+static inline __m128i AESNI_TARGET aesni_decrypt1(__m128i b, const __m128i *k, int Nr)
+{
+    int r;
+
+    b = _mm_xor_si128(b, k[0]);
+    for (r = 1; r < Nr; r++) b = _mm_aesdec_si128(b, k[r]);
+    return _mm_aesdeclast_si128(b, k[Nr]);
+}
+
+/* the rounds of four independent blocks are interleaved to hide the instruction latency */
+static void AESNI_TARGET aesni_ecb_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long blocks,
+                                           const aes_key *skey)
+{
+    __m128i k[15], b0, b1, b2, b3;
+    int r, Nr = skey->Nr;
+
+    aesni_load_keys(k, skey->ni_eK, Nr);
+
+    for (; blocks >= 4; blocks -= 4, pt += 64, ct += 64) {
+        b0 = _mm_xor_si128(AESNI_LOAD(pt), k[0]);
+        b1 = _mm_xor_si128(AESNI_LOAD(pt + 16), k[0]);
+        b2 = _mm_xor_si128(AESNI_LOAD(pt + 32), k[0]);
+        b3 = _mm_xor_si128(AESNI_LOAD(pt + 48), k[0]);
+        for (r = 1; r < Nr; r++) {
+            b0 = _mm_aesenc_si128(b0, k[r]);
+            b1 = _mm_aesenc_si128(b1, k[r]);
+            b2 = _mm_aesenc_si128(b2, k[r]);
+            b3 = _mm_aesenc_si128(b3, k[r]);
+        }
+        AESNI_STORE(ct, _mm_aesenclast_si128(b0, k[Nr]));
+        AESNI_STORE(ct + 16, _mm_aesenclast_si128(b1, k[Nr]));
+        AESNI_STORE(ct + 32, _mm_aesenclast_si128(b2, k[Nr]));
+        AESNI_STORE(ct + 48, _mm_aesenclast_si128(b3, k[Nr]));
+    }
+
+    for (; blocks; blocks--, pt += 16, ct += 16)
+        AESNI_STORE(ct, aesni_encrypt1(AESNI_LOAD(pt), k, Nr));
+}
+
+static void AESNI_TARGET aesni_ecb_decrypt(const unsigned char *ct, unsigned char *pt, unsigned long blocks,
+                                           const aes_key *skey)
+{
+    __m128i k[15], b0, b1, b2, b3;
+    int r, Nr = skey->Nr;
+
+    aesni_load_keys(k, skey->ni_dK, Nr);
+
+    for (; blocks >= 4; blocks -= 4, ct += 64, pt += 64) {
+        b0 = _mm_xor_si128(AESNI_LOAD(ct), k[0]);
+        b1 = _mm_xor_si128(AESNI_LOAD(ct + 16), k[0]);
+        b2 = _mm_xor_si128(AESNI_LOAD(ct + 32), k[0]);
+        b3 = _mm_xor_si128(AESNI_LOAD(ct + 48), k[0]);
+        for (r = 1; r < Nr; r++) {
+            b0 = _mm_aesdec_si128(b0, k[r]);
+            b1 = _mm_aesdec_si128(b1, k[r]);
+            b2 = _mm_aesdec_si128(b2, k[r]);
+            b3 = _mm_aesdec_si128(b3, k[r]);
+        }
+        AESNI_STORE(pt, _mm_aesdeclast_si128(b0, k[Nr]));
+        AESNI_STORE(pt + 16, _mm_aesdeclast_si128(b1, k[Nr]));
+        AESNI_STORE(pt + 32, _mm_aesdeclast_si128(b2, k[Nr]));
+        AESNI_STORE(pt + 48, _mm_aesdeclast_si128(b3, k[Nr]));
+    }
+
+    for (; blocks; blocks--, ct += 16, pt += 16)
+        AESNI_STORE(pt, aesni_decrypt1(AESNI_LOAD(ct), k, Nr));
+}
+
+/* CBC encryption is serial by nature, only the rounds themselves are accelerated */
+static void AESNI_TARGET aesni_cbc_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long blocks,
+                                           unsigned char *iv, const aes_key *skey)
+{
+    __m128i k[15], chain = AESNI_LOAD(iv);
+
+    aesni_load_keys(k, skey->ni_eK, skey->Nr);
+
+    for (; blocks; blocks--, pt += 16, ct += 16) {
+        chain = aesni_encrypt1(_mm_xor_si128(AESNI_LOAD(pt), chain), k, skey->Nr);
+        AESNI_STORE(ct, chain);
+    }
+    AESNI_STORE(iv, chain);
+}
+
+static void AESNI_TARGET aesni_cbc_decrypt(const unsigned char *ct, unsigned char *pt, unsigned long blocks,
+                                           unsigned char *iv, const aes_key *skey)
+{
+    __m128i k[15], b0, b1, b2, b3, c0, c1, c2, c3, chain = AESNI_LOAD(iv);
+    int r, Nr = skey->Nr;
+
+    aesni_load_keys(k, skey->ni_dK, Nr);
+
+    for (; blocks >= 4; blocks -= 4, ct += 64, pt += 64) {
+        c0 = AESNI_LOAD(ct);
+        c1 = AESNI_LOAD(ct + 16);
+        c2 = AESNI_LOAD(ct + 32);
+        c3 = AESNI_LOAD(ct + 48);
+        b0 = _mm_xor_si128(c0, k[0]);
+        b1 = _mm_xor_si128(c1, k[0]);
+        b2 = _mm_xor_si128(c2, k[0]);
+        b3 = _mm_xor_si128(c3, k[0]);
+        for (r = 1; r < Nr; r++) {
+            b0 = _mm_aesdec_si128(b0, k[r]);
+            b1 = _mm_aesdec_si128(b1, k[r]);
+            b2 = _mm_aesdec_si128(b2, k[r]);
+            b3 = _mm_aesdec_si128(b3, k[r]);
+        }
+        AESNI_STORE(pt, _mm_xor_si128(_mm_aesdeclast_si128(b0, k[Nr]), chain));
+        AESNI_STORE(pt + 16, _mm_xor_si128(_mm_aesdeclast_si128(b1, k[Nr]), c0));
+        AESNI_STORE(pt + 32, _mm_xor_si128(_mm_aesdeclast_si128(b2, k[Nr]), c1));
+        AESNI_STORE(pt + 48, _mm_xor_si128(_mm_aesdeclast_si128(b3, k[Nr]), c2));
+        chain = c3;
+    }
+
+    for (; blocks; blocks--, ct += 16, pt += 16) {
+        c0 = AESNI_LOAD(ct);
+        AESNI_STORE(pt, _mm_xor_si128(aesni_decrypt1(c0, k, Nr), chain));
+        chain = c0;
+    }
+    AESNI_STORE(iv, chain);
+}
+
+#endif /* __i386__ || __x86_64__ */
+
 static ulong32 setup_mix(ulong32 temp)
 {
    return (Te4_3[byte(temp, 2)]) ^
@@ -949,6 +1124,7 @@ int aes_setup(const unsigned char *key, int keylen, int rounds, aes_key *skey)
     }
 
     skey->Nr = 10 + ((keylen/8)-2)*2;
+    skey->ni = 0;
 
     /* setup the forward key */
     i                 = 0;
@@ -1058,6 +1234,9 @@ int aes_setup(const unsigned char *key, int keylen, int rounds, aes_key *skey)
     *rk++ = *rrk++;
     *rk   = *rrk;
 
+#if defined(__i386__) || defined(__x86_64__)
+    if (have_aesni()) aesni_setup(skey);
+#endif
     return CRYPT_OK;
 }
 
@@ -1066,6 +1245,13 @@ void aes_ecb_encrypt(const unsigned char *pt, unsigned char *ct, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#if defined(__i386__) || defined(__x86_64__)
+    if (skey->ni) {
+        aesni_ecb_encrypt(pt, ct, 1, skey);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->eK;
 
@@ -1167,6 +1353,13 @@ void aes_ecb_decrypt(const unsigned char *ct, unsigned char *pt, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#if defined(__i386__) || defined(__x86_64__)
+    if (skey->ni) {
+        aesni_ecb_decrypt(ct, pt, 1, skey);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->dK;
 
@@ -1264,3 +1457,65 @@ void aes_ecb_decrypt(const unsigned char *ct, unsigned char *pt, aes_key *skey)
         rk[3];
     STORE32H(s3, pt+12);
 }
+
+void aes_ecb_encrypt_blocks(const unsigned char *pt, unsigned char *ct, unsigned long blocks, aes_key *skey)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    if (skey->ni) {
+        aesni_ecb_encrypt(pt, ct, blocks, skey);
+        return;
+    }
+#endif
+    for (; blocks; blocks--, pt += 16, ct += 16)
+        aes_ecb_encrypt(pt, ct, skey);
+}
+
+void aes_ecb_decrypt_blocks(const unsigned char *ct, unsigned char *pt, unsigned long blocks, aes_key *skey)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    if (skey->ni) {
+        aesni_ecb_decrypt(ct, pt, blocks, skey);
+        return;
+    }
+#endif
+    for (; blocks; blocks--, ct += 16, pt += 16)
+        aes_ecb_decrypt(ct, pt, skey);
+}
+
+void aes_cbc_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long blocks, unsigned char *iv,
+                     aes_key *skey)
+{
+    int i;
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (skey->ni) {
+        aesni_cbc_encrypt(pt, ct, blocks, iv, skey);
+        return;
+    }
+#endif
+    for (; blocks; blocks--, pt += 16, ct += 16) {
+        for (i = 0; i < 16; i++) iv[i] ^= pt[i];
+        aes_ecb_encrypt(iv, ct, skey);
+        memcpy(iv, ct, 16);
+    }
+}
+
+void aes_cbc_decrypt(const unsigned char *ct, unsigned char *pt, unsigned long blocks, unsigned char *iv,
+                     aes_key *skey)
+{
+    unsigned char buf[16];
+    int i;
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (skey->ni) {
+        aesni_cbc_decrypt(ct, pt, blocks, iv, skey);
+        return;
+    }
+#endif
+    for (; blocks; blocks--, ct += 16, pt += 16) {
+        aes_ecb_decrypt(ct, buf, skey);
+        for (i = 0; i < 16; i++) buf[i] ^= iv[i];
+        memcpy(iv, ct, 16);
+        memcpy(pt, buf, 16);
+    }
+}
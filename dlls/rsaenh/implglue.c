@@ -297,6 +297,40 @@ BOOL encrypt_block_impl(ALG_ID aiAlgid, DWORD dwKeySpec, KEY_CONTEXT *pKeyContex
     return TRUE;
 }
 
+DWORD encrypt_blocks_impl(ALG_ID aiAlgid, DWORD dwMode, KEY_CONTEXT *pKeyContext, BYTE *pbChainVector,
+                          BYTE *pbInOut, DWORD dwLen, DWORD enc)
+{
+    unsigned long blocks;
+
+    switch (aiAlgid) {
+        case CALG_AES:
+        case CALG_AES_128:
+        case CALG_AES_192:
+        case CALG_AES_256:
+            blocks = dwLen / 16;
+            switch (dwMode) {
+                case CRYPT_MODE_ECB:
+                    if (enc) {
+                        aes_ecb_encrypt_blocks(pbInOut, pbInOut, blocks, &pKeyContext->aes);
+                    } else {
+                        aes_ecb_decrypt_blocks(pbInOut, pbInOut, blocks, &pKeyContext->aes);
+                    }
+                    return blocks * 16;
+
+                case CRYPT_MODE_CBC:
+                    if (enc) {
+                        aes_cbc_encrypt(pbInOut, pbInOut, blocks, pbChainVector, &pKeyContext->aes);
+                    } else {
+                        aes_cbc_decrypt(pbInOut, pbInOut, blocks, pbChainVector, &pKeyContext->aes);
+                    }
+                    return blocks * 16;
+            }
+            break;
+    }
+
+    return 0;
+}
+
 BOOL encrypt_stream_impl(ALG_ID aiAlgid, KEY_CONTEXT *pKeyContext, BYTE *stream, DWORD dwLen)
 {
     switch (aiAlgid) {
@@ -2529,7 +2529,9 @@ BOOL WINAPI RSAENH_CPEncrypt(HCRYPTPROV hProv, HCRYPTKEY hKey, HCRYPTHASH hHash,
         for (i=*pdwDataLen; i<dwEncryptedLen; i++) pbData[i] = dwEncryptedLen - *pdwDataLen;
         *pdwDataLen = dwEncryptedLen;
 
-        for (i=0, in=pbData; i<*pdwDataLen; i+=pCryptKey->dwBlockLen, in+=pCryptKey->dwBlockLen) {
+        i = encrypt_blocks_impl(pCryptKey->aiAlgid, pCryptKey->dwMode, &pCryptKey->context,
+                                pCryptKey->abChainVector, pbData, *pdwDataLen, RSAENH_ENCRYPT);
+        for (in=pbData+i; i<*pdwDataLen; i+=pCryptKey->dwBlockLen, in+=pCryptKey->dwBlockLen) {
             switch (pCryptKey->dwMode) {
                 case CRYPT_MODE_ECB:
                     encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, in, out, 
@@ -2658,7 +2660,9 @@ BOOL WINAPI RSAENH_CPDecrypt(HCRYPTPROV hProv, HCRYPTKEY hKey, HCRYPTHASH hHash,
     dwMax=*pdwDataLen;
 
     if (GET_ALG_TYPE(pCryptKey->aiAlgid) == ALG_TYPE_BLOCK) {
-        for (i=0, in=pbData; i<*pdwDataLen; i+=pCryptKey->dwBlockLen, in+=pCryptKey->dwBlockLen) {
+        i = encrypt_blocks_impl(pCryptKey->aiAlgid, pCryptKey->dwMode, &pCryptKey->context,
+                                pCryptKey->abChainVector, pbData, *pdwDataLen, RSAENH_DECRYPT);
+        for (in=pbData+i; i<*pdwDataLen; i+=pCryptKey->dwBlockLen, in+=pCryptKey->dwBlockLen) {
             switch (pCryptKey->dwMode) {
                 case CRYPT_MODE_ECB:
                     encrypt_block_impl(pCryptKey->aiAlgid, 0, &pCryptKey->context, in, out, 
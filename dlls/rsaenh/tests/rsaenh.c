@@ -1252,6 +1252,124 @@ static void test_aes(int keylen)
     ok(result, "%08x\n", GetLastError());
 }
 
+static void test_aes_blocks(void)
+{
+    static const BYTE key128[16] =
+    {
+        0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+    };
+    static const BYTE key256[32] =
+    {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+    static const BYTE iv[16] =
+    {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+    };
+    static const BYTE ecb128[96] =
+    {
+        0x50, 0xfe, 0x67, 0xcc, 0x99, 0x6d, 0x32, 0xb6, 0xda, 0x09, 0x37, 0xe9, 0x9b, 0xaf, 0xec, 0x60,
+        0xc8, 0x4a, 0xf0, 0xb6, 0x13, 0x43, 0x5d, 0x5d, 0x91, 0x82, 0x80, 0x1a, 0x9b, 0xd9, 0x32, 0x0b,
+        0x25, 0xf3, 0x3f, 0x02, 0x3d, 0x8e, 0x72, 0x4c, 0x67, 0x50, 0x44, 0xe8, 0x0b, 0x19, 0x34, 0x98,
+        0x5c, 0xe9, 0x9c, 0xa0, 0x2f, 0x4e, 0x97, 0x33, 0xf1, 0x93, 0xbf, 0x28, 0x00, 0x0b, 0xd4, 0x4c,
+        0x57, 0x60, 0x76, 0xa2, 0xe3, 0x95, 0x0d, 0x73, 0xf8, 0xe9, 0xbf, 0x79, 0x4a, 0x7b, 0x5d, 0x95,
+        0xc3, 0x4a, 0xb8, 0x82, 0x08, 0x8b, 0x53, 0x93, 0xda, 0xa9, 0xa6, 0x61, 0xd6, 0x90, 0x34, 0x36
+    };
+    static const BYTE cbc128[96] =
+    {
+        0x7d, 0xf7, 0x6b, 0x0c, 0x1a, 0xb8, 0x99, 0xb3, 0x3e, 0x42, 0xf0, 0x47, 0xb9, 0x1b, 0x54, 0x6f,
+        0x1c, 0xaa, 0x80, 0x18, 0xc8, 0x0b, 0x15, 0xb8, 0xe7, 0xae, 0xa8, 0x27, 0x94, 0xad, 0xcb, 0x00,
+        0xbb, 0xc1, 0xe2, 0x95, 0x91, 0x0b, 0x9d, 0xe4, 0xf1, 0x35, 0x8d, 0xcb, 0x42, 0x13, 0xbd, 0xd8,
+        0xee, 0xfa, 0x31, 0x54, 0x21, 0x5f, 0x47, 0x09, 0xaf, 0x46, 0x57, 0x3f, 0xc8, 0xcb, 0x07, 0xb9,
+        0x86, 0x0d, 0xc1, 0xdd, 0x67, 0xdd, 0xfd, 0x95, 0x2b, 0x41, 0xe3, 0xaa, 0x0c, 0xc4, 0x7a, 0x96,
+        0x48, 0x73, 0x85, 0x34, 0xd3, 0x7e, 0x5e, 0x29, 0xae, 0x21, 0x35, 0xaf, 0x75, 0x32, 0xe4, 0x1c
+    };
+    static const BYTE ecb256[96] =
+    {
+        0xb7, 0xbf, 0x3a, 0x5d, 0xf4, 0x39, 0x89, 0xdd, 0x97, 0xf0, 0xfa, 0x97, 0xeb, 0xce, 0x2f, 0x4a,
+        0x7e, 0x92, 0x48, 0xe5, 0xd8, 0x29, 0xca, 0x75, 0x93, 0xf0, 0xc5, 0x49, 0xdb, 0x2f, 0x5b, 0x8c,
+        0x1a, 0x60, 0x7c, 0x95, 0xe3, 0x45, 0x6b, 0xf4, 0xab, 0x9e, 0x64, 0xbf, 0x5c, 0xaf, 0x30, 0xd2,
+        0xa3, 0x7f, 0x59, 0x7d, 0x1c, 0x79, 0xa5, 0xc1, 0x33, 0x12, 0xcd, 0x6c, 0x9b, 0x70, 0x19, 0x1d,
+        0xfe, 0xe9, 0x88, 0x12, 0xda, 0xc7, 0x49, 0x50, 0x01, 0x5c, 0x2d, 0x35, 0x5f, 0xf1, 0x12, 0x72,
+        0x5c, 0x04, 0x75, 0x96, 0xc9, 0xda, 0x44, 0xc8, 0xb9, 0xbb, 0xab, 0x11, 0x55, 0xb5, 0xd3, 0x7b
+    };
+    static const BYTE cbc256[96] =
+    {
+        0xe5, 0x68, 0xf6, 0x81, 0x94, 0xcf, 0x76, 0xd6, 0x17, 0x4d, 0x4c, 0xc0, 0x43, 0x10, 0xa8, 0x54,
+        0xd0, 0x9e, 0xf9, 0x32, 0xb9, 0xff, 0x12, 0x44, 0xec, 0x7a, 0x1d, 0xc1, 0xcc, 0xb1, 0xc6, 0x37,
+        0x57, 0x3b, 0xd2, 0x9f, 0xbd, 0x6f, 0xb3, 0x17, 0x98, 0x97, 0xaa, 0x76, 0xa7, 0x0b, 0x55, 0x19,
+        0x28, 0x4f, 0x13, 0x39, 0xbe, 0xc2, 0x00, 0x4d, 0xf1, 0xc5, 0x1b, 0x33, 0xb5, 0x6d, 0x39, 0xb4,
+        0xbd, 0xef, 0x8d, 0x50, 0x88, 0x1d, 0x97, 0x79, 0x14, 0xe6, 0xc5, 0x7d, 0xd4, 0xc8, 0xc3, 0x41,
+        0x67, 0xd3, 0xc1, 0xc6, 0x9c, 0xc0, 0xcd, 0x1b, 0xc7, 0xda, 0xdf, 0x9a, 0x45, 0xac, 0xcc, 0x6d
+    };
+    static const struct
+    {
+        ALG_ID alg;
+        const BYTE *key;
+        DWORD key_len;
+        DWORD mode;
+        const BYTE *expect;
+    }
+    tests[] =
+    {
+        { CALG_AES_128, key128, sizeof(key128), CRYPT_MODE_ECB, ecb128 },
+        { CALG_AES_128, key128, sizeof(key128), CRYPT_MODE_CBC, cbc128 },
+        { CALG_AES_256, key256, sizeof(key256), CRYPT_MODE_ECB, ecb256 },
+        { CALG_AES_256, key256, sizeof(key256), CRYPT_MODE_CBC, cbc256 },
+    };
+    BYTE blob[sizeof(BLOBHEADER) + sizeof(DWORD) + 32], plain[96], data[96];
+    BLOBHEADER *header = (BLOBHEADER *)blob;
+    DWORD *key_len = (DWORD *)(header + 1);
+    HCRYPTKEY key;
+    BOOL result;
+    DWORD len;
+    int i;
+
+    for (i = 0; i < sizeof(plain); i++) plain[i] = i;
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        header->bType = PLAINTEXTKEYBLOB;
+        header->bVersion = CUR_BLOB_VERSION;
+        header->reserved = 0;
+        header->aiKeyAlg = tests[i].alg;
+        *key_len = tests[i].key_len;
+        memcpy(key_len + 1, tests[i].key, tests[i].key_len);
+        result = CryptImportKey(hProv, blob, sizeof(BLOBHEADER) + sizeof(DWORD) + tests[i].key_len, 0, 0, &key);
+        ok(result, "%d: CryptImportKey failed: %08x\n", i, GetLastError());
+        if (!result) continue;
+
+        result = CryptSetKeyParam(key, KP_MODE, (BYTE *)&tests[i].mode, 0);
+        ok(result, "%d: CryptSetKeyParam failed: %08x\n", i, GetLastError());
+        result = CryptSetKeyParam(key, KP_IV, (BYTE *)iv, 0);
+        ok(result, "%d: CryptSetKeyParam failed: %08x\n", i, GetLastError());
+
+        /* six blocks without padding, more than one batch of the multi-block code */
+        memcpy(data, plain, sizeof(data));
+        len = sizeof(data);
+        result = CryptEncrypt(key, 0, FALSE, 0, data, &len, sizeof(data));
+        ok(result, "%d: CryptEncrypt failed: %08x\n", i, GetLastError());
+        ok(len == sizeof(data), "%d: got length %u\n", i, len);
+        ok(!memcmp(data, tests[i].expect, sizeof(data)), "%d: wrong encrypted data\n", i);
+
+        /* decrypt in two parts, the chaining has to carry over between the calls */
+        result = CryptSetKeyParam(key, KP_IV, (BYTE *)iv, 0);
+        ok(result, "%d: CryptSetKeyParam failed: %08x\n", i, GetLastError());
+        len = 80;
+        result = CryptDecrypt(key, 0, FALSE, 0, data, &len);
+        ok(result, "%d: CryptDecrypt failed: %08x\n", i, GetLastError());
+        ok(len == 80, "%d: got length %u\n", i, len);
+        len = 16;
+        result = CryptDecrypt(key, 0, FALSE, 0, data + 80, &len);
+        ok(result, "%d: CryptDecrypt failed: %08x\n", i, GetLastError());
+        ok(len == 16, "%d: got length %u\n", i, len);
+        ok(!memcmp(data, plain, sizeof(data)), "%d: wrong decrypted data\n", i);
+
+        CryptDestroyKey(key);
+    }
+}
+
 static void test_sha2(void)
 {
     static const unsigned char sha256hash[32] = {
@@ -3978,6 +4096,7 @@ START_TEST(rsaenh)
     test_aes(128);
     test_aes(192);
     test_aes(256);
+    test_aes_blocks();
     test_sha2();
     test_key_derivation("AES");
     clean_up_aes_environment();
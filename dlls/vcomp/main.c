@@ -44,6 +44,7 @@ static HMODULE vcomp_module;
 static int     vcomp_max_threads;
 static int     vcomp_num_threads;
 static int     vcomp_num_procs;
+static int     vcomp_spin_count = 20000;
 static BOOL    vcomp_nested_fork = FALSE;
 
 static RTL_CRITICAL_SECTION vcomp_section;
@@ -98,7 +99,7 @@ struct vcomp_team_data
 
     /* barrier */
     unsigned int            barrier;
-    int                     barrier_count;
+    LONG                    barrier_count;
 };
 
 struct vcomp_task_data
@@ -113,6 +114,7 @@ struct vcomp_task_data
 
     /* dynamic */
     unsigned int            dynamic;
+    LONG64                  dynamic_state;  /* dynamic << 32 | remaining iterations */
     unsigned int            dynamic_first;
     unsigned int            dynamic_last;
     unsigned int            dynamic_iterations;
@@ -411,6 +413,7 @@ static struct vcomp_thread_data *vcomp_init_thread_data(void)
     data->task.single           = 0;
     data->task.section          = 0;
     data->task.dynamic          = 0;
+    data->task.dynamic_state    = 0;
 
     thread_data = &data->thread;
     thread_data->team           = NULL;
@@ -427,6 +430,19 @@ static struct vcomp_thread_data *vcomp_init_thread_data(void)
     return thread_data;
 }
 
+/* spin for a while until the value changes, returns FALSE if it didn't */
+static BOOL vcomp_spin_wait(const volatile unsigned int *ptr, unsigned int value)
+{
+    int i;
+
+    for (i = 0; i < vcomp_spin_count; i++)
+    {
+        if (*ptr != value) return TRUE;
+        YieldProcessor();
+    }
+    return *ptr != value;
+}
+
 static void vcomp_free_thread_data(void)
 {
     struct vcomp_thread_data *thread_data = vcomp_get_thread_data();
@@ -1057,26 +1073,28 @@ void CDECL _vcomp_flush(void)
 void CDECL _vcomp_barrier(void)
 {
     struct vcomp_team_data *team_data = vcomp_init_thread_data()->team;
+    unsigned int barrier;
 
     TRACE("()\n");
 
     if (!team_data)
         return;
 
-    EnterCriticalSection(&vcomp_section);
-    if (++team_data->barrier_count >= team_data->num_threads)
+    /* the generation can't change before this thread has arrived */
+    barrier = team_data->barrier;
+    if (InterlockedIncrement(&team_data->barrier_count) >= team_data->num_threads)
     {
-        team_data->barrier++;
         team_data->barrier_count = 0;
-        WakeAllConditionVariable(&team_data->cond);
-    }
-    else
-    {
-        unsigned int barrier = team_data->barrier;
-        while (team_data->barrier == barrier)
-            SleepConditionVariableCS(&team_data->cond, &vcomp_section, INFINITE);
+        InterlockedIncrement((LONG *)&team_data->barrier);
+        RtlWakeAddressAll(&team_data->barrier);
+        return;
     }
-    LeaveCriticalSection(&vcomp_section);
+
+    if (vcomp_spin_wait(&team_data->barrier, barrier))
+        return;
+
+    while (team_data->barrier == barrier)
+        RtlWaitOnAddress(&team_data->barrier, &barrier, sizeof(barrier), NULL);
 }
 
 void CDECL _vcomp_set_num_threads(int num_threads)
@@ -1287,6 +1305,14 @@ void CDECL _vcomp_for_static_end(void)
     /* nothing to do here */
 }
 
+static void set_dynamic_state(LONG64 *dest, LONG64 state)
+{
+    LONG64 prev, cur = *dest;
+
+    while ((prev = InterlockedCompareExchange64(dest, state, cur)) != cur)
+        cur = prev;
+}
+
 void CDECL _vcomp_for_dynamic_init(unsigned int flags, unsigned int first, unsigned int last,
                                    int step, unsigned int chunksize)
 {
@@ -1347,12 +1373,17 @@ void CDECL _vcomp_for_dynamic_init(unsigned int flags, unsigned int first, unsig
         thread_data->dynamic_type = type;
         if ((int)(thread_data->dynamic - task_data->dynamic) > 0)
         {
+            /* invalidate the previous loop first, so that threads still
+             * grabbing chunks from it never see a mix of both loops */
+            set_dynamic_state(&task_data->dynamic_state, (LONG64)((ULONG64)thread_data->dynamic << 32));
             task_data->dynamic              = thread_data->dynamic;
             task_data->dynamic_first        = first;
             task_data->dynamic_last         = last;
             task_data->dynamic_iterations   = iterations;
             task_data->dynamic_step         = step;
             task_data->dynamic_chunksize    = chunksize;
+            set_dynamic_state(&task_data->dynamic_state,
+                                  (LONG64)(((ULONG64)thread_data->dynamic << 32) | iterations));
         }
         LeaveCriticalSection(&vcomp_section);
     }
@@ -1377,26 +1408,43 @@ int CDECL _vcomp_for_dynamic_next(unsigned int *begin, unsigned int *end)
     else if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_CHUNKED ||
              thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED)
     {
-        unsigned int iterations = 0;
-        EnterCriticalSection(&vcomp_section);
-        if (thread_data->dynamic == task_data->dynamic &&
-            task_data->dynamic_iterations != 0)
+        unsigned int iterations, remaining, first, last, total, chunksize;
+        LONG64 state, prev;
+        int step;
+
+        /* grab a chunk without taking the lock, the loop parameters are
+         * stable as long as the state still belongs to our loop */
+        state = InterlockedCompareExchange64(&task_data->dynamic_state, 0, 0);
+        for (;;)
         {
-            iterations = min(task_data->dynamic_iterations, task_data->dynamic_chunksize);
+            remaining = (unsigned int)state;
+            if ((unsigned int)((ULONG64)state >> 32) != thread_data->dynamic || !remaining)
+                return 0;
+
+            first     = task_data->dynamic_first;
+            last      = task_data->dynamic_last;
+            total     = task_data->dynamic_iterations;
+            step      = task_data->dynamic_step;
+            chunksize = task_data->dynamic_chunksize;
+
+            iterations = min(remaining, chunksize);
             if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED &&
-                task_data->dynamic_iterations > num_threads * task_data->dynamic_chunksize)
+                remaining > num_threads * chunksize)
             {
-                iterations = (task_data->dynamic_iterations + num_threads - 1) / num_threads;
+                iterations = (remaining + num_threads - 1) / num_threads;
             }
-            *begin = task_data->dynamic_first;
-            *end   = task_data->dynamic_first + (iterations - 1) * task_data->dynamic_step;
-            task_data->dynamic_iterations -= iterations;
-            task_data->dynamic_first      += iterations * task_data->dynamic_step;
-            if (!task_data->dynamic_iterations)
-                *end = task_data->dynamic_last;
+            if (!iterations) return 0;
+
+            prev = InterlockedCompareExchange64(&task_data->dynamic_state, state - iterations, state);
+            if (prev == state) break;
+            state = prev;
         }
-        LeaveCriticalSection(&vcomp_section);
-        return iterations != 0;
+
+        *begin = first + (total - remaining) * step;
+        *end   = *begin + (iterations - 1) * step;
+        if (iterations == remaining)
+            *end = last;
+        return 1;
     }
 
     return 0;
@@ -1432,6 +1480,18 @@ static DWORD WINAPI _vcomp_fork_worker(void *param)
                 WakeAllConditionVariable(&team->cond);
         }
 
+        /* stay around for a while, the next parallel region often follows closely */
+        if (vcomp_spin_count)
+        {
+            int i;
+
+            LeaveCriticalSection(&vcomp_section);
+            for (i = 0; i < vcomp_spin_count && !*(struct vcomp_team_data * volatile *)&thread_data->team; i++)
+                YieldProcessor();
+            EnterCriticalSection(&vcomp_section);
+            if (thread_data->team) continue;
+        }
+
         if (!SleepConditionVariableCS(&thread_data->cond, &vcomp_section, 5000) &&
             GetLastError() == ERROR_TIMEOUT && !thread_data->team)
         {
@@ -1481,6 +1541,7 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
     task_data.single            = 0;
     task_data.section           = 0;
     task_data.dynamic           = 0;
+    task_data.dynamic_state     = 0;
 
     thread_data.team            = &team_data;
     thread_data.task            = &task_data;
@@ -1562,6 +1623,14 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
 
     if (team_data.num_threads > 1)
     {
+        int i;
+
+        for (i = 0; i < vcomp_spin_count; i++)
+        {
+            if (*(volatile int *)&team_data.finished_threads >= team_data.num_threads - 1) break;
+            YieldProcessor();
+        }
+
         EnterCriticalSection(&vcomp_section);
 
         team_data.finished_threads++;
@@ -1833,6 +1902,7 @@ BOOL WINAPI DllMain(HINSTANCE instance, DWORD reason, LPVOID reserved)
         case DLL_PROCESS_ATTACH:
         {
             SYSTEM_INFO sysinfo;
+            char buffer[16];
 
             if ((vcomp_context_tls = TlsAlloc()) == TLS_OUT_OF_INDEXES)
             {
@@ -1840,6 +1910,11 @@ BOOL WINAPI DllMain(HINSTANCE instance, DWORD reason, LPVOID reserved)
                 return FALSE;
             }
 
+            /* OMP_WAIT_POLICY=passive makes waiting threads block right away */
+            if (GetEnvironmentVariableA("OMP_WAIT_POLICY", buffer, sizeof(buffer)) &&
+                !lstrcmpiA(buffer, "passive"))
+                vcomp_spin_count = 0;
+
             GetSystemInfo(&sysinfo);
             vcomp_module      = instance;
             vcomp_max_threads = sysinfo.dwNumberOfProcessors;
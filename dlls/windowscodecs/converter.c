@@ -22,6 +22,10 @@
 
 #define COBJMACROS
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
+
 #include "windef.h"
 #include "winbase.h"
 #include "objbase.h"
@@ -33,6 +37,14 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+#if defined(__i386__) || defined(__x86_64__)
+#ifdef __x86_64__
+#define SSE2_TARGET
+#else
+#define SSE2_TARGET __attribute__((target("sse2")))
+#endif
+#endif
+
 struct FormatConverter;
 
 enum pixelformat {
@@ -71,11 +83,21 @@ struct pixelformatinfo {
     copyfunc copy_function;
 };
 
+typedef void (*convert_row_func)(const BYTE *src, BYTE *dst, UINT width);
+
+/* direct conversion between two formats, one row at a time */
+struct conversion {
+    enum pixelformat src_format, dst_format;
+    UINT src_bpp, dst_bpp;
+    convert_row_func convert_row;
+};
+
 typedef struct FormatConverter {
     IWICFormatConverter IWICFormatConverter_iface;
     LONG ref;
     IWICBitmapSource *source;
     const struct pixelformatinfo *dst_format, *src_format;
+    const struct conversion *conversion;
     WICBitmapDitherType dither;
     double alpha_threshold;
     IWICPalette *palette;
@@ -131,6 +153,262 @@ static void to_sRGB(BYTE *bgr)
 }
 #endif
 
+/* Conversions to 8-bit sRGB only depend on the float value through a
+ * monotonic function, so they can be done by looking up the value in the
+ * table of the smallest inputs giving each output byte. */
+static float srgb_thresholds[256];
+static BYTE srgb_buckets[1025];
+
+static inline BYTE to_sRGB_byte(float f)
+{
+    return (BYTE)floorf(to_sRGB_component(f) * 255.0f + 0.51f);
+}
+
+static BOOL WINAPI init_srgb_tables(INIT_ONCE *once, void *param, void **context)
+{
+    UINT i, b, lo, hi, mid;
+    float f;
+
+    /* binary search on the bit patterns of the floats between 0.0 and 1.0 */
+    for (b = 1; b < 256; b++)
+    {
+        lo = 0;
+        hi = 0x3f800001;
+        while (lo < hi)
+        {
+            mid = lo + (hi - lo) / 2;
+            memcpy(&f, &mid, sizeof(f));
+            if (to_sRGB_byte(f) >= b) hi = mid;
+            else lo = mid + 1;
+        }
+        memcpy(&srgb_thresholds[b], &lo, sizeof(float));
+    }
+
+    for (i = 0, b = 0; i < ARRAY_SIZE(srgb_buckets); i++)
+    {
+        f = i / 1024.0f;
+        while (b < 255 && srgb_thresholds[b + 1] <= f) b++;
+        srgb_buckets[i] = b;
+    }
+    return TRUE;
+}
+
+static inline BYTE lookup_sRGB_byte(float f)
+{
+    BYTE b;
+
+    if (!(f >= 0.0f && f <= 1.0f)) return to_sRGB_byte(f);
+
+    b = srgb_buckets[(UINT)(f * 1024.0f)];
+    while (b < 255 && srgb_thresholds[b + 1] <= f) b++;
+    return b;
+}
+
+static void init_srgb(void)
+{
+    static INIT_ONCE init_once = INIT_ONCE_STATIC_INIT;
+
+    InitOnceExecuteOnce(&init_once, init_srgb_tables, NULL, NULL);
+}
+
+/* unpremultiplied values, indexed by alpha and premultiplied value */
+static BYTE *unpremultiply_table;
+
+static BOOL WINAPI init_unpremultiply_table(INIT_ONCE *once, void *param, void **context)
+{
+    UINT a, x;
+
+    if (!(unpremultiply_table = HeapAlloc(GetProcessHeap(), 0, 256 * 256))) return FALSE;
+
+    for (a = 0; a < 256; a++)
+        for (x = 0; x < 256; x++)
+            unpremultiply_table[a * 256 + x] = (a == 0 || a == 255) ? x : x * 255 / a;
+    return TRUE;
+}
+
+static void convert_bgr24_to_bgra32(const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    DWORD s0, s1, s2;
+    UINT x = 0;
+
+    /* four pixels at a time from three aligned dwords */
+    for (; x + 4 <= width; x += 4, src += 12)
+    {
+        memcpy(&s0, src, 4);
+        memcpy(&s1, src + 4, 4);
+        memcpy(&s2, src + 8, 4);
+        *dstpixel++ = 0xff000000 | s0;
+        *dstpixel++ = 0xff000000 | (s0 >> 24) | (s1 << 8);
+        *dstpixel++ = 0xff000000 | (s1 >> 16) | (s2 << 16);
+        *dstpixel++ = 0xff000000 | (s2 >> 8);
+    }
+    for (; x < width; x++, src += 3)
+        *dstpixel++ = 0xff000000 | (src[2] << 16) | (src[1] << 8) | src[0];
+}
+
+static void convert_bgra32_to_bgr24(const BYTE *src, BYTE *dst, UINT width)
+{
+    const DWORD *srcpixel = (const DWORD *)src;
+    DWORD d0, d1, d2;
+    UINT x = 0;
+
+    for (; x + 4 <= width; x += 4, srcpixel += 4, dst += 12)
+    {
+        d0 = (srcpixel[0] & 0xffffff) | (srcpixel[1] << 24);
+        d1 = ((srcpixel[1] >> 8) & 0xffff) | (srcpixel[2] << 16);
+        d2 = ((srcpixel[2] >> 16) & 0xff) | (srcpixel[3] << 8);
+        memcpy(dst, &d0, 4);
+        memcpy(dst + 4, &d1, 4);
+        memcpy(dst + 8, &d2, 4);
+    }
+    for (; x < width; x++, srcpixel++, dst += 3)
+    {
+        dst[0] = *srcpixel;
+        dst[1] = *srcpixel >> 8;
+        dst[2] = *srcpixel >> 16;
+    }
+}
+
+static void convert_bgrx32_to_bgra32(const BYTE *src, BYTE *dst, UINT width)
+{
+    const DWORD *srcpixel = (const DWORD *)src;
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++) dstpixel[x] = srcpixel[x] | 0xff000000;
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+/* returns the number of pixels converted, the caller converts the rest */
+static UINT SSE2_TARGET convert_gray8_to_bgra32_sse2(const BYTE *src, DWORD *dstpixel, UINT width)
+{
+    const __m128i alpha = _mm_set1_epi32(0xff000000);
+    __m128i gray, gray2;
+    UINT x;
+
+    for (x = 0; x + 16 <= width; x += 16)
+    {
+        gray = _mm_loadu_si128((const __m128i *)(src + x));
+        gray2 = _mm_unpacklo_epi8(gray, gray);
+        _mm_storeu_si128((__m128i *)(dstpixel + x), _mm_or_si128(_mm_unpacklo_epi16(gray2, gray2), alpha));
+        _mm_storeu_si128((__m128i *)(dstpixel + x + 4), _mm_or_si128(_mm_unpackhi_epi16(gray2, gray2), alpha));
+        gray2 = _mm_unpackhi_epi8(gray, gray);
+        _mm_storeu_si128((__m128i *)(dstpixel + x + 8), _mm_or_si128(_mm_unpacklo_epi16(gray2, gray2), alpha));
+        _mm_storeu_si128((__m128i *)(dstpixel + x + 12), _mm_or_si128(_mm_unpackhi_epi16(gray2, gray2), alpha));
+    }
+    return x;
+}
+#endif
+
+static void convert_gray8_to_bgra32(const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x = 0;
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (sse2_supported) x = convert_gray8_to_bgra32_sse2(src, dstpixel, width);
+#endif
+    for (; x < width; x++) dstpixel[x] = 0xff000000 | (src[x] * 0x010101);
+}
+
+static void convert_gray8_to_bgr24(const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, dst += 3) dst[0] = dst[1] = dst[2] = src[x];
+}
+
+static inline void convert_bgr_to_gray8(const BYTE *src, BYTE *dst, UINT width, UINT bytesperpixel)
+{
+    float gray;
+    UINT x;
+
+    init_srgb();
+
+    for (x = 0; x < width; x++, src += bytesperpixel)
+    {
+        gray = (src[2] * 0.2126f + src[1] * 0.7152f + src[0] * 0.0722f) / 255.0f;
+        dst[x] = lookup_sRGB_byte(gray);
+    }
+}
+
+static void convert_bgr24_to_gray8(const BYTE *src, BYTE *dst, UINT width)
+{
+    convert_bgr_to_gray8(src, dst, width, 3);
+}
+
+static void convert_bgra32_to_gray8(const BYTE *src, BYTE *dst, UINT width)
+{
+    convert_bgr_to_gray8(src, dst, width, 4);
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+/* x * alpha / 255, rounded down as (t + 1 + (t >> 8)) >> 8 which is exact for 16-bit products */
+static UINT SSE2_TARGET convert_bgra32_to_pbgra32_sse2(const DWORD *srcpixel, DWORD *dstpixel, UINT width)
+{
+    const __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi16(1);
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+    __m128i pixels, lo, hi, a;
+    UINT x;
+
+    for (x = 0; x + 4 <= width; x += 4)
+    {
+        pixels = _mm_loadu_si128((const __m128i *)(srcpixel + x));
+
+        lo = _mm_unpacklo_epi8(pixels, zero);
+        a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xff), 0xff);
+        lo = _mm_mullo_epi16(lo, a);
+        lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+
+        hi = _mm_unpackhi_epi8(pixels, zero);
+        a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xff), 0xff);
+        hi = _mm_mullo_epi16(hi, a);
+        hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+
+        pixels = _mm_or_si128(_mm_andnot_si128(alpha_mask, _mm_packus_epi16(lo, hi)),
+                              _mm_and_si128(alpha_mask, pixels));
+        _mm_storeu_si128((__m128i *)(dstpixel + x), pixels);
+    }
+    return x;
+}
+#endif
+
+static void convert_bgra32_to_pbgra32(const BYTE *src, BYTE *dst, UINT width)
+{
+    const DWORD *srcpixel = (const DWORD *)src;
+    DWORD *dstpixel = (DWORD *)dst;
+    DWORD alpha;
+    UINT x = 0;
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (sse2_supported) x = convert_bgra32_to_pbgra32_sse2(srcpixel, dstpixel, width);
+#endif
+    for (; x < width; x++)
+    {
+        alpha = srcpixel[x] >> 24;
+        dstpixel[x] = (srcpixel[x] & 0xff000000) |
+                      (((srcpixel[x] >> 16) & 0xff) * alpha / 255) << 16 |
+                      (((srcpixel[x] >> 8) & 0xff) * alpha / 255) << 8 |
+                      ((srcpixel[x] & 0xff) * alpha / 255);
+    }
+}
+
+static void convert_pbgra32_to_bgra32(const BYTE *src, BYTE *dst, UINT width)
+{
+    const BYTE *table;
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 4, dst += 4)
+    {
+        table = unpremultiply_table + src[3] * 256;
+        dst[0] = table[src[0]];
+        dst[1] = table[src[1]];
+        dst[2] = table[src[2]];
+        dst[3] = src[3];
+    }
+}
+
 static inline FormatConverter *impl_from_IWICFormatConverter(IWICFormatConverter *iface)
 {
     return CONTAINING_RECORD(iface, FormatConverter, IWICFormatConverter_iface);
@@ -1130,6 +1408,8 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
                 INT x, y;
                 BYTE *src = srcdata, *dst = pbBuffer;
 
+                init_srgb();
+
                 for (y = 0; y < prc->Height; y++)
                 {
                     float *gray_float = (float *)src;
@@ -1137,7 +1417,7 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
 
                     for (x = 0; x < prc->Width; x++)
                     {
-                        BYTE gray = (BYTE)floorf(to_sRGB_component(gray_float[x]) * 255.0f + 0.51f);
+                        BYTE gray = lookup_sRGB_byte(gray_float[x]);
                         *bgr++ = gray;
                         *bgr++ = gray;
                         *bgr++ = gray;
@@ -1350,13 +1630,15 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
                 INT x, y;
                 BYTE *src = srcdata, *dst = pbBuffer;
 
+                init_srgb();
+
                 for (y=0; y < prc->Height; y++)
                 {
                     float *srcpixel = (float*)src;
                     BYTE *dstpixel = dst;
 
                     for (x=0; x < prc->Width; x++)
-                        *dstpixel++ = (BYTE)floorf(to_sRGB_component(*srcpixel++) * 255.0f + 0.51f);
+                        *dstpixel++ = lookup_sRGB_byte(*srcpixel++);
 
                     src += srcstride;
                     dst += cbStride;
@@ -1381,21 +1663,12 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
     hr = copypixels_to_24bppBGR(This, prc, srcstride, srcdatasize, srcdata, source_format);
     if (SUCCEEDED(hr))
     {
-        INT x, y;
+        INT y;
         BYTE *src = srcdata, *dst = pbBuffer;
 
         for (y = 0; y < prc->Height; y++)
         {
-            BYTE *bgr = src;
-
-            for (x = 0; x < prc->Width; x++)
-            {
-                float gray = (bgr[2] * 0.2126f + bgr[1] * 0.7152f + bgr[0] * 0.0722f) / 255.0f;
-
-                gray = to_sRGB_component(gray) * 255.0f;
-                dst[x] = (BYTE)floorf(gray + 0.51f);
-                bgr += 3;
-            }
+            convert_bgr24_to_gray8(src, dst, prc->Width);
             src += srcstride;
             dst += cbStride;
         }
@@ -1530,6 +1803,89 @@ static const struct pixelformatinfo *get_formatinfo(const WICPixelFormatGUID *fo
     return NULL;
 }
 
+static const struct conversion conversions[] = {
+    {format_24bppBGR,   format_32bppBGRA,  24, 32, convert_bgr24_to_bgra32},
+    {format_24bppBGR,   format_32bppBGR,   24, 32, convert_bgr24_to_bgra32},
+    {format_24bppBGR,   format_32bppPBGRA, 24, 32, convert_bgr24_to_bgra32},
+    {format_24bppBGR,   format_8bppGray,   24,  8, convert_bgr24_to_gray8},
+    {format_32bppBGR,   format_32bppBGRA,  32, 32, convert_bgrx32_to_bgra32},
+    {format_32bppBGR,   format_32bppPBGRA, 32, 32, convert_bgrx32_to_bgra32},
+    {format_32bppBGR,   format_24bppBGR,   32, 24, convert_bgra32_to_bgr24},
+    {format_32bppBGR,   format_8bppGray,   32,  8, convert_bgra32_to_gray8},
+    {format_32bppBGRA,  format_32bppPBGRA, 32, 32, convert_bgra32_to_pbgra32},
+    {format_32bppBGRA,  format_24bppBGR,   32, 24, convert_bgra32_to_bgr24},
+    {format_32bppBGRA,  format_8bppGray,   32,  8, convert_bgra32_to_gray8},
+    {format_32bppPBGRA, format_32bppBGRA,  32, 32, convert_pbgra32_to_bgra32},
+    {format_32bppPBGRA, format_24bppBGR,   32, 24, convert_bgra32_to_bgr24},
+    {format_32bppPBGRA, format_8bppGray,   32,  8, convert_bgra32_to_gray8},
+    {format_8bppGray,   format_32bppBGRA,   8, 32, convert_gray8_to_bgra32},
+    {format_8bppGray,   format_32bppBGR,    8, 32, convert_gray8_to_bgra32},
+    {format_8bppGray,   format_32bppPBGRA,  8, 32, convert_gray8_to_bgra32},
+    {format_8bppGray,   format_24bppBGR,    8, 24, convert_gray8_to_bgr24},
+};
+
+static const struct conversion *get_conversion(enum pixelformat src_format, enum pixelformat dst_format)
+{
+    static INIT_ONCE init_once = INIT_ONCE_STATIC_INIT;
+    UINT i;
+
+    for (i = 0; i < ARRAY_SIZE(conversions); i++)
+    {
+        if (conversions[i].src_format != src_format || conversions[i].dst_format != dst_format)
+            continue;
+        if (conversions[i].convert_row == convert_pbgra32_to_bgra32 &&
+            !InitOnceExecuteOnce(&init_once, init_unpremultiply_table, NULL, NULL))
+            return NULL;
+        return &conversions[i];
+    }
+    return NULL;
+}
+
+static HRESULT copypixels_direct(struct FormatConverter *This, const WICRect *prc,
+    UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
+{
+    const struct conversion *conversion = This->conversion;
+    UINT srcstride, srcdatasize, dststride;
+    BYTE *srcdata;
+    HRESULT hr;
+    INT y;
+
+    if (prc->Width <= 0 || prc->Height <= 0) return S_OK;
+
+    dststride = (prc->Width * conversion->dst_bpp + 7) / 8;
+    if (cbStride < dststride || cbBufferSize / cbStride < prc->Height - 1 ||
+        cbBufferSize - cbStride * (prc->Height - 1) < dststride)
+        return E_INVALIDARG;
+
+    /* same size pixels are converted in place */
+    if (conversion->src_bpp == conversion->dst_bpp)
+    {
+        hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
+        if (SUCCEEDED(hr))
+        {
+            for (y = 0; y < prc->Height; y++)
+                conversion->convert_row(pbBuffer + cbStride * y, pbBuffer + cbStride * y, prc->Width);
+        }
+        return hr;
+    }
+
+    srcstride = (prc->Width * conversion->src_bpp + 7) / 8;
+    srcdatasize = srcstride * prc->Height;
+
+    srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+    if (!srcdata) return E_OUTOFMEMORY;
+
+    hr = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+    if (SUCCEEDED(hr))
+    {
+        for (y = 0; y < prc->Height; y++)
+            conversion->convert_row(srcdata + srcstride * y, pbBuffer + cbStride * y, prc->Width);
+    }
+
+    HeapFree(GetProcessHeap(), 0, srcdata);
+    return hr;
+}
+
 static HRESULT WINAPI FormatConverter_QueryInterface(IWICFormatConverter *iface, REFIID iid,
     void **ppv)
 {
@@ -1670,6 +2026,9 @@ static HRESULT WINAPI FormatConverter_CopyPixels(IWICFormatConverter *iface,
             prc = &rc;
         }
 
+        if (This->conversion)
+            return copypixels_direct(This, prc, cbStride, cbBufferSize, pbBuffer);
+
         return This->dst_format->copy_function(This, prc, cbStride, cbBufferSize,
             pbBuffer, This->src_format->format);
     }
@@ -1760,6 +2119,7 @@ static HRESULT WINAPI FormatConverter_Initialize(IWICFormatConverter *iface,
         IWICBitmapSource_AddRef(source);
         This->src_format = srcinfo;
         This->dst_format = dstinfo;
+        This->conversion = get_conversion(srcinfo->format, dstinfo->format);
         This->dither = dither;
         This->alpha_threshold = alpha_threshold;
         This->palette = palette;
@@ -1845,6 +2205,7 @@ HRESULT FormatConverter_CreateInstance(REFIID iid, void** ppv)
     This->IWICFormatConverter_iface.lpVtbl = &FormatConverter_Vtbl;
     This->ref = 1;
     This->source = NULL;
+    This->conversion = NULL;
     This->palette = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": FormatConverter.lock");
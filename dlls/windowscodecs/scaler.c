@@ -18,6 +18,7 @@
  */
 
 #include <stdarg.h>
+#include <math.h>
 
 #define COBJMACROS
 
@@ -31,6 +32,15 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+/* contributions of the source pixels to each destination pixel along one axis */
+struct filter_axis
+{
+    UINT *start;     /* first contributing source pixel */
+    UINT *count;     /* number of contributing source pixels */
+    float *weights;  /* 'taps' weights for each destination pixel */
+    UINT taps;
+};
+
 typedef struct BitmapScaler {
     IWICBitmapScaler IWICBitmapScaler_iface;
     LONG ref;
@@ -42,6 +52,13 @@ typedef struct BitmapScaler {
     UINT bpp;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
     void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
+    BOOL filtered;
+    BOOL premultiply;    /* filter straight alpha formats with premultiplied colors */
+    struct filter_axis filter_x, filter_y;
+    float **cache_rows;  /* horizontally filtered source rows */
+    INT *cache_y;        /* source row held by each cache entry, or -1 */
+    BYTE *src_lines;     /* source rows being filtered */
+    float *accum;        /* vertical filter accumulator */
     CRITICAL_SECTION lock; /* must be held when initialized */
 } BitmapScaler;
 
@@ -55,6 +72,39 @@ static inline BitmapScaler *impl_from_IMILBitmapScaler(IMILBitmapScaler *iface)
     return CONTAINING_RECORD(iface, BitmapScaler, IMILBitmapScaler_iface);
 }
 
+static void free_filter_axis(struct filter_axis *axis)
+{
+    HeapFree(GetProcessHeap(), 0, axis->start);
+    HeapFree(GetProcessHeap(), 0, axis->count);
+    HeapFree(GetProcessHeap(), 0, axis->weights);
+}
+
+static void free_filter(BitmapScaler *This)
+{
+    UINT i;
+
+    if (This->cache_rows)
+    {
+        for (i = 0; i < This->filter_y.taps; i++)
+            HeapFree(GetProcessHeap(), 0, This->cache_rows[i]);
+        HeapFree(GetProcessHeap(), 0, This->cache_rows);
+    }
+    HeapFree(GetProcessHeap(), 0, This->cache_y);
+    HeapFree(GetProcessHeap(), 0, This->src_lines);
+    HeapFree(GetProcessHeap(), 0, This->accum);
+    free_filter_axis(&This->filter_x);
+    free_filter_axis(&This->filter_y);
+
+    This->filtered = FALSE;
+    This->premultiply = FALSE;
+    memset(&This->filter_x, 0, sizeof(This->filter_x));
+    memset(&This->filter_y, 0, sizeof(This->filter_y));
+    This->cache_rows = NULL;
+    This->cache_y = NULL;
+    This->src_lines = NULL;
+    This->accum = NULL;
+}
+
 static HRESULT WINAPI BitmapScaler_QueryInterface(IWICBitmapScaler *iface, REFIID iid,
     void **ppv)
 {
@@ -106,6 +156,7 @@ static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        free_filter(This);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -178,6 +229,283 @@ static HRESULT WINAPI BitmapScaler_CopyPalette(IWICBitmapScaler *iface,
     return IWICBitmapSource_CopyPalette(This->source, pIPalette);
 }
 
+static double filter_kernel(WICBitmapInterpolationMode mode, double x)
+{
+    x = fabs(x);
+
+    if (mode == WICBitmapInterpolationModeLinear)
+        return x < 1.0 ? 1.0 - x : 0.0;
+
+    /* Catmull-Rom spline */
+    if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
+    if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    return 0.0;
+}
+
+/* Fant and high quality cubic take every covered source pixel into account
+ * when shrinking, linear and cubic only look at the nearest ones. */
+static HRESULT init_filter_axis(struct filter_axis *axis, UINT src_len, UINT dst_len,
+    WICBitmapInterpolationMode mode)
+{
+    double scale = (double)src_len / dst_len, support = 1.0, radius, center, lo, hi, w, sum;
+    INT first, last, j;
+    UINT i, k;
+    float *weights;
+
+    if (scale > 1.0 && (mode == WICBitmapInterpolationModeFant ||
+                        mode == WICBitmapInterpolationModeHighQualityCubic))
+        support = scale;
+
+    switch (mode)
+    {
+    case WICBitmapInterpolationModeLinear: radius = 1.0; break;
+    case WICBitmapInterpolationModeFant: radius = 0.5 * support; break;
+    default: radius = 2.0 * support; break;
+    }
+
+    axis->taps = min((UINT)ceil(2.0 * radius) + 1, src_len);
+    axis->start = HeapAlloc(GetProcessHeap(), 0, dst_len * sizeof(*axis->start));
+    axis->count = HeapAlloc(GetProcessHeap(), 0, dst_len * sizeof(*axis->count));
+    axis->weights = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, dst_len * axis->taps * sizeof(*axis->weights));
+    if (!axis->start || !axis->count || !axis->weights) return E_OUTOFMEMORY;
+
+    for (i = 0; i < dst_len; i++)
+    {
+        center = (i + 0.5) * scale - 0.5;
+        weights = axis->weights + i * axis->taps;
+
+        if (mode == WICBitmapInterpolationModeFant)
+        {
+            lo = center + 0.5 - radius;
+            hi = center + 0.5 + radius;
+            first = floor(lo);
+            last = ceil(hi) - 1;
+        }
+        else
+        {
+            first = ceil(center - radius);
+            last = floor(center + radius);
+        }
+
+        axis->start[i] = min(max(first, 0), (INT)src_len - 1);
+        axis->count[i] = min(max(last, 0), (INT)src_len - 1) - axis->start[i] + 1;
+
+        for (j = first, sum = 0.0; j <= last; j++)
+        {
+            if (mode == WICBitmapInterpolationModeFant)
+                w = min(hi, j + 1.0) - max(lo, (double)j);
+            else
+                w = filter_kernel(mode, (j - center) / support);
+
+            /* pixels outside of the source repeat the edge */
+            k = min(max(j, 0), (INT)src_len - 1) - axis->start[i];
+            weights[k] += w;
+            sum += w;
+        }
+
+        if (sum != 0.0)
+            for (k = 0; k < axis->count[i]; k++) weights[k] /= sum;
+        else
+        {
+            axis->count[i] = 1;
+            weights[0] = 1.0f;
+        }
+    }
+
+    return S_OK;
+}
+
+static BOOL is_filterable_format(const WICPixelFormatGUID *format)
+{
+    static const GUID *formats[] =
+    {
+        &GUID_WICPixelFormat8bppGray,
+        &GUID_WICPixelFormat24bppBGR,
+        &GUID_WICPixelFormat24bppRGB,
+        &GUID_WICPixelFormat32bppBGR,
+        &GUID_WICPixelFormat32bppBGRA,
+        &GUID_WICPixelFormat32bppPBGRA,
+        &GUID_WICPixelFormat32bppRGB,
+        &GUID_WICPixelFormat32bppRGBA,
+        &GUID_WICPixelFormat32bppPRGBA,
+    };
+    UINT i;
+
+    for (i = 0; i < ARRAY_SIZE(formats); i++)
+        if (IsEqualGUID(format, formats[i])) return TRUE;
+    return FALSE;
+}
+
+static HRESULT init_filter(BitmapScaler *This, const WICPixelFormatGUID *format)
+{
+    UINT channels = This->bpp / 8, i;
+    HRESULT hr;
+
+    /* colors of transparent pixels must not bleed into their neighbors */
+    This->premultiply = IsEqualGUID(format, &GUID_WICPixelFormat32bppBGRA) ||
+                        IsEqualGUID(format, &GUID_WICPixelFormat32bppRGBA);
+
+    if (FAILED(hr = init_filter_axis(&This->filter_x, This->src_width, This->width, This->mode)))
+        return hr;
+    if (FAILED(hr = init_filter_axis(&This->filter_y, This->src_height, This->height, This->mode)))
+        return hr;
+
+    This->cache_rows = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, This->filter_y.taps * sizeof(*This->cache_rows));
+    This->cache_y = HeapAlloc(GetProcessHeap(), 0, This->filter_y.taps * sizeof(*This->cache_y));
+    This->src_lines = HeapAlloc(GetProcessHeap(), 0, This->filter_y.taps * This->src_width * channels);
+    This->accum = HeapAlloc(GetProcessHeap(), 0, This->width * channels * sizeof(*This->accum));
+    if (!This->cache_rows || !This->cache_y || !This->src_lines || !This->accum) return E_OUTOFMEMORY;
+
+    for (i = 0; i < This->filter_y.taps; i++)
+    {
+        This->cache_y[i] = -1;
+        if (!(This->cache_rows[i] = HeapAlloc(GetProcessHeap(), 0, This->width * channels * sizeof(float))))
+            return E_OUTOFMEMORY;
+    }
+
+    This->filtered = TRUE;
+    return S_OK;
+}
+
+/* The loops below only have the channel count as inner dimension or are
+ * flat, so that the compiler can turn them into vector code. */
+static void filter_row_horizontal(const struct filter_axis *axis, UINT channels,
+    const BYTE *src, float *dst, UINT dst_width)
+{
+    const float *weights;
+    const BYTE *pixel;
+    float sum[4];
+    UINT x, k, c;
+
+    for (x = 0; x < dst_width; x++)
+    {
+        weights = axis->weights + x * axis->taps;
+        pixel = src + axis->start[x] * channels;
+
+        for (c = 0; c < channels; c++) sum[c] = 0.0f;
+        for (k = 0; k < axis->count[x]; k++, pixel += channels)
+            for (c = 0; c < channels; c++) sum[c] += weights[k] * pixel[c];
+        for (c = 0; c < channels; c++) dst[x * channels + c] = sum[c];
+    }
+}
+
+/* same for 4 channels with straight alpha, the result has premultiplied colors */
+static void filter_row_horizontal_premultiply(const struct filter_axis *axis,
+    const BYTE *src, float *dst, UINT dst_width)
+{
+    const float *weights;
+    const BYTE *pixel;
+    float sum[4], w;
+    UINT x, k, c;
+
+    for (x = 0; x < dst_width; x++)
+    {
+        weights = axis->weights + x * axis->taps;
+        pixel = src + axis->start[x] * 4;
+
+        for (c = 0; c < 4; c++) sum[c] = 0.0f;
+        for (k = 0; k < axis->count[x]; k++, pixel += 4)
+        {
+            w = weights[k] * pixel[3];
+            for (c = 0; c < 3; c++) sum[c] += w * pixel[c];
+            sum[3] += w;
+        }
+        for (c = 0; c < 3; c++) dst[x * 4 + c] = sum[c] / 255.0f;
+        dst[x * 4 + 3] = sum[3];
+    }
+}
+
+/* make sure that the needed source rows are horizontally filtered in the cache */
+static HRESULT fill_row_cache(BitmapScaler *This, UINT first, UINT count)
+{
+    UINT channels = This->bpp / 8, stride = This->src_width * channels;
+    UINT y, end = first + count, run, i;
+    WICRect rect;
+    HRESULT hr;
+
+    for (y = first; y < end; y = run)
+    {
+        if (This->cache_y[y % This->filter_y.taps] == y)
+        {
+            run = y + 1;
+            continue;
+        }
+
+        /* read consecutive missing rows in a single call */
+        for (run = y + 1; run < end; run++)
+            if (This->cache_y[run % This->filter_y.taps] == run) break;
+
+        rect.X = 0;
+        rect.Y = y;
+        rect.Width = This->src_width;
+        rect.Height = run - y;
+        hr = IWICBitmapSource_CopyPixels(This->source, &rect, stride, stride * rect.Height, This->src_lines);
+        if (FAILED(hr)) return hr;
+
+        for (i = y; i < run; i++)
+        {
+            if (This->premultiply)
+                filter_row_horizontal_premultiply(&This->filter_x, This->src_lines + (i - y) * stride,
+                    This->cache_rows[i % This->filter_y.taps], This->width);
+            else
+                filter_row_horizontal(&This->filter_x, channels, This->src_lines + (i - y) * stride,
+                    This->cache_rows[i % This->filter_y.taps], This->width);
+            This->cache_y[i % This->filter_y.taps] = i;
+        }
+    }
+
+    return S_OK;
+}
+
+static HRESULT filter_copy_pixels(BitmapScaler *This, const WICRect *rect, UINT stride, BYTE *buffer)
+{
+    UINT channels = This->bpp / 8, offset = rect->X * channels, len = rect->Width * channels;
+    const float *weights, *row;
+    UINT y, k, i, c, start;
+    HRESULT hr;
+    float v, alpha;
+
+    for (y = rect->Y; y < rect->Y + rect->Height; y++, buffer += stride)
+    {
+        start = This->filter_y.start[y];
+        if (FAILED(hr = fill_row_cache(This, start, This->filter_y.count[y]))) return hr;
+
+        weights = This->filter_y.weights + y * This->filter_y.taps;
+        row = This->cache_rows[start % This->filter_y.taps] + offset;
+        for (i = 0; i < len; i++) This->accum[i] = weights[0] * row[i];
+
+        for (k = 1; k < This->filter_y.count[y]; k++)
+        {
+            row = This->cache_rows[(start + k) % This->filter_y.taps] + offset;
+            for (i = 0; i < len; i++) This->accum[i] += weights[k] * row[i];
+        }
+
+        if (This->premultiply)
+        {
+            for (i = 0; i < len; i += 4)
+            {
+                alpha = This->accum[i + 3];
+                for (c = 0; c < 3; c++)
+                {
+                    v = alpha >= 0.5f ? This->accum[i + c] * 255.0f / alpha + 0.5f : 0.0f;
+                    buffer[i + c] = v <= 0.0f ? 0 : v >= 255.0f ? 255 : (BYTE)v;
+                }
+                v = alpha + 0.5f;
+                buffer[i + 3] = v <= 0.0f ? 0 : v >= 255.0f ? 255 : (BYTE)v;
+            }
+            continue;
+        }
+
+        for (i = 0; i < len; i++)
+        {
+            v = This->accum[i] + 0.5f;
+            buffer[i] = v <= 0.0f ? 0 : v >= 255.0f ? 255 : (BYTE)v;
+        }
+    }
+
+    return S_OK;
+}
+
 static void NearestNeighbor_GetRequiredSourceRect(BitmapScaler *This,
     UINT x, UINT y, WICRect *src_rect)
 {
@@ -258,12 +586,16 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     }
 
     /* MSDN recommends calling CopyPixels once for each scanline from top to
-     * bottom, and claims codecs optimize for this. Ideally, when called in this
-     * way, we should avoid requesting a scanline from the source more than
-     * once, by saving the data that will be useful for the next scanline after
-     * the call returns. The GetRequiredSourceRect/CopyScanline functions are
-     * designed to make it possible to do this in a generic way, but for now we
-     * just grab all the data we need in each call. */
+     * bottom, and claims codecs optimize for this. The filtering modes keep
+     * the filtered source rows around between calls, so that each source row
+     * is only requested once when called in this way. The nearest neighbor
+     * mode just grabs all the data it needs in each call. */
+
+    if (This->filtered)
+    {
+        hr = filter_copy_pixels(This, &dest_rect, cbStride, pbBuffer);
+        goto end;
+    }
 
     This->fn_get_required_source_rect(This, dest_rect.X, dest_rect.Y, &src_rect_ul);
     This->fn_get_required_source_rect(This, dest_rect.X+dest_rect.Width-1,
@@ -312,6 +644,25 @@ end:
     return hr;
 }
 
+static HRESULT init_nearest_neighbor(BitmapScaler *This, IWICBitmapSource *source)
+{
+    HRESULT hr = S_OK;
+
+    if ((This->bpp % 8) == 0)
+    {
+        IWICBitmapSource_AddRef(source);
+        This->source = source;
+    }
+    else
+    {
+        hr = WICConvertBitmapSource(&GUID_WICPixelFormat32bppBGRA, source, &This->source);
+        This->bpp = 32;
+    }
+    This->fn_get_required_source_rect = NearestNeighbor_GetRequiredSourceRect;
+    This->fn_copy_scanline = NearestNeighbor_CopyScanline;
+    return hr;
+}
+
 static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     IWICBitmapSource *pISource, UINT uiWidth, UINT uiHeight,
     WICBitmapInterpolationMode mode)
@@ -351,23 +702,28 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     {
         switch (mode)
         {
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeFant:
+        case WICBitmapInterpolationModeHighQualityCubic:
+            if (is_filterable_format(&src_pixelformat))
+            {
+                if (SUCCEEDED(hr = init_filter(This, &src_pixelformat)))
+                {
+                    IWICBitmapSource_AddRef(pISource);
+                    This->source = pISource;
+                }
+                else free_filter(This);
+                break;
+            }
+            FIXME("unsupported format %s for mode %i\n", debugstr_guid(&src_pixelformat), mode);
+            hr = init_nearest_neighbor(This, pISource);
+            break;
         default:
             FIXME("unsupported mode %i\n", mode);
             /* fall-through */
         case WICBitmapInterpolationModeNearestNeighbor:
-            if ((This->bpp % 8) == 0)
-            {
-                IWICBitmapSource_AddRef(pISource);
-                This->source = pISource;
-            }
-            else
-            {
-                hr = WICConvertBitmapSource(&GUID_WICPixelFormat32bppBGRA,
-                    pISource, &This->source);
-                This->bpp = 32;
-            }
-            This->fn_get_required_source_rect = NearestNeighbor_GetRequiredSourceRect;
-            This->fn_copy_scanline = NearestNeighbor_CopyScanline;
+            hr = init_nearest_neighbor(This, pISource);
             break;
         }
     }
@@ -514,7 +870,7 @@ HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
 {
     BitmapScaler *This;
 
-    This = HeapAlloc(GetProcessHeap(), 0, sizeof(BitmapScaler));
+    This = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(BitmapScaler));
     if (!This) return E_OUTOFMEMORY;
 
     This->IWICBitmapScaler_iface.lpVtbl = &BitmapScaler_Vtbl;
@@ -1312,6 +1312,148 @@ static void test_bitmap_scaler(void)
     IWICBitmap_Release(bitmap);
 }
 
+static void test_bitmap_scaler_modes(void)
+{
+    static const WICBitmapInterpolationMode modes[] =
+    {
+        WICBitmapInterpolationModeNearestNeighbor,
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant,
+    };
+    static const UINT sizes[][2] = {{8, 4}, {2, 1}, {5, 3}};
+    BYTE src[4 * 2 * 4], buf[8 * 4 * 4];
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    UINT i, j, k;
+    WICRect rc;
+    HRESULT hr;
+
+    for (i = 0; i < sizeof(src); i += 4)
+    {
+        src[i] = 0x20;
+        src[i + 1] = 0x80;
+        src[i + 2] = 0xe0;
+        src[i + 3] = 0xff;
+    }
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 4, 2, &GUID_WICPixelFormat32bppBGRA,
+        16, sizeof(src), src, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(sizes); j++)
+        {
+            hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+            ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+
+            hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, sizes[j][0], sizes[j][1], modes[i]);
+            ok(hr == S_OK, "%u: failed to initialize bitmap scaler, hr %#x.\n", modes[i], hr);
+
+            /* a uniform image stays uniform whatever the filter */
+            memset(buf, 0xcc, sizeof(buf));
+            hr = IWICBitmapScaler_CopyPixels(scaler, NULL, sizes[j][0] * 4, sizeof(buf), buf);
+            ok(hr == S_OK, "%u: failed to copy pixels, hr %#x.\n", modes[i], hr);
+            for (k = 0; k < sizes[j][0] * sizes[j][1] * 4; k++)
+                if (buf[k] != src[k % 4]) break;
+            ok(k == sizes[j][0] * sizes[j][1] * 4, "%u, %ux%u: unexpected data %#x at %u.\n",
+                modes[i], sizes[j][0], sizes[j][1], buf[k], k);
+
+            rc.X = sizes[j][0] - 1;
+            rc.Y = sizes[j][1] - 1;
+            rc.Width = rc.Height = 1;
+            memset(buf, 0xcc, sizeof(buf));
+            hr = IWICBitmapScaler_CopyPixels(scaler, &rc, 4, 4, buf);
+            ok(hr == S_OK, "%u: failed to copy pixels, hr %#x.\n", modes[i], hr);
+            ok(!memcmp(buf, src, 4), "%u: unexpected data %02x%02x%02x%02x.\n", modes[i],
+                buf[0], buf[1], buf[2], buf[3]);
+
+            IWICBitmapScaler_Release(scaler);
+        }
+    }
+
+    IWICBitmap_Release(bitmap);
+}
+
+static void test_bitmap_scaler_filters(void)
+{
+    static const BYTE ramp8[8] = {0, 32, 64, 96, 128, 160, 192, 224}, ramp4[4] = {0, 64, 128, 192};
+    static const struct
+    {
+        WICBitmapInterpolationMode mode;
+        const BYTE *src;
+        UINT src_width, width;
+        BYTE expect[8];
+    }
+    tests[] =
+    {
+        {WICBitmapInterpolationModeNearestNeighbor, ramp8, 8, 4, {0, 64, 128, 192}},
+        {WICBitmapInterpolationModeLinear,          ramp8, 8, 4, {16, 80, 144, 208}},
+        {WICBitmapInterpolationModeCubic,           ramp8, 8, 4, {14, 80, 144, 210}},
+        {WICBitmapInterpolationModeFant,            ramp8, 8, 4, {16, 80, 144, 208}},
+        {WICBitmapInterpolationModeNearestNeighbor, ramp4, 4, 8, {0, 0, 64, 64, 128, 128, 192, 192}},
+        {WICBitmapInterpolationModeLinear,          ramp4, 4, 8, {0, 16, 48, 80, 112, 144, 176, 192}},
+        {WICBitmapInterpolationModeCubic,           ramp4, 4, 8, {0, 12, 47, 80, 112, 146, 181, 197}},
+        {WICBitmapInterpolationModeFant,            ramp4, 4, 8, {0, 16, 48, 80, 112, 144, 176, 192}},
+    };
+    /* an opaque red pixel next to a transparent green one */
+    static const BYTE alpha_src[8] = {0x00, 0x00, 0xff, 0xff, 0x00, 0xff, 0x00, 0x00};
+    static const BYTE alpha_expect[16] =
+    {
+        0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0xff, 0xbf, 0x00, 0x00, 0xff, 0x40, 0x00, 0x00, 0x00, 0x00
+    };
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    BYTE src[16], buf[16];
+    UINT i, j;
+    HRESULT hr;
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        /* two identical rows, so that the vertical filter is run as well */
+        memcpy(src, tests[i].src, tests[i].src_width);
+        memcpy(src + tests[i].src_width, tests[i].src, tests[i].src_width);
+        hr = IWICImagingFactory_CreateBitmapFromMemory(factory, tests[i].src_width, 2, &GUID_WICPixelFormat8bppGray,
+            tests[i].src_width, tests[i].src_width * 2, src, &bitmap);
+        ok(hr == S_OK, "%u: failed to create a bitmap, hr %#x.\n", i, hr);
+
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "%u: failed to create bitmap scaler, hr %#x.\n", i, hr);
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, tests[i].width, 2, tests[i].mode);
+        ok(hr == S_OK, "%u: failed to initialize bitmap scaler, hr %#x.\n", i, hr);
+
+        memset(buf, 0xcc, sizeof(buf));
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, tests[i].width, tests[i].width * 2, buf);
+        ok(hr == S_OK, "%u: failed to copy pixels, hr %#x.\n", i, hr);
+        for (j = 0; j < tests[i].width * 2; j++)
+            ok(buf[j] == tests[i].expect[j % tests[i].width], "%u: got %u at %u, expected %u.\n",
+                i, buf[j], j, tests[i].expect[j % tests[i].width]);
+
+        IWICBitmapScaler_Release(scaler);
+        IWICBitmap_Release(bitmap);
+    }
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 2, 1, &GUID_WICPixelFormat32bppBGRA,
+        8, sizeof(alpha_src), (BYTE *)alpha_src, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+    hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 4, 1, WICBitmapInterpolationModeLinear);
+    ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#x.\n", hr);
+
+    /* the color of the transparent pixel doesn't show */
+    memset(buf, 0xcc, sizeof(buf));
+    hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 16, sizeof(buf), buf);
+    ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+    for (i = 0; i < 4; i++)
+        ok(!memcmp(buf + i * 4, alpha_expect + i * 4, 4), "%u: got %08x, expected %08x.\n", i,
+            *(DWORD *)(buf + i * 4), *(DWORD *)(alpha_expect + i * 4));
+
+    IWICBitmapScaler_Release(scaler);
+    IWICBitmap_Release(bitmap);
+}
+
 static LONG obj_refcount(void *obj)
 {
     IUnknown_AddRef((IUnknown *)obj);
@@ -1482,6 +1624,8 @@ START_TEST(bitmap)
     test_CreateBitmapFromHBITMAP();
     test_clipper();
     test_bitmap_scaler();
+    test_bitmap_scaler_modes();
+    test_bitmap_scaler_filters();
 
     IWICImagingFactory_Release(factory);
 
@@ -589,6 +589,70 @@ static void test_conversion(const struct bitmap_data *src, const struct bitmap_d
     DeleteTestBitmap(src_obj);
 }
 
+/* compares the direct row converters against the per-pixel formulas of the
+ * generic path, the odd width exercises both the vector and the scalar tails */
+static void test_direct_conversion(void)
+{
+    static const UINT width = 37, height = 3;
+    BYTE gray[37 * 3], bgr24[37 * 3 * 3];
+    DWORD bgra[37 * 3], gray32[37 * 3], pbgra[37 * 3], unpremul[37 * 3];
+    struct bitmap_data src, dst;
+    UINT i, a, x;
+
+    for (i = 0; i < width * height; i++)
+    {
+        gray[i] = i * 7;
+        bgr24[i * 3] = bgr24[i * 3 + 1] = bgr24[i * 3 + 2] = gray[i];
+        gray32[i] = 0xff000000 | gray[i] * 0x010101;
+
+        /* cover fully transparent and fully opaque pixels and the values that round */
+        a = (i % 5 == 0) ? 0 : (i % 5 == 1) ? 255 : (i * 53) & 0xff;
+        bgra[i] = a << 24 | ((i * 29 + 1) & 0xff) << 16 | ((i * 61 + 128) & 0xff) << 8 | ((i * 97) & 0xff);
+        pbgra[i] = a << 24 | (((bgra[i] >> 16) & 0xff) * a / 255) << 16 |
+                   (((bgra[i] >> 8) & 0xff) * a / 255) << 8 | ((bgra[i] & 0xff) * a / 255);
+
+        unpremul[i] = pbgra[i];
+        if (a != 0 && a != 255)
+        {
+            x = (pbgra[i] & 0xff) * 255 / a;
+            x |= (((pbgra[i] >> 8) & 0xff) * 255 / a) << 8;
+            x |= (((pbgra[i] >> 16) & 0xff) * 255 / a) << 16;
+            unpremul[i] = (pbgra[i] & 0xff000000) | x;
+        }
+    }
+
+    src.width = dst.width = width;
+    src.height = dst.height = height;
+    src.xres = src.yres = dst.xres = dst.yres = 96.0;
+    src.alt_data = dst.alt_data = NULL;
+
+    src.format = &GUID_WICPixelFormat8bppGray;
+    src.bpp = 8;
+    src.bits = gray;
+    dst.format = &GUID_WICPixelFormat24bppBGR;
+    dst.bpp = 24;
+    dst.bits = bgr24;
+    test_conversion(&src, &dst, "8bppGray -> 24bppBGR direct", FALSE);
+
+    dst.format = &GUID_WICPixelFormat32bppBGRA;
+    dst.bpp = 32;
+    dst.bits = (const BYTE *)gray32;
+    test_conversion(&src, &dst, "8bppGray -> 32bppBGRA direct", FALSE);
+
+    src.format = &GUID_WICPixelFormat32bppBGRA;
+    src.bpp = 32;
+    src.bits = (const BYTE *)bgra;
+    dst.format = &GUID_WICPixelFormat32bppPBGRA;
+    dst.bits = (const BYTE *)pbgra;
+    test_conversion(&src, &dst, "32bppBGRA -> 32bppPBGRA direct", FALSE);
+
+    src.format = &GUID_WICPixelFormat32bppPBGRA;
+    src.bits = (const BYTE *)pbgra;
+    dst.format = &GUID_WICPixelFormat32bppBGRA;
+    dst.bits = (const BYTE *)unpremul;
+    test_conversion(&src, &dst, "32bppPBGRA -> 32bppBGRA direct", FALSE);
+}
+
 static void test_invalid_conversion(void)
 {
     BitmapTestSrc *src_obj;
@@ -1904,6 +1968,7 @@ START_TEST(converter)
     test_conversion(&testdata_32bppGrayFloat, &testdata_24bppBGR_gray, "32bppGrayFloat -> 24bppBGR gray", FALSE);
     test_conversion(&testdata_32bppGrayFloat, &testdata_8bppGray, "32bppGrayFloat -> 8bppGray", FALSE);
 
+    test_direct_conversion();
     test_invalid_conversion();
     test_default_converter();
     test_converter_8bppIndexed();
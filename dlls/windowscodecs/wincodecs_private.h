@@ -251,6 +251,7 @@ static inline const char *debug_wic_rect(const WICRect *rect)
 }
 
 extern HMODULE windowscodecs_module;
+extern BOOL sse2_supported DECLSPEC_HIDDEN;
 
 HRESULT read_png_chunk(IStream *stream, BYTE *type, BYTE **data, ULONG *data_size);
 
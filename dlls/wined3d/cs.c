@@ -21,10 +21,31 @@
 #include "wined3d_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 WINE_DECLARE_DEBUG_CHANNEL(d3d_sync);
 WINE_DECLARE_DEBUG_CHANNEL(fps);
 
 #define WINED3D_INITIAL_CS_SIZE 4096
+#define WINED3D_CS_MIN_CHUNK_SIZE 0x1000
+#define WINED3D_CS_CHUNK_SIZE 0x10000
+#define WINED3D_CS_MAX_POOLED_CHUNKS 64
+
+/* Deferred contexts record their commands into a list of chunks. When the
+ * command list is created the chunks are handed over to it as they are,
+ * and once the command list is destroyed they are returned to a pool shared
+ * by all the deferred contexts of the device.
+ *
+ * The first chunk of a command list is small, and each following one is
+ * twice the size of the previous one, so that small command lists don't
+ * hold on to much memory. Only chunks of the full WINED3D_CS_CHUNK_SIZE are
+ * pooled. */
+struct wined3d_cs_chunk
+{
+    SLIST_ENTRY entry;
+    struct wined3d_cs_chunk *next;
+    SIZE_T size, capacity;
+    BYTE data[1];
+};
 
 struct wined3d_deferred_upload
 {
@@ -40,8 +61,7 @@ struct wined3d_command_list
 
     struct wined3d_device *device;
 
-    SIZE_T data_size;
-    void *data;
+    struct wined3d_cs_chunk *chunks;
 
     SIZE_T resource_count;
     struct wined3d_resource **resources;
@@ -56,6 +76,52 @@ struct wined3d_command_list
     struct wined3d_command_list **command_lists;
 };
 
+static struct wined3d_cs_chunk *wined3d_cs_get_chunk(struct wined3d_cs *cs,
+        const struct wined3d_cs_chunk *prev, SIZE_T size)
+{
+    struct wined3d_cs_chunk *chunk;
+    SIZE_T capacity = WINED3D_CS_MIN_CHUNK_SIZE;
+    SLIST_ENTRY *entry;
+
+    if (prev)
+        capacity = min(prev->capacity * 2, WINED3D_CS_CHUNK_SIZE);
+
+    if (capacity == WINED3D_CS_CHUNK_SIZE && size <= capacity
+            && (entry = InterlockedPopEntrySList(&cs->chunk_pool)))
+    {
+        chunk = CONTAINING_RECORD(entry, struct wined3d_cs_chunk, entry);
+    }
+    else
+    {
+        capacity = max(size, capacity);
+        if (!(chunk = heap_alloc(offsetof(struct wined3d_cs_chunk, data[capacity]))))
+            return NULL;
+        chunk->capacity = capacity;
+    }
+
+    chunk->next = NULL;
+    chunk->size = 0;
+    return chunk;
+}
+
+static void wined3d_cs_release_chunks(struct wined3d_cs *cs, struct wined3d_cs_chunk *chunk)
+{
+    struct wined3d_cs_chunk *next;
+
+    for (; chunk; chunk = next)
+    {
+        next = chunk->next;
+
+        /* Smaller chunks start new command lists, and oversized chunks are
+         * only used for unusually large packets. */
+        if (chunk->capacity == WINED3D_CS_CHUNK_SIZE
+                && QueryDepthSList(&cs->chunk_pool) < WINED3D_CS_MAX_POOLED_CHUNKS)
+            InterlockedPushEntrySList(&cs->chunk_pool, &chunk->entry);
+        else
+            heap_free(chunk);
+    }
+}
+
 static void wined3d_command_list_destroy_object(void *object)
 {
     struct wined3d_command_list *list = object;
@@ -66,8 +132,9 @@ static void wined3d_command_list_destroy_object(void *object)
     for (i = 0; i < list->upload_count; ++i)
         heap_free(list->uploads[i].sysmem);
 
+    wined3d_cs_release_chunks(list->device->cs, list->chunks);
+    heap_free(list->command_lists);
     heap_free(list->resources);
-    heap_free(list->data);
     heap_free(list);
 }
 
@@ -649,6 +716,25 @@ static void wined3d_cs_exec_nop(struct wined3d_cs *cs, const void *data)
 {
 }
 
+static void wined3d_cs_report_stats(struct wined3d_cs *cs, BOOL force)
+{
+    const struct wined3d_cs_stats *stats = &cs->stats;
+    double ms_per_tick = 1000.0 / cs->counter_frequency;
+    DWORD time = GetTickCount();
+
+    if (!force && time - cs->stats.report_time < 1500)
+        return;
+    cs->stats.report_time = time;
+
+    TRACE_(d3d_perf)("cs %p: %s packets, max queue depth %lu bytes, spin limit %u.\n", cs,
+            wine_dbgstr_longlong(stats->packet_count), (unsigned long)stats->max_queue_depth, cs->spin_limit);
+    TRACE_(d3d_perf)("cs %p: %s wakeups while spinning, %s wakeups from the event.\n", cs,
+            wine_dbgstr_longlong(stats->spin_wakeups), wine_dbgstr_longlong(stats->event_wakeups));
+    TRACE_(d3d_perf)("cs %p: stalled %s times on a full queue for %.3f ms, waited %s times for completion for %.3f ms.\n",
+            cs, wine_dbgstr_longlong(stats->stall_count), stats->stall_time * ms_per_tick,
+            wine_dbgstr_longlong(stats->finish_count), stats->finish_time * ms_per_tick);
+}
+
 static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
 {
     struct wined3d_texture *logo_texture, *cursor_texture, *back_buffer;
@@ -712,6 +798,9 @@ static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
             wined3d_rendertarget_view_validate_location(dsv, WINED3D_LOCATION_DISCARDED);
     }
 
+    if (TRACE_ON(d3d_perf))
+        wined3d_cs_report_stats(cs, FALSE);
+
     if (TRACE_ON(fps))
     {
         DWORD time = GetTickCount();
@@ -2969,23 +3058,26 @@ static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void
 static void wined3d_cs_exec_execute_command_list(struct wined3d_cs *cs, const void *data)
 {
     const struct wined3d_cs_execute_command_list *op = data;
-    size_t start = 0, end = op->list->data_size;
-    const BYTE *cs_data = op->list->data;
+    const struct wined3d_cs_chunk *chunk;
+    size_t start;
 
     TRACE("Executing command list %p.\n", op->list);
 
-    while (start < end)
+    for (chunk = op->list->chunks; chunk; chunk = chunk->next)
     {
-        const struct wined3d_cs_packet *packet = (const struct wined3d_cs_packet *)&cs_data[start];
-        enum wined3d_cs_op opcode = *(const enum wined3d_cs_op *)packet->data;
+        for (start = 0; start < chunk->size;)
+        {
+            const struct wined3d_cs_packet *packet = (const struct wined3d_cs_packet *)&chunk->data[start];
+            enum wined3d_cs_op opcode = *(const enum wined3d_cs_op *)packet->data;
 
-        if (opcode >= WINED3D_CS_OP_STOP)
-            ERR("Invalid opcode %#x.\n", opcode);
-        else
-            wined3d_cs_op_handlers[opcode](cs, packet->data);
-        TRACE("%s executed.\n", debug_cs_op(opcode));
+            if (opcode >= WINED3D_CS_OP_STOP)
+                ERR("Invalid opcode %#x.\n", opcode);
+            else
+                wined3d_cs_op_handlers[opcode](cs, packet->data);
+            TRACE("%s executed.\n", debug_cs_op(opcode));
 
-        start += offsetof(struct wined3d_cs_packet, data[packet->size]);
+            start += offsetof(struct wined3d_cs_packet, data[packet->size]);
+        }
     }
 }
 
@@ -3091,6 +3183,15 @@ static const struct wined3d_device_context_ops wined3d_cs_st_ops =
     wined3d_cs_acquire_command_list,
 };
 
+static void wined3d_cs_record_wait(const LARGE_INTEGER *start, ULONG64 *count, ULONG64 *time)
+{
+    LARGE_INTEGER end;
+
+    QueryPerformanceCounter(&end);
+    *time += end.QuadPart - start->QuadPart;
+    ++*count;
+}
+
 static BOOL wined3d_cs_queue_is_empty(const struct wined3d_cs *cs, const struct wined3d_cs_queue *queue)
 {
     wined3d_from_cs(cs);
@@ -3125,6 +3226,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
     size_t queue_size = ARRAY_SIZE(queue->data);
     size_t header_size, packet_size, remaining;
     struct wined3d_cs_packet *packet;
+    LARGE_INTEGER stall_start;
 
     header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[size]);
@@ -3154,6 +3256,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
         assert(!queue->head);
     }
 
+    stall_start.QuadPart = 0;
     for (;;)
     {
         LONG tail = *(volatile LONG *)&queue->tail;
@@ -3173,9 +3276,16 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
         if (new_pos < tail && new_pos)
             break;
 
-        TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
-                head, tail, (unsigned long)packet_size);
+        if (!stall_start.QuadPart)
+        {
+            TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
+                    head, tail, (unsigned long)packet_size);
+            QueryPerformanceCounter(&stall_start);
+        }
+        YieldProcessor();
     }
+    if (stall_start.QuadPart)
+        wined3d_cs_record_wait(&stall_start, &cs->stats.stall_count, &cs->stats.stall_time);
 
     packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
     packet->size = size;
@@ -3196,12 +3306,18 @@ static void *wined3d_cs_mt_require_space(struct wined3d_device_context *context,
 static void wined3d_cs_mt_finish(struct wined3d_device_context *context, enum wined3d_cs_queue_id queue_id)
 {
     struct wined3d_cs *cs = wined3d_cs_from_context(context);
+    LARGE_INTEGER start;
 
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_finish(context, queue_id);
 
+    if (cs->queue[queue_id].head == *(volatile LONG *)&cs->queue[queue_id].tail)
+        return;
+
+    QueryPerformanceCounter(&start);
     while (cs->queue[queue_id].head != *(volatile LONG *)&cs->queue[queue_id].tail)
         YieldProcessor();
+    wined3d_cs_record_wait(&start, &cs->stats.finish_count, &cs->stats.finish_time);
 }
 
 static const struct wined3d_device_context_ops wined3d_cs_mt_ops =
@@ -3273,6 +3389,7 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
     enum wined3d_cs_op opcode;
     HMODULE wined3d_module;
     unsigned int poll = 0;
+    size_t depth;
     LONG tail;
 
     TRACE("Started.\n");
@@ -3299,14 +3416,33 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
             queue = &cs->queue[WINED3D_CS_QUEUE_DEFAULT];
             if (wined3d_cs_queue_is_empty(cs, queue))
             {
-                if (++spin_count >= WINED3D_CS_SPIN_COUNT && list_empty(&cs->query_poll_list))
+                if (++spin_count >= cs->spin_limit && list_empty(&cs->query_poll_list))
+                {
+                    /* Nothing arrived while spinning, spin for a shorter
+                     * time before going to sleep the next time. */
+                    cs->spin_limit = max(cs->spin_limit / 2, WINED3D_CS_MIN_SPIN_COUNT);
                     wined3d_cs_wait_event(cs);
+                    ++cs->stats.event_wakeups;
+                    spin_count = 0;
+                }
                 continue;
             }
         }
-        spin_count = 0;
+
+        if (spin_count)
+        {
+            /* Work arrived while spinning. If it came late, allow spinning
+             * for longer, so that a similar gap doesn't put us to sleep. */
+            if (spin_count > cs->spin_limit / 2)
+                cs->spin_limit = min(spin_count * 2, WINED3D_CS_SPIN_COUNT);
+            ++cs->stats.spin_wakeups;
+            spin_count = 0;
+        }
 
         tail = queue->tail;
+        depth = (*(volatile LONG *)&queue->head - tail) & (WINED3D_CS_QUEUE_SIZE - 1);
+        cs->stats.max_queue_depth = max(cs->stats.max_queue_depth, depth);
+        ++cs->stats.packet_count;
         packet = (struct wined3d_cs_packet *)&queue->data[tail];
         if (packet->size)
         {
@@ -3333,6 +3469,8 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
 
     cs->queue[WINED3D_CS_QUEUE_MAP].tail = cs->queue[WINED3D_CS_QUEUE_MAP].head;
     cs->queue[WINED3D_CS_QUEUE_DEFAULT].tail = cs->queue[WINED3D_CS_QUEUE_DEFAULT].head;
+    if (TRACE_ON(d3d_perf))
+        wined3d_cs_report_stats(cs, TRUE);
     TRACE("Stopped.\n");
     FreeLibraryAndExitThread(wined3d_module, 0);
 }
@@ -3341,6 +3479,7 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device,
         const enum wined3d_feature_level *levels, unsigned int level_count)
 {
     const struct wined3d_d3d_info *d3d_info = &device->adapter->d3d_info;
+    LARGE_INTEGER frequency;
     struct wined3d_cs *cs;
 
     if (!(cs = heap_alloc_zero(sizeof(*cs))))
@@ -3354,6 +3493,10 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device,
 
     cs->c.ops = &wined3d_cs_st_ops;
     cs->c.device = device;
+    InitializeSListHead(&cs->chunk_pool);
+    cs->spin_limit = WINED3D_CS_SPIN_COUNT;
+    QueryPerformanceFrequency(&frequency);
+    cs->counter_frequency = frequency.QuadPart;
     cs->serialize_commands = TRACE_ON(d3d_sync) || wined3d_settings.cs_multithreaded & WINED3D_CSMT_SERIALIZE;
 
     if (cs->serialize_commands)
@@ -3407,6 +3550,8 @@ fail:
 
 void wined3d_cs_destroy(struct wined3d_cs *cs)
 {
+    SLIST_ENTRY *entry, *next;
+
     if (cs->thread)
     {
         wined3d_cs_emit_stop(cs);
@@ -3415,6 +3560,12 @@ void wined3d_cs_destroy(struct wined3d_cs *cs)
             ERR("Closing event failed.\n");
     }
 
+    for (entry = InterlockedFlushSList(&cs->chunk_pool); entry; entry = next)
+    {
+        next = entry->Next;
+        heap_free(CONTAINING_RECORD(entry, struct wined3d_cs_chunk, entry));
+    }
+
     wined3d_state_destroy(cs->c.state);
     state_cleanup(&cs->state);
     heap_free(cs->data);
@@ -3425,8 +3576,7 @@ struct wined3d_deferred_context
 {
     struct wined3d_device_context c;
 
-    SIZE_T data_size, data_capacity;
-    void *data;
+    struct wined3d_cs_chunk *chunks, *current_chunk;
 
     SIZE_T resource_count, resources_capacity;
     struct wined3d_resource **resources;
@@ -3450,6 +3600,7 @@ static void *wined3d_deferred_context_require_space(struct wined3d_device_contex
         size_t size, enum wined3d_cs_queue_id queue_id)
 {
     struct wined3d_deferred_context *deferred = wined3d_deferred_context_from_context(context);
+    struct wined3d_cs_chunk *chunk = deferred->current_chunk;
     struct wined3d_cs_packet *packet;
     size_t header_size, packet_size;
 
@@ -3460,12 +3611,21 @@ static void *wined3d_deferred_context_require_space(struct wined3d_device_contex
     packet_size = offsetof(struct wined3d_cs_packet, data[size]);
     packet_size = (packet_size + header_size - 1) & ~(header_size - 1);
 
-    if (!wined3d_array_reserve(&deferred->data, &deferred->data_capacity, deferred->data_size + packet_size, 1))
-        return NULL;
+    if (!chunk || chunk->capacity - chunk->size < packet_size)
+    {
+        if (!(chunk = wined3d_cs_get_chunk(context->device->cs, chunk, packet_size)))
+            return NULL;
+
+        if (deferred->current_chunk)
+            deferred->current_chunk->next = chunk;
+        else
+            deferred->chunks = chunk;
+        deferred->current_chunk = chunk;
+    }
 
-    packet = (struct wined3d_cs_packet *)((BYTE *)deferred->data + deferred->data_size);
-    TRACE("size was %zu, adding %zu\n", (size_t)deferred->data_size, packet_size);
-    deferred->data_size += packet_size;
+    packet = (struct wined3d_cs_packet *)&chunk->data[chunk->size];
+    TRACE("size was %zu, adding %zu\n", (size_t)chunk->size, packet_size);
+    chunk->size += packet_size;
     packet->size = packet_size - header_size;
     return &packet->data;
 }
@@ -3679,7 +3839,7 @@ void CDECL wined3d_deferred_context_destroy(struct wined3d_device_context *conte
     heap_free(deferred->resources);
 
     wined3d_state_destroy(deferred->c.state);
-    heap_free(deferred->data);
+    wined3d_cs_release_chunks(deferred->c.device->cs, deferred->chunks);
     heap_free(deferred);
 }
 
@@ -3697,39 +3857,20 @@ HRESULT CDECL wined3d_deferred_context_record_command_list(struct wined3d_device
     object->refcount = 1;
     object->device = deferred->c.device;
 
-    if (!(object->data = heap_alloc(deferred->data_size)))
-    {
-        heap_free(object);
-        return E_OUTOFMEMORY;
-    }
-    object->data_size = deferred->data_size;
-    memcpy(object->data, deferred->data, deferred->data_size);
+    /* Transfer the recorded chunks, along with our references to the
+     * resources and command lists, to the command list. */
+    object->chunks = deferred->chunks;
+    deferred->chunks = deferred->current_chunk = NULL;
 
-    if (!(object->resources = heap_alloc(deferred->resource_count * sizeof(*object->resources))))
-    {
-        heap_free(object->data);
-        heap_free(object);
-        return E_OUTOFMEMORY;
-    }
     object->resource_count = deferred->resource_count;
-    memcpy(object->resources, deferred->resources, deferred->resource_count * sizeof(*object->resources));
-    /* Transfer our references to the resources to the command list. */
+    object->resources = deferred->resources;
+    deferred->resource_count = deferred->resources_capacity = 0;
+    deferred->resources = NULL;
 
-    if (!(object->command_lists = heap_alloc(deferred->command_list_count * sizeof(*object->command_lists))))
-    {
-        heap_free(object->resources);
-        heap_free(object->data);
-        heap_free(object);
-        return E_OUTOFMEMORY;
-    }
     object->command_list_count = deferred->command_list_count;
-    memcpy(object->command_lists, deferred->command_lists,
-            deferred->command_list_count * sizeof(*object->command_lists));
-    /* Transfer our references to the command lists to the command list. */
-
-    deferred->data_size = 0;
-    deferred->resource_count = 0;
-    deferred->command_list_count = 0;
+    object->command_lists = deferred->command_lists;
+    deferred->command_list_count = deferred->command_lists_capacity = 0;
+    deferred->command_lists = NULL;
 
     /* This is in fact recorded into a subsequent command list. */
     if (restore)
@@ -639,6 +639,163 @@ void shader_glsl_validate_link(const struct wined3d_gl_info *gl_info, GLuint pro
     print_glsl_info_log(gl_info, program, TRUE);
 }
 
+/* Programs linked with GL_ARB_get_program_binary are stored in the shader
+ * cache, keyed on the driver strings, the link state that isn't part of the
+ * shader sources, and the sources of all attached shaders. */
+struct glsl_program_link_state
+{
+    WORD attribs_map;
+    WORD dual_source;
+};
+
+/* Context activation is done by the caller. */
+static void *shader_glsl_get_program_cache_key(const struct wined3d_gl_info *gl_info, GLuint program,
+        const void *link_state, unsigned int link_state_size, SIZE_T *key_size)
+{
+    static const GLenum string_names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    const char *strings[ARRAY_SIZE(string_names)];
+    GLint i, shader_count, length, type;
+    SIZE_T size, offset;
+    unsigned int j;
+    GLuint *shaders;
+    char *key;
+
+    size = link_state_size;
+    for (j = 0; j < ARRAY_SIZE(string_names); ++j)
+    {
+        if (!(strings[j] = (const char *)gl_info->gl_ops.gl.p_glGetString(string_names[j])))
+            return NULL;
+        size += strlen(strings[j]) + 1;
+    }
+
+    GL_EXTCALL(glGetProgramiv(program, GL_ATTACHED_SHADERS, &shader_count));
+    if (!(shaders = heap_calloc(shader_count, sizeof(*shaders))))
+        return NULL;
+    GL_EXTCALL(glGetAttachedShaders(program, shader_count, NULL, shaders));
+
+    for (i = 0; i < shader_count; ++i)
+    {
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_SOURCE_LENGTH, &length));
+        size += sizeof(type) + length;
+    }
+
+    if (!(key = heap_alloc(size)))
+    {
+        heap_free(shaders);
+        return NULL;
+    }
+
+    offset = 0;
+    for (j = 0; j < ARRAY_SIZE(strings); ++j)
+    {
+        length = strlen(strings[j]) + 1;
+        memcpy(&key[offset], strings[j], length);
+        offset += length;
+    }
+    memcpy(&key[offset], link_state, link_state_size);
+    offset += link_state_size;
+
+    for (i = 0; i < shader_count; ++i)
+    {
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type));
+        memcpy(&key[offset], &type, sizeof(type));
+        offset += sizeof(type);
+
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_SOURCE_LENGTH, &length));
+        if (length > size - offset)
+            length = size - offset;
+        GL_EXTCALL(glGetShaderSource(shaders[i], length, NULL, &key[offset]));
+        offset += length;
+    }
+    checkGLcall("get program cache key");
+    heap_free(shaders);
+
+    *key_size = offset;
+    return key;
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_load_program_binary(const struct wined3d_gl_info *gl_info, GLuint program,
+        const void *key, SIZE_T key_size)
+{
+    GLint status = GL_FALSE;
+    SIZE_T size;
+    BYTE *data;
+
+    if (!(data = wined3d_shader_cache_load(key, key_size, &size)))
+        return FALSE;
+
+    if (size > sizeof(GLenum))
+    {
+        GL_EXTCALL(glProgramBinary(program, *(GLenum *)data, data + sizeof(GLenum), size - sizeof(GLenum)));
+        checkGLcall("glProgramBinary");
+        GL_EXTCALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+    }
+    heap_free(data);
+
+    if (!status)
+    {
+        WARN("Failed to load the cached binary for program %u.\n", program);
+        return FALSE;
+    }
+
+    TRACE("Loaded program %u from the shader cache.\n", program);
+    return TRUE;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_store_program_binary(const struct wined3d_gl_info *gl_info, GLuint program,
+        const void *key, SIZE_T key_size)
+{
+    GLint status, length;
+    GLenum format;
+    BYTE *data;
+
+    GL_EXTCALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+    if (!status)
+        return;
+
+    GL_EXTCALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0 || !(data = heap_alloc(sizeof(format) + length)))
+        return;
+
+    GL_EXTCALL(glGetProgramBinary(program, length, &length, &format, data + sizeof(format)));
+    checkGLcall("glGetProgramBinary");
+    memcpy(data, &format, sizeof(format));
+
+    wined3d_shader_cache_store(key, key_size, data, sizeof(format) + length);
+    heap_free(data);
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_link_program(const struct wined3d_gl_info *gl_info, GLuint program,
+        const void *link_state, unsigned int link_state_size, BOOL cacheable)
+{
+    SIZE_T key_size;
+    void *key = NULL;
+
+    if (cacheable && gl_info->supported[ARB_GET_PROGRAM_BINARY] && wined3d_settings.shader_cache_path
+            && (key = shader_glsl_get_program_cache_key(gl_info, program, link_state, link_state_size, &key_size)))
+    {
+        if (shader_glsl_load_program_binary(gl_info, program, key, key_size))
+        {
+            heap_free(key);
+            return;
+        }
+        GL_EXTCALL(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
+
+    TRACE("Linking GLSL shader program %u.\n", program);
+    GL_EXTCALL(glLinkProgram(program));
+    shader_glsl_validate_link(gl_info, program);
+
+    if (key)
+    {
+        shader_glsl_store_program_binary(gl_info, program, key, key_size);
+        heap_free(key);
+    }
+}
+
 static BOOL shader_glsl_use_layout_qualifier(const struct wined3d_gl_info *gl_info)
 {
     /* Layout qualifiers were introduced in GLSL 1.40. The Nvidia Legacy GPU
@@ -10145,9 +10302,7 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
 
     list_add_head(&shader->linked_programs, &entry->cs.shader_entry);
 
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    shader_glsl_link_program(gl_info, program_id, NULL, 0, TRUE);
 
     GL_EXTCALL(glUseProgram(program_id));
     checkGLcall("glUseProgram");
@@ -10228,6 +10383,7 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
     GLuint gs_id = 0;
     GLuint ps_id = 0;
     struct list *ps_list, *vs_list;
+    struct glsl_program_link_state link_state;
     WORD attribs_map;
     struct wined3d_string_buffer *tmp_name;
 
@@ -10394,6 +10550,9 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         attribs_map = (1u << WINED3D_FFP_ATTRIBS_COUNT) - 1;
     }
 
+    link_state.attribs_map = attribs_map;
+    link_state.dual_source = state->blend_state && state->blend_state->dual_source;
+
     if (!shader_glsl_use_explicit_attrib_location(gl_info))
     {
         /* Bind vertex attributes to a corresponding index number to match
@@ -10477,10 +10636,10 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         list_add_head(ps_list, &entry->ps.shader_entry);
     }
 
-    /* Link the program */
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    /* Link the program. Transform feedback varyings aren't part of the
+     * cache key, so don't cache programs that use stream output. */
+    shader_glsl_link_program(gl_info, program_id, &link_state, sizeof(link_state),
+            !gshader || !gshader->u.gs.so_desc);
 
     shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
             vshader ? vshader->limits->constant_float : 0);
@@ -567,6 +567,150 @@ void string_buffer_list_cleanup(struct wined3d_string_buffer_list *list)
     list_init(&list->list);
 }
 
+/* The on-disk shader cache stores one entry per file. Files are named after
+ * a hash of the key, and contain the full key, so that collisions are
+ * detected instead of returning the wrong program. */
+#define WINED3D_SHADER_CACHE_MAGIC 0x31435357 /* "WSC1" */
+
+struct wined3d_shader_cache_header
+{
+    DWORD magic;
+    DWORD key_size;
+    DWORD data_size;
+};
+
+static LONG shader_cache_hits, shader_cache_misses;
+
+static BOOL shader_cache_get_file_name(const void *key, SIZE_T key_size, char *name, size_t name_size)
+{
+    const BYTE *k = key;
+    UINT64 hash = 0xcbf29ce484222325ull;
+    SIZE_T i;
+    int len;
+
+    if (!wined3d_settings.shader_cache_path)
+        return FALSE;
+
+    /* FNV-1a */
+    for (i = 0; i < key_size; ++i)
+    {
+        hash ^= k[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    len = snprintf(name, name_size, "%s\\%08x%08x.bin", wined3d_settings.shader_cache_path,
+            (unsigned int)(hash >> 32), (unsigned int)hash);
+    return len > 0 && len < name_size;
+}
+
+static BOOL shader_cache_read(HANDLE file, void *data, DWORD size)
+{
+    DWORD read;
+
+    return ReadFile(file, data, size, &read, NULL) && read == size;
+}
+
+static BOOL shader_cache_write(HANDLE file, const void *data, DWORD size)
+{
+    DWORD written;
+
+    return WriteFile(file, data, size, &written, NULL) && written == size;
+}
+
+/* Returns a heap allocated copy of the data stored for "key", or NULL. */
+void *wined3d_shader_cache_load(const void *key, SIZE_T key_size, SIZE_T *data_size)
+{
+    struct wined3d_shader_cache_header header;
+    void *stored_key, *data = NULL;
+    char name[MAX_PATH];
+    HANDLE file;
+
+    if (!shader_cache_get_file_name(key, key_size, name, sizeof(name)))
+        return NULL;
+
+    if ((file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL)) == INVALID_HANDLE_VALUE)
+        goto done;
+
+    if (!shader_cache_read(file, &header, sizeof(header))
+            || header.magic != WINED3D_SHADER_CACHE_MAGIC || header.key_size != key_size)
+        goto done;
+
+    if (!(stored_key = heap_alloc(key_size)))
+        goto done;
+    if (!shader_cache_read(file, stored_key, key_size) || memcmp(stored_key, key, key_size))
+    {
+        heap_free(stored_key);
+        goto done;
+    }
+    heap_free(stored_key);
+
+    if ((data = heap_alloc(header.data_size)) && !shader_cache_read(file, data, header.data_size))
+    {
+        heap_free(data);
+        data = NULL;
+    }
+
+done:
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+
+    if (data)
+    {
+        *data_size = header.data_size;
+        TRACE("Shader cache hit for %s, %u hits, %u misses.\n", debugstr_a(name),
+                InterlockedIncrement(&shader_cache_hits), shader_cache_misses);
+    }
+    else
+    {
+        TRACE("Shader cache miss for %s, %u hits, %u misses.\n", debugstr_a(name),
+                shader_cache_hits, InterlockedIncrement(&shader_cache_misses));
+    }
+    return data;
+}
+
+void wined3d_shader_cache_store(const void *key, SIZE_T key_size, const void *data, SIZE_T data_size)
+{
+    struct wined3d_shader_cache_header header;
+    char name[MAX_PATH], tmp_name[MAX_PATH];
+    HANDLE file;
+    BOOL ret;
+    int len;
+
+    if (!shader_cache_get_file_name(key, key_size, name, sizeof(name)))
+        return;
+
+    /* Write to a temporary file first, so that concurrent readers never see
+     * a partially written entry. */
+    len = snprintf(tmp_name, sizeof(tmp_name), "%s.%x.tmp", name, GetCurrentThreadId());
+    if (len <= 0 || len >= sizeof(tmp_name))
+        return;
+
+    CreateDirectoryA(wined3d_settings.shader_cache_path, NULL);
+    if ((file = CreateFileA(tmp_name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create shader cache file %s, error %u.\n", debugstr_a(tmp_name), GetLastError());
+        return;
+    }
+
+    header.magic = WINED3D_SHADER_CACHE_MAGIC;
+    header.key_size = key_size;
+    header.data_size = data_size;
+    ret = shader_cache_write(file, &header, sizeof(header))
+            && shader_cache_write(file, key, key_size)
+            && shader_cache_write(file, data, data_size);
+    CloseHandle(file);
+
+    if (!ret || !MoveFileExA(tmp_name, name, MOVEFILE_REPLACE_EXISTING))
+    {
+        WARN("Failed to write shader cache file %s, error %u.\n", debugstr_a(name), GetLastError());
+        DeleteFileA(tmp_name);
+        return;
+    }
+
+    TRACE("Stored %lu bytes in %s.\n", (unsigned long)data_size, debugstr_a(name));
+}
+
 /* Convert floating point offset relative to a register file to an absolute
  * offset for float constants. */
 static unsigned int shader_get_float_offset(enum wined3d_shader_register_type register_type, UINT register_idx)
@@ -467,6 +467,7 @@ struct wined3d_settings
     /* Memory tracking and object counting. */
     UINT64 emulated_textureram;
     char *logo;
+    char *shader_cache_path;
     unsigned int multisample_textures;
     unsigned int sample_count;
     BOOL check_float_constants;
@@ -4695,6 +4696,7 @@ enum wined3d_push_constants
 #define WINED3D_CS_QUERY_POLL_INTERVAL  10u
 #define WINED3D_CS_QUEUE_SIZE           0x100000u
 #define WINED3D_CS_SPIN_COUNT           10000000u
+#define WINED3D_CS_MIN_SPIN_COUNT       10000u
 
 struct wined3d_cs_queue
 {
@@ -4727,6 +4729,20 @@ struct wined3d_device_context
     struct wined3d_state *state;
 };
 
+/* Command stream statistics, reported on the d3d_perf channel. The stall
+ * and finish counters are only updated by the thread submitting commands,
+ * the remaining ones only by the CS thread. Times are in performance counter
+ * ticks. */
+struct wined3d_cs_stats
+{
+    ULONG64 stall_count, stall_time;
+    ULONG64 finish_count, finish_time;
+    ULONG64 packet_count;
+    ULONG64 spin_wakeups, event_wakeups;
+    size_t max_queue_depth;
+    DWORD report_time;
+};
+
 struct wined3d_cs
 {
     struct wined3d_device_context c;
@@ -4746,6 +4762,13 @@ struct wined3d_cs
     HANDLE event;
     BOOL waiting_for_event;
     LONG pending_presents;
+    unsigned int spin_limit;
+
+    LONGLONG counter_frequency;
+    struct wined3d_cs_stats stats;
+
+    /* Free command chunks for deferred contexts. */
+    SLIST_HEADER chunk_pool;
 };
 
 struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device,
@@ -5612,6 +5635,9 @@ HRESULT shader_generate_code(const struct wined3d_shader *shader, struct wined3d
         const struct wined3d_shader_reg_maps *reg_maps, void *backend_ctx,
         const DWORD *start, const DWORD *end) DECLSPEC_HIDDEN;
 BOOL shader_match_semantic(const char *semantic_name, enum wined3d_decl_usage usage) DECLSPEC_HIDDEN;
+void *wined3d_shader_cache_load(const void *key, SIZE_T key_size, SIZE_T *data_size) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_store(const void *key, SIZE_T key_size,
+        const void *data, SIZE_T data_size) DECLSPEC_HIDDEN;
 
 static inline BOOL shader_is_scalar(const struct wined3d_shader_register *reg)
 {
@@ -54,6 +54,7 @@ typedef LONG NTSTATUS;
 #define BCRYPT_KEY_LENGTHS          L"KeyLengths"
 #define BCRYPT_KEY_OBJECT_LENGTH    L"KeyObjectLength"
 #define BCRYPT_KEY_STRENGTH         L"KeyStrength"
+#define BCRYPT_MULTI_OBJECT_LENGTH  L"MultiObjectLength"
 #define BCRYPT_OBJECT_LENGTH        L"ObjectLength"
 #define BCRYPT_PADDING_SCHEMES      L"PaddingSchemes"
 #define BCRYPT_PROVIDER_HANDLE      L"ProviderHandle"
@@ -125,6 +126,7 @@ static const WCHAR BCRYPT_KEY_LENGTH[] = {'K','e','y','L','e','n','g','t','h',0}
 static const WCHAR BCRYPT_KEY_LENGTHS[] = {'K','e','y','L','e','n','g','t','h','s',0};
 static const WCHAR BCRYPT_KEY_OBJECT_LENGTH[] = {'K','e','y','O','b','j','e','c','t','L','e','n','g','t','h',0};
 static const WCHAR BCRYPT_KEY_STRENGTH[] = {'K','e','y','S','t','r','e','n','g','t','h',0};
+static const WCHAR BCRYPT_MULTI_OBJECT_LENGTH[] = {'M','u','l','t','i','O','b','j','e','c','t','L','e','n','g','t','h',0};
 static const WCHAR BCRYPT_OBJECT_LENGTH[] = {'O','b','j','e','c','t','L','e','n','g','t','h',0};
 static const WCHAR BCRYPT_PADDING_SCHEMES[] = {'P','a','d','d','i','n','g','S','c','h','e','m','e','s',0};
 static const WCHAR BCRYPT_PROVIDER_HANDLE[] = {'P','r','o','v','i','d','e','r','H','a','n','d','l','e',0};
@@ -392,6 +394,7 @@ typedef PVOID BCRYPT_SECRET_HANDLE;
 
 /* Flags for BCryptOpenAlgorithmProvider */
 #define BCRYPT_ALG_HANDLE_HMAC_FLAG 0x00000008
+#define BCRYPT_MULTI_FLAG           0x00000040
 
 /* Flags for BCryptEncrypt/BCryptDecrypt */
 #define BCRYPT_BLOCK_PADDING        0x00000001
@@ -399,6 +402,31 @@ typedef PVOID BCRYPT_SECRET_HANDLE;
 /* Flags for BCryptCreateHash */
 #define BCRYPT_HASH_REUSABLE_FLAG   0x00000020
 
+typedef struct _BCRYPT_MULTI_OBJECT_LENGTH_STRUCT
+{
+    ULONG cbPerObject;
+    ULONG cbPerElement;
+} BCRYPT_MULTI_OBJECT_LENGTH_STRUCT;
+
+typedef enum
+{
+    BCRYPT_HASH_OPERATION_HASH_DATA = 1,
+    BCRYPT_HASH_OPERATION_FINISH_HASH = 2,
+} BCRYPT_HASH_OPERATION_TYPE;
+
+typedef struct _BCRYPT_MULTI_HASH_OPERATION
+{
+    ULONG iHash;
+    BCRYPT_HASH_OPERATION_TYPE hashOperation;
+    PUCHAR pbBuffer;
+    ULONG cbBuffer;
+} BCRYPT_MULTI_HASH_OPERATION;
+
+typedef enum
+{
+    BCRYPT_OPERATION_TYPE_HASH = 1,
+} BCRYPT_MULTI_OPERATION_TYPE;
+
 #define CRYPT_LOCAL     0x00000001
 #define CRYPT_DOMAIN    0x00000002
 
@@ -411,6 +439,7 @@ typedef struct _CRYPT_CONTEXT_FUNCTIONS
 NTSTATUS WINAPI BCryptAddContextFunction(ULONG, LPCWSTR, ULONG, LPCWSTR, ULONG);
 NTSTATUS WINAPI BCryptCloseAlgorithmProvider(BCRYPT_ALG_HANDLE, ULONG);
 NTSTATUS WINAPI BCryptCreateHash(BCRYPT_ALG_HANDLE, BCRYPT_HASH_HANDLE *, PUCHAR, ULONG, PUCHAR, ULONG, ULONG);
+NTSTATUS WINAPI BCryptCreateMultiHash(BCRYPT_ALG_HANDLE, BCRYPT_HASH_HANDLE *, ULONG, PUCHAR, ULONG, PUCHAR, ULONG, ULONG);
 NTSTATUS WINAPI BCryptDecrypt(BCRYPT_KEY_HANDLE, PUCHAR, ULONG, VOID *, PUCHAR, ULONG, PUCHAR, ULONG, ULONG *, ULONG);
 NTSTATUS WINAPI BCryptDeriveKey(BCRYPT_SECRET_HANDLE, LPCWSTR, BCryptBufferDesc*, PUCHAR, ULONG, ULONG *, ULONG);
 NTSTATUS WINAPI BCryptDeriveKeyCapi(BCRYPT_HASH_HANDLE, BCRYPT_ALG_HANDLE, PUCHAR, ULONG, ULONG);
@@ -437,6 +466,7 @@ NTSTATUS WINAPI BCryptHashData(BCRYPT_HASH_HANDLE, PUCHAR, ULONG, ULONG);
 NTSTATUS WINAPI BCryptImportKey(BCRYPT_ALG_HANDLE, BCRYPT_KEY_HANDLE, LPCWSTR, BCRYPT_KEY_HANDLE *, PUCHAR, ULONG, PUCHAR, ULONG, ULONG);
 NTSTATUS WINAPI BCryptImportKeyPair(BCRYPT_ALG_HANDLE, BCRYPT_KEY_HANDLE, LPCWSTR, BCRYPT_KEY_HANDLE *, UCHAR *, ULONG, ULONG);
 NTSTATUS WINAPI BCryptOpenAlgorithmProvider(BCRYPT_ALG_HANDLE *, LPCWSTR, LPCWSTR, ULONG);
+NTSTATUS WINAPI BCryptProcessMultiOperations(BCRYPT_HANDLE, BCRYPT_MULTI_OPERATION_TYPE, PVOID, ULONG, ULONG);
 NTSTATUS WINAPI BCryptRemoveContextFunction(ULONG, LPCWSTR, ULONG, LPCWSTR);
 NTSTATUS WINAPI BCryptSecretAgreement(BCRYPT_KEY_HANDLE, BCRYPT_KEY_HANDLE, BCRYPT_SECRET_HANDLE *, ULONG);
 NTSTATUS WINAPI BCryptSetProperty(BCRYPT_HANDLE, LPCWSTR, PUCHAR, ULONG, ULONG);
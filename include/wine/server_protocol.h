@@ -816,6 +816,39 @@ typedef struct
 } cursor_pos_t;
 
 
+typedef struct
+{
+    int          state;
+    int          count;
+    unsigned int flags;
+    unsigned int serial;
+} inproc_sync_t;
+
+#define INPROC_SYNC_EVENT        1
+#define INPROC_SYNC_SEMAPHORE    2
+#define INPROC_SYNC_MUTEX        3
+#define INPROC_SYNC_TYPE_MASK    0xff
+#define INPROC_SYNC_MANUAL_RESET 0x100
+#define INPROC_SYNC_ABANDONED    0x200
+
+#define INPROC_SYNC_WAITERS      0x80000000
+#define INPROC_SYNC_MAX_OBJECTS  65536
+
+
+typedef union
+{
+    struct
+    {
+        unsigned int   access;
+        unsigned short flags;
+        unsigned short type;
+    } s;
+    unsigned __int64   data;
+} shared_handle_t;
+
+#define SHARED_HANDLE_MAX_ENTRIES 0x100000
+
+
 
 
 
@@ -1232,6 +1265,20 @@ struct set_handle_info_reply
 
 
 
+struct get_shared_handle_table_request
+{
+    struct request_header __header;
+    unsigned int count;
+};
+struct get_shared_handle_table_reply
+{
+    struct reply_header __header;
+    obj_handle_t handle;
+    unsigned int count;
+};
+
+
+
 struct dup_handle_request
 {
     struct request_header __header;
@@ -1333,7 +1380,7 @@ struct create_event_reply
 {
     struct reply_header __header;
     obj_handle_t handle;
-    char __pad_12[4];
+    unsigned int inproc_sync;
 };
 
 
@@ -1425,7 +1472,7 @@ struct create_mutex_reply
 {
     struct reply_header __header;
     obj_handle_t handle;
-    char __pad_12[4];
+    unsigned int inproc_sync;
 };
 
 
@@ -1489,7 +1536,7 @@ struct create_semaphore_reply
 {
     struct reply_header __header;
     obj_handle_t handle;
-    char __pad_12[4];
+    unsigned int inproc_sync;
 };
 
 
@@ -1537,6 +1584,19 @@ struct open_semaphore_reply
 };
 
 
+struct get_inproc_sync_mapping_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_inproc_sync_mapping_reply
+{
+    struct reply_header __header;
+    obj_handle_t handle;
+    char __pad_12[4];
+};
+
+
 
 struct create_file_request
 {
@@ -4987,6 +5047,15 @@ struct add_completion_reply
 };
 
 
+struct completion_info
+{
+    apc_param_t   ckey;
+    apc_param_t   cvalue;
+    apc_param_t   information;
+    unsigned int  status;
+    unsigned int  __pad;
+};
+
 
 struct remove_completion_request
 {
@@ -5000,6 +5069,7 @@ struct remove_completion_reply
     apc_param_t   cvalue;
     apc_param_t   information;
     unsigned int  status;
+    /* VARARG(more,completion_infos); */
     char __pad_36[4];
 };
 
@@ -5437,6 +5507,7 @@ enum request
     REQ_get_apc_result,
     REQ_close_handle,
     REQ_set_handle_info,
+    REQ_get_shared_handle_table,
     REQ_dup_handle,
     REQ_make_temporary,
     REQ_open_process,
@@ -5456,6 +5527,7 @@ enum request
     REQ_release_semaphore,
     REQ_query_semaphore,
     REQ_open_semaphore,
+    REQ_get_inproc_sync_mapping,
     REQ_create_file,
     REQ_open_file_object,
     REQ_alloc_file_handle,
@@ -5718,6 +5790,7 @@ union generic_request
     struct get_apc_result_request get_apc_result_request;
     struct close_handle_request close_handle_request;
     struct set_handle_info_request set_handle_info_request;
+    struct get_shared_handle_table_request get_shared_handle_table_request;
     struct dup_handle_request dup_handle_request;
     struct make_temporary_request make_temporary_request;
     struct open_process_request open_process_request;
@@ -5737,6 +5810,7 @@ union generic_request
     struct release_semaphore_request release_semaphore_request;
     struct query_semaphore_request query_semaphore_request;
     struct open_semaphore_request open_semaphore_request;
+    struct get_inproc_sync_mapping_request get_inproc_sync_mapping_request;
     struct create_file_request create_file_request;
     struct open_file_object_request open_file_object_request;
     struct alloc_file_handle_request alloc_file_handle_request;
@@ -5997,6 +6071,7 @@ union generic_reply
     struct get_apc_result_reply get_apc_result_reply;
     struct close_handle_reply close_handle_reply;
     struct set_handle_info_reply set_handle_info_reply;
+    struct get_shared_handle_table_reply get_shared_handle_table_reply;
     struct dup_handle_reply dup_handle_reply;
     struct make_temporary_reply make_temporary_reply;
     struct open_process_reply open_process_reply;
@@ -6016,6 +6091,7 @@ union generic_reply
     struct release_semaphore_reply release_semaphore_reply;
     struct query_semaphore_reply query_semaphore_reply;
     struct open_semaphore_reply open_semaphore_reply;
+    struct get_inproc_sync_mapping_reply get_inproc_sync_mapping_reply;
     struct create_file_reply create_file_reply;
     struct open_file_object_reply open_file_object_reply;
     struct alloc_file_handle_reply alloc_file_handle_reply;
@@ -6252,7 +6328,7 @@ union generic_reply
 
 /* ### protocol_version begin ### */
 
-#define SERVER_PROTOCOL_VERSION 725
+#define SERVER_PROTOCOL_VERSION 728
 
 /* ### protocol_version end ### */
 
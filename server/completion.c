@@ -214,8 +214,10 @@ DECL_HANDLER(add_completion)
 DECL_HANDLER(remove_completion)
 {
     struct completion* completion = get_completion_obj( current->process, req->handle, IO_COMPLETION_MODIFY_STATE );
+    struct completion_info *info;
     struct list *entry;
     struct comp_msg *msg;
+    data_size_t i, count;
 
     if (!completion) return;
 
@@ -232,6 +234,25 @@ DECL_HANDLER(remove_completion)
         reply->status = msg->status;
         reply->information = msg->information;
         free( msg );
+
+        /* return as many of the following completions as the client wants */
+        count = min( get_reply_max_size() / sizeof(*info), completion->depth );
+        if (count && (info = set_reply_data_size( count * sizeof(*info) )))
+        {
+            for (i = 0; i < count; i++)
+            {
+                entry = list_head( &completion->queue );
+                list_remove( entry );
+                completion->depth--;
+                msg = LIST_ENTRY( entry, struct comp_msg, queue_entry );
+                info[i].ckey        = msg->ckey;
+                info[i].cvalue      = msg->cvalue;
+                info[i].information = msg->information;
+                info[i].status      = msg->status;
+                info[i].__pad       = 0;
+                free( msg );
+            }
+        }
     }
 
     release_object( completion );
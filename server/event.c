@@ -56,21 +56,25 @@ struct event
     struct list    kernel_object;   /* list of kernel object pointers */
     int            manual_reset;    /* is it a manual reset event? */
     int            signaled;        /* event has been signaled */
+    struct inproc_sync inproc_sync; /* shared state for in-process sync */
 };
 
 static void event_dump( struct object *obj, int verbose );
+static int event_add_queue( struct object *obj, struct wait_queue_entry *entry );
+static void event_remove_queue( struct object *obj, struct wait_queue_entry *entry );
 static int event_signaled( struct object *obj, struct wait_queue_entry *entry );
 static void event_satisfied( struct object *obj, struct wait_queue_entry *entry );
 static int event_signal( struct object *obj, unsigned int access);
 static struct list *event_get_kernel_obj_list( struct object *obj );
+static void event_destroy( struct object *obj );
 
 static const struct object_ops event_ops =
 {
     sizeof(struct event),      /* size */
     &event_type,               /* type */
     event_dump,                /* dump */
-    add_queue,                 /* add_queue */
-    remove_queue,              /* remove_queue */
+    event_add_queue,           /* add_queue */
+    event_remove_queue,        /* remove_queue */
     event_signaled,            /* signaled */
     event_satisfied,           /* satisfied */
     event_signal,              /* signal */
@@ -85,7 +89,7 @@ static const struct object_ops event_ops =
     no_open_file,              /* open_file */
     event_get_kernel_obj_list, /* get_kernel_obj_list */
     no_close_handle,           /* close_handle */
-    no_destroy                 /* destroy */
+    event_destroy              /* destroy */
 };
 
 
@@ -150,11 +154,38 @@ struct event *create_event( struct object *root, const struct unicode_str *name,
             list_init( &event->kernel_object );
             event->manual_reset = manual_reset;
             event->signaled     = initial_state;
+            event->inproc_sync.index = 0;
         }
     }
     return event;
 }
 
+/* move the event state to shared memory so that the client can access it directly */
+static void event_init_inproc_sync( struct event *event )
+{
+    unsigned int flags = INPROC_SYNC_EVENT;
+
+    if (event->manual_reset) flags |= INPROC_SYNC_MANUAL_RESET;
+    alloc_inproc_sync( &event->inproc_sync, current->process, flags, event->signaled, 0 );
+}
+
+static int get_event_state( struct event *event )
+{
+    if (event->inproc_sync.index) return get_inproc_sync_state( &event->inproc_sync );
+    return event->signaled;
+}
+
+/* set the event state and return the previous one */
+static int set_event_state( struct event *event, int signaled )
+{
+    int prev;
+
+    if (event->inproc_sync.index) return set_inproc_sync_state( &event->inproc_sync, signaled );
+    prev = event->signaled;
+    event->signaled = signaled;
+    return prev;
+}
+
 struct event *get_event_obj( struct process *process, obj_handle_t handle, unsigned int access )
 {
     return (struct event *)get_handle_obj( process, handle, access, &event_ops );
@@ -162,37 +193,55 @@ struct event *get_event_obj( struct process *process, obj_handle_t handle, unsig
 
 static void pulse_event( struct event *event )
 {
-    event->signaled = 1;
+    set_event_state( event, 1 );
     /* wake up all waiters if manual reset, a single one otherwise */
     wake_up( &event->obj, !event->manual_reset );
-    event->signaled = 0;
+    set_event_state( event, 0 );
 }
 
 void set_event( struct event *event )
 {
-    event->signaled = 1;
+    set_event_state( event, 1 );
     /* wake up all waiters if manual reset, a single one otherwise */
     wake_up( &event->obj, !event->manual_reset );
 }
 
 void reset_event( struct event *event )
 {
-    event->signaled = 0;
+    set_event_state( event, 0 );
 }
 
 static void event_dump( struct object *obj, int verbose )
 {
     struct event *event = (struct event *)obj;
     assert( obj->ops == &event_ops );
-    fprintf( stderr, "Event manual=%d signaled=%d\n",
-             event->manual_reset, event->signaled );
+    fprintf( stderr, "Event manual=%d signaled=%d inproc=%u\n",
+             event->manual_reset, get_event_state( event ), event->inproc_sync.index );
+}
+
+static int event_add_queue( struct object *obj, struct wait_queue_entry *entry )
+{
+    struct event *event = (struct event *)obj;
+    assert( obj->ops == &event_ops );
+    /* make the client go through the server while we have waiters */
+    if (event->inproc_sync.index) add_inproc_sync_waiter( &event->inproc_sync );
+    return add_queue( obj, entry );
+}
+
+static void event_remove_queue( struct object *obj, struct wait_queue_entry *entry )
+{
+    struct event *event = (struct event *)obj;
+    assert( obj->ops == &event_ops );
+    remove_queue( obj, entry );
+    if (event->inproc_sync.index && list_empty( &obj->wait_queue ))
+        remove_inproc_sync_waiters( &event->inproc_sync );
 }
 
 static int event_signaled( struct object *obj, struct wait_queue_entry *entry )
 {
     struct event *event = (struct event *)obj;
     assert( obj->ops == &event_ops );
-    return event->signaled;
+    return get_event_state( event );
 }
 
 static void event_satisfied( struct object *obj, struct wait_queue_entry *entry )
@@ -200,7 +249,7 @@ static void event_satisfied( struct object *obj, struct wait_queue_entry *entry
     struct event *event = (struct event *)obj;
     assert( obj->ops == &event_ops );
     /* Reset if it's an auto-reset event */
-    if (!event->manual_reset) event->signaled = 0;
+    if (!event->manual_reset) set_event_state( event, 0 );
 }
 
 static int event_signal( struct object *obj, unsigned int access )
@@ -223,6 +272,13 @@ static struct list *event_get_kernel_obj_list( struct object *obj )
     return &event->kernel_object;
 }
 
+static void event_destroy( struct object *obj )
+{
+    struct event *event = (struct event *)obj;
+    assert( obj->ops == &event_ops );
+    if (event->inproc_sync.index) free_inproc_sync( &event->inproc_sync );
+}
+
 struct keyed_event *create_keyed_event( struct object *root, const struct unicode_str *name,
                                         unsigned int attr, const struct security_descriptor *sd )
 {
@@ -293,8 +349,17 @@ DECL_HANDLER(create_event)
         if (get_error() == STATUS_OBJECT_NAME_EXISTS)
             reply->handle = alloc_handle( current->process, event, req->access, objattr->attributes );
         else
+        {
+            if (!name.len && !(objattr->attributes & OBJ_INHERIT) && use_inproc_sync())
+                event_init_inproc_sync( event );
             reply->handle = alloc_handle_no_access_check( current->process, event,
                                                           req->access, objattr->attributes );
+        }
+        /* the client can only use the shared state if the handle allows all operations */
+        if (reply->handle && event->inproc_sync.index &&
+            !(~get_handle_access( current->process, reply->handle ) &
+              (SYNCHRONIZE | EVENT_QUERY_STATE | EVENT_MODIFY_STATE)))
+            reply->inproc_sync = event->inproc_sync.index;
         release_object( event );
     }
 
@@ -316,17 +381,18 @@ DECL_HANDLER(event_op)
     struct event *event;
 
     if (!(event = get_event_obj( current->process, req->handle, EVENT_MODIFY_STATE ))) return;
-    reply->state = event->signaled;
     switch(req->op)
     {
     case PULSE_EVENT:
+        reply->state = get_event_state( event );
         pulse_event( event );
         break;
     case SET_EVENT:
-        set_event( event );
+        reply->state = set_event_state( event, 1 );
+        wake_up( &event->obj, !event->manual_reset );
         break;
     case RESET_EVENT:
-        reset_event( event );
+        reply->state = set_event_state( event, 0 );
         break;
     default:
         set_error( STATUS_INVALID_PARAMETER );
@@ -343,7 +409,7 @@ DECL_HANDLER(query_event)
     if (!(event = get_event_obj( current->process, req->handle, EVENT_QUERY_STATE ))) return;
 
     reply->manual_reset = event->manual_reset;
-    reply->state = event->signaled;
+    reply->state = get_event_state( event );
 
     release_object( event );
 }
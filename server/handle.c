@@ -27,12 +27,14 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/mman.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
 #include "windef.h"
 #include "winternl.h"
 
+#include "file.h"
 #include "handle.h"
 #include "process.h"
 #include "thread.h"
@@ -53,6 +55,9 @@ struct handle_table
     int                  last;        /* last used entry */
     int                  free;        /* first entry that may be free */
     struct handle_entry *entries;     /* handle entries */
+    shared_handle_t     *shared;      /* copy of the entries shared with the client */
+    int                  shared_count; /* number of entries in the shared copy */
+    struct object       *shared_mapping; /* mapping object for the shared entries */
 };
 
 static struct handle_table *global_table;
@@ -66,6 +71,15 @@ static struct handle_table *global_table;
 #define MIN_HANDLE_ENTRIES  32
 #define MAX_HANDLE_ENTRIES  0x00ffffff
 
+/* the shared copy covers the table entries, in whole pages */
+#define SHARED_HANDLE_PAGE_ENTRIES ((int)(4096 / sizeof(shared_handle_t)))
+
+static inline int get_shared_handle_count( int count )
+{
+    count = (count + SHARED_HANDLE_PAGE_ENTRIES - 1) & ~(SHARED_HANDLE_PAGE_ENTRIES - 1);
+    return min( count, SHARED_HANDLE_MAX_ENTRIES );
+}
+
 
 /* handle to table index conversion */
 
@@ -165,6 +179,24 @@ static void handle_table_dump( struct object *obj, int verbose )
     }
 }
 
+/* update the client-visible copy of a handle entry */
+static void update_shared_handle( struct handle_table *table, int index )
+{
+    struct handle_entry *entry = table->entries + index;
+    shared_handle_t shared;
+
+    if (index >= table->shared_count) return;
+
+    shared.data = 0;
+    if (entry->ptr)
+    {
+        shared.s.access = entry->access & ~RESERVED_ALL;
+        shared.s.flags  = (entry->access & RESERVED_ALL) >> RESERVED_SHIFT;
+        shared.s.type   = entry->ptr->ops->type->index + 1;
+    }
+    __atomic_store_n( &table->shared[index].data, shared.data, __ATOMIC_SEQ_CST );
+}
+
 /* destroy a handle table */
 static void handle_table_destroy( struct object *obj )
 {
@@ -186,6 +218,8 @@ static void handle_table_destroy( struct object *obj )
         }
     }
     free( table->entries );
+    if (table->shared) munmap( table->shared, table->shared_count * sizeof(*table->shared) );
+    if (table->shared_mapping) release_object( table->shared_mapping );
 }
 
 /* close all the process handles and free the handle table */
@@ -209,11 +243,32 @@ struct handle_table *alloc_handle_table( struct process *process, int count )
     table->count   = count;
     table->last    = -1;
     table->free    = 0;
+    table->shared  = NULL;
+    table->shared_count = 0;
+    table->shared_mapping = NULL;
     if ((table->entries = mem_alloc( count * sizeof(*table->entries) ))) return table;
     release_object( table );
     return NULL;
 }
 
+/* grow the shared copy to cover the table entries */
+/* on failure the new entries are simply not shared, and clients ask the server */
+static void grow_shared_table( struct handle_table *table )
+{
+    int i, old_count = table->shared_count, count = get_shared_handle_count( table->count );
+    void *ptr = table->shared;
+
+    if (count <= old_count) return;
+    if (!grow_shared_mapping( table->shared_mapping, count * sizeof(*table->shared), &ptr ))
+    {
+        clear_error();
+        return;
+    }
+    table->shared = ptr;
+    table->shared_count = count;
+    for (i = old_count; i <= table->last; i++) update_shared_handle( table, i );
+}
+
 /* grow a handle table */
 static int grow_handle_table( struct handle_table *table )
 {
@@ -228,6 +283,7 @@ static int grow_handle_table( struct handle_table *table )
     }
     table->entries = new_entries;
     table->count   = count;
+    if (table->shared) grow_shared_table( table );
     return 1;
 }
 
@@ -248,6 +304,7 @@ static obj_handle_t alloc_entry( struct handle_table *table, void *obj, unsigned
     table->free = i + 1;
     entry->ptr    = grab_object_for_handle( obj );
     entry->access = access;
+    update_shared_handle( table, i );
     return index_to_handle(i);
 }
 
@@ -430,6 +487,7 @@ unsigned int close_handle( struct process *process, obj_handle_t handle )
     if (!obj->ops->close_handle( obj, process, handle )) return STATUS_HANDLE_NOT_CLOSABLE;
     entry->ptr = NULL;
     table = handle_is_global(handle) ? global_table : process->handles;
+    update_shared_handle( table, entry - table->entries );
     if (entry < table->entries + table->free) table->free = entry - table->entries;
     if (entry == table->entries + table->last) shrink_handle_table( table );
     release_object_from_handle( obj );
@@ -542,6 +600,7 @@ static int set_handle_flags( struct process *process, obj_handle_t handle, int m
     mask  = (mask << RESERVED_SHIFT) & RESERVED_ALL;
     flags = (flags << RESERVED_SHIFT) & mask;
     entry->access = (entry->access & ~mask) | flags;
+    if (!handle_is_global( handle )) update_shared_handle( process->handles, entry - process->handles->entries );
     return (old_access & RESERVED_ALL) >> RESERVED_SHIFT;
 }
 
@@ -590,6 +649,8 @@ obj_handle_t duplicate_handle( struct process *src, obj_handle_t src_handle, str
         {
             if (attr & OBJ_INHERIT) access |= RESERVED_INHERIT;
             entry->access = access;
+            if (!handle_is_global( src_handle ))
+                update_shared_handle( src->handles, entry - src->handles->entries );
             res = src_handle;
         }
         else
@@ -652,6 +713,33 @@ DECL_HANDLER(set_handle_info)
     reply->old_flags = set_handle_flags( current->process, req->handle, req->mask, req->flags );
 }
 
+/* get a read-only view of the process handle table */
+DECL_HANDLER(get_shared_handle_table)
+{
+    struct handle_table *table = current->process->handles;
+    void *ptr;
+    int i, count;
+
+    if (!table)
+    {
+        set_error( STATUS_PROCESS_IS_TERMINATING );
+        return;
+    }
+    if (!table->shared_mapping)
+    {
+        count = get_shared_handle_count( table->count );
+        if (!(table->shared_mapping = create_shared_mapping( count * sizeof(*table->shared), &ptr ))) return;
+        table->shared = ptr;
+        table->shared_count = count;
+        for (i = 0; i <= table->last; i++) update_shared_handle( table, i );
+    }
+    if (table->shared_count > req->count)
+        reply->handle = alloc_handle_no_access_check( current->process, table->shared_mapping,
+                                                      SECTION_MAP_READ | SECTION_QUERY, 0 );
+    /* the new handle may have grown the table */
+    reply->count = table->shared_count;
+}
+
 /* duplicate a handle */
 DECL_HANDLER(dup_handle)
 {
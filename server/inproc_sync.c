@@ -0,0 +1,264 @@
+/*
+ * Server-side shared state for in-process synchronization objects
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * Unnamed events, semaphores and mutexes keep their state in a memory
+ * area shared with the process that created them, so that ntdll can
+ * signal and acquire them without a server round trip as long as nobody
+ * is blocked on them. Each process gets its own area, mapped only into
+ * that process and the server; other processes that get a handle to the
+ * object through DuplicateHandle go through the server. The server
+ * remains the only one allowed to modify a slot while the
+ * INPROC_SYNC_WAITERS bit is set, i.e. while threads are waiting on the
+ * object through a select request.
+ *
+ * The client can write anything to its own area, so the values read
+ * from it are only ever used as object state, never trusted for the
+ * server's own consistency.
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winternl.h"
+
+#include "file.h"
+#include "handle.h"
+#include "process.h"
+#include "request.h"
+
+struct inproc_sync_area
+{
+    unsigned int   refcount;    /* references from the process and from allocated slots */
+    struct object *mapping;     /* mapping object shared with the process */
+    inproc_sync_t *syncs;       /* server view of the mapping */
+    unsigned int   next_free;   /* next never used slot, 0 means no slot */
+    unsigned int  *free_list;   /* stack of freed slots */
+    unsigned int   free_count;  /* number of entries in the free list */
+    unsigned int   free_size;   /* allocated size of the free list */
+    struct list    mutexes;     /* mutexes that may be owned by threads of the process */
+};
+
+#define INPROC_SYNC_AREA_SIZE (INPROC_SYNC_MAX_OBJECTS * sizeof(inproc_sync_t))
+
+/* check whether in-process synchronization has been enabled */
+int use_inproc_sync(void)
+{
+#ifdef __linux__
+    static int enabled = -1;
+
+    if (enabled == -1)
+    {
+        const char *env = getenv( "WINEINPROCSYNC" );
+        enabled = env && atoi( env );
+    }
+    return enabled;
+#else
+    return 0;
+#endif
+}
+
+static void release_area( struct inproc_sync_area *area )
+{
+    if (--area->refcount) return;
+    assert( list_empty( &area->mutexes ));
+    munmap( area->syncs, INPROC_SYNC_AREA_SIZE );
+    release_object( area->mapping );
+    free( area->free_list );
+    free( area );
+}
+
+/* get the area of a process, creating it on first use */
+static struct inproc_sync_area *get_process_area( struct process *process )
+{
+    struct inproc_sync_area *area;
+    void *ptr;
+
+    if (process->inproc_syncs) return process->inproc_syncs;
+
+    if (!(area = mem_alloc( sizeof(*area) ))) return NULL;
+    if (!(area->mapping = create_shared_mapping( INPROC_SYNC_AREA_SIZE, &ptr )))
+    {
+        free( area );
+        return NULL;
+    }
+    area->refcount   = 1;
+    area->syncs      = ptr;
+    area->next_free  = 1;
+    area->free_list  = NULL;
+    area->free_count = 0;
+    area->free_size  = 0;
+    list_init( &area->mutexes );
+    return process->inproc_syncs = area;
+}
+
+/* release the area reference held by a process */
+void release_process_inproc_syncs( struct process *process )
+{
+    if (!process->inproc_syncs) return;
+    release_area( process->inproc_syncs );
+    process->inproc_syncs = NULL;
+}
+
+/* allocate a slot for an object in the area of the process; return 0 if none is available */
+int alloc_inproc_sync( struct inproc_sync *sync, struct process *process,
+                       unsigned int flags, int state, int count )
+{
+    struct inproc_sync_area *area;
+    inproc_sync_t *shared;
+    unsigned int index;
+
+    sync->area  = NULL;
+    sync->index = 0;
+
+    if (!(area = get_process_area( process )))
+    {
+        clear_error();
+        return 0;
+    }
+
+    if (area->free_count) index = area->free_list[--area->free_count];
+    else if (area->next_free < INPROC_SYNC_MAX_OBJECTS) index = area->next_free++;
+    else return 0;
+
+    shared = &area->syncs[index];
+    shared->count = count;
+    shared->flags = flags;
+    __atomic_store_n( &shared->state, state, __ATOMIC_SEQ_CST );
+
+    area->refcount++;
+    sync->area  = area;
+    sync->index = index;
+    return 1;
+}
+
+/* release a slot once the owning object is destroyed */
+void free_inproc_sync( struct inproc_sync *sync )
+{
+    struct inproc_sync_area *area = sync->area;
+    inproc_sync_t *shared = get_inproc_sync( sync );
+
+    /* invalidate stale client references to the slot */
+    __atomic_add_fetch( &shared->serial, 1, __ATOMIC_SEQ_CST );
+    shared->flags = 0;
+    __atomic_store_n( &shared->state, 0, __ATOMIC_SEQ_CST );
+
+    if (area->free_count == area->free_size)
+    {
+        unsigned int size = max( 64, area->free_size * 2 );
+        unsigned int *list = realloc( area->free_list, size * sizeof(*list) );
+
+        if (list)
+        {
+            area->free_list = list;
+            area->free_size = size;
+        }
+    }
+    /* if the list couldn't grow, the slot is leaked */
+    if (area->free_count < area->free_size) area->free_list[area->free_count++] = sync->index;
+
+    sync->area  = NULL;
+    sync->index = 0;
+    release_area( area );
+}
+
+/* retrieve the shared slot of an object */
+inproc_sync_t *get_inproc_sync( const struct inproc_sync *sync )
+{
+    assert( sync->index && sync->index < sync->area->next_free );
+    return &sync->area->syncs[sync->index];
+}
+
+/* list of the mutexes in the same area as the object */
+struct list *get_inproc_sync_mutexes( const struct inproc_sync *sync )
+{
+    return &sync->area->mutexes;
+}
+
+/* list of the mutexes that threads of the process may own without the server knowing */
+struct list *get_process_inproc_mutexes( struct process *process )
+{
+    return process->inproc_syncs ? &process->inproc_syncs->mutexes : NULL;
+}
+
+/* get the current state value, without the waiters bit */
+int get_inproc_sync_state( const struct inproc_sync *sync )
+{
+    return __atomic_load_n( &get_inproc_sync( sync )->state, __ATOMIC_SEQ_CST ) & ~INPROC_SYNC_WAITERS;
+}
+
+/* atomically replace the state value if it matches 'old', keeping the waiters bit */
+/* returns the previous state value */
+int cmpxchg_inproc_sync_state( const struct inproc_sync *sync, int old, int new )
+{
+    inproc_sync_t *shared = get_inproc_sync( sync );
+    int cur = __atomic_load_n( &shared->state, __ATOMIC_SEQ_CST );
+
+    for (;;)
+    {
+        if ((cur & ~INPROC_SYNC_WAITERS) != old) break;
+        if (__atomic_compare_exchange_n( &shared->state, &cur, (cur & INPROC_SYNC_WAITERS) | new,
+                                         0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST ))
+            break;
+    }
+    return cur & ~INPROC_SYNC_WAITERS;
+}
+
+/* atomically replace the state value, keeping the waiters bit; returns the previous value */
+int set_inproc_sync_state( const struct inproc_sync *sync, int state )
+{
+    int prev, cur = get_inproc_sync_state( sync );
+
+    while ((prev = cmpxchg_inproc_sync_state( sync, cur, state )) != cur) cur = prev;
+    return prev;
+}
+
+/* a thread is about to wait on the object through the server */
+void add_inproc_sync_waiter( const struct inproc_sync *sync )
+{
+    __atomic_or_fetch( &get_inproc_sync( sync )->state, INPROC_SYNC_WAITERS, __ATOMIC_SEQ_CST );
+}
+
+/* the last server waiter is gone, let the clients modify the state again */
+void remove_inproc_sync_waiters( const struct inproc_sync *sync )
+{
+    __atomic_and_fetch( &get_inproc_sync( sync )->state, ~INPROC_SYNC_WAITERS, __ATOMIC_SEQ_CST );
+}
+
+/* get a handle to the in-process sync area of the current process */
+DECL_HANDLER(get_inproc_sync_mapping)
+{
+    struct inproc_sync_area *area = current->process->inproc_syncs;
+
+    if (!area)
+    {
+        set_error( STATUS_NOT_SUPPORTED );
+        return;
+    }
+    reply->handle = alloc_handle_no_access_check( current->process, area->mapping,
+                                                  SECTION_MAP_READ | SECTION_MAP_WRITE | SECTION_QUERY, 0 );
+}
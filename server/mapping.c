@@ -1089,6 +1089,48 @@ struct object *create_user_data_mapping( struct object *root, const struct unico
     return &mapping->obj;
 }
 
+/* create an anonymous mapping that the server keeps mapped to share data with clients */
+struct object *create_shared_mapping( mem_size_t size, void **ptr )
+{
+    struct mapping *mapping;
+    void *base;
+
+    if (!(mapping = create_mapping( NULL, NULL, 0, size, SEC_COMMIT, 0,
+                                    FILE_READ_DATA | FILE_WRITE_DATA, NULL ))) return NULL;
+    base = mmap( NULL, mapping->size, PROT_READ | PROT_WRITE, MAP_SHARED, get_unix_fd( mapping->fd ), 0 );
+    if (base == MAP_FAILED)
+    {
+        file_set_error();
+        release_object( mapping );
+        return NULL;
+    }
+    *ptr = base;
+    return &mapping->obj;
+}
+
+/* grow a mapping created by create_shared_mapping, moving the server view */
+/* views already mapped by clients stay valid since the file never shrinks */
+int grow_shared_mapping( struct object *obj, mem_size_t size, void **ptr )
+{
+    struct mapping *mapping = (struct mapping *)obj;
+    int unix_fd = get_unix_fd( mapping->fd );
+    void *base;
+
+    assert( obj->ops == &mapping_ops );
+    if (size <= mapping->size) return 1;
+    if (!grow_file( unix_fd, size )) return 0;
+    base = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, unix_fd, 0 );
+    if (base == MAP_FAILED)
+    {
+        file_set_error();
+        return 0;
+    }
+    munmap( *ptr, mapping->size );
+    mapping->size = size;
+    *ptr = base;
+    return 1;
+}
+
 /* create a file mapping */
 DECL_HANDLER(create_mapping)
 {
@@ -32,6 +32,7 @@
 #include "winternl.h"
 
 #include "handle.h"
+#include "process.h"
 #include "thread.h"
 #include "request.h"
 #include "security.h"
@@ -56,10 +57,13 @@ struct mutex
     struct thread *owner;           /* mutex owner */
     unsigned int   count;           /* recursion count */
     int            abandoned;       /* has it been abandoned? */
-    struct list    entry;           /* entry in owner thread mutex list */
+    struct list    entry;           /* entry in owner thread mutex list, or in the in-process sync area list */
+    struct inproc_sync inproc_sync; /* shared state for in-process sync */
 };
 
 static void mutex_dump( struct object *obj, int verbose );
+static int mutex_add_queue( struct object *obj, struct wait_queue_entry *entry );
+static void mutex_remove_queue( struct object *obj, struct wait_queue_entry *entry );
 static int mutex_signaled( struct object *obj, struct wait_queue_entry *entry );
 static void mutex_satisfied( struct object *obj, struct wait_queue_entry *entry );
 static void mutex_destroy( struct object *obj );
@@ -70,8 +74,8 @@ static const struct object_ops mutex_ops =
     sizeof(struct mutex),      /* size */
     &mutex_type,               /* type */
     mutex_dump,                /* dump */
-    add_queue,                 /* add_queue */
-    remove_queue,              /* remove_queue */
+    mutex_add_queue,           /* add_queue */
+    mutex_remove_queue,        /* remove_queue */
     mutex_signaled,            /* signaled */
     mutex_satisfied,           /* satisfied */
     mutex_signal,              /* signal */
@@ -126,20 +130,106 @@ static struct mutex *create_mutex( struct object *root, const struct unicode_str
             mutex->count = 0;
             mutex->owner = NULL;
             mutex->abandoned = 0;
+            mutex->inproc_sync.index = 0;
             if (owned) do_grab( mutex, current );
         }
     }
     return mutex;
 }
 
+/* move the mutex owner and count to shared memory so that the client can access them directly */
+/* the mutex is then kept in the area list, where the threads of the process find it when they exit; */
+/* threads of other processes can only acquire it through the server, which keeps it in their list */
+static void mutex_init_inproc_sync( struct mutex *mutex )
+{
+    thread_id_t owner = mutex->owner ? mutex->owner->id : 0;
+
+    if (!alloc_inproc_sync( &mutex->inproc_sync, current->process, INPROC_SYNC_MUTEX,
+                            owner, mutex->count )) return;
+    if (mutex->owner) list_remove( &mutex->entry );
+    list_add_tail( get_inproc_sync_mutexes( &mutex->inproc_sync ), &mutex->entry );
+    mutex->owner = NULL;
+    mutex->count = 0;
+}
+
+/* release an in-process mutex once the recursion count is 0 */
+static void inproc_release( struct mutex *mutex, int abandoned )
+{
+    inproc_sync_t *sync = get_inproc_sync( &mutex->inproc_sync );
+
+    if (mutex->owner)  /* owned by a thread of another process, give it back to the area */
+    {
+        list_remove( &mutex->entry );
+        list_add_tail( get_inproc_sync_mutexes( &mutex->inproc_sync ), &mutex->entry );
+        mutex->owner = NULL;
+    }
+    __atomic_store_n( &sync->count, 0, __ATOMIC_SEQ_CST );
+    if (abandoned) __atomic_or_fetch( &sync->flags, INPROC_SYNC_ABANDONED, __ATOMIC_SEQ_CST );
+    set_inproc_sync_state( &mutex->inproc_sync, 0 );
+    wake_up( &mutex->obj, 0 );
+}
+
+/* release a mutex owned by the current thread, return the previous recursion count */
+static unsigned int release_mutex( struct mutex *mutex )
+{
+    unsigned int prev;
+
+    if (mutex->inproc_sync.index)
+    {
+        inproc_sync_t *sync = get_inproc_sync( &mutex->inproc_sync );
+
+        if (get_inproc_sync_state( &mutex->inproc_sync ) != current->id)
+        {
+            set_error( STATUS_MUTANT_NOT_OWNED );
+            return 0;
+        }
+        prev = __atomic_fetch_sub( &sync->count, 1, __ATOMIC_SEQ_CST );
+        if (prev == 1) inproc_release( mutex, 0 );
+        return prev;
+    }
+
+    if (!mutex->count || (mutex->owner != current))
+    {
+        set_error( STATUS_MUTANT_NOT_OWNED );
+        return 0;
+    }
+    prev = mutex->count;
+    if (!--mutex->count) do_release( mutex );
+    return prev;
+}
+
 void abandon_mutexes( struct thread *thread )
 {
+    struct list *inproc_mutexes = get_process_inproc_mutexes( thread->process );
+    struct mutex *mutex;
     struct list *ptr;
 
+    /* in-process mutexes of the thread's own process may have been acquired without the server */
+    if (inproc_mutexes)
+    {
+    restart:
+        LIST_FOR_EACH_ENTRY( mutex, inproc_mutexes, struct mutex, entry )
+        {
+            if (get_inproc_sync_state( &mutex->inproc_sync ) != thread->id) continue;
+            /* waking up waiters may release other mutexes, so start over afterwards */
+            grab_object( mutex );
+            inproc_release( mutex, 1 );
+            release_object( mutex );
+            goto restart;
+        }
+    }
+
     while ((ptr = list_head( &thread->mutex_list )) != NULL)
     {
         struct mutex *mutex = LIST_ENTRY( ptr, struct mutex, entry );
         assert( mutex->owner == thread );
+        if (mutex->inproc_sync.index)
+        {
+            grab_object( mutex );
+            inproc_release( mutex, 1 );
+            release_object( mutex );
+            continue;
+        }
         mutex->count = 0;
         mutex->abandoned = 1;
         do_release( mutex );
@@ -150,13 +240,41 @@ static void mutex_dump( struct object *obj, int verbose )
 {
     struct mutex *mutex = (struct mutex *)obj;
     assert( obj->ops == &mutex_ops );
-    fprintf( stderr, "Mutex count=%u owner=%p\n", mutex->count, mutex->owner );
+    if (mutex->inproc_sync.index)
+        fprintf( stderr, "Mutex count=%d owner=%04x inproc=%u\n",
+                 get_inproc_sync( &mutex->inproc_sync )->count,
+                 get_inproc_sync_state( &mutex->inproc_sync ), mutex->inproc_sync.index );
+    else
+        fprintf( stderr, "Mutex count=%u owner=%p\n", mutex->count, mutex->owner );
+}
+
+static int mutex_add_queue( struct object *obj, struct wait_queue_entry *entry )
+{
+    struct mutex *mutex = (struct mutex *)obj;
+    assert( obj->ops == &mutex_ops );
+    /* make the client go through the server while we have waiters */
+    if (mutex->inproc_sync.index) add_inproc_sync_waiter( &mutex->inproc_sync );
+    return add_queue( obj, entry );
+}
+
+static void mutex_remove_queue( struct object *obj, struct wait_queue_entry *entry )
+{
+    struct mutex *mutex = (struct mutex *)obj;
+    assert( obj->ops == &mutex_ops );
+    remove_queue( obj, entry );
+    if (mutex->inproc_sync.index && list_empty( &obj->wait_queue ))
+        remove_inproc_sync_waiters( &mutex->inproc_sync );
 }
 
 static int mutex_signaled( struct object *obj, struct wait_queue_entry *entry )
 {
     struct mutex *mutex = (struct mutex *)obj;
     assert( obj->ops == &mutex_ops );
+    if (mutex->inproc_sync.index)
+    {
+        thread_id_t owner = get_inproc_sync_state( &mutex->inproc_sync );
+        return (!owner || owner == get_wait_queue_thread( entry )->id);
+    }
     return (!mutex->count || (mutex->owner == get_wait_queue_thread( entry )));
 }
 
@@ -165,6 +283,35 @@ static void mutex_satisfied( struct object *obj, struct wait_queue_entry *entry
     struct mutex *mutex = (struct mutex *)obj;
     assert( obj->ops == &mutex_ops );
 
+    if (mutex->inproc_sync.index)
+    {
+        inproc_sync_t *sync = get_inproc_sync( &mutex->inproc_sync );
+        struct thread *thread = get_wait_queue_thread( entry );
+
+        /* the client of another process can't release it without us, so we track the owner */
+        if (thread->process->inproc_syncs != mutex->inproc_sync.area)
+        {
+            if (mutex->owner != thread)
+            {
+                list_remove( &mutex->entry );
+                list_add_head( &thread->mutex_list, &mutex->entry );
+                mutex->owner = thread;
+            }
+        }
+        else if (mutex->owner)  /* the state was changed behind our back */
+        {
+            list_remove( &mutex->entry );
+            list_add_tail( get_inproc_sync_mutexes( &mutex->inproc_sync ), &mutex->entry );
+            mutex->owner = NULL;
+        }
+        /* the client doesn't touch the state while we have waiters */
+        set_inproc_sync_state( &mutex->inproc_sync, thread->id );
+        __atomic_add_fetch( &sync->count, 1, __ATOMIC_SEQ_CST );
+        if (__atomic_fetch_and( &sync->flags, ~INPROC_SYNC_ABANDONED, __ATOMIC_SEQ_CST ) & INPROC_SYNC_ABANDONED)
+            make_wait_abandoned( entry );
+        return;
+    }
+
     do_grab( mutex, get_wait_queue_thread( entry ));
     if (mutex->abandoned) make_wait_abandoned( entry );
     mutex->abandoned = 0;
@@ -180,13 +327,7 @@ static int mutex_signal( struct object *obj, unsigned int access )
         set_error( STATUS_ACCESS_DENIED );
         return 0;
     }
-    if (!mutex->count || (mutex->owner != current))
-    {
-        set_error( STATUS_MUTANT_NOT_OWNED );
-        return 0;
-    }
-    if (!--mutex->count) do_release( mutex );
-    return 1;
+    return release_mutex( mutex ) != 0;
 }
 
 static void mutex_destroy( struct object *obj )
@@ -194,6 +335,12 @@ static void mutex_destroy( struct object *obj )
     struct mutex *mutex = (struct mutex *)obj;
     assert( obj->ops == &mutex_ops );
 
+    if (mutex->inproc_sync.index)
+    {
+        list_remove( &mutex->entry );
+        free_inproc_sync( &mutex->inproc_sync );
+        return;
+    }
     if (!mutex->count) return;
     mutex->count = 0;
     do_release( mutex );
@@ -215,8 +362,16 @@ DECL_HANDLER(create_mutex)
         if (get_error() == STATUS_OBJECT_NAME_EXISTS)
             reply->handle = alloc_handle( current->process, mutex, req->access, objattr->attributes );
         else
+        {
+            if (!name.len && !(objattr->attributes & OBJ_INHERIT) && use_inproc_sync())
+                mutex_init_inproc_sync( mutex );
             reply->handle = alloc_handle_no_access_check( current->process, mutex,
                                                           req->access, objattr->attributes );
+        }
+        /* the client can only use the shared state if the handle allows all operations */
+        if (reply->handle && mutex->inproc_sync.index &&
+            !(~get_handle_access( current->process, reply->handle ) & (SYNCHRONIZE | MUTANT_QUERY_STATE)))
+            reply->inproc_sync = mutex->inproc_sync.index;
         release_object( mutex );
     }
 
@@ -240,12 +395,7 @@ DECL_HANDLER(release_mutex)
     if ((mutex = (struct mutex *)get_handle_obj( current->process, req->handle,
                                                  0, &mutex_ops )))
     {
-        if (!mutex->count || (mutex->owner != current)) set_error( STATUS_MUTANT_NOT_OWNED );
-        else
-        {
-            reply->prev_count = mutex->count;
-            if (!--mutex->count) do_release( mutex );
-        }
+        reply->prev_count = release_mutex( mutex );
         release_object( mutex );
     }
 }
@@ -258,9 +408,21 @@ DECL_HANDLER(query_mutex)
     if ((mutex = (struct mutex *)get_handle_obj( current->process, req->handle,
                                                  MUTANT_QUERY_STATE, &mutex_ops )))
     {
-        reply->count = mutex->count;
-        reply->owned = (mutex->owner == current);
-        reply->abandoned = mutex->abandoned;
+        if (mutex->inproc_sync.index)
+        {
+            inproc_sync_t *sync = get_inproc_sync( &mutex->inproc_sync );
+            thread_id_t owner = get_inproc_sync_state( &mutex->inproc_sync );
+
+            reply->count = owner ? __atomic_load_n( &sync->count, __ATOMIC_SEQ_CST ) : 0;
+            reply->owned = (owner == current->id);
+            reply->abandoned = !!(__atomic_load_n( &sync->flags, __ATOMIC_SEQ_CST ) & INPROC_SYNC_ABANDONED);
+        }
+        else
+        {
+            reply->count = mutex->count;
+            reply->owned = (mutex->owner == current);
+            reply->abandoned = mutex->abandoned;
+        }
 
         release_object( mutex );
     }
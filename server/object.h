@@ -45,6 +45,7 @@ struct async;
 struct async_queue;
 struct winstation;
 struct object_type;
+struct inproc_sync_area;
 
 
 struct unicode_str
@@ -218,6 +219,28 @@ extern struct keyed_event *get_keyed_event_obj( struct process *process, obj_han
 extern void set_event( struct event *event );
 extern void reset_event( struct event *event );
 
+/* in-process synchronization functions */
+
+struct inproc_sync
+{
+    struct inproc_sync_area *area;   /* shared area of the process that created the object */
+    unsigned int             index;  /* index of the slot in the area, 0 if none */
+};
+
+extern int use_inproc_sync(void);
+extern void release_process_inproc_syncs( struct process *process );
+extern int alloc_inproc_sync( struct inproc_sync *sync, struct process *process,
+                              unsigned int flags, int state, int count );
+extern void free_inproc_sync( struct inproc_sync *sync );
+extern inproc_sync_t *get_inproc_sync( const struct inproc_sync *sync );
+extern struct list *get_inproc_sync_mutexes( const struct inproc_sync *sync );
+extern struct list *get_process_inproc_mutexes( struct process *process );
+extern int get_inproc_sync_state( const struct inproc_sync *sync );
+extern int cmpxchg_inproc_sync_state( const struct inproc_sync *sync, int old, int new );
+extern int set_inproc_sync_state( const struct inproc_sync *sync, int state );
+extern void add_inproc_sync_waiter( const struct inproc_sync *sync );
+extern void remove_inproc_sync_waiters( const struct inproc_sync *sync );
+
 /* mutex functions */
 
 extern void abandon_mutexes( struct thread *thread );
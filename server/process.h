@@ -88,6 +88,7 @@ struct process
     const struct rawinput_device *rawinput_mouse; /* rawinput mouse device, if any */
     const struct rawinput_device *rawinput_kbd;   /* rawinput keyboard device, if any */
     struct list          kernel_object;   /* list of kernel object pointers */
+    struct inproc_sync_area *inproc_syncs; /* shared state of in-process sync objects */
 };
 
 /* process functions */
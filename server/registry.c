@@ -35,6 +35,13 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/types.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -85,7 +92,11 @@ struct key
     struct key       *parent;      /* parent key */
     int               last_subkey; /* last in use subkey */
     int               nb_subkeys;  /* count of allocated subkeys */
+    int               sorted_subkeys; /* count of subkeys at the start of the array that are sorted */
     struct key      **subkeys;     /* subkeys array */
+    struct key      **subkey_hash; /* hash table of subkeys, for keys with many subkeys */
+    unsigned int      subkey_hash_size; /* size of the subkey hash table */
+    struct key       *hash_next;   /* next key in the parent hash table bucket */
     int               last_value;  /* last in use value */
     int               nb_values;   /* count of allocated values in array */
     struct key_value *values;      /* values array */
@@ -113,6 +124,7 @@ struct key_value
 };
 
 #define MIN_SUBKEYS  8   /* min. number of allocated subkeys per key */
+#define MIN_HASHED_SUBKEYS 256  /* number of subkeys above which a key uses a hash table */
 #define MIN_VALUES   8   /* min. number of allocated values per key */
 
 #define MAX_NAME_LEN  256    /* max. length of a key name */
@@ -132,6 +144,7 @@ static const WCHAR symlink_value[] = {'S','y','m','b','o','l','i','c','L','i','n
 static const struct unicode_str symlink_str = { symlink_value, sizeof(symlink_value) };
 
 static void set_periodic_save_timer(void);
+static void sort_subkeys( struct key *key );
 static struct key_value *find_value( const struct key *key, const struct unicode_str *name, int *index );
 
 /* information about where to save a registry branch */
@@ -144,11 +157,49 @@ struct save_branch_info
 #define MAX_SAVE_BRANCH_INFO 3
 static int save_branch_count;
 static struct save_branch_info save_branch_info[MAX_SAVE_BRANCH_INFO];
+static pid_t save_pid;              /* process doing a periodic save in the background */
+static int save_status_fd = -1;     /* pipe the process writes its result to */
+static unsigned int save_pid_mask;  /* branches it is saving */
 
 unsigned int supported_machines_count = 0;
 unsigned short supported_machines[8];
 unsigned short native_machine = 0;
 
+/* header of a binary registry cache file */
+struct bin_registry_header
+{
+    char             magic[8];    /* BIN_REGISTRY_MAGIC */
+    unsigned int     prefix;      /* prefix type */
+    unsigned int     text_mtime_nsec; /* nanoseconds part of the text file modification time */
+    unsigned __int64 size;        /* total size of the cache file */
+    unsigned __int64 text_size;   /* size of the text file the cache matches */
+    unsigned __int64 text_mtime;  /* modification time of the text file */
+    unsigned __int64 text_ino;    /* inode of the text file */
+};
+
+/* a key in a binary registry cache file, followed by its name, class, values and subkeys */
+struct bin_registry_key
+{
+    timeout_t        modif;       /* last modification time */
+    unsigned int     flags;       /* KEY_SYMLINK or 0 */
+    unsigned int     values;      /* number of values */
+    unsigned int     subkeys;     /* number of subkeys */
+    unsigned short   namelen;     /* length of key name */
+    unsigned short   classlen;    /* length of class name */
+};
+
+/* a value in a binary registry cache file, followed by its name and data */
+struct bin_registry_value
+{
+    unsigned int     type;        /* value type */
+    data_size_t      len;         /* value data length in bytes */
+    unsigned short   namelen;     /* length of value name */
+    unsigned short   reserved;
+};
+
+#define BIN_REGISTRY_MAGIC "WINEREG2"
+#define BIN_REGISTRY_ALIGN(len) (((len) + 7) & ~7)
+
 /* information about a file being loaded */
 struct file_load_info
 {
@@ -274,11 +325,12 @@ static void dump_value( const struct key_value *value, FILE *f )
 }
 
 /* save a registry and all its subkeys to a text file */
-static void save_subkeys( const struct key *key, const struct key *base, FILE *f )
+static void save_subkeys( struct key *key, const struct key *base, FILE *f )
 {
     int i;
 
     if (key->flags & KEY_VOLATILE) return;
+    sort_subkeys( key );
     /* save key if it has either some values or no subkeys, or needs special options */
     /* keys with no values but subkeys are saved implicitly by saving the subkeys */
     if ((key->last_value >= 0) || (key->last_subkey == -1) || key->class || (key->flags & KEY_SYMLINK))
@@ -464,6 +516,7 @@ static void key_destroy( struct object *obj )
         release_object( key->subkeys[i] );
     }
     free( key->subkeys );
+    free( key->subkey_hash );
     /* unconditionally notify everything waiting on this key */
     while ((ptr = list_head( &key->notify_list )))
     {
@@ -525,7 +578,11 @@ static struct key *alloc_key( const struct unicode_str *name, timeout_t modif )
         key->flags       = 0;
         key->last_subkey = -1;
         key->nb_subkeys  = 0;
+        key->sorted_subkeys = 0;
         key->subkeys     = NULL;
+        key->subkey_hash = NULL;
+        key->subkey_hash_size = 0;
+        key->hash_next   = NULL;
         key->nb_values   = 0;
         key->last_value  = -1;
         key->values      = NULL;
@@ -615,6 +672,81 @@ static int grow_subkeys( struct key *key )
     return 1;
 }
 
+/* compare two subkeys by name, for sorting */
+static int compare_subkeys( const void *p1, const void *p2 )
+{
+    const struct key *key1 = *(const struct key * const *)p1;
+    const struct key *key2 = *(const struct key * const *)p2;
+    int res = memicmp_strW( key1->name, key2->name, min( key1->namelen, key2->namelen ));
+
+    if (!res) res = key1->namelen - key2->namelen;
+    return res;
+}
+
+/* sort the subkeys that have been appended to a hashed key since the last time */
+static void sort_subkeys( struct key *key )
+{
+    struct key **sorted;
+    int i, j, k, count = key->last_subkey + 1;
+
+    if (key->sorted_subkeys == count) return;
+
+    qsort( key->subkeys + key->sorted_subkeys, count - key->sorted_subkeys,
+           sizeof(*key->subkeys), compare_subkeys );
+
+    if (key->sorted_subkeys && (sorted = malloc( key->nb_subkeys * sizeof(*sorted) )))
+    {
+        /* merge the sorted tail into the rest of the array */
+        for (i = 0, j = key->sorted_subkeys, k = 0; k < count; k++)
+        {
+            if (j == count || (i < key->sorted_subkeys &&
+                               compare_subkeys( &key->subkeys[i], &key->subkeys[j] ) < 0))
+                sorted[k] = key->subkeys[i++];
+            else
+                sorted[k] = key->subkeys[j++];
+        }
+        free( key->subkeys );
+        key->subkeys = sorted;
+    }
+    else if (key->sorted_subkeys)
+        qsort( key->subkeys, count, sizeof(*key->subkeys), compare_subkeys );
+
+    key->sorted_subkeys = count;
+}
+
+/* add a subkey to the hash table of its parent */
+static void add_subkey_hash( struct key *parent, struct key *key )
+{
+    unsigned int hash = hash_strW( key->name, key->namelen, parent->subkey_hash_size );
+
+    key->hash_next = parent->subkey_hash[hash];
+    parent->subkey_hash[hash] = key;
+}
+
+/* remove a subkey from the hash table of its parent */
+static void remove_subkey_hash( struct key *parent, struct key *key )
+{
+    struct key **ptr = &parent->subkey_hash[hash_strW( key->name, key->namelen, parent->subkey_hash_size )];
+
+    while (*ptr != key) ptr = &(*ptr)->hash_next;
+    *ptr = key->hash_next;
+    key->hash_next = NULL;
+}
+
+/* (re)build the hash table of a key with many subkeys; on failure the old one is kept unchanged */
+static int rehash_subkeys( struct key *key, unsigned int size )
+{
+    struct key **hash;
+    int i;
+
+    if (!(hash = calloc( size, sizeof(*hash) ))) return 0;
+    free( key->subkey_hash );
+    key->subkey_hash = hash;
+    key->subkey_hash_size = size;
+    for (i = 0; i <= key->last_subkey; i++) add_subkey_hash( key, key->subkeys[i] );
+    return 1;
+}
+
 /* allocate a subkey for a given key, and return its index */
 static struct key *alloc_subkey( struct key *parent, const struct unicode_str *name,
                                  int index, timeout_t modif )
@@ -635,9 +767,25 @@ static struct key *alloc_subkey( struct key *parent, const struct unicode_str *n
     if ((key = alloc_key( name, modif )) != NULL)
     {
         key->parent = parent;
-        for (i = ++parent->last_subkey; i > index; i--)
-            parent->subkeys[i] = parent->subkeys[i-1];
-        parent->subkeys[index] = key;
+        if (parent->subkey_hash)
+        {
+            /* new subkeys are appended, and sorted only when the order is needed */
+            assert( index == parent->last_subkey + 1 );
+            parent->subkeys[++parent->last_subkey] = key;
+            /* if the table can't grow, keep using the current one */
+            if (parent->last_subkey < 2 * parent->subkey_hash_size ||
+                !rehash_subkeys( parent, 4 * parent->subkey_hash_size + 1 ))
+                add_subkey_hash( parent, key );
+        }
+        else
+        {
+            for (i = ++parent->last_subkey; i > index; i--)
+                parent->subkeys[i] = parent->subkeys[i-1];
+            parent->subkeys[index] = key;
+            parent->sorted_subkeys++;
+            if (parent->last_subkey + 1 >= MIN_HASHED_SUBKEYS)
+                rehash_subkeys( parent, 2 * MIN_HASHED_SUBKEYS + 1 );
+        }
         if (is_wow6432node( key->name, key->namelen ) && !is_wow6432node( parent->name, parent->namelen ))
             parent->flags |= KEY_WOW64;
     }
@@ -654,6 +802,8 @@ static void free_subkey( struct key *parent, int index )
     assert( index <= parent->last_subkey );
 
     key = parent->subkeys[index];
+    if (parent->subkey_hash) remove_subkey_hash( parent, key );
+    if (index < parent->sorted_subkeys) parent->sorted_subkeys--;
     for (i = index; i < parent->last_subkey; i++) parent->subkeys[i] = parent->subkeys[i + 1];
     parent->last_subkey--;
     key->flags |= KEY_DELETED;
@@ -675,11 +825,25 @@ static void free_subkey( struct key *parent, int index )
 }
 
 /* find the named child of a given key and return its index */
+/* for hashed keys, the index is only meaningful when the child is not found */
 static struct key *find_subkey( const struct key *key, const struct unicode_str *name, int *index )
 {
     int i, min, max, res;
     data_size_t len;
 
+    if (key->subkey_hash)
+    {
+        struct key *subkey = key->subkey_hash[hash_strW( name->str, name->len, key->subkey_hash_size )];
+
+        for ( ; subkey; subkey = subkey->hash_next)
+        {
+            if (subkey->namelen != name->len) continue;
+            if (!memicmp_strW( subkey->name, name->str, name->len )) break;
+        }
+        *index = key->last_subkey + 1;  /* always append new subkeys */
+        return subkey;
+    }
+
     min = 0;
     max = key->last_subkey;
     while (min <= max)
@@ -932,6 +1096,7 @@ static void enum_key( struct key *key, int index, int info_class, struct enum_ke
             set_error( STATUS_NO_MORE_ENTRIES );
             return;
         }
+        sort_subkeys( key );
         key = key->subkeys[index];
     }
 
@@ -1718,13 +1883,41 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
 }
 
 /* load a part of the registry from a file */
+static int load_bin_registry( const char *path, struct key *key );
+static int save_bin_registry( struct key *key, const char *path );
+
+/* get the unix name of a registry hive file, for use with the binary cache */
+static char *get_hive_file_name( struct file *file )
+{
+    struct fd *fd = get_obj_fd( (struct object *)file );
+    struct stat st, name_st;
+    char *name;
+
+    if (!fd) return NULL;
+    name = dup_fd_name( fd, "" );
+    release_object( fd );
+
+    /* make sure the name still refers to the opened file */
+    if (name && (fstat( get_file_unix_fd( file ), &st ) == -1 || stat( name, &name_st ) == -1 ||
+                 st.st_dev != name_st.st_dev || st.st_ino != name_st.st_ino))
+    {
+        free( name );
+        name = NULL;
+    }
+    return name;
+}
+
 static void load_registry( struct key *key, obj_handle_t handle )
 {
     struct file *file;
-    int fd;
+    char *name;
+    int fd, ret;
 
     if (!(file = get_file_obj( current->process, handle, FILE_READ_DATA ))) return;
-    fd = dup( get_file_unix_fd( file ) );
+    name = get_hive_file_name( file );
+    ret = name && load_bin_registry( name, key );
+    free( name );
+    fd = ret ? -1 : dup( get_file_unix_fd( file ) );
     release_object( file );
     if (fd != -1)
     {
@@ -1738,12 +1931,314 @@ static void load_registry( struct key *key, obj_handle_t handle )
     }
 }
 
+/* check whether the binary registry cache has been enabled */
+static int use_bin_registry(void)
+{
+    static int enabled = -1;
+
+    if (enabled == -1)
+    {
+        const char *env = getenv( "WINEREGISTRYCACHE" );
+        enabled = env && atoi( env );
+    }
+    return enabled;
+}
+
+/* get the nanoseconds part of a file modification time, where available */
+static unsigned int get_mtime_nsec( const struct stat *st )
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    return st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    return st->st_mtimespec.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+/* build the name of the binary cache for a registry file */
+static char *get_bin_registry_name( const char *path )
+{
+    char *name = malloc( strlen(path) + sizeof(".bin") );
+
+    if (name) strcat( strcpy( name, path ), ".bin" );
+    return name;
+}
+
+/* write a block of data to a binary cache file, padded to the record alignment */
+static void write_bin_block( const void *data, size_t len, FILE *f )
+{
+    static const char zero[8];
+
+    fwrite( data, len, 1, f );
+    fwrite( zero, BIN_REGISTRY_ALIGN(len) - len, 1, f );
+}
+
+/* save a key and all its non-volatile subkeys to a binary cache file */
+static void save_bin_key( struct key *key, FILE *f )
+{
+    struct bin_registry_key bin;
+    struct bin_registry_value val;
+    int i;
+
+    sort_subkeys( key );
+
+    bin.modif    = key->modif;
+    bin.flags    = key->flags & KEY_SYMLINK;
+    bin.values   = key->last_value + 1;
+    bin.subkeys  = 0;
+    bin.namelen  = key->namelen;
+    bin.classlen = key->class ? key->classlen : 0;
+    for (i = 0; i <= key->last_subkey; i++)
+        if (!(key->subkeys[i]->flags & KEY_VOLATILE)) bin.subkeys++;
+
+    write_bin_block( &bin, sizeof(bin), f );
+    write_bin_block( key->name, bin.namelen, f );
+    write_bin_block( key->class, bin.classlen, f );
+    for (i = 0; i <= key->last_value; i++)
+    {
+        const struct key_value *value = &key->values[i];
+
+        memset( &val, 0, sizeof(val) );
+        val.type    = value->type;
+        val.len     = value->len;
+        val.namelen = value->namelen;
+        write_bin_block( &val, sizeof(val), f );
+        write_bin_block( value->name, value->namelen, f );
+        write_bin_block( value->data, value->len, f );
+    }
+    for (i = 0; i <= key->last_subkey; i++)
+        if (!(key->subkeys[i]->flags & KEY_VOLATILE)) save_bin_key( key->subkeys[i], f );
+}
+
+/* save a registry branch to the binary cache of the text file 'path', which must be up to date */
+static int save_bin_registry( struct key *key, const char *path )
+{
+    struct bin_registry_header header;
+    struct stat st;
+    char *name, *tmp = NULL;
+    long pos;
+    int ret = 0;
+    FILE *f;
+
+    if (!use_bin_registry()) return 1;
+    if (stat( path, &st ) == -1) return 0;
+    if (!(name = get_bin_registry_name( path ))) return 0;
+    if (!(tmp = malloc( strlen(name) + sizeof(".tmp") ))) goto done;
+    strcat( strcpy( tmp, name ), ".tmp" );
+    if (!(f = fopen( tmp, "wb" ))) goto done;
+
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, BIN_REGISTRY_MAGIC, sizeof(header.magic) );
+    header.prefix     = prefix_type;
+    header.text_size  = st.st_size;
+    header.text_mtime = st.st_mtime;
+    header.text_mtime_nsec = get_mtime_nsec( &st );
+    header.text_ino   = st.st_ino;
+    fwrite( &header, sizeof(header), 1, f );
+    save_bin_key( key, f );
+
+    /* the size is written last, so that a truncated file is never considered valid */
+    if ((pos = ftell( f )) != -1 && !fseek( f, 0, SEEK_SET ))
+    {
+        header.size = pos;
+        fwrite( &header, sizeof(header), 1, f );
+    }
+    ret = !ferror( f ) && pos != -1;
+    if (fclose( f )) ret = 0;
+    if (ret) ret = !rename( tmp, name );
+    if (!ret) unlink( tmp );
+
+done:
+    free( tmp );
+    free( name );
+    return ret;
+}
+
+/* check that a binary cache key record and its subtree lie within the file */
+static int check_bin_key( const char *base, size_t size, size_t *pos, int depth )
+{
+    struct bin_registry_key bin;
+    struct bin_registry_value val;
+    unsigned int i;
+
+    if (depth > 512) return 0;
+    if (size - *pos < sizeof(bin)) return 0;
+    memcpy( &bin, base + *pos, sizeof(bin) );
+    *pos += sizeof(bin);
+    if (bin.namelen > MAX_NAME_LEN * sizeof(WCHAR) || (bin.namelen | bin.classlen) % sizeof(WCHAR)) return 0;
+    if (size - *pos < BIN_REGISTRY_ALIGN(bin.namelen) + BIN_REGISTRY_ALIGN(bin.classlen)) return 0;
+    *pos += BIN_REGISTRY_ALIGN(bin.namelen) + BIN_REGISTRY_ALIGN(bin.classlen);
+
+    for (i = 0; i < bin.values; i++)
+    {
+        if (size - *pos < sizeof(val)) return 0;
+        memcpy( &val, base + *pos, sizeof(val) );
+        *pos += sizeof(val);
+        if (val.namelen % sizeof(WCHAR)) return 0;
+        if (size - *pos < BIN_REGISTRY_ALIGN(val.namelen)) return 0;
+        *pos += BIN_REGISTRY_ALIGN(val.namelen);
+        if (size - *pos < BIN_REGISTRY_ALIGN((size_t)val.len)) return 0;
+        *pos += BIN_REGISTRY_ALIGN((size_t)val.len);
+    }
+    for (i = 0; i < bin.subkeys; i++)
+        if (!check_bin_key( base, size, pos, depth + 1 )) return 0;
+    return 1;
+}
+
+/* load a key and its subtree from a binary cache file already validated by check_bin_key */
+static int load_bin_key( struct key *key, const char *base, size_t *pos )
+{
+    struct bin_registry_key bin;
+    struct bin_registry_value val;
+    struct key_value *value;
+    struct unicode_str name;
+    struct key *subkey;
+    unsigned int i;
+    int index;
+
+    memcpy( &bin, base + *pos, sizeof(bin) );
+    *pos += sizeof(bin) + BIN_REGISTRY_ALIGN(bin.namelen);
+
+    key->modif = bin.modif;
+    key->flags |= bin.flags & KEY_SYMLINK;
+    if (bin.classlen)
+    {
+        free( key->class );
+        if (!(key->class = memdup( base + *pos, bin.classlen ))) return 0;
+        key->classlen = bin.classlen;
+    }
+    *pos += BIN_REGISTRY_ALIGN(bin.classlen);
+
+    for (i = 0; i < bin.values; i++)
+    {
+        void *data = NULL;
+
+        memcpy( &val, base + *pos, sizeof(val) );
+        *pos += sizeof(val);
+        name.str = (const WCHAR *)(base + *pos);
+        name.len = val.namelen;
+        *pos += BIN_REGISTRY_ALIGN(val.namelen);
+        if (val.len && !(data = memdup( base + *pos, val.len ))) return 0;
+        *pos += BIN_REGISTRY_ALIGN((size_t)val.len);
+
+        if (!(value = find_value( key, &name, &index )) &&
+            !(value = insert_value( key, &name, index )))
+        {
+            free( data );
+            return 0;
+        }
+        free( value->data );
+        value->type = val.type;
+        value->len  = val.len;
+        value->data = data;
+    }
+
+    for (i = 0; i < bin.subkeys; i++)
+    {
+        memcpy( &bin, base + *pos, sizeof(bin) );
+        name.str = (const WCHAR *)(base + *pos + sizeof(bin));
+        name.len = bin.namelen;
+        if (!(subkey = find_subkey( key, &name, &index )) &&
+            !(subkey = alloc_subkey( key, &name, index, bin.modif )))
+            return 0;
+        if (!load_bin_key( subkey, base, pos )) return 0;
+    }
+    return 1;
+}
+
+/* move the contents of a branch loaded from a binary cache into the empty key 'key' */
+static void graft_bin_key( struct key *key, struct key *scratch )
+{
+    int i;
+
+    key->class            = scratch->class;
+    key->classlen         = scratch->classlen;
+    key->last_subkey      = scratch->last_subkey;
+    key->nb_subkeys       = scratch->nb_subkeys;
+    key->sorted_subkeys   = scratch->sorted_subkeys;
+    key->subkeys          = scratch->subkeys;
+    key->subkey_hash      = scratch->subkey_hash;
+    key->subkey_hash_size = scratch->subkey_hash_size;
+    key->last_value       = scratch->last_value;
+    key->nb_values        = scratch->nb_values;
+    key->values           = scratch->values;
+    key->modif            = scratch->modif;
+    key->flags           |= scratch->flags & (KEY_SYMLINK | KEY_WOW64);
+    for (i = 0; i <= key->last_subkey; i++) key->subkeys[i]->parent = key;
+
+    scratch->class       = NULL;
+    scratch->classlen    = 0;
+    scratch->last_subkey = -1;
+    scratch->nb_subkeys  = 0;
+    scratch->sorted_subkeys = 0;
+    scratch->subkeys     = NULL;
+    scratch->subkey_hash = NULL;
+    scratch->subkey_hash_size = 0;
+    scratch->last_value  = -1;
+    scratch->nb_values   = 0;
+    scratch->values      = NULL;
+}
+
+/* load a registry branch from the binary cache of the text file 'path', if it is up to date */
+static int load_bin_registry( const char *path, struct key *key )
+{
+    static const struct unicode_str empty_name = { NULL, 0 };
+    struct bin_registry_header header;
+    struct key *scratch;
+    struct stat st, bin_st;
+    void *base = MAP_FAILED;
+    size_t pos = sizeof(header);
+    char *name;
+    int fd, ret = 0;
+
+    if (!use_bin_registry()) return 0;
+    /* the cache replaces the whole branch, it can only be used for a new key */
+    if (key->last_subkey != -1 || key->last_value != -1) return 0;
+    if (stat( path, &st ) == -1) return 0;
+    if (!(name = get_bin_registry_name( path ))) return 0;
+    fd = open( name, O_RDONLY );
+    free( name );
+    if (fd == -1) return 0;
+
+    if (!fstat( fd, &bin_st ) && bin_st.st_size >= sizeof(header))
+        base = mmap( NULL, bin_st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if (base == MAP_FAILED) return 0;
+
+    memcpy( &header, base, sizeof(header) );
+    if (memcmp( header.magic, BIN_REGISTRY_MAGIC, sizeof(header.magic) )) goto done;
+    if (header.size != bin_st.st_size) goto done;
+    if (header.text_size != st.st_size || header.text_mtime != st.st_mtime ||
+        header.text_mtime_nsec != get_mtime_nsec( &st ) || header.text_ino != st.st_ino)
+        goto done;
+    if (prefix_type != PREFIX_UNKNOWN && header.prefix != PREFIX_UNKNOWN && header.prefix != prefix_type)
+        goto done;
+    if (!check_bin_key( base, bin_st.st_size, &pos, 0 ) || pos != bin_st.st_size) goto done;
+
+    /* load into a scratch key, so that a failure doesn't leave a partial branch behind */
+    if (!(scratch = alloc_key( &empty_name, key->modif ))) goto done;
+    pos = sizeof(header);
+    if ((ret = load_bin_key( scratch, base, &pos )))
+    {
+        if (prefix_type == PREFIX_UNKNOWN) prefix_type = header.prefix;
+        graft_bin_key( key, scratch );
+    }
+    else fprintf( stderr, "wineserver: could not load registry cache for %s\n", path );
+    release_object( scratch );
+
+done:
+    munmap( base, bin_st.st_size );
+    return ret;
+}
+
 /* load one of the initial registry files */
 static int load_init_registry_from_file( const char *filename, struct key *key )
 {
     FILE *f;
+    int ret;
 
-    if ((f = fopen( filename, "r" )))
+    if (!(ret = load_bin_registry( filename, key )) && (f = fopen( filename, "r" )))
     {
         load_keys( key, filename, f, 0 );
         fclose( f );
@@ -1752,6 +2247,9 @@ static int load_init_registry_from_file( const char *filename, struct key *key )
             fprintf( stderr, "%s is not a valid registry file\n", filename );
             return 1;
         }
+        /* create the cache now, the branch may stay clean for a long time */
+        save_bin_registry( key, filename );
+        ret = 1;
     }
 
     assert( save_branch_count < MAX_SAVE_BRANCH_INFO );
@@ -1759,7 +2257,7 @@ static int load_init_registry_from_file( const char *filename, struct key *key )
     save_branch_info[save_branch_count].path = filename;
     save_branch_info[save_branch_count++].key = (struct key *)grab_object( key );
     make_object_permanent( &key->obj );
-    return (f != NULL);
+    return ret;
 }
 
 static WCHAR *format_user_registry_path( const SID *sid, struct unicode_str *path )
@@ -1943,11 +2441,11 @@ static void save_all_subkeys( struct key *key, FILE *f )
 static void save_registry( struct key *key, obj_handle_t handle )
 {
     struct file *file;
+    char *name;
     int fd;
 
     if (!(file = get_file_obj( current->process, handle, FILE_WRITE_DATA ))) return;
     fd = dup( get_file_unix_fd( file ) );
-    release_object( file );
     if (fd != -1)
     {
         FILE *f = fdopen( fd, "w" );
@@ -1955,6 +2453,11 @@ static void save_registry( struct key *key, obj_handle_t handle )
         {
             save_all_subkeys( key, f );
             if (fclose( f )) file_set_error();
+            else if (use_bin_registry() && (name = get_hive_file_name( file )))
+            {
+                save_bin_registry( key, name );
+                free( name );
+            }
         }
         else
         {
@@ -1962,6 +2465,7 @@ static void save_registry( struct key *key, obj_handle_t handle )
             close( fd );
         }
     }
+    release_object( file );
 }
 
 /* save a registry branch to a file */
@@ -2031,6 +2535,7 @@ static int save_branch( struct key *key, const char *path )
         if (ret) ret = !rename( tmp, path );
         if (!ret) unlink( tmp );
     }
+    if (ret) save_bin_registry( key, path );
 
 done:
     free( tmp );
@@ -2038,16 +2543,96 @@ done:
     return ret;
 }
 
+/* close all the server file descriptors except the standard ones and 'keep' in a forked child */
+static void close_server_fds( int keep )
+{
+    long fd, max_fd = sysconf( _SC_OPEN_MAX );
+
+    if (max_fd == -1) max_fd = 1024;
+    for (fd = 3; fd < max_fd; fd++) if (fd != keep) close( fd );
+}
+
+/* check for the end of a background save; return 0 if it's still running */
+static int wait_background_save( int block )
+{
+    int i, ret;
+    char result = 0;
+
+    if (!save_pid) return 1;
+
+    /* the exit status can't be used, the SIGCHLD handler may reap the process first */
+    if (block) fcntl( save_status_fd, F_SETFL, 0 );
+    while ((ret = read( save_status_fd, &result, 1 )) == -1 && errno == EINTR);
+    if (ret == -1 && errno == EAGAIN) return 0;
+
+    /* on failure, or if the process died before reporting, the branches are still dirty */
+    if (ret != 1 || !result)
+    {
+        for (i = 0; i < save_branch_count; i++)
+            if (save_pid_mask & (1 << i)) make_dirty( save_branch_info[i].key );
+    }
+    waitpid( save_pid, NULL, WNOHANG );
+    close( save_status_fd );
+    save_status_fd = -1;
+    save_pid = 0;
+    save_pid_mask = 0;
+    return 1;
+}
+
+/* save the dirty branches from a forked process, so that formatting and writing
+ * a large registry doesn't block request processing; return 0 on failure */
+static int background_save(void)
+{
+    unsigned int mask = 0;
+    int i, fds[2];
+    char ret = 1;
+    pid_t pid;
+
+    for (i = 0; i < save_branch_count; i++)
+        if (save_branch_info[i].key->flags & KEY_DIRTY) mask |= 1 << i;
+    if (!mask) return 1;
+
+    if (pipe( fds ) == -1) return 0;
+
+    switch ((pid = fork()))
+    {
+    case -1:
+        close( fds[0] );
+        close( fds[1] );
+        return 0;
+    case 0:
+        /* the child has a consistent snapshot of the tree, it only has to write it out */
+        if (fchdir( config_dir_fd ) == -1) ret = 0;
+        close_server_fds( fds[1] );
+        if (ret) for (i = 0; i < save_branch_count; i++)
+            if (mask & (1 << i)) ret &= save_branch( save_branch_info[i].key, save_branch_info[i].path );
+        _exit( write( fds[1], &ret, 1 ) != 1 || !ret );
+    default:
+        close( fds[1] );
+        fcntl( fds[0], F_SETFL, O_NONBLOCK );
+        save_status_fd = fds[0];
+        save_pid = pid;
+        save_pid_mask = mask;
+        for (i = 0; i < save_branch_count; i++)
+            if (mask & (1 << i)) make_clean( save_branch_info[i].key );
+        return 1;
+    }
+}
+
 /* periodic saving of the registry */
 static void periodic_save( void *arg )
 {
     int i;
 
-    if (fchdir( config_dir_fd ) == -1) return;
     save_timeout_user = NULL;
-    for (i = 0; i < save_branch_count; i++)
-        save_branch( save_branch_info[i].key, save_branch_info[i].path );
-    if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
+    /* skip this round if the previous save is still in progress */
+    if (wait_background_save( 0 ) && !background_save())
+    {
+        if (fchdir( config_dir_fd ) == -1) return;
+        for (i = 0; i < save_branch_count; i++)
+            save_branch( save_branch_info[i].key, save_branch_info[i].path );
+        if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
+    }
     set_periodic_save_timer();
 }
 
@@ -2063,6 +2648,9 @@ void flush_registry(void)
 {
     int i;
 
+    /* make sure a background save doesn't overwrite the files after us */
+    wait_background_save( 1 );
+
     if (fchdir( config_dir_fd ) == -1) return;
     for (i = 0; i < save_branch_count; i++)
     {
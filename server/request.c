@@ -334,24 +334,47 @@ static void call_req_handler( struct thread *thread )
 /* read a request from a thread */
 void read_request( struct thread *thread )
 {
+    static char buffer[4096];  /* the variable data usually comes along with the request */
+    struct iovec vec[2];
     int ret;
 
     if (!thread->req_toread)  /* no pending request */
     {
-        if ((ret = read( get_unix_fd( thread->request_fd ), &thread->req,
-                         sizeof(thread->req) )) != sizeof(thread->req)) goto error;
+        vec[0].iov_base = (char *)&thread->req + thread->req_hdr_read;
+        vec[0].iov_len  = sizeof(thread->req) - thread->req_hdr_read;
+        vec[1].iov_base = buffer;
+        vec[1].iov_len  = sizeof(buffer);
+        if ((ret = readv( get_unix_fd( thread->request_fd ), vec, 2 )) <= 0) goto error;
+        if ((size_t)ret < vec[0].iov_len)
+        {
+            /* wait for the rest of the fixed part */
+            thread->req_hdr_read += ret;
+            return;
+        }
+        ret -= vec[0].iov_len;
+        thread->req_hdr_read = 0;
         if (!(thread->req_toread = thread->req.request_header.request_size))
         {
+            if (ret) goto error;
             /* no data, handle request at once */
             call_req_handler( thread );
             return;
         }
+        if ((unsigned int)ret > thread->req_toread) goto error;
         if (!(thread->req_data = malloc( thread->req_toread )))
         {
             fatal_protocol_error( thread, "no memory for %u bytes request %d\n",
                                   thread->req_toread, thread->req.request_header.req );
             return;
         }
+        memcpy( thread->req_data, buffer, ret );
+        if (!(thread->req_toread -= ret))
+        {
+            call_req_handler( thread );
+            free( thread->req_data );
+            thread->req_data = NULL;
+            return;
+        }
     }
 
     /* read the variable sized data */
@@ -142,6 +142,7 @@ DECL_HANDLER(queue_apc);
 DECL_HANDLER(get_apc_result);
 DECL_HANDLER(close_handle);
 DECL_HANDLER(set_handle_info);
+DECL_HANDLER(get_shared_handle_table);
 DECL_HANDLER(dup_handle);
 DECL_HANDLER(make_temporary);
 DECL_HANDLER(open_process);
@@ -161,6 +162,7 @@ DECL_HANDLER(create_semaphore);
 DECL_HANDLER(release_semaphore);
 DECL_HANDLER(query_semaphore);
 DECL_HANDLER(open_semaphore);
+DECL_HANDLER(get_inproc_sync_mapping);
 DECL_HANDLER(create_file);
 DECL_HANDLER(open_file_object);
 DECL_HANDLER(alloc_file_handle);
@@ -422,6 +424,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_get_apc_result,
     (req_handler)req_close_handle,
     (req_handler)req_set_handle_info,
+    (req_handler)req_get_shared_handle_table,
     (req_handler)req_dup_handle,
     (req_handler)req_make_temporary,
     (req_handler)req_open_process,
@@ -441,6 +444,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_release_semaphore,
     (req_handler)req_query_semaphore,
     (req_handler)req_open_semaphore,
+    (req_handler)req_get_inproc_sync_mapping,
     (req_handler)req_create_file,
     (req_handler)req_open_file_object,
     (req_handler)req_alloc_file_handle,
@@ -865,6 +869,11 @@ C_ASSERT( FIELD_OFFSET(struct set_handle_info_request, mask) == 20 );
 C_ASSERT( sizeof(struct set_handle_info_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct set_handle_info_reply, old_flags) == 8 );
 C_ASSERT( sizeof(struct set_handle_info_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_shared_handle_table_request, count) == 12 );
+C_ASSERT( sizeof(struct get_shared_handle_table_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_shared_handle_table_reply, handle) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_shared_handle_table_reply, count) == 12 );
+C_ASSERT( sizeof(struct get_shared_handle_table_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct dup_handle_request, src_process) == 12 );
 C_ASSERT( FIELD_OFFSET(struct dup_handle_request, src_handle) == 16 );
 C_ASSERT( FIELD_OFFSET(struct dup_handle_request, dst_process) == 20 );
@@ -903,6 +912,7 @@ C_ASSERT( FIELD_OFFSET(struct create_event_request, manual_reset) == 16 );
 C_ASSERT( FIELD_OFFSET(struct create_event_request, initial_state) == 20 );
 C_ASSERT( sizeof(struct create_event_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct create_event_reply, handle) == 8 );
+C_ASSERT( FIELD_OFFSET(struct create_event_reply, inproc_sync) == 12 );
 C_ASSERT( sizeof(struct create_event_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct event_op_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct event_op_request, op) == 16 );
@@ -934,6 +944,7 @@ C_ASSERT( FIELD_OFFSET(struct create_mutex_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_mutex_request, owned) == 16 );
 C_ASSERT( sizeof(struct create_mutex_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct create_mutex_reply, handle) == 8 );
+C_ASSERT( FIELD_OFFSET(struct create_mutex_reply, inproc_sync) == 12 );
 C_ASSERT( sizeof(struct create_mutex_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct release_mutex_request, handle) == 12 );
 C_ASSERT( sizeof(struct release_mutex_request) == 16 );
@@ -956,6 +967,7 @@ C_ASSERT( FIELD_OFFSET(struct create_semaphore_request, initial) == 16 );
 C_ASSERT( FIELD_OFFSET(struct create_semaphore_request, max) == 20 );
 C_ASSERT( sizeof(struct create_semaphore_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct create_semaphore_reply, handle) == 8 );
+C_ASSERT( FIELD_OFFSET(struct create_semaphore_reply, inproc_sync) == 12 );
 C_ASSERT( sizeof(struct create_semaphore_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct release_semaphore_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct release_semaphore_request, count) == 16 );
@@ -973,6 +985,9 @@ C_ASSERT( FIELD_OFFSET(struct open_semaphore_request, rootdir) == 20 );
 C_ASSERT( sizeof(struct open_semaphore_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct open_semaphore_reply, handle) == 8 );
 C_ASSERT( sizeof(struct open_semaphore_reply) == 16 );
+C_ASSERT( sizeof(struct get_inproc_sync_mapping_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_inproc_sync_mapping_reply, handle) == 8 );
+C_ASSERT( sizeof(struct get_inproc_sync_mapping_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct create_file_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_file_request, sharing) == 16 );
 C_ASSERT( FIELD_OFFSET(struct create_file_request, create) == 20 );
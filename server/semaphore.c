@@ -55,20 +55,24 @@ struct semaphore
     struct object  obj;    /* object header */
     unsigned int   count;  /* current count */
     unsigned int   max;    /* maximum possible count */
+    struct inproc_sync inproc_sync; /* shared state for in-process sync */
 };
 
 static void semaphore_dump( struct object *obj, int verbose );
+static int semaphore_add_queue( struct object *obj, struct wait_queue_entry *entry );
+static void semaphore_remove_queue( struct object *obj, struct wait_queue_entry *entry );
 static int semaphore_signaled( struct object *obj, struct wait_queue_entry *entry );
 static void semaphore_satisfied( struct object *obj, struct wait_queue_entry *entry );
 static int semaphore_signal( struct object *obj, unsigned int access );
+static void semaphore_destroy( struct object *obj );
 
 static const struct object_ops semaphore_ops =
 {
     sizeof(struct semaphore),      /* size */
     &semaphore_type,               /* type */
     semaphore_dump,                /* dump */
-    add_queue,                     /* add_queue */
-    remove_queue,                  /* remove_queue */
+    semaphore_add_queue,           /* add_queue */
+    semaphore_remove_queue,        /* remove_queue */
     semaphore_signaled,            /* signaled */
     semaphore_satisfied,           /* satisfied */
     semaphore_signal,              /* signal */
@@ -83,7 +87,7 @@ static const struct object_ops semaphore_ops =
     no_open_file,                  /* open_file */
     no_kernel_obj_list,            /* get_kernel_obj_list */
     no_close_handle,               /* close_handle */
-    no_destroy                     /* destroy */
+    semaphore_destroy              /* destroy */
 };
 
 
@@ -105,30 +109,53 @@ static struct semaphore *create_semaphore( struct object *root, const struct uni
             /* initialize it if it didn't already exist */
             sem->count = initial;
             sem->max   = max;
+            sem->inproc_sync.index = 0;
         }
     }
     return sem;
 }
 
+/* move the semaphore count to shared memory so that the client can access it directly */
+static void semaphore_init_inproc_sync( struct semaphore *sem )
+{
+    if (sem->max > INPROC_SYNC_WAITERS - 1) return;  /* doesn't fit in the state value */
+    alloc_inproc_sync( &sem->inproc_sync, current->process, INPROC_SYNC_SEMAPHORE, sem->count, sem->max );
+}
+
+static unsigned int get_semaphore_count( struct semaphore *sem )
+{
+    if (sem->inproc_sync.index) return get_inproc_sync_state( &sem->inproc_sync );
+    return sem->count;
+}
+
+/* atomically change the count from 'old' to 'new', return the previous count */
+static unsigned int cmpxchg_semaphore_count( struct semaphore *sem, unsigned int old, unsigned int new )
+{
+    unsigned int prev = sem->count;
+
+    if (sem->inproc_sync.index) return cmpxchg_inproc_sync_state( &sem->inproc_sync, old, new );
+    if (prev == old) sem->count = new;
+    return prev;
+}
+
 static int release_semaphore( struct semaphore *sem, unsigned int count,
                               unsigned int *prev )
 {
-    if (prev) *prev = sem->count;
-    if (sem->count + count < sem->count || sem->count + count > sem->max)
-    {
-        set_error( STATUS_SEMAPHORE_LIMIT_EXCEEDED );
-        return 0;
-    }
-    else if (sem->count)
-    {
-        /* there cannot be any thread to wake up if the count is != 0 */
-        sem->count += count;
-    }
-    else
+    unsigned int cur, old = get_semaphore_count( sem );
+
+    for (;;)
     {
-        sem->count = count;
-        wake_up( &sem->obj, count );
+        if (prev) *prev = old;
+        if (old + count < old || old + count > sem->max)
+        {
+            set_error( STATUS_SEMAPHORE_LIMIT_EXCEEDED );
+            return 0;
+        }
+        if ((cur = cmpxchg_semaphore_count( sem, old, old + count )) == old) break;
+        old = cur;
     }
+    /* there cannot be any thread to wake up if the count was != 0 */
+    if (!old) wake_up( &sem->obj, count );
     return 1;
 }
 
@@ -136,22 +163,48 @@ static void semaphore_dump( struct object *obj, int verbose )
 {
     struct semaphore *sem = (struct semaphore *)obj;
     assert( obj->ops == &semaphore_ops );
-    fprintf( stderr, "Semaphore count=%d max=%d\n", sem->count, sem->max );
+    fprintf( stderr, "Semaphore count=%d max=%d inproc=%u\n",
+             get_semaphore_count( sem ), sem->max, sem->inproc_sync.index );
+}
+
+static int semaphore_add_queue( struct object *obj, struct wait_queue_entry *entry )
+{
+    struct semaphore *sem = (struct semaphore *)obj;
+    assert( obj->ops == &semaphore_ops );
+    /* make the client go through the server while we have waiters */
+    if (sem->inproc_sync.index) add_inproc_sync_waiter( &sem->inproc_sync );
+    return add_queue( obj, entry );
+}
+
+static void semaphore_remove_queue( struct object *obj, struct wait_queue_entry *entry )
+{
+    struct semaphore *sem = (struct semaphore *)obj;
+    assert( obj->ops == &semaphore_ops );
+    remove_queue( obj, entry );
+    if (sem->inproc_sync.index && list_empty( &obj->wait_queue ))
+        remove_inproc_sync_waiters( &sem->inproc_sync );
 }
 
 static int semaphore_signaled( struct object *obj, struct wait_queue_entry *entry )
 {
     struct semaphore *sem = (struct semaphore *)obj;
     assert( obj->ops == &semaphore_ops );
-    return (sem->count > 0);
+    return (get_semaphore_count( sem ) > 0);
 }
 
 static void semaphore_satisfied( struct object *obj, struct wait_queue_entry *entry )
 {
     struct semaphore *sem = (struct semaphore *)obj;
+    unsigned int cur, old = get_semaphore_count( sem );
+
     assert( obj->ops == &semaphore_ops );
-    assert( sem->count );
-    sem->count--;
+    /* an in-process count may have been changed by a misbehaving client */
+    while (old)
+    {
+        if ((cur = cmpxchg_semaphore_count( sem, old, old - 1 )) == old) break;
+        old = cur;
+    }
+    assert( old || sem->inproc_sync.index );
 }
 
 static int semaphore_signal( struct object *obj, unsigned int access )
@@ -167,6 +220,13 @@ static int semaphore_signal( struct object *obj, unsigned int access )
     return release_semaphore( sem, 1, NULL );
 }
 
+static void semaphore_destroy( struct object *obj )
+{
+    struct semaphore *sem = (struct semaphore *)obj;
+    assert( obj->ops == &semaphore_ops );
+    if (sem->inproc_sync.index) free_inproc_sync( &sem->inproc_sync );
+}
+
 /* create a semaphore */
 DECL_HANDLER(create_semaphore)
 {
@@ -183,8 +243,17 @@ DECL_HANDLER(create_semaphore)
         if (get_error() == STATUS_OBJECT_NAME_EXISTS)
             reply->handle = alloc_handle( current->process, sem, req->access, objattr->attributes );
         else
+        {
+            if (!name.len && !(objattr->attributes & OBJ_INHERIT) && use_inproc_sync())
+                semaphore_init_inproc_sync( sem );
             reply->handle = alloc_handle_no_access_check( current->process, sem,
                                                           req->access, objattr->attributes );
+        }
+        /* the client can only use the shared state if the handle allows all operations */
+        if (reply->handle && sem->inproc_sync.index &&
+            !(~get_handle_access( current->process, reply->handle ) &
+              (SYNCHRONIZE | SEMAPHORE_QUERY_STATE | SEMAPHORE_MODIFY_STATE)))
+            reply->inproc_sync = sem->inproc_sync.index;
         release_object( sem );
     }
 
@@ -221,7 +290,7 @@ DECL_HANDLER(query_semaphore)
     if ((sem = (struct semaphore *)get_handle_obj( current->process, req->handle,
                                                    SEMAPHORE_QUERY_STATE, &semaphore_ops )))
     {
-        reply->current = sem->count;
+        reply->current = get_semaphore_count( sem );
         reply->max = sem->max;
         release_object( sem );
     }
@@ -231,6 +231,7 @@ static inline void init_thread_structure( struct thread *thread )
     thread->error           = 0;
     thread->req_data        = NULL;
     thread->req_toread      = 0;
+    thread->req_hdr_read    = 0;
     thread->reply_data      = NULL;
     thread->reply_towrite   = 0;
     thread->request_fd      = NULL;
@@ -1403,6 +1403,25 @@ static void dump_varargs_handle_infos( const char *prefix, data_size_t size )
     fputc( '}', stderr );
 }
 
+static void dump_varargs_completion_infos( const char *prefix, data_size_t size )
+{
+    const struct completion_info *info;
+
+    fprintf( stderr, "%s{", prefix );
+    while (size >= sizeof(*info))
+    {
+        info = cur_data;
+        dump_uint64( "{ckey=", &info->ckey );
+        dump_uint64( ",cvalue=", &info->cvalue );
+        dump_uint64( ",information=", &info->information );
+        fprintf( stderr, ",status=%s}", get_status_name( info->status ) );
+        size -= sizeof(*info);
+        remove_data( sizeof(*info) );
+        if (size) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+}
+
 static void dump_varargs_poll_socket_input( const char *prefix, data_size_t size )
 {
     const struct poll_socket_input *input;
@@ -1743,6 +1762,17 @@ static void dump_set_handle_info_reply( const struct set_handle_info_reply *req
     fprintf( stderr, " old_flags=%d", req->old_flags );
 }
 
+static void dump_get_shared_handle_table_request( const struct get_shared_handle_table_request *req )
+{
+    fprintf( stderr, " count=%08x", req->count );
+}
+
+static void dump_get_shared_handle_table_reply( const struct get_shared_handle_table_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", count=%08x", req->count );
+}
+
 static void dump_dup_handle_request( const struct dup_handle_request *req )
 {
     fprintf( stderr, " src_process=%04x", req->src_process );
@@ -1818,6 +1848,7 @@ static void dump_create_event_request( const struct create_event_request *req )
 static void dump_create_event_reply( const struct create_event_reply *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", inproc_sync=%08x", req->inproc_sync );
 }
 
 static void dump_event_op_request( const struct event_op_request *req )
@@ -1889,6 +1920,7 @@ static void dump_create_mutex_request( const struct create_mutex_request *req )
 static void dump_create_mutex_reply( const struct create_mutex_reply *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", inproc_sync=%08x", req->inproc_sync );
 }
 
 static void dump_release_mutex_request( const struct release_mutex_request *req )
@@ -1937,6 +1969,7 @@ static void dump_create_semaphore_request( const struct create_semaphore_request
 static void dump_create_semaphore_reply( const struct create_semaphore_reply *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", inproc_sync=%08x", req->inproc_sync );
 }
 
 static void dump_release_semaphore_request( const struct release_semaphore_request *req )
@@ -1974,6 +2007,15 @@ static void dump_open_semaphore_reply( const struct open_semaphore_reply *req )
     fprintf( stderr, " handle=%04x", req->handle );
 }
 
+static void dump_get_inproc_sync_mapping_request( const struct get_inproc_sync_mapping_request *req )
+{
+}
+
+static void dump_get_inproc_sync_mapping_reply( const struct get_inproc_sync_mapping_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
 static void dump_create_file_request( const struct create_file_request *req )
 {
     fprintf( stderr, " access=%08x", req->access );
@@ -4315,6 +4357,7 @@ static void dump_remove_completion_reply( const struct remove_completion_reply *
     dump_uint64( ", cvalue=", &req->cvalue );
     dump_uint64( ", information=", &req->information );
     fprintf( stderr, ", status=%08x", req->status );
+    dump_varargs_completion_infos( ", more=", cur_size );
 }
 
 static void dump_query_completion_request( const struct query_completion_request *req )
@@ -4580,6 +4623,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_apc_result_request,
     (dump_func)dump_close_handle_request,
     (dump_func)dump_set_handle_info_request,
+    (dump_func)dump_get_shared_handle_table_request,
     (dump_func)dump_dup_handle_request,
     (dump_func)dump_make_temporary_request,
     (dump_func)dump_open_process_request,
@@ -4599,6 +4643,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_release_semaphore_request,
     (dump_func)dump_query_semaphore_request,
     (dump_func)dump_open_semaphore_request,
+    (dump_func)dump_get_inproc_sync_mapping_request,
     (dump_func)dump_create_file_request,
     (dump_func)dump_open_file_object_request,
     (dump_func)dump_alloc_file_handle_request,
@@ -4857,6 +4902,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_apc_result_reply,
     NULL,
     (dump_func)dump_set_handle_info_reply,
+    (dump_func)dump_get_shared_handle_table_reply,
     (dump_func)dump_dup_handle_reply,
     NULL,
     (dump_func)dump_open_process_reply,
@@ -4876,6 +4922,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_release_semaphore_reply,
     (dump_func)dump_query_semaphore_reply,
     (dump_func)dump_open_semaphore_reply,
+    (dump_func)dump_get_inproc_sync_mapping_reply,
     (dump_func)dump_create_file_reply,
     (dump_func)dump_open_file_object_reply,
     (dump_func)dump_alloc_file_handle_reply,
@@ -5134,6 +5181,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "get_apc_result",
     "close_handle",
     "set_handle_info",
+    "get_shared_handle_table",
     "dup_handle",
     "make_temporary",
     "open_process",
@@ -5153,6 +5201,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "release_semaphore",
     "query_semaphore",
     "open_semaphore",
+    "get_inproc_sync_mapping",
     "create_file",
     "open_file_object",
     "alloc_file_handle",